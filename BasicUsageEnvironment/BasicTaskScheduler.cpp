@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "BasicUsageEnvironment.hh"
 #include "HandlerSet.hh"
+#include "GroupsockHelper.hh"
 #include <stdio.h>
 #if defined(_QNX4)
 #include <sys/select.h>
@@ -82,6 +83,11 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 
 	int selectResult = select(fMaxNumSockets, &readSet, &writeSet, &exceptionSet, &tv_timeToDelay);
 
+	// If we're recording event loop statistics, then the rest of this iteration is 'busy' time:
+	Boolean const recordingStats = fEventLoopStats.isEnabled();
+	struct timeval busyStartTime;
+	if (recordingStats) gettimeofday(&busyStartTime, NULL);
+
 
 	if (selectResult < 0) {
 #if defined(__WIN32__) || defined(_WIN32)
@@ -147,7 +153,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 			fLastHandledSocketNum = sock;
 			// Note: we set "fLastHandledSocketNum" before calling the handler,
 			// in case the handler calls "doEventLoop()" reentrantly.
-			(*handler->handlerProc)(handler->clientData, resultConditionSet);
+			callBackgroundHandler(handler->handlerProc, handler->clientData, resultConditionSet);
 			break;
 		}
 	}
@@ -165,7 +171,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 				fLastHandledSocketNum = sock;
 				// Note: we set "fLastHandledSocketNum" before calling the handler,
 				// in case the handler calls "doEventLoop()" reentrantly.
-				(*handler->handlerProc)(handler->clientData, resultConditionSet);
+				callBackgroundHandler(handler->handlerProc, handler->clientData, resultConditionSet);
 				break;
 			}
 		}
@@ -178,9 +184,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 		if (fTriggersAwaitingHandling == fLastUsedTriggerMask) {
 			// Common-case optimization for a single event trigger:
 			fTriggersAwaitingHandling = 0;
-			if (fTriggeredEventHandlers[fLastUsedTriggerNum] != NULL) {
-				(*fTriggeredEventHandlers[fLastUsedTriggerNum])(fTriggeredEventClientDatas[fLastUsedTriggerNum]);
-			}
+			callTriggeredEventHandler(fLastUsedTriggerNum);
 		}
 		else {
 			// Look for an event trigger that needs handling (making sure that we make forward progress through all possible triggers):
@@ -194,9 +198,7 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 
 				if ((fTriggersAwaitingHandling&mask) != 0) {
 					fTriggersAwaitingHandling &= ~mask;
-					if (fTriggeredEventHandlers[i] != NULL) {
-						(*fTriggeredEventHandlers[i])(fTriggeredEventClientDatas[i]);
-					}
+					callTriggeredEventHandler(i);
 
 					fLastUsedTriggerMask = mask;
 					fLastUsedTriggerNum = i;
@@ -207,7 +209,13 @@ void BasicTaskScheduler::SingleStep(unsigned maxDelayTime) {
 	}
 
 	// Also handle any delayed event that may have come due.
-	fDelayQueue.handleAlarm();
+	handleAlarm();
+
+	if (recordingStats) {
+		struct timeval busyEndTime;
+		gettimeofday(&busyEndTime, NULL);
+		fEventLoopStats.noteIteration(EventLoopStats::usecsBetween(busyStartTime, busyEndTime), fDelayQueue.numEntries());
+	}
 }
 
 void BasicTaskScheduler
@@ -19,6 +19,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "BasicUsageEnvironment0.hh"
 #include "HandlerSet.hh"
+#include "GroupsockHelper.hh"
 
 ////////// A subclass of DelayQueueEntry,
 //////////     used to implement BasicTaskScheduler0::scheduleDelayedTask()
@@ -35,6 +36,10 @@ private: // redefined virtual functions
 		DelayQueueEntry::handleTimeout();  // handleTimeout
 	}
 
+	virtual void const* handlerAddress() const {
+		return (void const*)fProc;
+	}
+
 private:
 	TaskFunc* fProc;
 	void* fClientData;
@@ -151,6 +156,40 @@ void BasicTaskScheduler0::triggerEvent(EventTriggerId eventTriggerId, void* clie
 	fTriggersAwaitingHandling |= eventTriggerId;
 }
 
+EventLoopStats* BasicTaskScheduler0::eventLoopStats() {
+	return &fEventLoopStats;
+}
+
+void BasicTaskScheduler0
+::callBackgroundHandler(BackgroundHandlerProc* handlerProc, void* clientData, int resultConditionSet) {
+	if (!fEventLoopStats.isEnabled()) {
+		(*handlerProc)(clientData, resultConditionSet);
+		return;
+	}
+
+	struct timeval startTime, endTime;
+	gettimeofday(&startTime, NULL);
+	(*handlerProc)(clientData, resultConditionSet);
+	gettimeofday(&endTime, NULL);
+	fEventLoopStats.noteHandlerCall((void const*)handlerProc, EventLoopStats::SOCKET_HANDLER, startTime, endTime);
+}
+
+void BasicTaskScheduler0::callTriggeredEventHandler(unsigned triggerNum) {
+	TaskFunc* handlerProc = fTriggeredEventHandlers[triggerNum];
+	if (handlerProc == NULL) return;
+
+	if (!fEventLoopStats.isEnabled()) {
+		(*handlerProc)(fTriggeredEventClientDatas[triggerNum]);
+		return;
+	}
+
+	struct timeval startTime, endTime;
+	gettimeofday(&startTime, NULL);
+	(*handlerProc)(fTriggeredEventClientDatas[triggerNum]);
+	gettimeofday(&endTime, NULL);
+	fEventLoopStats.noteHandlerCall((void const*)handlerProc, EventLoopStats::EVENT_TRIGGER_HANDLER, startTime, endTime);
+}
+
 
 ////////// HandlerSet (etc.) implementation //////////
 
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "DelayQueue.hh"
 #include "GroupsockHelper.hh"
+#include "EventLoopStats.hh"
 
 static const int MILLION = 1000000;
 
@@ -110,6 +111,10 @@ void DelayQueueEntry::handleTimeout() {
 	delete this;
 }
 
+void const* DelayQueueEntry::handlerAddress() const {
+	return NULL;
+}
+
 
 ///// DelayQueue /////
 //DelayQueue̳DelayQueueEntry
@@ -120,6 +125,7 @@ DelayQueue::DelayQueue()
 : DelayQueueEntry(ETERNITY) {
 	//ǰʱΪһͬʱ
 	fLastSyncTime = TimeNow();
+	fNumEntries = 0;
 }
 
 
@@ -147,6 +153,10 @@ void DelayQueue ::addEntry(DelayQueueEntry* newEntry) {
 
 	synchronize();
 
+	newEntry->fDueTime = fLastSyncTime;
+	newEntry->fDueTime += newEntry->fDeltaTimeRemaining;
+	++fNumEntries;
+
 	DelayQueueEntry* cur = head();
 	while (newEntry->fDeltaTimeRemaining >= cur->fDeltaTimeRemaining) {
 		newEntry->fDeltaTimeRemaining -= cur->fDeltaTimeRemaining;
@@ -187,6 +197,7 @@ void DelayQueue::removeEntry(DelayQueueEntry* entry) {
 	entry->fNext->fPrev = entry->fPrev;
 	entry->fNext = entry->fPrev = NULL;
 	// in case we should try to remove it again
+	--fNumEntries;
 }
 
 //EnTrytokenIDɾ
@@ -218,6 +229,25 @@ void DelayQueue::handleAlarm() {
 		
 	}
 }
+
+void DelayQueue::handleAlarm(EventLoopStats& stats) {
+	if (head()->fDeltaTimeRemaining != DELAY_ZERO) synchronize();
+	if (head()->fDeltaTimeRemaining == DELAY_ZERO) {
+		// This event is due to be handled:
+		DelayQueueEntry* toRemove = head();
+		removeEntry(toRemove); // do this first, in case handler accesses queue
+
+		struct timeval dueTime, startTime, endTime;
+		dueTime.tv_sec = toRemove->fDueTime.seconds(); dueTime.tv_usec = toRemove->fDueTime.useconds();
+		gettimeofday(&startTime, NULL);
+		stats.noteAlarmLateness(EventLoopStats::usecsBetween(dueTime, startTime));
+
+		void const* handlerAddress = toRemove->handlerAddress(); // because "handleTimeout()" deletes "toRemove"
+		toRemove->handleTimeout();
+		gettimeofday(&endTime, NULL);
+		stats.noteHandlerCall(handlerAddress, EventLoopStats::DELAYED_TASK, startTime, endTime);
+	}
+}
 //УEntryIDвңҵ򷵻ظEntry򷵻NULL
 DelayQueueEntry* DelayQueue::findEntryByToken(intptr_t tokenToFind) {
 	DelayQueueEntry* cur = head();
@@ -32,6 +32,10 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "DelayQueue.hh"
 #endif
 
+#ifndef _EVENT_LOOP_STATS_HH
+#include "EventLoopStats.hh"
+#endif
+
 #define RESULT_MSG_BUFFER_MAX 1000
 
 // An abstract base class, useful for subclassing
@@ -92,9 +96,18 @@ public:
   virtual void deleteEventTrigger(EventTriggerId eventTriggerId);
   virtual void triggerEvent(EventTriggerId eventTriggerId, void* clientData = NULL);
 
+  virtual EventLoopStats* eventLoopStats();
+
 protected:
   BasicTaskScheduler0();
 
+  // Used by "SingleStep()" implementations to call handlers (timing them, if our "EventLoopStats" are enabled):
+  void callBackgroundHandler(BackgroundHandlerProc* handlerProc, void* clientData, int resultConditionSet);
+  void callTriggeredEventHandler(unsigned triggerNum);
+  void handleAlarm() {
+    if (fEventLoopStats.isEnabled()) fDelayQueue.handleAlarm(fEventLoopStats); else fDelayQueue.handleAlarm();
+  }
+
 protected:
   // To implement delayed operations:
   DelayQueue fDelayQueue;
@@ -108,6 +121,9 @@ protected:
   TaskFunc* fTriggeredEventHandlers[MAX_NUM_EVENT_TRIGGERS];
   void* fTriggeredEventClientDatas[MAX_NUM_EVENT_TRIGGERS];
   unsigned fLastUsedTriggerNum; // in the range [0,MAX_NUM_EVENT_TRIGGERS)
+
+  // To implement event loop timing statistics:
+  EventLoopStats fEventLoopStats;
 };
 
 #endif
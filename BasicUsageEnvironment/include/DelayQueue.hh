@@ -24,6 +24,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "NetCommon.h"
 #endif
 
+class EventLoopStats; // forward
+
 #ifdef TIME_BASE
 typedef TIME_BASE time_base_seconds;
 #else
@@ -150,6 +152,9 @@ protected: // abstract base class
 
   virtual void handleTimeout();
 
+  virtual void const* handlerAddress() const;
+      // identifies - for "EventLoopStats" - the function that "handleTimeout()" will call (default: NULL)
+
 private:
   friend class DelayQueue;
   //˫						 
@@ -157,6 +162,7 @@ private:
   DelayQueueEntry* fNext;
   DelayQueueEntry* fPrev;
   DelayInterval fDeltaTimeRemaining;
+  EventTime fDueTime; // the (absolute) time at which we were scheduled to be handled
 
   intptr_t fToken;
   static intptr_t tokenCounter;
@@ -177,6 +183,8 @@ public:
 
   DelayInterval const& timeToNextAlarm();
   void handleAlarm();
+  void handleAlarm(EventLoopStats& stats); // also records how late, and for how long, the entry was handled
+  unsigned numEntries() const { return fNumEntries; }
 
 private:
   DelayQueueEntry* head() { return fNext; }
@@ -184,6 +192,7 @@ private:
   void synchronize(); // bring the 'time remaining' fields up-to-date
 
   EventTime fLastSyncTime;
+  unsigned fNumEntries;
 };
 
 #endif
@@ -0,0 +1,205 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// Event loop timing statistics (optionally recorded by a "TaskScheduler")
+// Implementation
+
+#include "EventLoopStats.hh"
+#include <stdio.h>
+
+////////// EventLoopHistogram //////////
+
+EventLoopHistogram::EventLoopHistogram() {
+  reset();
+}
+
+void EventLoopHistogram::reset() {
+  fCount = fTotalUSecs = 0;
+  fMaxUSecs = 0;
+  for (unsigned i = 0; i < EVENT_LOOP_HISTOGRAM_NUM_BUCKETS; ++i) fBuckets[i] = 0;
+}
+
+void EventLoopHistogram::record(unsigned durationUSecs) {
+  ++fCount;
+  fTotalUSecs += durationUSecs;
+  if (durationUSecs > fMaxUSecs) fMaxUSecs = durationUSecs;
+
+  // The bucket number is the number of significant bits in "durationUSecs":
+  unsigned bucketNum = 0;
+  while (durationUSecs > 0 && bucketNum < EVENT_LOOP_HISTOGRAM_NUM_BUCKETS-1) {
+    durationUSecs >>= 1;
+    ++bucketNum;
+  }
+  ++fBuckets[bucketNum];
+}
+
+unsigned EventLoopHistogram::bucketUpperBoundUSecs(unsigned bucketNum) {
+  if (bucketNum >= EVENT_LOOP_HISTOGRAM_NUM_BUCKETS-1) return ~0;
+  return 1<<bucketNum;
+}
+
+unsigned EventLoopHistogram::percentileUSecs(double fraction) const {
+  if (fCount == 0) return 0;
+
+  u_int64_t const target = (u_int64_t)(fraction*fCount + 0.5);
+  u_int64_t countSoFar = 0;
+  for (unsigned i = 0; i < EVENT_LOOP_HISTOGRAM_NUM_BUCKETS-1; ++i) {
+    countSoFar += fBuckets[i];
+    if (countSoFar >= target) {
+      unsigned upperBound = bucketUpperBoundUSecs(i);
+      return upperBound < fMaxUSecs ? upperBound : fMaxUSecs;
+    }
+  }
+  return fMaxUSecs;
+}
+
+
+////////// EventLoopStats //////////
+
+// The statistics kept for each handler:
+class HandlerRecord {
+public:
+  HandlerRecord(EventLoopStats::HandlerKind kind) : fKind(kind) {}
+
+  EventLoopStats::HandlerKind fKind;
+  EventLoopHistogram fDurations;
+};
+
+EventLoopStats::EventLoopStats()
+  : fIsEnabled(False), fSlowHandlerThresholdUSecs(0),
+    fHandlerRecords(HashTable::create(ONE_WORD_HASH_KEYS)), fHandlerNames(HashTable::create(ONE_WORD_HASH_KEYS)) {
+  reset();
+}
+
+EventLoopStats::~EventLoopStats() {
+  reset();
+  delete fHandlerRecords;
+  delete fHandlerNames;
+}
+
+void EventLoopStats::enable(unsigned slowHandlerThresholdUSecs) {
+  fIsEnabled = True;
+  fSlowHandlerThresholdUSecs = slowHandlerThresholdUSecs;
+}
+
+void EventLoopStats::disable() {
+  fIsEnabled = False;
+}
+
+void EventLoopStats::reset() {
+  fNumIterations = 0;
+  fAlarmLateness.reset();
+  fIterationBusyTime.reset();
+  fNumPendingDelayedTasks = 0;
+  fNumSlowHandlerCalls = 0;
+
+  HandlerRecord* record;
+  while ((record = (HandlerRecord*)fHandlerRecords->RemoveNext()) != NULL) {
+    delete record;
+  }
+}
+
+char const* EventLoopStats::handlerKindName(HandlerKind kind) {
+  switch (kind) {
+    case SOCKET_HANDLER: return "socket";
+    case DELAYED_TASK: return "task";
+    case EVENT_TRIGGER_HANDLER: return "trigger";
+    default: return "unknown";
+  }
+}
+
+void EventLoopStats::setHandlerName(void const* handlerAddress, char const* name) {
+  if (name == NULL) {
+    fHandlerNames->Remove((char const*)handlerAddress);
+  } else {
+    fHandlerNames->Add((char const*)handlerAddress, (void*)name);
+  }
+}
+
+char const* EventLoopStats::handlerName(void const* handlerAddress) const {
+  return (char const*)(fHandlerNames->Lookup((char const*)handlerAddress));
+}
+
+EventLoopStats::SlowHandlerCall const* EventLoopStats::recentSlowHandlerCall(unsigned i) const {
+  if (i >= fNumSlowHandlerCalls || i >= EVENT_LOOP_STATS_SLOW_LOG_SIZE) return NULL;
+
+  return &fSlowHandlerCalls[(fNumSlowHandlerCalls - 1 - i)%EVENT_LOOP_STATS_SLOW_LOG_SIZE];
+}
+
+void EventLoopStats::noteIteration(unsigned busyUSecs, unsigned numPendingDelayedTasks) {
+  ++fNumIterations;
+  fIterationBusyTime.record(busyUSecs);
+  fNumPendingDelayedTasks = numPendingDelayedTasks;
+}
+
+void EventLoopStats::noteHandlerCall(void const* handlerAddress, HandlerKind kind,
+				     struct timeval const& startTime, struct timeval const& endTime) {
+  unsigned const durationUSecs = usecsBetween(startTime, endTime);
+
+  HandlerRecord* record = (HandlerRecord*)(fHandlerRecords->Lookup((char const*)handlerAddress));
+  if (record == NULL) {
+    record = new HandlerRecord(kind);
+    fHandlerRecords->Add((char const*)handlerAddress, record);
+  }
+  record->fDurations.record(durationUSecs);
+
+  if (fSlowHandlerThresholdUSecs > 0 && durationUSecs >= fSlowHandlerThresholdUSecs) {
+    SlowHandlerCall& call = fSlowHandlerCalls[fNumSlowHandlerCalls%EVENT_LOOP_STATS_SLOW_LOG_SIZE];
+    call.when = endTime;
+    call.handlerAddress = handlerAddress;
+    call.kind = kind;
+    call.durationUSecs = durationUSecs;
+    ++fNumSlowHandlerCalls;
+
+    char const* name = handlerName(handlerAddress);
+    if (name != NULL) {
+      fprintf(stderr, "Event loop: slow %s handler \"%s\" took %u us\n", handlerKindName(kind), name, durationUSecs);
+    } else {
+      fprintf(stderr, "Event loop: slow %s handler %p took %u us\n", handlerKindName(kind), handlerAddress, durationUSecs);
+    }
+  }
+}
+
+unsigned EventLoopStats::usecsBetween(struct timeval const& startTime, struct timeval const& endTime) {
+  long secs = endTime.tv_sec - startTime.tv_sec;
+  long usecs = endTime.tv_usec - startTime.tv_usec;
+  if (usecs < 0) { usecs += 1000000; --secs; }
+  if (secs < 0) return 0;
+  if (secs >= 4000) return ~0; // too large to represent (shouldn't happen)
+
+  return (unsigned)(secs*1000000 + usecs);
+}
+
+
+////////// EventLoopStats::Iterator //////////
+
+EventLoopStats::Iterator::Iterator(EventLoopStats const& stats)
+  : fIter(HashTable::Iterator::create(*stats.fHandlerRecords)) {
+}
+
+EventLoopStats::Iterator::~Iterator() {
+  delete fIter;
+}
+
+EventLoopHistogram const* EventLoopStats::Iterator::next(void const*& handlerAddress, HandlerKind& kind) {
+  char const* key;
+  HandlerRecord* record = (HandlerRecord*)(fIter->next(key));
+  if (record == NULL) return NULL;
+
+  handlerAddress = (void const*)key;
+  kind = record->fKind;
+  return &record->fDurations;
+}
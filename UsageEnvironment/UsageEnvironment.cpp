@@ -57,3 +57,7 @@ void TaskScheduler::rescheduleDelayedTask(TaskToken& task,
 void TaskScheduler::internalError() {
 	abort();
 }
+
+EventLoopStats* TaskScheduler::eventLoopStats() {
+	return NULL; // by default, we don't keep event loop statistics
+}
@@ -0,0 +1,142 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// Event loop timing statistics (optionally recorded by a "TaskScheduler")
+// C++ header
+
+#ifndef _EVENT_LOOP_STATS_HH
+#define _EVENT_LOOP_STATS_HH
+
+#ifndef _NETCOMMON_H
+#include "NetCommon.h"
+#endif
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+
+#ifndef _HASH_TABLE_HH
+#include "HashTable.hh"
+#endif
+
+// A histogram of durations (in microseconds), with power-of-2 bucket boundaries:
+// Bucket 0 counts durations < 1us; bucket i (0 < i < EVENT_LOOP_HISTOGRAM_NUM_BUCKETS-1) counts durations in [2^(i-1), 2^i) us;
+// the last bucket counts everything longer (i.e., >= ~4 seconds).
+#define EVENT_LOOP_HISTOGRAM_NUM_BUCKETS 24
+
+class EventLoopHistogram {
+public:
+  EventLoopHistogram();
+
+  void record(unsigned durationUSecs);
+  void reset();
+
+  u_int64_t count() const { return fCount; }
+  u_int64_t totalUSecs() const { return fTotalUSecs; }
+  unsigned maxUSecs() const { return fMaxUSecs; }
+  u_int64_t bucketCount(unsigned bucketNum) const { return fBuckets[bucketNum]; }
+  static unsigned bucketUpperBoundUSecs(unsigned bucketNum);
+      // the (exclusive) upper bound of durations counted in bucket "bucketNum" (or ~0, for the last bucket)
+  unsigned percentileUSecs(double fraction) const;
+      // an upper bound on the given percentile (e.g., "fraction" == 0.99): the upper bound of the bucket in which it falls
+
+private:
+  u_int64_t fCount, fTotalUSecs;
+  unsigned fMaxUSecs;
+  u_int64_t fBuckets[EVENT_LOOP_HISTOGRAM_NUM_BUCKETS];
+};
+
+#ifndef EVENT_LOOP_STATS_SLOW_LOG_SIZE
+#define EVENT_LOOP_STATS_SLOW_LOG_SIZE 32
+#endif
+
+class EventLoopStats {
+public:
+  EventLoopStats();
+  virtual ~EventLoopStats();
+
+  void enable(unsigned slowHandlerThresholdUSecs = 0);
+      // Starts recording.  If "slowHandlerThresholdUSecs" > 0, then each handler call that takes at least this long
+      // is also logged (to stderr, and to our list of recent slow handler calls).
+  void disable();
+  Boolean isEnabled() const { return fIsEnabled; }
+      // Note: When we're not enabled, the cost to the event loop is just a test of this flag.
+  unsigned slowHandlerThresholdUSecs() const { return fSlowHandlerThresholdUSecs; }
+
+  void reset(); // clears all recorded statistics (but not handler names)
+
+  // The kinds of 'handler' that the event loop calls:
+  enum HandlerKind { SOCKET_HANDLER, DELAYED_TASK, EVENT_TRIGGER_HANDLER };
+  static char const* handlerKindName(HandlerKind kind);
+
+  void setHandlerName(void const* handlerAddress, char const* name);
+      // Gives a (static) name to a handler function (a "TaskScheduler::BackgroundHandlerProc" or a "TaskFunc").
+      // Statistics for unnamed handlers are reported by address.
+  char const* handlerName(void const* handlerAddress) const; // NULL if unnamed
+
+  // Statistics for the event loop as a whole:
+  u_int64_t numIterations() const { return fNumIterations; }
+  EventLoopHistogram const& alarmLateness() const { return fAlarmLateness; }
+      // how late (compared to their scheduled times) delayed tasks were actually run
+  EventLoopHistogram const& iterationBusyTime() const { return fIterationBusyTime; }
+      // the time spent in each iteration of the loop, other than waiting in "select()"
+  unsigned numPendingDelayedTasks() const { return fNumPendingDelayedTasks; }
+
+  // Statistics for each handler that has been called (while we were enabled):
+  class Iterator {
+  public:
+    Iterator(EventLoopStats const& stats);
+    virtual ~Iterator();
+
+    EventLoopHistogram const* next(void const*& handlerAddress, HandlerKind& kind);
+        // returns NULL when there are no more
+  private:
+    HashTable::Iterator* fIter;
+  };
+
+  // The most recent slow handler calls:
+  struct SlowHandlerCall {
+    struct timeval when; // the time at which the call ended
+    void const* handlerAddress;
+    HandlerKind kind;
+    unsigned durationUSecs;
+  };
+  unsigned numSlowHandlerCalls() const { return fNumSlowHandlerCalls; } // total, since we were last reset
+  SlowHandlerCall const* recentSlowHandlerCall(unsigned i) const;
+      // "i" == 0 is the most recent; returns NULL if "i" >= min(numSlowHandlerCalls(), EVENT_LOOP_STATS_SLOW_LOG_SIZE)
+
+public: // used by schedulers to record statistics:
+  void noteIteration(unsigned busyUSecs, unsigned numPendingDelayedTasks);
+  void noteAlarmLateness(unsigned latenessUSecs) { fAlarmLateness.record(latenessUSecs); }
+  void noteHandlerCall(void const* handlerAddress, HandlerKind kind,
+		       struct timeval const& startTime, struct timeval const& endTime);
+
+  static unsigned usecsBetween(struct timeval const& startTime, struct timeval const& endTime);
+      // returns 0 if "endTime" is before "startTime" (e.g., because the clock was set back)
+
+private:
+  Boolean fIsEnabled;
+  unsigned fSlowHandlerThresholdUSecs;
+  u_int64_t fNumIterations;
+  EventLoopHistogram fAlarmLateness, fIterationBusyTime;
+  unsigned fNumPendingDelayedTasks;
+  HashTable* fHandlerRecords; // maps handler addresses to their statistics
+  HashTable* fHandlerNames; // maps handler addresses to their names
+  SlowHandlerCall fSlowHandlerCalls[EVENT_LOOP_STATS_SLOW_LOG_SIZE]; // a ring buffer
+  unsigned fNumSlowHandlerCalls;
+};
+
+#endif
@@ -98,6 +98,8 @@ private:
 };
 
 
+class EventLoopStats; // forward
+
 typedef void TaskFunc(void* clientData);
 typedef void* TaskToken;
 typedef u_int32_t EventTriggerId;
@@ -159,6 +161,10 @@ public:
 
   virtual void internalError(); // used to 'handle' a 'should not occur'-type error condition within the library.
 
+  virtual EventLoopStats* eventLoopStats();
+      // Returns the event loop's timing statistics (which are recorded only after "eventLoopStats()->enable()" is called),
+      // or NULL if this scheduler doesn't keep any.
+
 protected:
   TaskScheduler(); // abstract base class
 };
@@ -0,0 +1,535 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "mTunnel" multicast access service
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A non-blocking (i.e., event loop driven) resolver of host names into (IPv4) addresses, with a cache
+// Implementation
+
+#include "DNSResolver.hh"
+#include "GroupsockHelper.hh"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifndef INADDR_NONE
+#define INADDR_NONE 0xFFFFFFFF
+#endif
+
+#define DNS_PORT 53
+#define DNS_MAX_MESSAGE_SIZE 512 // because we don't ask for larger (i.e., EDNS) responses
+#define DNS_MAX_NAME_LENGTH 253
+
+////////// Helper classes //////////
+
+class DNSCacheEntry {
+public:
+  DNSCacheEntry(netAddressBits address, long expirationTime)
+    : fAddress(address), fExpirationTime(expirationTime) {}
+
+  netAddressBits fAddress;
+  long fExpirationTime; // in seconds, as returned by "gettimeofday()"
+};
+
+class DNSLookupWaiter {
+public:
+  DNSLookupWaiter(DNSLookupHandler* handler, void* clientData, DNSLookupWaiter* next)
+    : fHandler(handler), fClientData(clientData), fNext(next) {}
+
+  DNSLookupHandler* fHandler;
+  void* fClientData;
+  DNSLookupWaiter* fNext;
+};
+
+class PendingLookup {
+public:
+  PendingLookup(DNSResolver& resolver, char const* hostName, PendingLookup* next)
+    : fResolver(resolver), fHostName(strDup(hostName)), fQueryId(0), fNumAttempts(0), fNameserver(0),
+      fTimeoutTask(NULL), fWaiters(NULL), fNext(next) {}
+  virtual ~PendingLookup() {
+    delete[] fHostName;
+    while (fWaiters != NULL) {
+      DNSLookupWaiter* next = fWaiters->fNext;
+      delete fWaiters; fWaiters = next;
+    }
+  }
+
+  void removeWaiters(void* clientData) {
+    DNSLookupWaiter** ptr = &fWaiters;
+    while (*ptr != NULL) {
+      if ((*ptr)->fClientData == clientData) {
+	DNSLookupWaiter* waiter = *ptr;
+	*ptr = waiter->fNext;
+	delete waiter;
+      } else {
+	ptr = &((*ptr)->fNext);
+      }
+    }
+  }
+
+  DNSResolver& fResolver;
+  char* fHostName;
+  u_int16_t fQueryId;
+  unsigned fNumAttempts;
+  netAddressBits fNameserver; // the nameserver that we sent our most recent query to
+  TaskToken fTimeoutTask;
+  DNSLookupWaiter* fWaiters;
+  PendingLookup* fNext;
+};
+
+static long currentTimeInSeconds() {
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  return timeNow.tv_sec;
+}
+
+// Converts a host name into the form that we use for our cache keys (and queries): lower case, without any trailing '.'.
+// Returns False if it's not a valid host name:
+static Boolean normalizeHostName(char const* hostName, char* result /* at least DNS_MAX_NAME_LENGTH+1 bytes */) {
+  unsigned length = strlen(hostName);
+  if (length > 0 && hostName[length-1] == '.') --length;
+  if (length == 0 || length > DNS_MAX_NAME_LENGTH) return False;
+
+  unsigned labelLength = 0;
+  for (unsigned i = 0; i < length; ++i) {
+    char c = hostName[i];
+    if (c == '.') {
+      if (labelLength == 0) return False;
+      labelLength = 0;
+    } else {
+      if (++labelLength > 63 || c <= ' ') return False;
+    }
+    result[i] = tolower(c);
+  }
+  if (labelLength == 0) return False;
+  result[length] = '\0';
+
+  return True;
+}
+
+
+static netAddressBits lookupSynchronously(char const* hostName) {
+  NetAddressList addresses(hostName);
+  return addresses.numAddresses() == 0 ? 0 : *(netAddressBits*)(addresses.firstAddress()->data());
+}
+
+
+////////// DNSResolver implementation //////////
+
+unsigned DNSResolver::queryTimeoutSeconds = 3;
+unsigned DNSResolver::queryAttemptsPerNameserver = 2;
+unsigned DNSResolver::maxCacheTTLSeconds = 3600;
+
+Boolean DNSResolver::lookup(UsageEnvironment& env, char const* hostName, netAddressBits& address,
+			    DNSLookupHandler* handler, void* clientData) {
+  DNSResolver* resolver = existingForEnvironment(env);
+  if (resolver == NULL) { // We need to create it
+    resolver = groupsockPriv(env)->dnsResolver = new DNSResolver(env);
+  }
+
+  Boolean result = resolver->lookup1(hostName, address, handler, clientData);
+  resolver->reclaimIfUnused(); // in case we answered immediately
+  return result;
+}
+
+void DNSResolver::cancelLookups(UsageEnvironment& env, void* clientData) {
+  DNSResolver* resolver = existingForEnvironment(env);
+  if (resolver == NULL) return; // no lookups have been made (or all have completed), so there's nothing to cancel
+
+  resolver->cancelLookups1(clientData);
+  resolver->reclaimIfUnused();
+}
+
+DNSResolver* DNSResolver::existingForEnvironment(UsageEnvironment& env) {
+  // Note: We don't call "groupsockPriv(env)" here, because that would create the "groupsockPriv" structure if necessary
+  _groupsockPriv* priv = (_groupsockPriv*)(env.groupsockPriv);
+  return priv == NULL ? NULL : priv->dnsResolver;
+}
+
+DNSResolver::DNSResolver(UsageEnvironment& env)
+  : fEnv(env), fNumNameservers(0), fSocketNum(-1), fCache(HashTable::create(STRING_HASH_KEYS)),
+    fPendingLookups(NULL), fCompletingLookup(NULL) {
+  readResolvConf();
+}
+
+DNSResolver::~DNSResolver() {
+  while (fPendingLookups != NULL) {
+    PendingLookup* next = fPendingLookups->fNext;
+    fEnv.taskScheduler().unscheduleDelayedTask(fPendingLookups->fTimeoutTask);
+    delete fPendingLookups; fPendingLookups = next;
+  }
+
+  if (fSocketNum >= 0) {
+    fEnv.taskScheduler().disableBackgroundHandling(fSocketNum);
+    ::closeSocket(fSocketNum);
+  }
+
+  flushCache();
+  delete fCache;
+}
+
+Boolean DNSResolver::lookup1(char const* hostName, netAddressBits& address, DNSLookupHandler* handler, void* clientData) {
+  char name[DNS_MAX_NAME_LENGTH+1];
+  if (!normalizeHostName(hostName, name)) {
+    address = 0;
+    return True;
+  }
+  if (lookupNow(name, address)) return True;
+
+  if (strchr(name, '.') == NULL) {
+    // A name without a '.' is probably relative to one of the system's 'search' domains (or is known only to some other
+    // name service), neither of which we handle ourself.  So let the system resolve it:
+    address = lookupSynchronously(name);
+    return True;
+  }
+
+  if (fNumNameservers > 0 && fSocketNum < 0) {
+    // This is our first query.  Set up the socket that we use to send queries (and receive responses):
+    fSocketNum = setupDatagramSocket(fEnv, 0);
+    if (fSocketNum >= 0) {
+      makeSocketNonBlocking(fSocketNum);
+      fEnv.taskScheduler().setBackgroundHandling(fSocketNum, SOCKET_READABLE,
+						 (TaskScheduler::BackgroundHandlerProc*)&incomingResponseHandler, this);
+    }
+  }
+  if (fSocketNum < 0) {
+    // We can't send DNS queries ourself, so resolve the name synchronously instead:
+    address = lookupSynchronously(name);
+    return True;
+  }
+
+  // If there's already a query pending for this name, then we just wait for its response.  Otherwise, send a new query:
+  PendingLookup* lookup;
+  for (lookup = fPendingLookups; lookup != NULL; lookup = lookup->fNext) {
+    if (strcmp(lookup->fHostName, name) == 0) break;
+  }
+  if (lookup == NULL) {
+    lookup = fPendingLookups = new PendingLookup(*this, name, fPendingLookups);
+    sendQuery(lookup);
+  }
+  lookup->fWaiters = new DNSLookupWaiter(handler, clientData, lookup->fWaiters);
+
+  return False;
+}
+
+void DNSResolver::cancelLookups1(void* clientData) {
+  PendingLookup** ptr = &fPendingLookups;
+  while (*ptr != NULL) {
+    PendingLookup* lookup = *ptr;
+    lookup->removeWaiters(clientData);
+    if (lookup->fWaiters == NULL) {
+      // Nobody is waiting for this lookup any more, so abandon it:
+      *ptr = lookup->fNext;
+      fEnv.taskScheduler().unscheduleDelayedTask(lookup->fTimeoutTask);
+      delete lookup;
+    } else {
+      ptr = &(lookup->fNext);
+    }
+  }
+  if (fCompletingLookup != NULL) fCompletingLookup->removeWaiters(clientData);
+}
+
+void DNSResolver::reclaimIfUnused() {
+  if (fPendingLookups != NULL || fCompletingLookup != NULL) return; // we're still in use
+
+  groupsockPriv(fEnv)->dnsResolver = NULL;
+  reclaimGroupsockPriv(fEnv);
+  delete this;
+}
+
+void DNSResolver::flushCache() {
+  DNSCacheEntry* entry;
+  while ((entry = (DNSCacheEntry*)fCache->RemoveNext()) != NULL) {
+    delete entry;
+  }
+}
+
+Boolean DNSResolver::lookupNow(char const* hostName, netAddressBits& address) {
+  // First, check whether "hostName" is an IP address string:
+  netAddressBits addr = our_inet_addr((char*)hostName);
+  if (addr != INADDR_NONE) {
+    address = addr;
+    return True;
+  }
+
+  // Then check our cache:
+  DNSCacheEntry* entry = (DNSCacheEntry*)fCache->Lookup(hostName);
+  if (entry != NULL) {
+    if (currentTimeInSeconds() < entry->fExpirationTime) {
+      address = entry->fAddress;
+      return True;
+    }
+    // This entry has expired:
+    fCache->Remove(hostName);
+    delete entry;
+  }
+
+  // Then check the 'hosts' file (which is small, and local, so reading it doesn't block for long):
+  return lookupHostsFile(hostName, address);
+}
+
+Boolean DNSResolver::lookupHostsFile(char const* hostName, netAddressBits& address) {
+  FILE* fid = fopen("/etc/hosts", "r");
+  if (fid == NULL) return False;
+
+  Boolean found = False;
+  char line[1024];
+  while (!found && fgets(line, sizeof line, fid) != NULL) {
+    char* comment = strchr(line, '#');
+    if (comment != NULL) *comment = '\0';
+
+    // Each line is "<address> <name> [<alias>...]":
+    char* token = strtok(line, " \t\r\n");
+    if (token == NULL) continue;
+    netAddressBits addr = our_inet_addr(token);
+    if (addr == INADDR_NONE) continue; // e.g., an IPv6 address
+
+    char name[DNS_MAX_NAME_LENGTH+1];
+    while ((token = strtok(NULL, " \t\r\n")) != NULL) {
+      if (normalizeHostName(token, name) && strcmp(name, hostName) == 0) {
+	address = addr;
+	found = True;
+	break;
+      }
+    }
+  }
+  fclose(fid);
+
+  return found;
+}
+
+void DNSResolver::readResolvConf() {
+  FILE* fid = fopen("/etc/resolv.conf", "r");
+  if (fid == NULL) return;
+
+  char line[1024];
+  char addressStr[100];
+  while (fNumNameservers < DNS_RESOLVER_MAX_NAMESERVERS && fgets(line, sizeof line, fid) != NULL) {
+    if (sscanf(line, " nameserver %99s", addressStr) != 1) continue;
+
+    netAddressBits addr = our_inet_addr(addressStr);
+    if (addr == INADDR_NONE) continue; // e.g., an IPv6 address
+    fNameservers[fNumNameservers++] = addr;
+  }
+  fclose(fid);
+}
+
+void DNSResolver::sendQuery(PendingLookup* lookup) {
+  lookup->fQueryId = (u_int16_t)our_random();
+  lookup->fNameserver = fNameservers[lookup->fNumAttempts%fNumNameservers];
+  ++lookup->fNumAttempts;
+
+  // Construct the query: A header, and a single question (for an IPv4 'A' record):
+  unsigned char query[DNS_MAX_MESSAGE_SIZE];
+  unsigned char* to = query;
+  *to++ = lookup->fQueryId>>8; *to++ = lookup->fQueryId;
+  *to++ = 0x01; *to++ = 0x00; // flags: a standard query, with 'recursion desired'
+  *to++ = 0; *to++ = 1; // QDCOUNT
+  *to++ = 0; *to++ = 0; // ANCOUNT
+  *to++ = 0; *to++ = 0; // NSCOUNT
+  *to++ = 0; *to++ = 0; // ARCOUNT
+
+  char const* label = lookup->fHostName; // note: this has already been checked (by "normalizeHostName()")
+  while (*label != '\0') {
+    char const* dot = strchr(label, '.');
+    unsigned labelLength = dot == NULL ? strlen(label) : (unsigned)(dot - label);
+    *to++ = labelLength;
+    memmove(to, label, labelLength);
+    to += labelLength;
+    label += labelLength;
+    if (*label == '.') ++label;
+  }
+  *to++ = 0;
+  *to++ = 0; *to++ = 1; // QTYPE: A
+  *to++ = 0; *to++ = 1; // QCLASS: IN
+
+  struct in_addr nameserverAddress;
+  nameserverAddress.s_addr = lookup->fNameserver;
+  writeSocket(fEnv, fSocketNum, nameserverAddress, Port(DNS_PORT), query, to - query);
+      // If this fails, then we'll just time out, and try again
+
+  lookup->fTimeoutTask = fEnv.taskScheduler().scheduleDelayedTask(queryTimeoutSeconds*1000000,
+								  (TaskFunc*)queryTimeoutHandler, lookup);
+}
+
+void DNSResolver::queryTimeoutHandler(void* clientData) {
+  PendingLookup* lookup = (PendingLookup*)clientData;
+  lookup->fTimeoutTask = NULL;
+  DNSResolver& resolver = lookup->fResolver;
+  resolver.queryTimeoutHandler1(lookup);
+  resolver.reclaimIfUnused();
+}
+
+void DNSResolver::queryTimeoutHandler1(PendingLookup* lookup) {
+  if (lookup->fNumAttempts >= queryAttemptsPerNameserver*fNumNameservers) {
+    completeLookup(lookup, 0, 0); // give up
+  } else {
+    sendQuery(lookup); // to the next nameserver (if there is one)
+  }
+}
+
+void DNSResolver::incomingResponseHandler(void* clientData, int /*mask*/) {
+  DNSResolver* resolver = (DNSResolver*)clientData;
+  resolver->incomingResponseHandler1();
+  resolver->reclaimIfUnused();
+}
+
+void DNSResolver::incomingResponseHandler1() {
+  unsigned char response[DNS_MAX_MESSAGE_SIZE];
+  struct sockaddr_in fromAddress;
+  int responseSize = readSocket(fEnv, fSocketNum, response, sizeof response, fromAddress);
+  if (responseSize < 12) return; // too short to be a DNS response (or an error)
+
+  // Find the lookup that this response is for.  (It must match both the query id, and the nameserver that we sent it to.):
+  u_int16_t const queryId = (response[0]<<8)|response[1];
+  PendingLookup* lookup;
+  for (lookup = fPendingLookups; lookup != NULL; lookup = lookup->fNext) {
+    if (lookup->fQueryId == queryId && lookup->fNameserver == fromAddress.sin_addr.s_addr) break;
+  }
+  if (lookup == NULL) return; // a late (or spoofed) response; ignore it
+
+  netAddressBits address;
+  unsigned ttl;
+  if (!parseResponse(response, (unsigned)responseSize, lookup, address, ttl)) return; // it wasn't a valid response
+
+  fEnv.taskScheduler().unscheduleDelayedTask(lookup->fTimeoutTask); lookup->fTimeoutTask = NULL;
+  if (ttl == ~0U) {
+    // The nameserver failed (rather than telling us that the name doesn't exist).  Try again (if we can):
+    queryTimeoutHandler1(lookup);
+  } else {
+    if (address == 0) {
+      // The nameserver says that there's no such host.  But the system might still know the name - from a 'search' domain,
+      // or some other name service - so try it that way before giving up:
+      address = lookupSynchronously(lookup->fHostName);
+      ttl = 0; // don't cache this answer, because it didn't come from DNS
+    }
+    completeLookup(lookup, address, ttl);
+  }
+}
+
+// Reads a (possibly compressed) domain name from a DNS message, advancing "pos" past it.  If "result" is non-NULL, then the
+// name is also copied there (in lower case, with '.'s between labels).  Returns False if the name is malformed:
+static Boolean readDNSName(unsigned char const* msg, unsigned msgSize, unsigned& pos, char* result /* DNS_MAX_NAME_LENGTH+1 bytes */) {
+  unsigned p = pos;
+  Boolean haveJumped = False;
+  unsigned numJumps = 0;
+  unsigned resultLength = 0;
+
+  while (1) {
+    if (p >= msgSize) return False;
+    unsigned char const labelLength = msg[p];
+    if (labelLength == 0) {
+      if (!haveJumped) pos = p+1;
+      break;
+    } else if ((labelLength&0xC0) == 0xC0) { // a compression pointer
+      if (p+1 >= msgSize || ++numJumps > 20) return False;
+      if (!haveJumped) pos = p+2;
+      haveJumped = True;
+      p = ((labelLength&0x3F)<<8)|msg[p+1];
+    } else if ((labelLength&0xC0) != 0) {
+      return False;
+    } else {
+      if (p+1+labelLength > msgSize) return False;
+      if (result != NULL) {
+	if (resultLength + (resultLength > 0) + labelLength > DNS_MAX_NAME_LENGTH) return False;
+	if (resultLength > 0) result[resultLength++] = '.';
+	for (unsigned i = 0; i < labelLength; ++i) result[resultLength++] = tolower(msg[p+1+i]);
+      }
+      p += 1+labelLength;
+    }
+  }
+  if (result != NULL) result[resultLength] = '\0';
+
+  return True;
+}
+
+Boolean DNSResolver::parseResponse(unsigned char* response, unsigned responseSize, PendingLookup* lookup,
+				   netAddressBits& address, unsigned& ttl) {
+  // Returns True, with "address" (0 if there's no such host) and "ttl" set, if "response" is a valid response to "lookup"s
+  // query.  "ttl" == ~0 means that the nameserver failed (so we should try again).
+  u_int16_t const flags = (response[2]<<8)|response[3];
+  if ((flags&0x8000) == 0) return False; // it's not a response
+  unsigned const qdCount = (response[4]<<8)|response[5];
+  unsigned const anCount = (response[6]<<8)|response[7];
+
+  unsigned pos = 12;
+  if (qdCount == 1) {
+    // Check that the response's question is the same as ours:
+    char name[DNS_MAX_NAME_LENGTH+1];
+    if (!readDNSName(response, responseSize, pos, name) || strcmp(name, lookup->fHostName) != 0) return False;
+    pos += 4; // QTYPE and QCLASS
+  } else if (qdCount != 0) {
+    return False;
+  }
+
+  unsigned const rcode = flags&0x000F;
+  if (rcode == 3/*NXDOMAIN*/) {
+    address = 0; ttl = 0;
+    return True;
+  } else if (rcode != 0) {
+    ttl = ~0U;
+    return True;
+  }
+
+  // Look for an 'A' record in the answers.  (Any CNAME records that precede it have already been followed by the nameserver.)
+  address = 0; ttl = maxCacheTTLSeconds;
+  for (unsigned i = 0; i < anCount; ++i) {
+    if (!readDNSName(response, responseSize, pos, NULL) || pos + 10 > responseSize) break;
+    unsigned const rrType = (response[pos]<<8)|response[pos+1];
+    unsigned const rrClass = (response[pos+2]<<8)|response[pos+3];
+    unsigned const rrTTL = (response[pos+4]<<24)|(response[pos+5]<<16)|(response[pos+6]<<8)|response[pos+7];
+    unsigned const rdLength = (response[pos+8]<<8)|response[pos+9];
+    pos += 10;
+    if (pos + rdLength > responseSize) break;
+
+    if (rrClass == 1/*IN*/ && (rrType == 1/*A*/ || rrType == 5/*CNAME*/)) {
+      if (rrTTL < ttl) ttl = rrTTL; // the answer is valid only as long as each record in its chain
+      if (rrType == 1 && rdLength == 4 && address == 0) memmove(&address, &response[pos], 4);
+    }
+    pos += rdLength;
+  }
+  if (address == 0) ttl = 0;
+
+  return True;
+}
+
+void DNSResolver::completeLookup(PendingLookup* lookup, netAddressBits address, unsigned ttl) {
+  // Remove "lookup" from our list of pending lookups:
+  PendingLookup** ptr = &fPendingLookups;
+  while (*ptr != lookup) ptr = &((*ptr)->fNext);
+  *ptr = lookup->fNext;
+  fEnv.taskScheduler().unscheduleDelayedTask(lookup->fTimeoutTask); lookup->fTimeoutTask = NULL;
+
+  // Cache the answer (for as long as the nameserver says that we can):
+  if (address != 0 && ttl > 0) {
+    if (ttl > maxCacheTTLSeconds) ttl = maxCacheTTLSeconds;
+    DNSCacheEntry* oldEntry
+      = (DNSCacheEntry*)fCache->Add(lookup->fHostName, new DNSCacheEntry(address, currentTimeInSeconds() + ttl));
+    delete oldEntry;
+  }
+
+  // Then tell each waiter about the answer.  (We do this one waiter at a time, because a handler might cancel other waiters.)
+  fCompletingLookup = lookup;
+  DNSLookupWaiter* waiter;
+  while ((waiter = lookup->fWaiters) != NULL) {
+    lookup->fWaiters = waiter->fNext;
+    (*waiter->fHandler)(waiter->fClientData, address);
+    delete waiter;
+  }
+  fCompletingLookup = NULL;
+
+  delete lookup;
+}
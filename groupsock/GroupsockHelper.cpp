@@ -55,6 +55,7 @@ _groupsockPriv* groupsockPriv(UsageEnvironment& env) {
     _groupsockPriv* result = new _groupsockPriv;
     result->socketTable = NULL;
     result->reuseFlag = 1; // default value => allow reuse of socket numbers
+    result->dnsResolver = NULL;
     env.groupsockPriv = result;
   }
   return (_groupsockPriv*)(env.groupsockPriv);
@@ -62,7 +63,7 @@ _groupsockPriv* groupsockPriv(UsageEnvironment& env) {
 
 void reclaimGroupsockPriv(UsageEnvironment& env) {
   _groupsockPriv* priv = (_groupsockPriv*)(env.groupsockPriv);
-  if (priv->socketTable == NULL && priv->reuseFlag == 1/*default value*/) {
+  if (priv->socketTable == NULL && priv->reuseFlag == 1/*default value*/ && priv->dnsResolver == NULL) {
     // We can delete the structure (to save space); it will get created again, if needed:
     delete priv;
     env.groupsockPriv = NULL;
@@ -87,6 +88,28 @@ static int createSocket(int type) {
   return sock;
 }
 
+int acceptStreamSocket(int serverSocket, struct sockaddr_in& clientAddr) {
+  SOCKLEN_T clientAddrLen = sizeof clientAddr;
+  int sock;
+
+#if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC) && defined(__linux__)
+  // Use "accept4()", to set both properties in the same system call:
+  sock = accept4(serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen, SOCK_NONBLOCK|SOCK_CLOEXEC);
+  if (sock != -1 || errno != ENOSYS) return sock;
+  // An "errno" of ENOSYS means that the kernel doesn't support "accept4()"; fall through and try again without it:
+  clientAddrLen = sizeof clientAddr;
+#endif
+
+  sock = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
+  if (sock < 0) return sock;
+
+  makeSocketNonBlocking(sock);
+#ifdef FD_CLOEXEC
+  fcntl(sock, F_SETFD, FD_CLOEXEC);
+#endif
+  return sock;
+}
+
 int setupDatagramSocket(UsageEnvironment& env, Port port) {
   if (!initializeWinsockIfNecessary()) {
     socketErr(env, "Failed to initialize 'winsock': ");
@@ -0,0 +1,90 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "mTunnel" multicast access service
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A non-blocking (i.e., event loop driven) resolver of host names into (IPv4) addresses, with a cache
+// C++ header
+
+#ifndef _DNS_RESOLVER_HH
+#define _DNS_RESOLVER_HH
+
+#ifndef _NET_ADDRESS_HH
+#include "NetAddress.hh"
+#endif
+
+typedef void DNSLookupHandler(void* clientData, netAddressBits address);
+    // "address" is 0 if the lookup failed
+
+#define DNS_RESOLVER_MAX_NAMESERVERS 3
+
+class DNSResolver {
+public:
+  static Boolean lookup(UsageEnvironment& env, char const* hostName, netAddressBits& address,
+			DNSLookupHandler* handler, void* clientData);
+      // If the address for "hostName" is known immediately - because "hostName" is an IP address string, or is in the
+      // 'hosts' file, or has an (unexpired) entry in our cache - then sets "address" (0 if "hostName" is invalid),
+      // and returns True.  Otherwise, sends a DNS query (if one isn't already pending for "hostName") and returns False;
+      // "handler(clientData, address)" will be called (from the event loop) once the answer (or a failure) arrives.
+      // Note: We resolve the name synchronously instead (using "NetAddressList", which - unlike us - knows about the
+      // system's 'search' domains, and name service configuration), returning True, if:
+      //   - "hostName" has no '.' (so it's probably relative to a 'search' domain, or is a local name), or
+      //   - there's no "nameserver" in the system's 'resolv.conf' file (e.g., on Windows).
+      // Also, if the nameserver says that a name doesn't exist, then we try it again synchronously before giving up.
+  static void cancelLookups(UsageEnvironment& env, void* clientData); // ensures that no handler will be called with "clientData"
+
+  // Parameters (these can be changed at any time):
+  static unsigned queryTimeoutSeconds; // default: 3
+  static unsigned queryAttemptsPerNameserver; // default: 2
+  static unsigned maxCacheTTLSeconds; // caps the TTL of cached answers; default: 3600
+
+  // Note: Each "UsageEnvironment"s resolver (and its cache) exists only while it has lookups pending.  (This lets the
+  // "UsageEnvironment" be reclaimed.)
+
+protected:
+  DNSResolver(UsageEnvironment& env); // called only by "lookup()"
+  virtual ~DNSResolver();
+
+private:
+  static DNSResolver* existingForEnvironment(UsageEnvironment& env);
+  Boolean lookup1(char const* hostName, netAddressBits& address, DNSLookupHandler* handler, void* clientData);
+  void cancelLookups1(void* clientData);
+  void reclaimIfUnused();
+  void flushCache();
+
+  Boolean lookupNow(char const* hostName, netAddressBits& address);
+  Boolean lookupHostsFile(char const* hostName, netAddressBits& address);
+  void readResolvConf();
+
+  void sendQuery(class PendingLookup* lookup);
+  static void queryTimeoutHandler(void* clientData);
+  void queryTimeoutHandler1(class PendingLookup* lookup);
+  static void incomingResponseHandler(void* clientData, int mask);
+  void incomingResponseHandler1();
+  Boolean parseResponse(unsigned char* response, unsigned responseSize, class PendingLookup* lookup,
+			netAddressBits& address, unsigned& ttl);
+  void completeLookup(class PendingLookup* lookup, netAddressBits address, unsigned ttl);
+
+private:
+  UsageEnvironment& fEnv;
+  netAddressBits fNameservers[DNS_RESOLVER_MAX_NAMESERVERS];
+  unsigned fNumNameservers;
+  int fSocketNum;
+  HashTable* fCache; // maps host names to "DNSCacheEntry"s
+  class PendingLookup* fPendingLookups; // a linked list
+  class PendingLookup* fCompletingLookup; // the lookup whose handlers we're currently calling (if any)
+};
+
+#endif
@@ -28,6 +28,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 int setupDatagramSocket(UsageEnvironment& env, Port port);
 int setupStreamSocket(UsageEnvironment& env,
 		      Port port, Boolean makeNonBlocking = True);
+int acceptStreamSocket(int serverSocket, struct sockaddr_in& clientAddr);
+    // Accepts a pending connection on "serverSocket", returning a socket that's non-blocking and 'close on exec'.
+    // Returns -1 (with "errno" set) if there's none.
 
 
 int readSocket(UsageEnvironment& env,
@@ -124,6 +127,7 @@ private:
 struct _groupsockPriv { // There should be only one of these allocated
   HashTable* socketTable;
   int reuseFlag;
+  class DNSResolver* dnsResolver;
 };
 _groupsockPriv* groupsockPriv(UsageEnvironment& env); // allocates it if necessary
 void reclaimGroupsockPriv(UsageEnvironment& env);
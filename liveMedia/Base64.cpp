@@ -22,6 +22,13 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <strDup.hh>
 #include <string.h>
 
+// On x86 with GCC or Clang, we also compile SSSE3 and AVX2 versions of the inner loops, and choose between them at run time.
+// (Everywhere else, we use only the portable code below.)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(NO_BASE64_SIMD)
+#define BASE64_SIMD 1
+#include <immintrin.h>
+#endif
+
 static char base64DecodeTable[256];
 
 static void initBase64DecodeTable() {
@@ -37,6 +44,197 @@ static void initBase64DecodeTable() {
   base64DecodeTable[(unsigned char)'='] = 0;
 }
 
+#ifdef BASE64_SIMD
+// Each of these decodes as many complete input blocks as it can, stopping early at the first block that contains
+// anything other than the 64 Base64 alphabet characters ('=' padding included).  The remainder is left to the scalar code.
+// The 'out' pointer may trail the 'in' pointer (for in-place decoding), because each store lands wholly before the next load.
+// Each returns the number of input bytes consumed (always a multiple of 4).
+
+__attribute__((target("ssse3")))
+static unsigned base64DecodeSSSE3(unsigned char const* in, unsigned inSize, unsigned char* out) {
+  __m128i const lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+				      0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  __m128i const lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+				      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  __m128i const lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i const nibbleMask = _mm_set1_epi8(0x0F);
+  __m128i const slash = _mm_set1_epi8('/');
+  __m128i const pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  unsigned consumed = 0;
+  // We store 16 bytes (of which 12 are valid) per 16 input bytes, so stop while there's still enough input left
+  // to guarantee that the over-written bytes fall within the caller's ("3*(inSize/4)"-byte) output buffer:
+  while (inSize - consumed >= 24) {
+    __m128i const src = _mm_loadu_si128((__m128i const*)(in + consumed));
+    __m128i const hiNibbles = _mm_and_si128(_mm_srli_epi32(src, 4), nibbleMask);
+    __m128i const loNibbles = _mm_and_si128(src, nibbleMask);
+    __m128i const lo = _mm_shuffle_epi8(lutLo, loNibbles);
+    __m128i const hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) break; // not pure Base64
+
+    __m128i const isSlash = _mm_cmpeq_epi8(src, slash);
+    __m128i const roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(isSlash, hiNibbles));
+    __m128i const values = _mm_add_epi8(src, roll);
+
+    __m128i const mergedAB = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i const merged = _mm_madd_epi16(mergedAB, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(merged, pack));
+
+    consumed += 16;
+    out += 12;
+  }
+  return consumed;
+}
+
+__attribute__((target("avx2")))
+static unsigned base64DecodeAVX2(unsigned char const* in, unsigned inSize, unsigned char* out) {
+  __m256i const lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+					 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+					 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+					 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  __m256i const lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+					 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+					 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+					 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  __m256i const lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+					   0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i const nibbleMask = _mm256_set1_epi8(0x0F);
+  __m256i const slash = _mm256_set1_epi8('/');
+  __m256i const pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+					2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  __m256i const gather = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+  unsigned consumed = 0;
+  // As above: we store 32 bytes (24 valid) per 32 input bytes, so leave enough input for the over-write to be safe:
+  while (inSize - consumed >= 48) {
+    __m256i const src = _mm256_loadu_si256((__m256i const*)(in + consumed));
+    __m256i const hiNibbles = _mm256_and_si256(_mm256_srli_epi32(src, 4), nibbleMask);
+    __m256i const loNibbles = _mm256_and_si256(src, nibbleMask);
+    __m256i const lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+    __m256i const hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+    if (!_mm256_testz_si256(lo, hi)) break; // not pure Base64
+
+    __m256i const isSlash = _mm256_cmpeq_epi8(src, slash);
+    __m256i const roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(isSlash, hiNibbles));
+    __m256i const values = _mm256_add_epi8(src, roll);
+
+    __m256i const mergedAB = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i const merged = _mm256_madd_epi16(mergedAB, _mm256_set1_epi32(0x00011000));
+    __m256i const packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(merged, pack), gather);
+    _mm256_storeu_si256((__m256i*)out, packed);
+
+    consumed += 32;
+    out += 24;
+  }
+  return consumed;
+}
+
+// Each of these encodes as many complete 3-byte groups as it can (while it can safely over-read the input),
+// and returns the number of input bytes consumed (always a multiple of 3).
+
+__attribute__((target("ssse3")))
+static inline __m128i base64EncodeIndicesSSSE3(__m128i in) {
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  __m128i const t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  __m128i const t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  __m128i const t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  __m128i const t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  __m128i const indices = _mm_or_si128(t1, t3);
+
+  // Map each 6-bit index to its character, by adding an offset that depends upon which range the index falls in:
+  __m128i const shiftLUT = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+					 '/' - 63, 'A', 0, 0);
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  __m128i const less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  range = _mm_or_si128(range, _mm_and_si128(less, _mm_set1_epi8(13)));
+  return _mm_add_epi8(_mm_shuffle_epi8(shiftLUT, range), indices);
+}
+
+__attribute__((target("ssse3")))
+static unsigned base64EncodeSSSE3(unsigned char const* orig, unsigned origLength, char* out) {
+  unsigned consumed = 0;
+  while (origLength - consumed >= 16) { // we load 16 bytes, but use only 12
+    __m128i const src = _mm_loadu_si128((__m128i const*)(orig + consumed));
+    _mm_storeu_si128((__m128i*)out, base64EncodeIndicesSSSE3(src));
+    consumed += 12;
+    out += 16;
+  }
+  return consumed;
+}
+
+__attribute__((target("avx2")))
+static unsigned base64EncodeAVX2(unsigned char const* orig, unsigned origLength, char* out) {
+  __m256i const shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+					  10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  __m256i const shiftLUT = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+					    '/' - 63, 'A', 0, 0,
+					    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+					    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+					    '/' - 63, 'A', 0, 0);
+  unsigned consumed = 0;
+  while (origLength - consumed >= 28) { // each 128-bit lane loads 16 bytes (starting 12 bytes apart), but uses only 12
+    __m128i const srcLo = _mm_loadu_si128((__m128i const*)(orig + consumed));
+    __m128i const srcHi = _mm_loadu_si128((__m128i const*)(orig + consumed + 12));
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(srcLo), srcHi, 1);
+
+    in = _mm256_shuffle_epi8(in, shuffle);
+    __m256i const t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00));
+    __m256i const t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    __m256i const t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0));
+    __m256i const t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    __m256i const indices = _mm256_or_si256(t1, t3);
+
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i const less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    range = _mm256_or_si256(range, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    _mm256_storeu_si256((__m256i*)out, _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, range), indices));
+
+    consumed += 24;
+    out += 32;
+  }
+  return consumed;
+}
+
+enum Base64SIMDLevel { BASE64_SIMD_UNKNOWN, BASE64_SIMD_NONE, BASE64_SIMD_SSSE3, BASE64_SIMD_AVX2 };
+
+static Base64SIMDLevel base64CPUSIMDLevel() {
+  static Base64SIMDLevel level = BASE64_SIMD_UNKNOWN;
+  if (level == BASE64_SIMD_UNKNOWN) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) level = BASE64_SIMD_AVX2;
+    else if (__builtin_cpu_supports("ssse3")) level = BASE64_SIMD_SSSE3;
+    else level = BASE64_SIMD_NONE;
+  }
+  return level;
+}
+
+static Base64SIMDLevel base64MaxSIMDLevel = BASE64_SIMD_AVX2; // see "base64SetMaxSIMDLevel()"
+
+static Base64SIMDLevel base64SIMDLevel() {
+  Base64SIMDLevel level = base64CPUSIMDLevel();
+  return level < base64MaxSIMDLevel ? level : base64MaxSIMDLevel;
+}
+#endif
+
+unsigned base64SetMaxSIMDLevel(unsigned maxLevel) {
+#ifdef BASE64_SIMD
+  base64MaxSIMDLevel = maxLevel >= 2 ? BASE64_SIMD_AVX2 : maxLevel == 1 ? BASE64_SIMD_SSSE3 : BASE64_SIMD_NONE;
+  return base64SIMDLevel() - BASE64_SIMD_NONE;
+#else
+  return 0;
+#endif
+}
+
+unsigned base64DecodedMaxSize(unsigned inSize) {
+  return 3*(inSize/4);
+}
+
+unsigned base64EncodedSize(unsigned origLength) {
+  return 4*((origLength+2)/3);
+}
+
 unsigned char* base64Decode(char const* in, unsigned& resultSize,
 			    Boolean trimTrailingZeros) {
   if (in == NULL) return NULL; // sanity check
@@ -46,58 +244,108 @@ unsigned char* base64Decode(char const* in, unsigned& resultSize,
 unsigned char* base64Decode(char const* in, unsigned inSize,
 			    unsigned& resultSize,
 			    Boolean trimTrailingZeros) {
+  if (in == NULL) return NULL; // sanity check
+
+  unsigned char* result = new unsigned char[base64DecodedMaxSize(inSize) + 1]; // "+1" so that we never allocate 0 bytes
+  resultSize = base64DecodeToBuffer(in, inSize, result, trimTrailingZeros);
+
+  return result;
+}
+
+unsigned base64DecodeToBuffer(char const* inSigned, unsigned inSize, unsigned char* to,
+			      Boolean trimTrailingZeros) {
   static Boolean haveInitializedBase64DecodeTable = False;
   if (!haveInitializedBase64DecodeTable) {
     initBase64DecodeTable();
     haveInitializedBase64DecodeTable = True;
   }
 
-  unsigned char* out = (unsigned char*)strDupSize(in); // ensures we have enough space
-  int k = 0;
-  int paddingCount = 0;
-  int const jMax = inSize - 3;
+  unsigned char const* in = (unsigned char const*)inSigned;
+  unsigned const inSizeRounded = inSize&~3;
      // in case "inSize" is not a multiple of 4 (although it should be)
-  for (int j = 0; j < jMax; j += 4) {
-    char inTmp[4], outTmp[4];
+  unsigned j = 0;
+  unsigned k = 0;
+
+#ifdef BASE64_SIMD
+  // Decode the bulk of the input - up to any padding or invalid characters - using vector instructions:
+  switch (base64SIMDLevel()) {
+    case BASE64_SIMD_AVX2: {
+      j = base64DecodeAVX2(in, inSizeRounded, to);
+      k = (j/4)*3;
+      // fall through, to let SSSE3 code handle part of the tail
+    }
+    case BASE64_SIMD_SSSE3: {
+      unsigned const n = base64DecodeSSSE3(&in[j], inSizeRounded - j, &to[k]);
+      j += n; k += (n/4)*3;
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+#endif
+
+  int paddingCount = 0;
+  for (; j < inSizeRounded; j += 4) {
+    char outTmp[4];
     for (int i = 0; i < 4; ++i) {
-      inTmp[i] = in[i+j];
-      if (inTmp[i] == '=') ++paddingCount;
-      outTmp[i] = base64DecodeTable[(unsigned char)inTmp[i]];
+      if (in[i+j] == '=') ++paddingCount;
+      outTmp[i] = base64DecodeTable[in[i+j]];
       if ((outTmp[i]&0x80) != 0) outTmp[i] = 0; // this happens only if there was an invalid character; pretend that it was 'A'
     }
 
-    out[k++] = (outTmp[0]<<2) | (outTmp[1]>>4);
-    out[k++] = (outTmp[1]<<4) | (outTmp[2]>>2);
-    out[k++] = (outTmp[2]<<6) | outTmp[3];
+    to[k++] = (outTmp[0]<<2) | (outTmp[1]>>4);
+    to[k++] = (outTmp[1]<<4) | (outTmp[2]>>2);
+    to[k++] = (outTmp[2]<<6) | outTmp[3];
   }
 
   if (trimTrailingZeros) {
-    while (paddingCount > 0 && k > 0 && out[k-1] == '\0') { --k; --paddingCount; }
+    while (paddingCount > 0 && k > 0 && to[k-1] == '\0') { --k; --paddingCount; }
   }
-  resultSize = k;
-  unsigned char* result = new unsigned char[resultSize];
-  memmove(result, out, resultSize);
-  delete[] out;
 
-  return result;
+  return k;
 }
 
 static const char base64Char[] =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-char* base64Encode(char const* origSigned, unsigned origLength) {
-  unsigned char const* orig = (unsigned char const*)origSigned; // in case any input bytes have the MSB set
+char* base64Encode(char const* orig, unsigned origLength) {
   if (orig == NULL) return NULL;
 
+  char* result = new char[base64EncodedSize(origLength)+1]; // allow for trailing '\0'
+  base64EncodeToBuffer(orig, origLength, result);
+
+  return result;
+}
+
+unsigned base64EncodeToBuffer(char const* origSigned, unsigned origLength, char* result) {
+  unsigned char const* orig = (unsigned char const*)origSigned; // in case any input bytes have the MSB set
+
   unsigned const numOrig24BitValues = origLength/3;
   Boolean havePadding = origLength > numOrig24BitValues*3;
   Boolean havePadding2 = origLength == numOrig24BitValues*3 + 2;
   unsigned const numResultBytes = 4*(numOrig24BitValues + havePadding);
-  char* result = new char[numResultBytes+1]; // allow for trailing '\0'
 
-  // Map each full group of 3 input bytes into 4 output base-64 characters:
-  unsigned i;
-  for (i = 0; i < numOrig24BitValues; ++i) {
+  unsigned i = 0;
+#ifdef BASE64_SIMD
+  // Encode the bulk of the input using vector instructions:
+  switch (base64SIMDLevel()) {
+    case BASE64_SIMD_AVX2: {
+      i = base64EncodeAVX2(orig, origLength, result)/3;
+      // fall through, to let SSSE3 code handle part of the tail
+    }
+    case BASE64_SIMD_SSSE3: {
+      i += base64EncodeSSSE3(&orig[3*i], origLength - 3*i, &result[4*i])/3;
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+#endif
+
+  // Map each remaining full group of 3 input bytes into 4 output base-64 characters:
+  for (; i < numOrig24BitValues; ++i) {
     result[4*i+0] = base64Char[(orig[3*i]>>2)&0x3F];
     result[4*i+1] = base64Char[(((orig[3*i]&0x3)<<4) | (orig[3*i+1]>>4))&0x3F];
     result[4*i+2] = base64Char[((orig[3*i+1]<<2) | (orig[3*i+2]>>6))&0x3F];
@@ -118,5 +366,5 @@ char* base64Encode(char const* origSigned, unsigned origLength) {
   }
 
   result[numResultBytes] = '\0';
-  return result;
+  return numResultBytes;
 }
@@ -33,6 +33,7 @@ void BitVector::setup(unsigned char* baseBytePtr,
   fBaseBitOffset = baseBitOffset;
   fTotNumBits = totNumBits;
   fCurBitIndex = 0;
+  invalidateCache();
 }
 
 static unsigned char const singleBitMask[8]
@@ -43,7 +44,6 @@ static unsigned char const singleBitMask[8]
 void BitVector::putBits(unsigned from, unsigned numBits) {
   if (numBits == 0) return; 
 
-  unsigned char tmpBuf[4];
   unsigned overflowingBits = 0;
 
   if (numBits > MAX_LENGTH) {
@@ -54,15 +54,30 @@ void BitVector::putBits(unsigned from, unsigned numBits) {
     overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
   }
 
-  tmpBuf[0] = (unsigned char)(from>>24);
-  tmpBuf[1] = (unsigned char)(from>>16);
-  tmpBuf[2] = (unsigned char)(from>>8);
-  tmpBuf[3] = (unsigned char)from;
+  // Write the high-order "numBits - overflowingBits" bits of the (low-order "numBits" bits of) "from", at most a byte at a
+  // time (rather than a bit at a time, as "shiftBits()" would):
+  unsigned numBitsToWrite = numBits - overflowingBits;
+  if (numBitsToWrite == 0) return;
+  unsigned value = (from & (0xFFFFFFFF >> (MAX_LENGTH - numBits))) >> overflowingBits;
+  unsigned totBitOffset = fBaseBitOffset + fCurBitIndex;
+  fCurBitIndex += numBitsToWrite;
+
+  while (numBitsToWrite > 0) {
+    unsigned bitRem = totBitOffset%8;
+    unsigned numBitsInThisByte = 8 - bitRem;
+    if (numBitsInThisByte > numBitsToWrite) numBitsInThisByte = numBitsToWrite;
+
+    unsigned shift = 8 - bitRem - numBitsInThisByte;
+    unsigned char mask = (unsigned char)(((1<<numBitsInThisByte) - 1) << shift);
+    unsigned char bits = (unsigned char)(((value >> (numBitsToWrite - numBitsInThisByte)) << shift) & mask);
+    unsigned char& toByte = fBaseBytePtr[totBitOffset/8];
+    toByte = (toByte &~ mask) | bits;
+
+    totBitOffset += numBitsInThisByte;
+    numBitsToWrite -= numBitsInThisByte;
+  }
 
-  shiftBits(fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* to */
-	    tmpBuf, MAX_LENGTH - numBits, /* from */
-	    numBits - overflowingBits /* num bits */);
-  fCurBitIndex += numBits - overflowingBits;
+  invalidateCache();
 }
 
 void BitVector::put1Bit(unsigned bit) {
@@ -77,32 +92,33 @@ void BitVector::put1Bit(unsigned bit) {
     } else {
       fBaseBytePtr[totBitOffset/8] &=~ mask;
     }
+    invalidateCache();
   }
 }
 
-unsigned BitVector::getBits(unsigned numBits) {
-  if (numBits == 0) return 0;
-
-  unsigned char tmpBuf[4];
-  unsigned overflowingBits = 0;
-
-  if (numBits > MAX_LENGTH) {
-    numBits = MAX_LENGTH;
+inline unsigned BitVector::cachedBits(unsigned numBits) {
+  // Returns the next "numBits" bits (without consuming them), usually from our 64-bit cache, rather than from the bytes:
+  unsigned offsetInCache = fCurBitIndex - fCacheBitIndex;
+  if (offsetInCache + numBits > fCacheNumBits) {
+    if (fCacheBitIndex + fCacheNumBits < fTotNumBits) {
+      // The cache doesn't hold all of the bits that we want (and there are more in the vector), so refill it:
+      fillCache();
+      offsetInCache = 0;
+    } else if (offsetInCache >= 64) {
+      return 0; // we're at the end of the vector
+    }
   }
 
-  if (numBits > fTotNumBits - fCurBitIndex) {
-    overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
-  }
+  // Any bits beyond the end of the vector are 0 in the cache, so overflow bits are 0:
+  return (unsigned)((fCache << offsetInCache) >> (64 - numBits));
+}
 
-  shiftBits(tmpBuf, 0, /* to */
-	    fBaseBytePtr, fBaseBitOffset + fCurBitIndex, /* from */
-	    numBits - overflowingBits /* num bits */);
-  fCurBitIndex += numBits - overflowingBits;
+unsigned BitVector::getBits(unsigned numBits) {
+  if (numBits == 0) return 0;
+  if (numBits > MAX_LENGTH) numBits = MAX_LENGTH;
 
-  unsigned result
-    = (tmpBuf[0]<<24) | (tmpBuf[1]<<16) | (tmpBuf[2]<<8) | tmpBuf[3];
-  result >>= (MAX_LENGTH - numBits); // move into low-order part of word
-  result &= (0xFFFFFFFF << overflowingBits); // so any overflow bits are 0
+  unsigned result = cachedBits(numBits);
+  skipBits(numBits);
   return result;
 }
 
@@ -112,13 +128,20 @@ unsigned BitVector::get1Bit() {
   if (fCurBitIndex >= fTotNumBits) { /* overflow */
     return 0;
   } else {
-    unsigned totBitOffset = fBaseBitOffset + fCurBitIndex++;
-    unsigned char curFromByte = fBaseBytePtr[totBitOffset/8];
-    unsigned result = (curFromByte >> (7-(totBitOffset%8))) & 0x01;
+    unsigned result = cachedBits(1);
+    ++fCurBitIndex;
     return result;
   }
 }
 
+unsigned BitVector::peekBits(unsigned numBits) {
+  // This is equivalent to "getBits(numBits)" (without advancing "fCurBitIndex"):
+  if (numBits == 0) return 0;
+  if (numBits > MAX_LENGTH) numBits = MAX_LENGTH;
+
+  return cachedBits(numBits);
+}
+
 void BitVector::skipBits(unsigned numBits) {
   if (numBits > fTotNumBits - fCurBitIndex) { /* overflow */
     fCurBitIndex = fTotNumBits;
@@ -127,7 +150,36 @@ void BitVector::skipBits(unsigned numBits) {
   }
 }
 
+static inline unsigned numLeadingZeroBits(unsigned long long word) { // "word" != 0
+#if defined(__GNUC__)
+  return __builtin_clzll(word);
+#else
+  unsigned result = 0;
+  while ((word & (1ULL<<63)) == 0) { word <<= 1; ++result; }
+  return result;
+#endif
+}
+
 unsigned BitVector::get_expGolomb() {
+  // The common case - a code of no more than 32 bits, all within the vector - is handled by counting the leading zero bits
+  // in our cache (refilling it at most once), rather than reading the code a bit at a time:
+  for (unsigned i = 0; i < 2; ++i) {
+    unsigned offsetInCache = fCurBitIndex - fCacheBitIndex;
+    if (offsetInCache < fCacheNumBits) {
+      unsigned long long nextBits = fCache << offsetInCache; // bits beyond "fCacheNumBits" are 0
+      if (nextBits != 0) {
+	unsigned codeLength = 2*numLeadingZeroBits(nextBits) + 1;
+	if (codeLength <= MAX_LENGTH && codeLength <= fCacheNumBits - offsetInCache) {
+	  fCurBitIndex += codeLength;
+	  return (unsigned)(nextBits >> (64 - codeLength)) - 1;
+	}
+      }
+    }
+    if (fCacheBitIndex + fCacheNumBits >= fTotNumBits) break; // the cache already extends to the end of the vector
+    fillCache();
+  }
+
+  // Otherwise, read the code a bit at a time:
   unsigned numLeadingZeroBits = 0;
   unsigned codeStart = 1;
 
@@ -139,6 +191,39 @@ unsigned BitVector::get_expGolomb() {
   return codeStart - 1 + getBits(numLeadingZeroBits);
 }
 
+void BitVector::fillCache() {
+  // Load (up to) 8 bytes, beginning with the one that contains the bit at "fCurBitIndex":
+  unsigned totBitOffset = fBaseBitOffset + fCurBitIndex;
+  unsigned char const* fromPtr = &fBaseBytePtr[totBitOffset/8];
+  unsigned bitRem = totBitOffset%8;
+  unsigned numBitsAvailable = fTotNumBits - fCurBitIndex;
+  unsigned numBytes = (bitRem + numBitsAvailable + 7)/8; // we don't read any bytes beyond these
+  if (numBytes > 8) numBytes = 8;
+
+  unsigned long long word;
+  if (numBytes == 8) {
+    word = ((unsigned long long)((fromPtr[0]<<24) | (fromPtr[1]<<16) | (fromPtr[2]<<8) | fromPtr[3]) << 32)
+      | (unsigned)((fromPtr[4]<<24) | (fromPtr[5]<<16) | (fromPtr[6]<<8) | fromPtr[7]);
+  } else {
+    word = 0;
+    for (unsigned i = 0; i < 8; ++i) {
+      word <<= 8;
+      if (i < numBytes) word |= fromPtr[i];
+    }
+  }
+
+  fCacheBitIndex = fCurBitIndex;
+  fCacheNumBits = 64 - bitRem;
+  if (fCacheNumBits > numBitsAvailable) fCacheNumBits = numBitsAvailable;
+  fCache = fCacheNumBits == 0 ? 0 : (word << bitRem) & (~0ULL << (64 - fCacheNumBits));
+}
+
+void BitVector::invalidateCache() {
+  fCache = 0;
+  fCacheBitIndex = fCurBitIndex;
+  fCacheNumBits = 0;
+}
+
 
 void shiftBits(unsigned char* toBasePtr, unsigned toBitOffset,
 	       unsigned char const* fromBasePtr, unsigned fromBitOffset,
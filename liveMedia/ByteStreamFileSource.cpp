@@ -68,12 +68,20 @@ void ByteStreamFileSource::seekToEnd() {
   SeekFile64(fFid, 0, SEEK_END);
 }
 
+void ByteStreamFileSource::followGrowingFile(unsigned idleTimeoutSeconds, unsigned pollIntervalMS) {
+  fFollowGrowingFile = fFidIsSeekable;
+  fFollowIdleTimeoutMS = idleTimeoutSeconds*1000;
+  fFollowPollIntervalMS = pollIntervalMS == 0 ? 1 : pollIntervalMS;
+  fFollowIdleMS = 0;
+}
+
 ByteStreamFileSource::ByteStreamFileSource(UsageEnvironment& env, FILE* fid,
 					   unsigned preferredFrameSize,
 					   unsigned playTimePerFrame)
   : FramedFileSource(env, fid), fFileSize(0), fPreferredFrameSize(preferredFrameSize),
     fPlayTimePerFrame(playTimePerFrame), fLastPlayTime(0),
-    fHaveStartedReading(False), fLimitNumBytesToStream(False), fNumBytesToStream(0) {
+    fHaveStartedReading(False), fLimitNumBytesToStream(False), fNumBytesToStream(0),
+    fFollowGrowingFile(False), fFollowIdleTimeoutMS(0), fFollowPollIntervalMS(0), fFollowIdleMS(0) {
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
   makeSocketNonBlocking(fileno(fFid));
 #endif
@@ -93,6 +101,8 @@ ByteStreamFileSource::~ByteStreamFileSource() {
 }
 
 void ByteStreamFileSource::doGetNextFrame() {
+  if (fFollowGrowingFile && feof(fFid) && !ferror(fFid)) clearerr(fFid); // more data might have been appended since
+
   if (feof(fFid) || ferror(fFid) || (fLimitNumBytesToStream && fNumBytesToStream == 0)) {
     handleClosure();
     return;
@@ -110,6 +120,26 @@ void ByteStreamFileSource::doGetNextFrame() {
 #endif
 }
 
+void ByteStreamFileSource::retryReadingFromFile(ByteStreamFileSource* source) {
+  source->nextTask() = NULL;
+  source->doGetNextFrame();
+}
+
+void ByteStreamFileSource::awaitMoreFileData() {
+  if (fFollowIdleTimeoutMS > 0 && fFollowIdleMS >= fFollowIdleTimeoutMS) {
+    // The file has stopped growing, so treat this as EOF:
+    handleClosure();
+    return;
+  }
+
+  // Stop reading (because - for a regular file - background read handling would just tell us, repeatedly, that we're at EOF),
+  // and look again later:
+  doStopGettingFrames();
+  fFollowIdleMS += fFollowPollIntervalMS;
+  nextTask() = envir().taskScheduler().scheduleDelayedTask(fFollowPollIntervalMS*1000,
+							  (TaskFunc*)retryReadingFromFile, this);
+}
+
 void ByteStreamFileSource::doStopGettingFrames() {
   envir().taskScheduler().unscheduleDelayedTask(nextTask());
 #ifndef READ_FROM_FILES_SYNCHRONOUSLY
@@ -144,11 +174,18 @@ void ByteStreamFileSource::doReadFromFile() {
     fFrameSize = read(fileno(fFid), fTo, fMaxSize);
   }
 #endif
+  if (fFollowGrowingFile && (fFrameSize == 0 || (fPreferredFrameSize > 0 && fFrameSize < fMaxSize))) {
+    // We're at the (current) end of a file that's still being written.  Put back any incomplete frame, and try again later:
+    if (fFrameSize > 0) SeekFile64(fFid, -(int64_t)fFrameSize, SEEK_CUR);
+    awaitMoreFileData();
+    return;
+  }
   if (fFrameSize == 0) {
     handleClosure();
     return;
   }
   fNumBytesToStream -= fFrameSize;
+  fFollowIdleMS = 0;
 
   // Set the 'presentation time':
   if (fPlayTimePerFrame > 0 && fPreferredFrameSize > 0) {
@@ -0,0 +1,382 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A filter that records the most recent frames of a live stream (up to a given number of seconds, and bytes) in a ring
+// buffer, indexed by presentation time, so that clients can play the stream from a point in the recent past (i.e.,
+// 'time-shift' it), and then catch up with the live stream.
+// Implementation
+
+#include "DVRBuffer.hh"
+#include "GOPCache.hh"
+#include <string.h>
+
+static Boolean isEarlier(struct timeval const& t1, struct timeval const& t2) {
+  return t1.tv_sec < t2.tv_sec || (t1.tv_sec == t2.tv_sec && t1.tv_usec < t2.tv_usec);
+}
+
+static double secondsBetween(struct timeval const& t1, struct timeval const& t2) {
+  return (t2.tv_sec - t1.tv_sec) + (t2.tv_usec - t1.tv_usec)/1000000.0;
+}
+
+////////// DVRBuffer implementation //////////
+
+DVRBuffer* DVRBuffer::createNew(UsageEnvironment& env, FramedSource* inputSource, char const* codecName,
+				unsigned maxSeconds, unsigned maxBytes) {
+  return new DVRBuffer(env, inputSource, codecName, maxSeconds, maxBytes);
+}
+
+DVRBuffer::DVRBuffer(UsageEnvironment& env, FramedSource* inputSource, char const* codecName,
+		     unsigned maxSeconds, unsigned maxBytes)
+  : FramedFilter(env, inputSource),
+    fIsH264or5(strcmp(codecName, "H264") == 0 || strcmp(codecName, "H265") == 0), fIsH265(strcmp(codecName, "H265") == 0),
+    fMaxSeconds(maxSeconds), fMaxBytes(maxBytes),
+    fIsRecording(False), fLastRecordWasKey(False), fHaveLiveGOP(False), fLiveGOPStartRecordNum(0),
+    fNextFrameNum(0),
+    fRecords(NULL), fFirstRecordIndex(0), fNumRecords(0), fMaxNumRecords(0), fFirstRecordNum(0),
+    fData(NULL), fDataSize(0), fDataBufferSize(0), fNextOffset(0) {
+}
+
+DVRBuffer::~DVRBuffer() {
+  delete[] fRecords;
+  delete[] fData;
+}
+
+void DVRBuffer::noteDiscontinuity() {
+  fIsRecording = False;
+  fHaveLiveGOP = False;
+}
+
+double DVRBuffer::recordedSeconds() const {
+  if (fNumRecords == 0) return 0.0;
+
+  DVRBuffer* self = (DVRBuffer*)this; // because "record()" isn't "const"
+  return secondsBetween(self->record(fFirstRecordNum).presentationTime, self->record(endRecordNum()-1).presentationTime);
+}
+
+void DVRBuffer::doGetNextFrame() {
+  fInputSource->getNextFrame(fTo, fMaxSize, afterGettingFrame, this, FramedSource::handleClosure, this);
+}
+
+void DVRBuffer::afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				  struct timeval presentationTime, unsigned durationInMicroseconds) {
+  ((DVRBuffer*)clientData)->afterGettingFrame(frameSize, numTruncatedBytes, presentationTime, durationInMicroseconds);
+}
+
+void DVRBuffer::afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes,
+				  struct timeval presentationTime, unsigned durationInMicroseconds) {
+  fFrameSize = frameSize;
+  fNumTruncatedBytes = numTruncatedBytes;
+  fPresentationTime = presentationTime;
+  fDurationInMicroseconds = durationInMicroseconds;
+
+  if (frameSize > 0 && numTruncatedBytes == 0) recordFrame();
+  else noteDiscontinuity(); // the GOP that this frame belongs to can't be played from our buffer
+  ++fNextFrameNum;
+
+  // Complete delivery (of the frame, unchanged):
+  FramedSource::afterGetting(this);
+}
+
+void DVRBuffer::recordFrame() {
+  Boolean isGOPStart = True; // for codecs other than H.264 and H.265, playback can begin at any frame
+  if (fIsH264or5) {
+    GOPCache::NALKind const kind = GOPCache::nalKind(fTo[0], fIsH265);
+
+    isGOPStart = kind == GOPCache::KEY_NAL && !(fIsRecording && fLastRecordWasKey);
+    if (!isGOPStart && !fIsRecording) return; // we're waiting for a key frame; don't record this NAL unit
+    if (kind != GOPCache::NEUTRAL_NAL) fLastRecordWasKey = kind == GOPCache::KEY_NAL;
+  }
+
+  unsigned offset;
+  if (!makeRoomFor(fFrameSize, isGOPStart, offset)) {
+    // We can't record this frame (or - because we've had to discard the start of its GOP - the rest of its GOP):
+    noteDiscontinuity();
+    return;
+  }
+
+  if (fNumRecords == fMaxNumRecords) {
+    // Grow our ring of records (keeping them in order, from the start of the new ring):
+    unsigned newMaxNumRecords = fMaxNumRecords == 0 ? 256 : 2*fMaxNumRecords;
+    Record* newRecords = new Record[newMaxNumRecords];
+    for (unsigned i = 0; i < fNumRecords; ++i) newRecords[i] = record(fFirstRecordNum + i);
+    delete[] fRecords; fRecords = newRecords;
+    fFirstRecordIndex = 0;
+    fMaxNumRecords = newMaxNumRecords;
+  }
+
+  u_int64_t const recordNum = endRecordNum();
+  if (isGOPStart) {
+    fIsRecording = fHaveLiveGOP = True;
+    fLiveGOPStartRecordNum = recordNum;
+  }
+  ++fNumRecords;
+  Record& r = record(recordNum);
+  r.offset = offset;
+  r.size = fFrameSize;
+  r.presentationTime = fPresentationTime;
+  r.frameNum = fNextFrameNum;
+  r.gopStartRecordNum = fLiveGOPStartRecordNum;
+  memmove(&fData[offset], fTo, fFrameSize);
+  fNextOffset = offset + fFrameSize;
+  fDataSize += fFrameSize;
+
+  // Discard our oldest GOP(s), for as long as what would remain would still cover "fMaxSeconds":
+  while (1) {
+    u_int64_t const nextGOPStart = nextGOPStartRecordNum();
+    if (nextGOPStart == endRecordNum()
+	|| secondsBetween(record(nextGOPStart).presentationTime, fPresentationTime) < fMaxSeconds) break;
+    discardOldestGOP();
+  }
+}
+
+Boolean DVRBuffer::makeRoomFor(unsigned frameSize, Boolean isGOPStart, unsigned& offset) {
+  if (frameSize > fMaxBytes) return False;
+
+  while (1) {
+    if (fNumRecords == 0) {
+      if (!isGOPStart) return False;
+      if (fDataBufferSize < frameSize) growBuffer(frameSize);
+      offset = 0;
+      return True;
+    }
+
+    // Our records occupy [oldest, fNextOffset) - or, if they've wrapped around, [oldest, end) and [0, fNextOffset):
+    unsigned const oldest = record(fFirstRecordNum).offset;
+    if (fNextOffset > oldest) {
+      if (fDataBufferSize - fNextOffset >= frameSize) {
+	offset = fNextOffset;
+	return True;
+      }
+      if (oldest >= frameSize) { // wrap around
+	offset = 0;
+	return True;
+      }
+    } else if (oldest - fNextOffset >= frameSize) {
+      offset = fNextOffset;
+      return True;
+    }
+
+    if (fDataBufferSize < fMaxBytes) {
+      growBuffer(fDataBufferSize + frameSize);
+    } else {
+      discardOldestGOP();
+    }
+  }
+}
+
+void DVRBuffer::growBuffer(unsigned minNewSize) {
+  unsigned newBufferSize = fDataBufferSize == 0 ? 256*1024 : 2*fDataBufferSize;
+  if (newBufferSize < minNewSize) newBufferSize = minNewSize;
+  if (newBufferSize > fMaxBytes) newBufferSize = fMaxBytes;
+
+  // Copy our records (in order) to the start of the new buffer:
+  unsigned char* newData = new unsigned char[newBufferSize];
+  unsigned newOffset = 0;
+  for (u_int64_t recordNum = fFirstRecordNum; recordNum < endRecordNum(); ++recordNum) {
+    Record& r = record(recordNum);
+    memmove(&newData[newOffset], &fData[r.offset], r.size);
+    r.offset = newOffset;
+    newOffset += r.size;
+  }
+  delete[] fData; fData = newData;
+  fDataBufferSize = newBufferSize;
+  fNextOffset = newOffset;
+}
+
+u_int64_t DVRBuffer::nextGOPStartRecordNum() {
+  // Records' "gopStartRecordNum"s never decrease, so do a binary search for the first one that's later than our first record's:
+  u_int64_t lo = fFirstRecordNum, hi = endRecordNum();
+  while (lo < hi) {
+    u_int64_t const mid = lo + (hi - lo)/2;
+    if (record(mid).gopStartRecordNum > fFirstRecordNum) hi = mid; else lo = mid + 1;
+  }
+  return lo;
+}
+
+void DVRBuffer::discardOldestGOP() {
+  u_int64_t const nextGOPStart = nextGOPStartRecordNum();
+  while (fFirstRecordNum < nextGOPStart) {
+    fDataSize -= record(fFirstRecordNum).size;
+    fFirstRecordIndex = (fFirstRecordIndex + 1)%fMaxNumRecords;
+    ++fFirstRecordNum;
+    --fNumRecords;
+  }
+  if (fNumRecords == 0) {
+    fNextOffset = 0;
+    fHaveLiveGOP = False;
+  }
+}
+
+u_int64_t DVRBuffer::recordNumAtTime(struct timeval const& time) {
+  // Do a binary search for the first record that's later than "time":
+  u_int64_t lo = fFirstRecordNum, hi = endRecordNum();
+  while (lo < hi) {
+    u_int64_t const mid = lo + (hi - lo)/2;
+    if (isEarlier(time, record(mid).presentationTime)) hi = mid; else lo = mid + 1;
+  }
+  if (lo == fFirstRecordNum) return fFirstRecordNum; // "time" is earlier than anything we have
+
+  return record(lo - 1).gopStartRecordNum;
+}
+
+u_int64_t DVRBuffer::recordNumAfterFrame(u_int64_t frameNum) {
+  u_int64_t lo = fFirstRecordNum, hi = endRecordNum();
+  while (lo < hi) {
+    u_int64_t const mid = lo + (hi - lo)/2;
+    if (record(mid).frameNum > frameNum) hi = mid; else lo = mid + 1;
+  }
+  return lo;
+}
+
+
+////////// DVRBufferReader implementation //////////
+
+DVRBufferReader* DVRBufferReader::createNew(UsageEnvironment& env, DVRBuffer& buffer, FramedSource* liveSource,
+					    unsigned replaySpeedup) {
+  return new DVRBufferReader(env, buffer, liveSource, replaySpeedup);
+}
+
+DVRBufferReader::DVRBufferReader(UsageEnvironment& env, DVRBuffer& buffer, FramedSource* liveSource, unsigned replaySpeedup)
+  : FramedFilter(env, liveSource),
+    fBuffer(buffer), fReplaySpeedup(replaySpeedup == 0 ? 1 : replaySpeedup), fScale(1.0f),
+    fHaveStarted(False), fIsReplaying(False), fIsCatchingUp(False), fNextRecordNum(0), fNextFrameNum(0) {
+}
+
+DVRBufferReader::~DVRBufferReader() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+}
+
+Boolean DVRBufferReader::seekToTime(struct timeval& time) {
+  if (fBuffer.fNumRecords == 0) return False;
+
+  // Stop whatever we were doing (we'll redo any pending delivery from our new position):
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  if (fHaveStarted && !fIsReplaying) fInputSource->stopGettingFrames();
+
+  fNextRecordNum = fBuffer.recordNumAtTime(time);
+  time = fBuffer.record(fNextRecordNum).presentationTime;
+  fHaveStarted = fIsReplaying = True;
+  fIsCatchingUp = False;
+
+  if (isCurrentlyAwaitingData()) doGetNextFrame();
+  return True;
+}
+
+void DVRBufferReader::aboutToDeliverFrame() {
+}
+
+void DVRBufferReader::doGetNextFrame() {
+  if (!fHaveStarted) {
+    fHaveStarted = True;
+
+    // Begin by replaying the most recent GOP (if it's current), so that our client can start decoding straight away:
+    if (fBuffer.fHaveLiveGOP) {
+      fIsReplaying = fIsCatchingUp = True;
+      fNextRecordNum = fBuffer.fLiveGOPStartRecordNum;
+    }
+  }
+
+  if (fIsReplaying) {
+    // If our next frame has been discarded from the buffer (because we fell too far behind), then skip to the oldest GOP:
+    if (fNextRecordNum < fBuffer.fFirstRecordNum) fNextRecordNum = fBuffer.fFirstRecordNum;
+
+    if (fNextRecordNum < fBuffer.endRecordNum()) {
+      deliverRecordedFrame();
+      return;
+    }
+
+    // We've caught up with the live stream:
+    fIsReplaying = fIsCatchingUp = False;
+  }
+
+  fInputSource->getNextFrame(fTo, fMaxSize, afterGettingLiveFrame, this, FramedSource::handleClosure, this);
+}
+
+void DVRBufferReader::doStopGettingFrames() {
+  if (nextTask() != NULL) {
+    // A recorded frame was about to be delivered; deliver it again when we restart:
+    envir().taskScheduler().unscheduleDelayedTask(nextTask());
+    --fNextRecordNum;
+  }
+
+  if (fHaveStarted && !fIsReplaying) {
+    // We were playing the live stream.  When we restart (e.g., after a "PAUSE"), continue from where we stopped, in the buffer:
+    fNextRecordNum = fBuffer.recordNumAfterFrame(fNextFrameNum - 1);
+    fIsReplaying = True;
+    fIsCatchingUp = False;
+  }
+  FramedFilter::doStopGettingFrames();
+}
+
+void DVRBufferReader::deliverRecordedFrame() {
+  DVRBuffer::Record const& r = fBuffer.record(fNextRecordNum);
+
+  if (r.size > fMaxSize) {
+    fFrameSize = fMaxSize;
+    fNumTruncatedBytes = r.size - fMaxSize;
+  } else {
+    fFrameSize = r.size;
+    fNumTruncatedBytes = 0;
+  }
+  memmove(fTo, &fBuffer.fData[r.offset], fFrameSize);
+  fPresentationTime = r.presentationTime;
+  fNextFrameNum = r.frameNum + 1;
+  ++fNextRecordNum;
+
+  // Pace the replay by the gaps between recorded frames' presentation times (sped up, if we're catching up, or have a "Scale"):
+  fDurationInMicroseconds = 0;
+  if (fNextRecordNum < fBuffer.endRecordNum()) {
+    struct timeval const& nextPT = fBuffer.record(fNextRecordNum).presentationTime;
+    long gap = (nextPT.tv_sec - fPresentationTime.tv_sec)*1000000 + (nextPT.tv_usec - fPresentationTime.tv_usec);
+    float const speed = fIsCatchingUp ? (float)fReplaySpeedup : fScale;
+    if (gap > 0 && gap < 1000000) fDurationInMicroseconds = (unsigned)(gap/speed);
+  }
+
+  // Deliver the frame from the event loop (rather than recursively), because our sink will ask for another straight away:
+  nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)deliverFrame, this);
+}
+
+void DVRBufferReader::afterGettingLiveFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+					    struct timeval presentationTime, unsigned durationInMicroseconds) {
+  ((DVRBufferReader*)clientData)->afterGettingLiveFrame(frameSize, numTruncatedBytes, presentationTime, durationInMicroseconds);
+}
+
+void DVRBufferReader::afterGettingLiveFrame(unsigned frameSize, unsigned numTruncatedBytes,
+					    struct timeval presentationTime, unsigned durationInMicroseconds) {
+  // As for a "GOPCacheReader", the frame that we just got is the one that most recently passed through the buffer.
+  // If we had already played it from the buffer, then don't deliver it again:
+  u_int64_t const frameNum = fBuffer.fNextFrameNum - 1;
+  if (frameNum < fNextFrameNum) {
+    fInputSource->getNextFrame(fTo, fMaxSize, afterGettingLiveFrame, this, FramedSource::handleClosure, this);
+    return;
+  }
+  fNextFrameNum = frameNum + 1;
+
+  fFrameSize = frameSize;
+  fNumTruncatedBytes = numTruncatedBytes;
+  fPresentationTime = presentationTime;
+  fDurationInMicroseconds = durationInMicroseconds;
+  deliverFrame(this);
+}
+
+void DVRBufferReader::deliverFrame(void* clientData) {
+  DVRBufferReader* reader = (DVRBufferReader*)clientData;
+  reader->nextTask() = NULL;
+
+  reader->aboutToDeliverFrame();
+  FramedSource::afterGetting(reader);
+}
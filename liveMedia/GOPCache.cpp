@@ -0,0 +1,260 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A filter that keeps a copy of the most recent 'group of pictures' (i.e., the NAL units since - and including - the most
+// recent key frame, and the parameter sets that precede it) of a H.264 or H.265 video stream, so that it can be replayed
+// to clients that join the stream later (so that they don't have to wait for the next key frame before they can decode).
+// Implementation
+
+#include "GOPCache.hh"
+#include <string.h>
+
+////////// GOPCache implementation //////////
+
+unsigned long GOPCache::fGlobalMemoryLimit = 0;
+unsigned long GOPCache::fGlobalMemoryInUse = 0;
+
+GOPCache* GOPCache::createNew(UsageEnvironment& env, FramedSource* inputSource,
+			      Boolean isH265, unsigned maxCacheSize) {
+  return new GOPCache(env, inputSource, isH265, maxCacheSize);
+}
+
+GOPCache::GOPCache(UsageEnvironment& env, FramedSource* inputSource, Boolean isH265, unsigned maxCacheSize)
+  : FramedFilter(env, inputSource),
+    fIsH265(isH265), fMaxCacheSize(maxCacheSize), fIsCaching(False), fLastCachedFrameWasKey(False),
+    fNextFrameNum(0), fFirstFrameNum(0),
+    fFrames(NULL), fNumFrames(0), fMaxNumFrames(0),
+    fData(NULL), fDataSize(0), fDataBufferSize(0) {
+}
+
+GOPCache::~GOPCache() {
+  abandonGOP();
+  delete[] fFrames;
+}
+
+void GOPCache::flush() {
+  fIsCaching = False;
+  fNumFrames = fDataSize = 0;
+  fFirstFrameNum = fNextFrameNum;
+}
+
+void GOPCache::doGetNextFrame() {
+  fInputSource->getNextFrame(fTo, fMaxSize, afterGettingFrame, this, FramedSource::handleClosure, this);
+}
+
+void GOPCache::afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				 struct timeval presentationTime, unsigned durationInMicroseconds) {
+  ((GOPCache*)clientData)->afterGettingFrame(frameSize, numTruncatedBytes, presentationTime, durationInMicroseconds);
+}
+
+void GOPCache::afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes,
+				 struct timeval presentationTime, unsigned durationInMicroseconds) {
+  fFrameSize = frameSize;
+  fNumTruncatedBytes = numTruncatedBytes;
+  fPresentationTime = presentationTime;
+  fDurationInMicroseconds = durationInMicroseconds;
+
+  if (frameSize > 0 && numTruncatedBytes == 0) cacheFrame();
+  else abandonGOP(); // we can't replay a GOP that's missing data
+  ++fNextFrameNum;
+
+  // Complete delivery (of the frame, unchanged):
+  FramedSource::afterGetting(this);
+}
+
+GOPCache::NALKind GOPCache::nalKind(u_int8_t firstByte, Boolean isH265) {
+  if (isH265) {
+    u_int8_t const nal_unit_type = (firstByte&0x7E)>>1;
+    if ((nal_unit_type >= 16 && nal_unit_type <= 23) /* IRAP picture */ ||
+	(nal_unit_type >= 32 && nal_unit_type <= 34) /* VPS, SPS or PPS */) return KEY_NAL;
+    if (nal_unit_type == 35 /* AUD */ || nal_unit_type == 39 || nal_unit_type == 40 /* SEI */) return NEUTRAL_NAL;
+  } else {
+    u_int8_t const nal_unit_type = firstByte&0x1F;
+    if (nal_unit_type == 5 /* IDR picture */ || nal_unit_type == 7 /* SPS */ || nal_unit_type == 8 /* PPS */) return KEY_NAL;
+    if (nal_unit_type == 6 /* SEI */ || nal_unit_type == 9 /* AUD */) return NEUTRAL_NAL;
+  }
+  return OTHER_NAL;
+}
+
+void GOPCache::cacheFrame() {
+  NALKind const kind = nalKind(fTo[0], fIsH265);
+
+  if (kind == KEY_NAL && !(fIsCaching && fLastCachedFrameWasKey)) {
+    // This NAL unit begins a new GOP.  Discard the previous one:
+    fIsCaching = True;
+    fNumFrames = fDataSize = 0;
+    fFirstFrameNum = fNextFrameNum;
+  } else if (!fIsCaching) {
+    // We're waiting for a key frame; don't cache this NAL unit:
+    fFirstFrameNum = fNextFrameNum + 1;
+    return;
+  }
+  if (kind != NEUTRAL_NAL) fLastCachedFrameWasKey = kind == KEY_NAL;
+
+  if (!ensureBufferSize(fDataSize + fFrameSize)) {
+    // This GOP is too large to cache:
+    abandonGOP();
+    return;
+  }
+
+  if (fNumFrames == fMaxNumFrames) {
+    unsigned newMaxNumFrames = fMaxNumFrames == 0 ? 64 : 2*fMaxNumFrames;
+    CachedFrame* newFrames = new CachedFrame[newMaxNumFrames];
+    if (fNumFrames > 0) memmove(newFrames, fFrames, fNumFrames*sizeof (CachedFrame));
+    delete[] fFrames; fFrames = newFrames;
+    fMaxNumFrames = newMaxNumFrames;
+  }
+
+  CachedFrame& frame = fFrames[fNumFrames++];
+  frame.offset = fDataSize;
+  frame.size = fFrameSize;
+  frame.presentationTime = fPresentationTime;
+  memmove(&fData[fDataSize], fTo, fFrameSize);
+  fDataSize += fFrameSize;
+}
+
+Boolean GOPCache::ensureBufferSize(unsigned newDataSize) {
+  if (newDataSize <= fDataBufferSize) return True;
+  if (newDataSize > fMaxCacheSize) return False;
+
+  unsigned newBufferSize = fDataBufferSize == 0 ? 64*1024 : 2*fDataBufferSize;
+  if (newBufferSize < newDataSize) newBufferSize = newDataSize;
+  if (newBufferSize > fMaxCacheSize) newBufferSize = fMaxCacheSize;
+
+  unsigned long const newGlobalMemoryInUse = fGlobalMemoryInUse - fDataBufferSize + newBufferSize;
+  if (fGlobalMemoryLimit > 0 && newGlobalMemoryInUse > fGlobalMemoryLimit) return False;
+
+  unsigned char* newData = new unsigned char[newBufferSize];
+  if (fDataSize > 0) memmove(newData, fData, fDataSize);
+  delete[] fData; fData = newData;
+  fGlobalMemoryInUse = newGlobalMemoryInUse;
+  fDataBufferSize = newBufferSize;
+
+  return True;
+}
+
+void GOPCache::abandonGOP() {
+  flush();
+  ++fFirstFrameNum; // because the current frame (if any) isn't cached either
+
+  // Also free our buffer, so that other "GOPCache"s can use its memory:
+  delete[] fData; fData = NULL;
+  fGlobalMemoryInUse -= fDataBufferSize;
+  fDataBufferSize = 0;
+}
+
+
+////////// GOPCacheReader implementation //////////
+
+GOPCacheReader* GOPCacheReader::createNew(UsageEnvironment& env, GOPCache& cache, FramedSource* liveSource,
+					  unsigned replaySpeedup) {
+  return new GOPCacheReader(env, cache, liveSource, replaySpeedup);
+}
+
+GOPCacheReader::GOPCacheReader(UsageEnvironment& env, GOPCache& cache, FramedSource* liveSource, unsigned replaySpeedup)
+  : FramedFilter(env, liveSource),
+    fCache(cache), fReplaySpeedup(replaySpeedup == 0 ? 1 : replaySpeedup), fIsReplaying(True),
+    fNextFrameNum(cache.fFirstFrameNum) {
+}
+
+GOPCacheReader::~GOPCacheReader() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+}
+
+void GOPCacheReader::aboutToDeliverFrame() {
+}
+
+void GOPCacheReader::doGetNextFrame() {
+  if (fIsReplaying) {
+    // If the cache has moved on to a new GOP since our last frame, then skip to it:
+    if (fNextFrameNum < fCache.fFirstFrameNum) fNextFrameNum = fCache.fFirstFrameNum;
+
+    if (fNextFrameNum < fCache.fFirstFrameNum + fCache.fNumFrames) {
+      deliverCachedFrame();
+      return;
+    }
+
+    // We've caught up with the live stream:
+    fIsReplaying = False;
+  }
+
+  fInputSource->getNextFrame(fTo, fMaxSize, afterGettingLiveFrame, this, FramedSource::handleClosure, this);
+}
+
+void GOPCacheReader::doStopGettingFrames() {
+  envir().taskScheduler().unscheduleDelayedTask(nextTask());
+  FramedFilter::doStopGettingFrames();
+}
+
+void GOPCacheReader::deliverCachedFrame() {
+  unsigned const index = (unsigned)(fNextFrameNum - fCache.fFirstFrameNum);
+  GOPCache::CachedFrame const& frame = fCache.fFrames[index];
+
+  if (frame.size > fMaxSize) {
+    fFrameSize = fMaxSize;
+    fNumTruncatedBytes = frame.size - fMaxSize;
+  } else {
+    fFrameSize = frame.size;
+    fNumTruncatedBytes = 0;
+  }
+  memmove(fTo, &fCache.fData[frame.offset], fFrameSize);
+  fPresentationTime = frame.presentationTime;
+
+  // Pace the replay by the (sped-up) gaps between cached frames' presentation times:
+  fDurationInMicroseconds = 0;
+  if (index + 1 < fCache.fNumFrames) {
+    struct timeval const& nextPT = fCache.fFrames[index+1].presentationTime;
+    long gap = (nextPT.tv_sec - fPresentationTime.tv_sec)*1000000 + (nextPT.tv_usec - fPresentationTime.tv_usec);
+    if (gap > 0 && gap < 1000000) fDurationInMicroseconds = (unsigned)gap/fReplaySpeedup;
+  }
+  ++fNextFrameNum;
+
+  // Deliver the frame from the event loop (rather than recursively), because our sink will ask for another straight away:
+  nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)deliverFrame, this);
+}
+
+void GOPCacheReader::afterGettingLiveFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+					   struct timeval presentationTime, unsigned durationInMicroseconds) {
+  ((GOPCacheReader*)clientData)->afterGettingLiveFrame(frameSize, numTruncatedBytes, presentationTime, durationInMicroseconds);
+}
+
+void GOPCacheReader::afterGettingLiveFrame(unsigned frameSize, unsigned numTruncatedBytes,
+					   struct timeval presentationTime, unsigned durationInMicroseconds) {
+  // Because a "StreamReplicator" doesn't read a new frame until all of its active replicas have received the current one,
+  // the frame that we just got is the one that most recently passed through the cache.  If we had already replayed it
+  // from the cache, then don't deliver it again:
+  u_int64_t const frameNum = fCache.fNextFrameNum - 1;
+  if (frameNum < fNextFrameNum) {
+    fInputSource->getNextFrame(fTo, fMaxSize, afterGettingLiveFrame, this, FramedSource::handleClosure, this);
+    return;
+  }
+  fNextFrameNum = frameNum + 1;
+
+  fFrameSize = frameSize;
+  fNumTruncatedBytes = numTruncatedBytes;
+  fPresentationTime = presentationTime;
+  fDurationInMicroseconds = durationInMicroseconds;
+  deliverFrame(this);
+}
+
+void GOPCacheReader::deliverFrame(void* clientData) {
+  GOPCacheReader* reader = (GOPCacheReader*)clientData;
+  reader->nextTask() = NULL;
+
+  reader->aboutToDeliverFrame();
+  FramedSource::afterGetting(reader);
+}
@@ -24,8 +24,10 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "H264or5VideoStreamDiscreteFramer.hh"
 
 H264or5VideoStreamDiscreteFramer
-::H264or5VideoStreamDiscreteFramer(int hNumber, UsageEnvironment& env, FramedSource* inputSource)
-  : H264or5VideoStreamFramer(hNumber, env, inputSource, False/*don't create a parser*/, False) {
+::H264or5VideoStreamDiscreteFramer(int hNumber, UsageEnvironment& env, FramedSource* inputSource,
+                                   Boolean includeStartCodeInOutput)
+  : H264or5VideoStreamFramer(hNumber, env, inputSource, False/*don't create a parser*/, False),
+    fIncludeStartCodeInOutput(includeStartCodeInOutput) {
 }
 
 H264or5VideoStreamDiscreteFramer::~H264or5VideoStreamDiscreteFramer() {
@@ -35,7 +37,9 @@ void H264or5VideoStreamDiscreteFramer::doGetNextFrame() {
   // Arrange to read data (which should be a complete H.264 or H.265 NAL unit)
   // from our data source, directly into the client's input buffer.
   // After reading this, we'll do some parsing on the frame.
-  fInputSource->getNextFrame(fTo, fMaxSize,
+  // (If we're to output a 'start code', we leave room for it at the front of the buffer.)
+  unsigned const startCodeSize = fIncludeStartCodeInOutput ? 4 : 0;
+  fInputSource->getNextFrame(fTo + startCodeSize, fMaxSize > startCodeSize ? fMaxSize - startCodeSize : 0,
                              afterGettingFrame, this,
                              FramedSource::handleClosure, this);
 }
@@ -53,12 +57,15 @@ void H264or5VideoStreamDiscreteFramer
 ::afterGettingFrame1(unsigned frameSize, unsigned numTruncatedBytes,
                      struct timeval presentationTime,
                      unsigned durationInMicroseconds) {
+  unsigned const startCodeSize = fIncludeStartCodeInOutput ? 4 : 0;
+  u_int8_t* nalUnit = fTo + startCodeSize;
+
   // Get the "nal_unit_type", to see if this NAL unit is one that we want to save a copy of:
   u_int8_t nal_unit_type;
   if (fHNumber == 264 && frameSize >= 1) {
-    nal_unit_type = fTo[0]&0x1F;
+    nal_unit_type = nalUnit[0]&0x1F;
   } else if (fHNumber == 265 && frameSize >= 2) {
-    nal_unit_type = (fTo[0]&0x7E)>>1;
+    nal_unit_type = (nalUnit[0]&0x7E)>>1;
   } else {
     // This is too short to be a valid NAL unit, so just assume a bogus nal_unit_type
     nal_unit_type = 0xFF;
@@ -69,14 +76,14 @@ void H264or5VideoStreamDiscreteFramer
   // *not* data that consists of discrete NAL units.)
   // Once again, to be clear: The NAL units that you feed to a "H264or5VideoStreamDiscreteFramer"
   // MUST NOT include start codes.
-  if (frameSize >= 4 && fTo[0] == 0 && fTo[1] == 0 && ((fTo[2] == 0 && fTo[3] == 1) || fTo[2] == 1)) {
+  if (frameSize >= 4 && nalUnit[0] == 0 && nalUnit[1] == 0 && ((nalUnit[2] == 0 && nalUnit[3] == 1) || nalUnit[2] == 1)) {
     envir() << "H264or5VideoStreamDiscreteFramer error: MPEG 'start code' seen in the input\n";
   } else if (isVPS(nal_unit_type)) { // Video parameter set (VPS)
-    saveCopyOfVPS(fTo, frameSize);
+    saveCopyOfVPS(nalUnit, frameSize);
   } else if (isSPS(nal_unit_type)) { // Sequence parameter set (SPS)
-    saveCopyOfSPS(fTo, frameSize);
+    saveCopyOfSPS(nalUnit, frameSize);
   } else if (isPPS(nal_unit_type)) { // Picture parameter set (PPS)
-    saveCopyOfPPS(fTo, frameSize);
+    saveCopyOfPPS(nalUnit, frameSize);
   }
 
   // Next, check whether this NAL unit ends the current 'access unit' (basically, a video frame).
@@ -85,8 +92,11 @@ void H264or5VideoStreamDiscreteFramer
   // if this NAL unit is a VCL NAL unit, then it ends the current 'access unit'.
   if (isVCL(nal_unit_type)) fPictureEndMarker = True;
 
-  // Finally, complete delivery to the client:
-  fFrameSize = frameSize;
+  // Finally, complete delivery to the client (prepending a 'start code', if requested):
+  if (fIncludeStartCodeInOutput) {
+    fTo[0] = fTo[1] = fTo[2] = 0; fTo[3] = 1;
+  }
+  fFrameSize = startCodeSize + frameSize;
   fNumTruncatedBytes = numTruncatedBytes;
   fPresentationTime = presentationTime;
   fDurationInMicroseconds = durationInMicroseconds;
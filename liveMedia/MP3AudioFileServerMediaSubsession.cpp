@@ -25,12 +25,19 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MP3ADURTPSink.hh"
 #include "MP3FileSource.hh"
 #include "MP3ADU.hh"
+#include "MP3FrameIndex.hh"
 
 MP3AudioFileServerMediaSubsession* MP3AudioFileServerMediaSubsession
 ::createNew(UsageEnvironment& env, char const* fileName, Boolean reuseFirstSource,
 	    Boolean generateADUs, Interleaving* interleaving) {
-  return new MP3AudioFileServerMediaSubsession(env, fileName, reuseFirstSource,
-					       generateADUs, interleaving);
+  MP3AudioFileServerMediaSubsession* newSubsession
+    = new MP3AudioFileServerMediaSubsession(env, fileName, reuseFirstSource, generateADUs, interleaving);
+
+  // Start indexing the file's frames now (unless a saved index is read instead), so that the index is more likely to be
+  // ready - with the file's exact duration - by the time that the first "DESCRIBE" needs it:
+  newSubsession->fFrameIndex = MP3FrameIndex::attach(env, fileName);
+
+  return newSubsession;
 }
 
 MP3AudioFileServerMediaSubsession
@@ -39,12 +46,13 @@ MP3AudioFileServerMediaSubsession
 				    Boolean generateADUs,
 				    Interleaving* interleaving)
   : FileServerMediaSubsession(env, fileName, reuseFirstSource),
-    fGenerateADUs(generateADUs), fInterleaving(interleaving), fFileDuration(0.0) {
+    fGenerateADUs(generateADUs), fInterleaving(interleaving), fFileDuration(0.0), fFrameIndex(NULL) {
 }
 
 MP3AudioFileServerMediaSubsession
 ::~MP3AudioFileServerMediaSubsession() {
   delete fInterleaving;
+  if (fFrameIndex != NULL) MP3FrameIndex::detach(envir(), fFrameIndex);
 }
 
 FramedSource* MP3AudioFileServerMediaSubsession
@@ -144,6 +152,14 @@ FramedSource* MP3AudioFileServerMediaSubsession
 ::createNewStreamSource(unsigned /*clientSessionId*/, unsigned& estBitrate) {
   MP3FileSource* mp3Source = MP3FileSource::createNew(envir(), fFileName);
   if (mp3Source == NULL) return NULL;
+
+  // Use the index of the file's frames (once it's been built), so that we know the file's exact duration, and can seek
+  // exactly within it (even if it's VBR).  We "attach()" the index again for each new stream, in case the file has been
+  // replaced since the index was built.  (The stream's source holds its own reference to the index.):
+  MP3FrameIndex* frameIndex = MP3FrameIndex::attach(envir(), fFileName);
+  if (fFrameIndex != NULL) MP3FrameIndex::detach(envir(), fFrameIndex);
+  fFrameIndex = frameIndex;
+  mp3Source->setFrameIndex(MP3FrameIndex::attach(envir(), fFileName));
   fFileDuration = mp3Source->filePlayTime();
 
   return createNewStreamSourceCommon(mp3Source, mp3Source->fileSize(), estBitrate);
@@ -175,5 +191,6 @@ void MP3AudioFileServerMediaSubsession::testScaleFactor(float& scale) {
 }
 
 float MP3AudioFileServerMediaSubsession::duration() const {
+  if (fFrameIndex != NULL && fFrameIndex->isReady()) return fFrameIndex->playTime();
   return fFileDuration;
 }
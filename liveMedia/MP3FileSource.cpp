@@ -20,17 +20,19 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "MP3FileSource.hh"
 #include "MP3StreamState.hh"
+#include "MP3FrameIndex.hh"
 #include "InputFile.hh"
 
 ////////// MP3FileSource //////////
 
 MP3FileSource::MP3FileSource(UsageEnvironment& env, FILE* fid)
   : FramedFileSource(env, fid),
-    fStreamState(new MP3StreamState(env)) {
+    fStreamState(new MP3StreamState(env)), fFrameIndex(NULL) {
 }
 
 MP3FileSource::~MP3FileSource() {
   delete fStreamState;
+  if (fFrameIndex != NULL) MP3FrameIndex::detach(envir(), fFrameIndex);
 }
 
 char const* MP3FileSource::MIMEtype() const {
@@ -60,7 +62,13 @@ MP3FileSource* MP3FileSource::createNew(UsageEnvironment& env, char const* fileN
   return NULL;
 }
 
+void MP3FileSource::setFrameIndex(MP3FrameIndex* frameIndex) {
+  if (fFrameIndex != NULL) MP3FrameIndex::detach(envir(), fFrameIndex);
+  fFrameIndex = frameIndex;
+}
+
 float MP3FileSource::filePlayTime() const {
+  if (fFrameIndex != NULL && fFrameIndex->isReady()) return fFrameIndex->playTime();
   return fStreamState->filePlayTime();
 }
 
@@ -87,14 +95,24 @@ void MP3FileSource::seekWithinFile(double seekNPT, double streamDuration) {
     streamDuration = fileDuration - seekNPT; 
   }
 
-  float seekFraction = (float)seekNPT/fileDuration;
-  unsigned seekByteNumber = fStreamState->getByteNumberFromPositionFraction(seekFraction);
+  unsigned seekByteNumber;
+  if (fFrameIndex != NULL && fFrameIndex->isReady()) {
+    seekByteNumber = fFrameIndex->byteOffsetFromPlayTime(seekNPT);
+  } else {
+    float seekFraction = (float)seekNPT/fileDuration;
+    seekByteNumber = fStreamState->getByteNumberFromPositionFraction(seekFraction);
+  }
   fStreamState->seekWithinFile(seekByteNumber);
 
   fLimitNumBytesToStream = False; // by default
   if (streamDuration > 0.0) {
-    float endFraction = (float)(seekNPT + streamDuration)/fileDuration;
-    unsigned endByteNumber = fStreamState->getByteNumberFromPositionFraction(endFraction);
+    unsigned endByteNumber;
+    if (fFrameIndex != NULL && fFrameIndex->isReady()) {
+      endByteNumber = fFrameIndex->byteOffsetFromPlayTime(seekNPT + streamDuration);
+    } else {
+      float endFraction = (float)(seekNPT + streamDuration)/fileDuration;
+      endByteNumber = fStreamState->getByteNumberFromPositionFraction(endFraction);
+    }
     if (endByteNumber > seekByteNumber) { // sanity check
       fNumBytesToStream = endByteNumber - seekByteNumber;
       fLimitNumBytesToStream = True;
@@ -0,0 +1,270 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// An index of the byte offset of each frame in a MPEG audio (e.g., MP3) file, built by a (fast) scan of the
+// file's frame headers.
+// Implementation
+
+#include "MP3FrameIndex.hh"
+#include "MP3Internals.hh"
+#include "MediaFileCache.hh"
+#include "InputFile.hh"
+#include <sys/stat.h>
+
+#define MILLION 1000000
+
+MP3FrameIndex* MP3FrameIndex::createNew(UsageEnvironment& env, char const* fileName) {
+  FILE* fid = OpenInputFile(env, fileName);
+  if (fid == NULL) return NULL;
+  if (fid == stdin) return NULL; // we can index only real files
+
+  struct stat sb;
+  if (stat(fileName, &sb) != 0) {
+    CloseInputFile(fid);
+    return NULL;
+  }
+
+  return new MP3FrameIndex(env, fid, fileName, (u_int64_t)sb.st_mtime, (u_int64_t)sb.st_size);
+}
+
+MP3FrameIndex* MP3FrameIndex::attach(UsageEnvironment& env, char const* fileName) {
+  char* key = new char[strlen(fileName) + 20];
+  sprintf(key, "MP3FrameIndex:%s", fileName);
+
+  MP3FrameIndex* frameIndex = (MP3FrameIndex*)MediaFileCache::attach(env, key, fileName);
+  if (frameIndex == NULL) {
+    frameIndex = createNew(env, fileName);
+    MediaFileCache::add(env, key, fileName, frameIndex);
+  }
+
+  delete[] key;
+  return frameIndex;
+}
+
+void MP3FrameIndex::detach(UsageEnvironment& env, MP3FrameIndex* frameIndex) {
+  MediaFileCache::detach(env, frameIndex);
+}
+
+#define SCAN_BUFFER_SIZE 65536
+
+MP3FrameIndex::MP3FrameIndex(UsageEnvironment& env, FILE* fid, char const* fileName,
+			     u_int64_t fileModificationTime, u_int64_t fileSize)
+  : Medium(env),
+    fFid(fid), fScanTask(NULL), fScanBuffer(new unsigned char[SCAN_BUFFER_SIZE]),
+    fScanBufferStart(0), fScanBufferSize(0), fScanPosition(0), fFirstHeader(0),
+    fFrameOffsets(NULL), fNumFrames(0), fMaxNumFrames(0), fEndOffset(0), fFrameDurationInMicroseconds(0),
+    fFileModificationTime(fileModificationTime), fFileSize(fileSize) {
+  fIndexFileName = new char[strlen(fileName) + 2];
+  sprintf(fIndexFileName, "%sx", fileName);
+
+  if (readIndexFile()) {
+    // This (unchanged) file has already been indexed, so there's no need to scan it again:
+    finishScanning();
+  } else {
+    // Begin scanning the file - one chunk at a time, so that other events can be handled in between:
+    fScanTask = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)scanNextChunk, this);
+  }
+}
+
+MP3FrameIndex::~MP3FrameIndex() {
+  envir().taskScheduler().unscheduleDelayedTask(fScanTask);
+  if (fFid != NULL) CloseInputFile(fFid);
+  delete[] fScanBuffer;
+  delete[] fFrameOffsets;
+  delete[] fIndexFileName;
+}
+
+float MP3FrameIndex::playTime() const {
+  return (float)(fNumFrames*(double)fFrameDurationInMicroseconds/MILLION);
+}
+
+unsigned MP3FrameIndex::byteOffsetFromPlayTime(double npt) const {
+  if (npt <= 0.0 || fFrameDurationInMicroseconds == 0) return fNumFrames > 0 ? fFrameOffsets[0] : 0;
+
+  // Every frame has the same duration, so we can find the frame directly:
+  double frameNum = npt*MILLION/fFrameDurationInMicroseconds;
+  if (frameNum >= (double)fNumFrames) return fEndOffset;
+  return fFrameOffsets[(unsigned)frameNum];
+}
+
+#define HEADER_MATCH_MASK 0xFFFE0C00 /* sync word, version, layer, and sampling frequency */
+
+static Boolean isValidHeader(unsigned hdr) {
+  // (These are the same checks that "MP3StreamState::findNextFrame()" makes)
+  return !(   (hdr & 0xffe00000) != 0xffe00000
+	   || (hdr & 0x00060000) == 0 // undefined 'layer' field
+	   || (hdr & 0x0000F000) == 0 // 'free format' bitrate index
+	   || (hdr & 0x0000F000) == 0x0000F000 // undefined bitrate index
+	   || (hdr & 0x00000C00) == 0x00000C00 // undefined frequency index
+	   || (hdr & 0x00000003) != 0x00000000 // 'emphasis' field unexpectedly set
+	  );
+}
+
+void MP3FrameIndex::scanNextChunk(void* clientData) {
+  ((MP3FrameIndex*)clientData)->scanNextChunk();
+}
+
+void MP3FrameIndex::scanNextChunk() {
+  fScanTask = NULL;
+  if (scanChunk()) {
+    fScanTask = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)scanNextChunk, this);
+  } else {
+    // We're done.  (If we found no frames, then we stay unusable - but still cached (and saved) - so that the file isn't
+    // scanned again.)
+    finishScanning();
+    writeIndexFile();
+  }
+}
+
+void MP3FrameIndex::finishScanning() {
+  CloseInputFile(fFid); fFid = NULL;
+  delete[] fScanBuffer; fScanBuffer = NULL;
+}
+
+Boolean MP3FrameIndex::scanChunk() {
+  // Read the next chunk of the file, but look only at each frame's 4-byte header (which tells us where the next frame
+  // begins).  Like "MP3StreamState::findNextFrame()", skip over any ID3 tags, and resync (a byte at a time) over anything
+  // else that doesn't look like a frame header:
+  Boolean haveReadChunk = False;
+  MP3FrameParams* fr = new MP3FrameParams;
+  Boolean result = True;
+
+  while (1) {
+    if (fScanPosition < fScanBufferStart || fScanPosition + 10 > fScanBufferStart + fScanBufferSize) {
+      // We need more data.  (If we've already read a chunk this time, then continue later.)
+      if (haveReadChunk) break;
+      if (SeekFile64(fFid, fScanPosition, SEEK_SET) != 0) { result = False; break; }
+      fScanBufferStart = fScanPosition;
+      fScanBufferSize = fread(fScanBuffer, 1, SCAN_BUFFER_SIZE, fFid);
+      if (fScanBufferSize < 4) { result = False; break; }
+      haveReadChunk = True;
+    }
+    unsigned char const* p = &fScanBuffer[fScanPosition - fScanBufferStart];
+    unsigned numBytesAvailable = fScanBufferStart + fScanBufferSize - fScanPosition;
+    unsigned hdr = (p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3];
+
+    if (isValidHeader(hdr) && (fFirstHeader == 0 || (hdr&HEADER_MATCH_MASK) == (fFirstHeader&HEADER_MATCH_MASK))) {
+      fr->hdr = hdr;
+      fr->setParamsFromHeader();
+      if (fFirstHeader == 0) {
+	fFirstHeader = hdr;
+
+	// All frames have the same duration (computed the same way as "MP3StreamState::currentFramePlayTime()"):
+	unsigned const numSamples = 1152;
+	unsigned const freq = fr->samplingFreq*(1 + fr->isMPEG2);
+	fFrameDurationInMicroseconds = ((numSamples*2*MILLION)/freq + 1)/2;
+      }
+      addFrame(fScanPosition);
+      fScanPosition += 4 + fr->frameSize;
+      fEndOffset = fScanPosition;
+    } else if (numBytesAvailable >= 10 && p[0] == 'I' && p[1] == 'D' && p[2] == '3') {
+      unsigned tagSize = ((p[6]&0x7F)<<21) | ((p[7]&0x7F)<<14) | ((p[8]&0x7F)<<7) | (p[9]&0x7F);
+      fScanPosition += 10 + tagSize;
+    } else {
+      ++fScanPosition;
+    }
+  }
+
+  delete fr;
+  return result;
+}
+
+void MP3FrameIndex::addFrame(unsigned byteOffset) {
+  if (fNumFrames == fMaxNumFrames) {
+    // Grow our array:
+    fMaxNumFrames = fMaxNumFrames == 0 ? 1024 : 2*fMaxNumFrames;
+    unsigned* newFrameOffsets = new unsigned[fMaxNumFrames];
+    if (fNumFrames > 0) memmove(newFrameOffsets, fFrameOffsets, fNumFrames*sizeof (unsigned));
+    delete[] fFrameOffsets;
+    fFrameOffsets = newFrameOffsets;
+  }
+  fFrameOffsets[fNumFrames++] = byteOffset;
+}
+
+// A saved index consists of big-endian 32-bit words: a header (identifying the version of the file that was indexed),
+// followed by the offset of each frame:
+#define INDEX_FILE_MAGIC 0x4D503358 /* 'MP3X' */
+#define INDEX_HEADER_SIZE 9
+
+static Boolean readWords(FILE* fid, unsigned* words, unsigned numWords) {
+  unsigned char buf[4];
+  for (unsigned i = 0; i < numWords; ++i) {
+    if (fread(buf, 1, 4, fid) != 4) return False;
+    words[i] = (buf[0]<<24)|(buf[1]<<16)|(buf[2]<<8)|buf[3];
+  }
+  return True;
+}
+
+static Boolean writeWords(FILE* fid, unsigned const* words, unsigned numWords) {
+  unsigned char buf[4];
+  for (unsigned i = 0; i < numWords; ++i) {
+    buf[0] = words[i]>>24; buf[1] = words[i]>>16; buf[2] = words[i]>>8; buf[3] = words[i];
+    if (fwrite(buf, 1, 4, fid) != 4) return False;
+  }
+  return True;
+}
+
+Boolean MP3FrameIndex::readIndexFile() {
+  FILE* fid = fopen(fIndexFileName, "rb");
+  if (fid == NULL) return False;
+
+  Boolean result = False;
+  do {
+    unsigned header[INDEX_HEADER_SIZE];
+    if (!readWords(fid, header, INDEX_HEADER_SIZE)) break;
+    if (header[0] != INDEX_FILE_MAGIC
+	|| header[1] != (unsigned)(fFileModificationTime>>32) || header[2] != (unsigned)fFileModificationTime
+	|| header[3] != (unsigned)(fFileSize>>32) || header[4] != (unsigned)fFileSize) {
+      break; // the saved index is for some other version of the file
+    }
+
+    unsigned const numFrames = header[7];
+    if (numFrames > fFileSize/4) break; // sanity check: each frame is at least 4 bytes long
+    unsigned* frameOffsets = new unsigned[numFrames];
+    if (!readWords(fid, frameOffsets, numFrames)) { // the saved index was truncated
+      delete[] frameOffsets;
+      break;
+    }
+
+    fFirstHeader = header[5];
+    fFrameDurationInMicroseconds = header[6];
+    fFrameOffsets = frameOffsets;
+    fNumFrames = fMaxNumFrames = numFrames;
+    fEndOffset = header[8];
+    result = True;
+  } while (0);
+
+  fclose(fid);
+  return result;
+}
+
+void MP3FrameIndex::writeIndexFile() {
+  // If we can't save the index (e.g., because the file's directory isn't writable), then it'll just be built again the
+  // next time that it's needed (after it's left our "MediaFileCache"):
+  FILE* fid = fopen(fIndexFileName, "wb");
+  if (fid == NULL) return;
+
+  unsigned const header[INDEX_HEADER_SIZE] = {
+    INDEX_FILE_MAGIC,
+    (unsigned)(fFileModificationTime>>32), (unsigned)fFileModificationTime,
+    (unsigned)(fFileSize>>32), (unsigned)fFileSize,
+    fFirstHeader, fFrameDurationInMicroseconds, fNumFrames, fEndOffset
+  };
+  Boolean success = writeWords(fid, header, INDEX_HEADER_SIZE) && writeWords(fid, fFrameOffsets, fNumFrames);
+  if (fclose(fid) != 0) success = False;
+  if (!success) remove(fIndexFileName); // so that a partial index isn't read later
+}
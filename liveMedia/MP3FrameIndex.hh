@@ -0,0 +1,84 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// An index of the byte offset of each frame in a MPEG audio (e.g., MP3) file, built - in the background, from the event
+// loop - by a (fast) scan of the file's frame headers.  It lets us seek exactly - and know the file's exact duration -
+// even for VBR files that have no Xing 'table of contents'.  Once built, the index is also saved beside the file (as
+// "<fileName>x"), so that it doesn't need to be built again - even by a later run of the server - unless the file changes.
+// C++ header
+
+#ifndef _MP3_FRAME_INDEX_HH
+#define _MP3_FRAME_INDEX_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+class MP3FrameIndex: public Medium {
+public:
+  static MP3FrameIndex* createNew(UsageEnvironment& env, char const* fileName);
+      // Returns NULL if the file can't be opened.  Otherwise, if a saved index for the (unchanged) file exists, then it's
+      // read immediately.  If not, the file is then scanned - one chunk at a time, from the event loop - and the index
+      // can't be used until this is done (see "isReady()").
+
+  static MP3FrameIndex* attach(UsageEnvironment& env, char const* fileName);
+      // Like "createNew()", except that the index is kept in our environment's "MediaFileCache", so that it's built
+      // only once for each (unchanged) file.  (This includes a file that turns out to contain no MPEG audio frames;
+      // it's not scanned again unless it changes.)  Each successful call must be matched by a call to "detach()".
+  static void detach(UsageEnvironment& env, MP3FrameIndex* frameIndex);
+
+  Boolean isReady() const { return fFid == NULL && fNumFrames > 0; }
+      // True iff we've finished scanning the file, and found frames in it.  (Until then, callers should estimate
+      // durations and seek positions some other way - e.g., from a Xing header, or the bitrate.)
+  unsigned numFrames() const { return fNumFrames; }
+  float playTime() const; // in seconds
+  unsigned byteOffsetFromPlayTime(double npt) const;
+      // Returns the offset of the frame that's playing at "npt" (or the offset of the end of the last frame,
+      // if "npt" is beyond the end of the file).
+
+protected:
+  MP3FrameIndex(UsageEnvironment& env, FILE* fid, char const* fileName,
+		u_int64_t fileModificationTime, u_int64_t fileSize);
+      // called only by createNew()
+  virtual ~MP3FrameIndex();
+
+private:
+  static void scanNextChunk(void* clientData);
+  void scanNextChunk();
+  Boolean scanChunk(); // returns False when there's nothing more to scan
+  void addFrame(unsigned byteOffset);
+  void finishScanning();
+  Boolean readIndexFile();
+  void writeIndexFile();
+
+private:
+  FILE* fFid; // while we're scanning the file
+  TaskToken fScanTask;
+  unsigned char* fScanBuffer;
+  unsigned fScanBufferStart, fScanBufferSize, fScanPosition;
+  unsigned fFirstHeader;
+
+  unsigned* fFrameOffsets;
+  unsigned fNumFrames, fMaxNumFrames;
+  unsigned fEndOffset; // just past the last frame
+  unsigned fFrameDurationInMicroseconds;
+
+  char* fIndexFileName;
+  u_int64_t fFileModificationTime, fFileSize; // when we began indexing the file (these are saved with the index)
+};
+
+#endif
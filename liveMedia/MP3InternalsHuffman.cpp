@@ -330,8 +330,29 @@ struct huffcodetab {
   unsigned char *hlen;	/*pointer to array[xlen][ylen]		*/
   unsigned char(*val)[2];/*decoder tree				*/
   unsigned int treelen;	/*length of decoder tree		*/
+  struct huffLookupEntry* lookup; /*decodes the first HUFF_LOOKUP_BITS bits at once*/
 };
 
+// To decode quickly, we don't walk the decoder tree one bit at a time.  Instead, we peek at the next
+// "HUFF_LOOKUP_BITS" bits, and use these to index a table (built from the tree, once).  Almost all codes are
+// no longer than this, and so are decoded by a single table lookup.  For longer codes, the table tells us where in
+// the tree to continue walking from:
+#define HUFF_LOOKUP_BITS 8
+
+enum huffLookupKind { HUFF_LOOKUP_FALLBACK, HUFF_LOOKUP_LEAF, HUFF_LOOKUP_CONTINUE };
+struct huffLookupEntry {
+  unsigned char kind; /* a "huffLookupKind" */
+  unsigned char numBits; /*the length of the code (for HUFF_LOOKUP_LEAF)*/
+  unsigned char value; /*the decoded value (x<<4|y) (for HUFF_LOOKUP_LEAF)*/
+  unsigned short point; /*where to continue walking the tree from (for HUFF_LOOKUP_CONTINUE)*/
+};
+
+static Boolean useHuffmanLookupTables = True; // see "MP3HuffmanSetUseLookupTables()"
+
+void MP3HuffmanSetUseLookupTables(Boolean useLookupTables) {
+  useHuffmanLookupTables = useLookupTables;
+}
+
 static struct huffcodetab rsf_ht[HTN]; // array of all huffcodetable headers
 				/* 0..31 Huffman code table 0..31	*/
 				/* 32,33 count1-tables			*/
@@ -417,6 +438,42 @@ static int read_decoder_table(unsigned char* fi) {
   return n;
 }
 
+static unsigned nextTreePoint(struct huffcodetab const* h, unsigned point, unsigned bit) {
+  // Moves down the decoder tree (from a non-leaf "point"), exactly as "rsf_huffman_decoder()" does:
+  while (h->val[point][bit] >= MXOFF) point += h->val[point][bit];
+  return point + h->val[point][bit];
+}
+
+static void build_lookup_table(struct huffcodetab* h) {
+  h->lookup = new huffLookupEntry[1<<HUFF_LOOKUP_BITS];
+
+  for (unsigned bits = 0; bits < (1<<HUFF_LOOKUP_BITS); ++bits) {
+    huffLookupEntry& entry = h->lookup[bits];
+    entry.kind = HUFF_LOOKUP_CONTINUE;
+    entry.numBits = entry.value = 0;
+
+    // Walk the tree using "bits" (most significant bit first):
+    unsigned point = 0;
+    for (unsigned i = 0; i <= HUFF_LOOKUP_BITS; ++i) {
+      if (point >= h->treelen) {
+	// An illegal code; let the tree walk handle (i.e., report) it:
+	entry.kind = HUFF_LOOKUP_FALLBACK;
+	break;
+      }
+      if (h->val[point][0] == 0) { /*end of tree*/
+	entry.kind = HUFF_LOOKUP_LEAF;
+	entry.numBits = i;
+	entry.value = h->val[point][1];
+	break;
+      }
+      if (i == HUFF_LOOKUP_BITS) break; // the code is longer than this
+
+      point = nextTreePoint(h, point, (bits >> (HUFF_LOOKUP_BITS-1-i)) & 1);
+    }
+    entry.point = point;
+  }
+}
+
 static void initialize_huffman() {
   static Boolean huffman_initialized = False;
 
@@ -428,6 +485,15 @@ static void initialize_huffman() {
 #endif
       return;
       }
+
+   // Build the lookup table for each decoder tree (sharing it with any tables that reference the same tree):
+   for (unsigned n = 0; n < HTN; ++n) {
+     if (rsf_ht[n].ref >= 0) {
+       rsf_ht[n].lookup = rsf_ht[rsf_ht[n].ref].lookup;
+     } else if (rsf_ht[n].val != NULL && rsf_ht[n].treelen > 0) {
+       build_lookup_table(&rsf_ht[n]);
+     }
+   }
    huffman_initialized = True;
 }
 
@@ -626,6 +692,19 @@ static int rsf_huffman_decoder(BitVector& bv,
 
   /* Lookup in Huffman table. */
 
+  /* First, decode (up to) the first HUFF_LOOKUP_BITS bits at once: */
+  if (h->lookup != NULL && useHuffmanLookupTables) {
+    huffLookupEntry const& entry = h->lookup[bv.peekBits(HUFF_LOOKUP_BITS)];
+    if (entry.kind == HUFF_LOOKUP_LEAF) {
+      bv.skipBits(entry.numBits);
+      point = entry.point;
+    } else if (entry.kind == HUFF_LOOKUP_CONTINUE) {
+      bv.skipBits(HUFF_LOOKUP_BITS);
+      point = entry.point;
+      level >>= HUFF_LOOKUP_BITS;
+    }
+  }
+
   do {
     if (h->val[point][0]==0) {   /*end of tree*/
       *x = h->val[point][1] >> 4;
@@ -58,6 +58,10 @@ void MP3HuffmanDecode(MP3SideInfo::gr_info_s_t* gr, Boolean isMPEG2,
 		      unsigned& scaleFactorsLength,
 		      MP3HuffmanEncodingInfo& hei);
 
+void MP3HuffmanSetUseLookupTables(Boolean useLookupTables);
+    // For testing and benchmarking: if False, "MP3HuffmanDecode()" walks each decoder tree one bit at a time, rather than
+    // first using its lookup table.  (The default is True.)
+
 extern unsigned char huffdec[]; // huffman table data
 
 // The following are used if we process Huffman-decoded values
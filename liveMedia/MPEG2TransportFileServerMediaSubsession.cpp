@@ -151,8 +151,43 @@ void MPEG2TransportFileServerMediaSubsession
   OnDemandServerMediaSubsession::deleteStream(clientSessionId, streamToken);
 }
 
+void MPEG2TransportFileServerMediaSubsession::handleKeyFrameRequest(FramedSource* inputSource) {
+  if (fIndexFile == NULL) return; // we don't know where the key frames are
+
+  // Find the client that's being streamed "inputSource", and skip its stream ahead to the next key frame:
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fClientSessionHashTable);
+  ClientTrickPlayState* client;
+  char const* key; // dummy
+  while ((client = (ClientTrickPlayState*)(iter->next(key))) != NULL) {
+    if (client->source() == inputSource) {
+      client->skipToNextCleanPoint();
+      break;
+    }
+  }
+  delete iter;
+}
+
+void MPEG2TransportFileServerMediaSubsession::closeStreamSource(FramedSource* inputSource) {
+  if (fIndexFile != NULL && inputSource != NULL) { // we support 'trick play'
+    // Let the client whose framer this is release the sources that closing the framer won't:
+    HashTable::Iterator* iter = HashTable::Iterator::create(*fClientSessionHashTable);
+    ClientTrickPlayState* client;
+    char const* key; // dummy
+    while ((client = (ClientTrickPlayState*)(iter->next(key))) != NULL) {
+      if (client->source() == inputSource) {
+	client->handleStreamDeletion();
+	break;
+      }
+    }
+    delete iter;
+  }
+
+  // Call the original, default version of this routine:
+  OnDemandServerMediaSubsession::closeStreamSource(inputSource);
+}
+
 ClientTrickPlayState* MPEG2TransportFileServerMediaSubsession::newClientTrickPlayState() {
-  return new ClientTrickPlayState(fIndexFile);
+  return new ClientTrickPlayState(fIndexFile, fFileName);
 }
 
 FramedSource* MPEG2TransportFileServerMediaSubsession
@@ -164,6 +199,7 @@ FramedSource* MPEG2TransportFileServerMediaSubsession
     = ByteStreamFileSource::createNew(envir(), fFileName, inputDataChunkSize);
   if (fileSource == NULL) return NULL;
   fFileSize = fileSource->fileSize();
+  if (fIndexFile != NULL) fDuration = fIndexFile->getPlayingDuration(); // in case the file (and its index) have grown
 
   // Use the file size and the duration to estimate the stream's bitrate:
   if (fFileSize > 0 && fDuration > 0.0) {
@@ -211,7 +247,9 @@ void MPEG2TransportFileServerMediaSubsession::testScaleFactor(float& scale) {
 }
 
 float MPEG2TransportFileServerMediaSubsession::duration() const {
-  return fDuration;
+  // Ask the index file each time, because - if the Transport Stream file is still being recorded (and indexed) - it grows.
+  // (This is cheap: the index file re-reads the duration only after it has grown.)
+  return fIndexFile != NULL ? fIndexFile->getPlayingDuration() : fDuration;
 }
 
 ClientTrickPlayState* MPEG2TransportFileServerMediaSubsession
@@ -222,13 +260,22 @@ ClientTrickPlayState* MPEG2TransportFileServerMediaSubsession
 
 ////////// ClientTrickPlayState implementation //////////
 
-ClientTrickPlayState::ClientTrickPlayState(MPEG2TransportStreamIndexFile* indexFile)
+ClientTrickPlayState::ClientTrickPlayState(MPEG2TransportStreamIndexFile* indexFile, char const* tsFileName)
   : fIndexFile(indexFile),
     fOriginalTransportStreamSource(NULL),
     fTrickModeFilter(NULL), fTrickPlaySource(NULL),
     fFramer(NULL),
     fScale(1.0f), fNextScale(1.0f), fNPT(0.0f),
-    fTSRecordNum(0), fIxRecordNum(0) {
+    fTSRecordNum(0), fIxRecordNum(0),
+    fTSFileName(tsFileName), fPreRenderedSource(NULL), fPreRenderedIndexFile(NULL),
+    fPreRenderedTSRecordNum(0), fTrickPlayPCRLimit(0.0f) {
+  fLastCleanPointSkipTime.tv_sec = fLastCleanPointSkipTime.tv_usec = 0;
+}
+
+ClientTrickPlayState::~ClientTrickPlayState() {
+  Medium::close(fPreRenderedIndexFile);
+  // Note: Our sources (including "fPreRenderedSource", if any) are closed when our framer is (see "handleStreamDeletion()"),
+  // not here
 }
 
 unsigned long ClientTrickPlayState::updateStateFromNPT(double npt, double streamDuration) {
@@ -280,6 +327,7 @@ unsigned long ClientTrickPlayState::updateStateFromNPT(double npt, double stream
   }
   fFramer->setNumTSPacketsToStream(numTSRecordsToStream);
   fFramer->setPCRLimit(pcrLimit);
+  fTrickPlayPCRLimit = pcrLimit; // in case we later stream from a pre-rendered 'trick play' file instead
 
   return numTSRecordsToStream;
 }
@@ -296,7 +344,11 @@ void ClientTrickPlayState::updateStateOnScaleChange() {
     fTrickPlaySource = NULL;
     fTrickModeFilter = NULL;
   }
-  if (fNextScale != 1.0f) {
+  closePreRenderedSource();
+  if (fNextScale != 1.0f && openPreRenderedSource()) {
+    // Stream (sequentially) from a pre-rendered copy of the trick play stream:
+    fFramer->changeInputSource(fPreRenderedSource);
+  } else if (fNextScale != 1.0f) {
     // Create a new trick play filter from the original Transport Stream source:
     UsageEnvironment& env = fIndexFile->envir(); // alias
     fTrickModeFilter = MPEG2TransportStreamTrickModeFilter
@@ -316,6 +368,21 @@ void ClientTrickPlayState::updateStateOnScaleChange() {
 }
 
 void ClientTrickPlayState::updateStateOnPlayChange(Boolean reverseToPreviousVSH) {
+  if (fPreRenderedSource != NULL) {
+    // We were streaming a pre-rendered trick play file.  Use its index file to find the PCR that we reached in it,
+    // and from this, the corresponding npt (and record numbers) in the original file:
+    if (fFramer != NULL) fPreRenderedTSRecordNum += (unsigned long)(fFramer->tsPacketCount());
+    float pcr;
+    unsigned long ixRecordNum; // dummy
+    fPreRenderedIndexFile->lookupPCRFromTSPacketNum(fPreRenderedTSRecordNum, False, pcr, ixRecordNum);
+
+    float npt = preRenderedStartNPT(fScale) + pcr*fScale;
+    if (npt < 0.0f) npt = 0.0f;
+    fIndexFile->lookupTSPacketNumFromNPT(npt, fTSRecordNum, fIxRecordNum);
+    fNPT = npt;
+    return;
+  }
+
   updateTSRecordNum();
   if (fTrickPlaySource == NULL) {
     // We were in regular (1x) play. Use the index file to look up the
@@ -337,7 +404,48 @@ void ClientTrickPlayState::updateStateOnPlayChange(Boolean reverseToPreviousVSH)
   }
 }
 
+Boolean ClientTrickPlayState::skipToNextCleanPoint() {
+  if (fTrickPlaySource != NULL || fPreRenderedSource != NULL || fFramer == NULL) {
+    return False; // a 'trick play' stream is made up of key frames anyway
+  }
+
+  // Don't do this more than once a second, otherwise a client that keeps asking would skip much of the stream:
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  if (timeNow.tv_sec - fLastCleanPointSkipTime.tv_sec < 2
+      && (timeNow.tv_sec - fLastCleanPointSkipTime.tv_sec)*1000000
+         + (timeNow.tv_usec - fLastCleanPointSkipTime.tv_usec) < 1000000) return False;
+
+  // Note: We skip forward (rather than back to the previous clean point), so that the viewer never sees media replayed:
+  updateTSRecordNum();
+  fFramer->resetTSPacketCount(); // because "fTSRecordNum" now counts up to the current position
+  unsigned long tsRecordNum = fTSRecordNum;
+  float npt;
+  unsigned long ixRecordNum;
+  if (!fIndexFile->lookupNextCleanPoint(tsRecordNum, npt, ixRecordNum)) return False; // e.g., we're in the last GOP
+  fLastCleanPointSkipTime = timeNow;
+
+  fTSRecordNum = tsRecordNum; fNPT = npt; fIxRecordNum = ixRecordNum;
+  reseekOriginalTransportStreamSource();
+  fFramer->clearPIDStatusTable();
+  return True;
+}
+
+void ClientTrickPlayState::handleStreamDeletion() {
+  // Closing our framer also closes its current input source, and - through it - any 'trick play' filter, and the
+  // original Transport Stream source beneath that.  But when the framer is reading a pre-rendered 'trick play' file,
+  // the original Transport Stream source is not part of this chain, so we close it ourself:
+  if (fPreRenderedSource != NULL) Medium::close(fOriginalTransportStreamSource);
+  fOriginalTransportStreamSource = NULL;
+  fPreRenderedSource = NULL;
+  Medium::close(fPreRenderedIndexFile); fPreRenderedIndexFile = NULL;
+  fTrickModeFilter = NULL; fTrickPlaySource = NULL;
+  fFramer = NULL;
+  fScale = 1.0f; // because any new framer will begin by reading the original Transport Stream source
+}
+
 void ClientTrickPlayState::setSource(MPEG2TransportStreamFramer* framer) {
+  // Any previous framer (and the sources beneath it) will already have been closed - see "handleStreamDeletion()":
   fFramer = framer;
   fOriginalTransportStreamSource = (ByteStreamFileSource*)(framer->inputSource());
 }
@@ -350,3 +458,53 @@ void ClientTrickPlayState::reseekOriginalTransportStreamSource() {
   u_int64_t tsRecordNum64 = (u_int64_t)fTSRecordNum;
   fOriginalTransportStreamSource->seekToByteAbsolute(tsRecordNum64*TRANSPORT_PACKET_SIZE);
 }
+
+Boolean ClientTrickPlayState::openPreRenderedSource() {
+  char* fileName = MPEG2TransportStreamTrickModeFilter::preRenderedFileName(fTSFileName, int(fNextScale));
+  if (fileName == NULL) return False;
+
+  // The pre-rendered file must have its own index file, so that we can find our current position in it:
+  UsageEnvironment& env = fIndexFile->envir(); // alias
+  char* indexFileName = new char[strlen(fileName)+2]; // allow for trailing x\0
+  sprintf(indexFileName, "%sx", fileName);
+  fPreRenderedIndexFile = MPEG2TransportStreamIndexFile::createNew(env, indexFileName);
+  delete[] indexFileName;
+  if (fPreRenderedIndexFile != NULL) {
+    fPreRenderedSource = ByteStreamFileSource::createNew(env, fileName,
+							 TRANSPORT_PACKETS_PER_NETWORK_PACKET*TRANSPORT_PACKET_SIZE);
+  }
+  delete[] fileName;
+  if (fPreRenderedSource == NULL) {
+    closePreRenderedSource();
+    return False;
+  }
+
+  // The pre-rendered file's PCRs start at 0.0, and advance 1/|scale| times as fast as the original file's npt.
+  // Use this to seek to our current position:
+  float pcr = (fNPT - preRenderedStartNPT(fNextScale))/fNextScale;
+  if (pcr < 0.0f) pcr = 0.0f;
+  unsigned long ixRecordNum; // dummy
+  fPreRenderedIndexFile->lookupTSPacketNumFromNPT(pcr, fPreRenderedTSRecordNum, ixRecordNum);
+  fPreRenderedSource->seekToByteAbsolute((u_int64_t)fPreRenderedTSRecordNum*TRANSPORT_PACKET_SIZE);
+
+  // Because this stream doesn't begin at PCR 0.0, offset any PCR limit that was set for it:
+  if (fTrickPlayPCRLimit != 0.0f) fFramer->setPCRLimit(pcr + fTrickPlayPCRLimit);
+  return True;
+}
+
+void ClientTrickPlayState::closePreRenderedSource() {
+  Medium::close(fPreRenderedSource); fPreRenderedSource = NULL;
+  Medium::close(fPreRenderedIndexFile); fPreRenderedIndexFile = NULL;
+}
+
+float ClientTrickPlayState::preRenderedStartNPT(float scale) {
+  // A pre-rendered file for fast forward begins at the start of the original file; one for reverse play begins at the
+  // original file's last clean point (because that's where "MPEG2TransportStreamIndexer" began rendering it):
+  float npt = 0.0f;
+  if (scale < 0.0f) {
+    unsigned long tsRecordNum, ixRecordNum; // dummies
+    npt = fIndexFile->getPlayingDuration();
+    fIndexFile->lookupTSPacketNumFromNPT(npt, tsRecordNum, ixRecordNum);
+  }
+  return npt;
+}
@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // Implementation
 
 #include "MPEG2TransportStreamFromESSource.hh"
+#include "GOPCache.hh"
 
 #define MAX_INPUT_ES_FRAME_SIZE 100000
 #define SIMPLE_PES_HEADER_SIZE 14
@@ -43,11 +44,7 @@ public:
   Boolean deliverBufferToClient();
 
   unsigned char* buffer() const { return fInputBuffer; }
-  void reset() {
-    // Reset the buffer for future use:
-    fInputBufferBytesAvailable = 0;
-    fInputBufferInUse = False;
-  }
+  void reset();
 
 private:
   static void afterGettingFrame(void* clientData, unsigned frameSize,
@@ -57,6 +54,9 @@ private:
   void afterGettingFrame1(unsigned frameSize,
                           unsigned numTruncatedBytes,
                           struct timeval presentationTime);
+  void beginPESPacket(); // writes a simple PES header at the start of the buffer
+  void setSCR(struct timeval const& presentationTime);
+  Boolean beginsGOP(unsigned char const* frame, unsigned frameSize);
 
 private:
   InputESSourceRecord* fNext;
@@ -68,6 +68,11 @@ private:
   unsigned fInputBufferBytesAvailable;
   Boolean fInputBufferInUse;
   MPEG1or2Demux::SCR fSCR;
+  // For H.264 or H.265 video, we begin each GOP in a new PES packet, so we hold back a GOP's first NAL unit until the
+  // previous PES packet has been delivered:
+  Boolean fLastNALUnitWasKey;
+  unsigned fHeldBackFrameOffset, fHeldBackFrameSize; // "fHeldBackFrameSize" == 0 means: none
+  struct timeval fHeldBackPresentationTime;
 };
 
 
@@ -158,7 +163,8 @@ InputESSourceRecord
 		      u_int8_t streamId, int mpegVersion,
 		      InputESSourceRecord* next)
   : fNext(next), fParent(parent), fInputSource(inputSource),
-    fStreamId(streamId), fMPEGVersion(mpegVersion) {
+    fStreamId(streamId), fMPEGVersion(mpegVersion),
+    fLastNALUnitWasKey(False), fHeldBackFrameOffset(0), fHeldBackFrameSize(0) {
   fInputBuffer = new unsigned char[INPUT_BUFFER_SIZE];
   reset();
 }
@@ -169,21 +175,40 @@ InputESSourceRecord::~InputESSourceRecord() {
   delete fNext;
 }
 
+void InputESSourceRecord::reset() {
+  // Reset the buffer for future use:
+  fInputBufferBytesAvailable = 0;
+  fInputBufferInUse = False;
+
+  if (fHeldBackFrameSize > 0) {
+    // Begin the next PES packet with the frame that we held back:
+    beginPESPacket();
+    memmove(&fInputBuffer[SIMPLE_PES_HEADER_SIZE], &fInputBuffer[fHeldBackFrameOffset], fHeldBackFrameSize);
+    fInputBufferBytesAvailable += fHeldBackFrameSize;
+    setSCR(fHeldBackPresentationTime);
+    fHeldBackFrameSize = 0;
+  }
+}
+
+void InputESSourceRecord::beginPESPacket() {
+  fInputBuffer[0] = 0; fInputBuffer[1] = 0; fInputBuffer[2] = 1;
+  fInputBuffer[3] = fStreamId;
+  fInputBuffer[4] = 0; fInputBuffer[5] = 0; // fill in later with the length
+  fInputBuffer[6] = 0x80;
+  fInputBuffer[7] = 0x80; // include a PTS
+  fInputBuffer[8] = 5; // PES_header_data_length (enough for a PTS)
+  // fInputBuffer[9..13] will be the PTS; fill this in later
+  fInputBufferBytesAvailable = SIMPLE_PES_HEADER_SIZE;
+}
+
 void InputESSourceRecord::askForNewData() {
   if (fInputBufferInUse) return;
 
   if (fInputBufferBytesAvailable == 0) {
     // Reset our buffer, by adding a simple PES header at the start:
-    fInputBuffer[0] = 0; fInputBuffer[1] = 0; fInputBuffer[2] = 1;
-    fInputBuffer[3] = fStreamId;
-    fInputBuffer[4] = 0; fInputBuffer[5] = 0; // fill in later with the length
-    fInputBuffer[6] = 0x80;
-    fInputBuffer[7] = 0x80; // include a PTS
-    fInputBuffer[8] = 5; // PES_header_data_length (enough for a PTS)
-    // fInputBuffer[9..13] will be the PTS; fill this in later
-    fInputBufferBytesAvailable = SIMPLE_PES_HEADER_SIZE;
+    beginPESPacket();
   }
-  if (fInputBufferBytesAvailable < LOW_WATER_MARK &&
+  if (fInputBufferBytesAvailable < LOW_WATER_MARK && fHeldBackFrameSize == 0 &&
       !fInputSource->isCurrentlyAwaitingData()) {
     // We don't yet have enough data in our buffer.  Arrange to read more:
     fInputSource->getNextFrame(&fInputBuffer[fInputBufferBytesAvailable],
@@ -194,7 +219,9 @@ void InputESSourceRecord::askForNewData() {
 }
 
 Boolean InputESSourceRecord::deliverBufferToClient() {
-  if (fInputBufferInUse || fInputBufferBytesAvailable < LOW_WATER_MARK) return False;
+  if (fInputBufferInUse) return False;
+  if (fInputBufferBytesAvailable < LOW_WATER_MARK && fHeldBackFrameSize == 0) return False;
+      // (If we're holding back a frame, then our PES packet is complete, however small it is.)
 
   // Fill in the PES_packet_length field that we left unset before:
   unsigned PES_packet_length = fInputBufferBytesAvailable - 6;
@@ -237,23 +264,54 @@ void InputESSourceRecord
 		    << numTruncatedBytes << " bytes!\n";
   }
 
-  if (fInputBufferBytesAvailable == SIMPLE_PES_HEADER_SIZE) {
-    // Use this presentationTime for our SCR:
-    fSCR.highBit
-      = ((presentationTime.tv_sec*45000 + (presentationTime.tv_usec*9)/200)&
-	 0x80000000) != 0;
-    fSCR.remainingBits
-      = presentationTime.tv_sec*90000 + (presentationTime.tv_usec*9)/100;
-    fSCR.extension = (presentationTime.tv_usec*9)%100;
-#ifdef DEBUG_SCR
-    fprintf(stderr, "PES header: stream_id 0x%02x, pts: %u.%06u => SCR 0x%x%08x:%03x\n", fStreamId, (unsigned)presentationTime.tv_sec, (unsigned)presentationTime.tv_usec, fSCR.highBit, fSCR.remainingBits, fSCR.extension);
-#endif
-  }
+  if (beginsGOP(&fInputBuffer[fInputBufferBytesAvailable], frameSize)
+      && fInputBufferBytesAvailable > SIMPLE_PES_HEADER_SIZE) {
+    // This frame begins a new GOP, so hold it back (to begin our next PES packet), and deliver what we already have:
+    fHeldBackFrameOffset = fInputBufferBytesAvailable;
+    fHeldBackFrameSize = frameSize;
+    fHeldBackPresentationTime = presentationTime;
+  } else {
+    if (fInputBufferBytesAvailable == SIMPLE_PES_HEADER_SIZE) {
+      // Use this presentationTime for our SCR:
+      setSCR(presentationTime);
+    }
 
-  fInputBufferBytesAvailable += frameSize;
+    fInputBufferBytesAvailable += frameSize;
+  }
 
   fParent.fPresentationTime = presentationTime;
 
   // Now that we have new input data, check if we can deliver to the client:
   fParent.awaitNewBuffer(NULL);
 }
+
+void InputESSourceRecord::setSCR(struct timeval const& presentationTime) {
+  fSCR.highBit
+    = ((presentationTime.tv_sec*45000 + (presentationTime.tv_usec*9)/200)&
+       0x80000000) != 0;
+  fSCR.remainingBits
+    = presentationTime.tv_sec*90000 + (presentationTime.tv_usec*9)/100;
+  fSCR.extension = (presentationTime.tv_usec*9)%100;
+#ifdef DEBUG_SCR
+  fprintf(stderr, "PES header: stream_id 0x%02x, pts: %u.%06u => SCR 0x%x%08x:%03x\n", fStreamId, (unsigned)presentationTime.tv_sec, (unsigned)presentationTime.tv_usec, fSCR.highBit, fSCR.remainingBits, fSCR.extension);
+#endif
+}
+
+Boolean InputESSourceRecord::beginsGOP(unsigned char const* frame, unsigned frameSize) {
+  if (fMPEGVersion != 5 && fMPEGVersion != 6) return False; // we check only H.264 and H.265 video
+
+  // Skip over any 'start code' at the front of the NAL unit:
+  if (frameSize >= 4 && frame[0] == 0 && frame[1] == 0 && frame[2] == 0 && frame[3] == 1) {
+    frame += 4; frameSize -= 4;
+  } else if (frameSize >= 3 && frame[0] == 0 && frame[1] == 0 && frame[2] == 1) {
+    frame += 3; frameSize -= 3;
+  }
+  if (frameSize == 0) return False;
+
+  GOPCache::NALKind const kind = GOPCache::nalKind(frame[0], fMPEGVersion == 6);
+  if (kind == GOPCache::NEUTRAL_NAL) return False;
+
+  Boolean const result = kind == GOPCache::KEY_NAL && !fLastNALUnitWasKey;
+  fLastNALUnitWasKey = kind == GOPCache::KEY_NAL;
+  return result;
+}
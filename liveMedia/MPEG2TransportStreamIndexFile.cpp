@@ -28,7 +28,8 @@ MPEG2TransportStreamIndexFile
 ::MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName)
   : Medium(env),
     fFileName(strDup(indexFileName)), fFid(NULL), fMPEGVersion(0), fCurrentIndexRecordNum(0),
-    fCachedPCR(0.0f), fCachedTSPacketNumber(0), fNumIndexRecords(0) {
+    fCachedPCR(0.0f), fCachedTSPacketNumber(0), fNumIndexRecords(0),
+    fPlayingDuration(0.0f), fNumIndexRecordsAtPlayingDuration(0) {
   // Get the file size, to determine how many index records it contains:
   u_int64_t indexFileSize = GetFileSize(indexFileName, NULL);
   if (indexFileSize % INDEX_RECORD_SIZE != 0) {
@@ -40,6 +41,14 @@ MPEG2TransportStreamIndexFile
   fNumIndexRecords = (unsigned long)(indexFileSize/INDEX_RECORD_SIZE);
 }
 
+void MPEG2TransportStreamIndexFile::updateNumIndexRecords() {
+  // The index file might still be growing (if it's being written - by an indexer in 'follow' mode - for a Transport Stream
+  // file that's still being recorded), so check its size again.  (Any partially-written record at the end is ignored.)
+  if (fFileName == NULL) return;
+  unsigned long numIndexRecords = (unsigned long)(GetFileSize(fFileName, NULL)/INDEX_RECORD_SIZE);
+  if (numIndexRecords > fNumIndexRecords) fNumIndexRecords = numIndexRecords;
+}
+
 MPEG2TransportStreamIndexFile* MPEG2TransportStreamIndexFile
 ::createNew(UsageEnvironment& env, char const* indexFileName) {
   if (indexFileName == NULL) return NULL;
@@ -63,6 +72,7 @@ MPEG2TransportStreamIndexFile::~MPEG2TransportStreamIndexFile() {
 void MPEG2TransportStreamIndexFile
 ::lookupTSPacketNumFromNPT(float& npt, unsigned long& tsPacketNumber,
 			   unsigned long& indexRecordNumber) {
+  updateNumIndexRecords();
   if (npt <= 0.0 || fNumIndexRecords == 0) { // Fast-track a common case:
     npt = 0.0f;
     tsPacketNumber = indexRecordNumber = 0;
@@ -128,6 +138,7 @@ void MPEG2TransportStreamIndexFile
 void MPEG2TransportStreamIndexFile
 ::lookupPCRFromTSPacketNum(unsigned long& tsPacketNumber, Boolean reverseToPreviousCleanPoint,
 			   float& pcr, unsigned long& indexRecordNumber) {
+  updateNumIndexRecords();
   if (tsPacketNumber == 0 || fNumIndexRecords == 0) { // Fast-track a common case:
     pcr = 0.0f;
     indexRecordNumber = 0;
@@ -195,6 +206,36 @@ void MPEG2TransportStreamIndexFile
   closeFid();
 }
 
+Boolean MPEG2TransportStreamIndexFile
+::lookupNextCleanPoint(unsigned long& tsPacketNumber, float& pcr, unsigned long& indexRecordNumber) {
+  // Begin with the index record for "tsPacketNumber", then scan forward from there:
+  unsigned long tsNum = tsPacketNumber; // because "lookupPCRFromTSPacketNum()" can change it
+  float pcrDummy;
+  unsigned long ixFound;
+  lookupPCRFromTSPacketNum(tsNum, False, pcrDummy, ixFound);
+
+  Boolean success = False;
+  for (; ixFound < fNumIndexRecords; ++ixFound) {
+    if (!readIndexRecord(ixFound)) break;
+
+    u_int8_t recordType = recordTypeFromBuf();
+    setMPEGVersionFromRecordType(recordType);
+    if (tsPacketNumFromBuf() >= tsPacketNumber && isCleanPoint(recordType)) {
+      success = True;
+      break;
+    }
+  }
+
+  if (success) {
+    // Return (and cache) information from record "ixFound":
+    pcr = fCachedPCR = pcrFromBuf();
+    tsPacketNumber = fCachedTSPacketNumber = tsPacketNumFromBuf();
+    indexRecordNumber = fCachedIndexRecordNumber = ixFound;
+  }
+  closeFid();
+  return success;
+}
+
 Boolean MPEG2TransportStreamIndexFile
 ::readIndexRecordValues(unsigned long indexRecordNum,
 			unsigned long& transportPacketNum, u_int8_t& offset,
@@ -210,9 +251,16 @@ Boolean MPEG2TransportStreamIndexFile
 }
 
 float MPEG2TransportStreamIndexFile::getPlayingDuration() {
-  if (fNumIndexRecords == 0 || !readOneIndexRecord(fNumIndexRecords-1)) return 0.0f;
+  updateNumIndexRecords();
+  if (fNumIndexRecords != fNumIndexRecordsAtPlayingDuration) {
+    // This is the first time that we've been called, or the index file has grown since, so read its (new) last record:
+    if (fNumIndexRecords == 0 || !readOneIndexRecord(fNumIndexRecords-1)) return fPlayingDuration;
+
+    fPlayingDuration = pcrFromBuf();
+    fNumIndexRecordsAtPlayingDuration = fNumIndexRecords;
+  }
 
-  return pcrFromBuf();
+  return fPlayingDuration;
 }
 
 int MPEG2TransportStreamIndexFile::mpegVersion() {
@@ -254,12 +302,17 @@ Boolean MPEG2TransportStreamIndexFile::readIndexRecord(unsigned long indexRecord
     return True;
   } while (0);
 
+  // We no longer know where we are within "fFid", so make sure that our next read seeks first.  (This also clears the
+  // end-of-file condition, so that - if the index file is still growing - that read will see any newly-appended records.)
+  fCurrentIndexRecordNum = ~0UL;
   return False; // an error occurred
 }
 
 Boolean MPEG2TransportStreamIndexFile::readOneIndexRecord(unsigned long indexRecordNum) {
+  // If "fFid" is already open, then a 'trick play' filter is reading through the file, so leave it open for it:
+  Boolean fidWasOpen = fFid != NULL;
   Boolean result = readIndexRecord(indexRecordNum);
-  closeFid();
+  if (!fidWasOpen) closeFid();
 
   return result;
 }
@@ -292,6 +345,15 @@ void MPEG2TransportStreamIndexFile::setMPEGVersionFromRecordType(u_int8_t record
       // represents H.265
 }
 
+Boolean MPEG2TransportStreamIndexFile::isCleanPoint(u_int8_t recordType) {
+  if ((recordType&0x80) == 0) return False; // not the start of a 'frame'
+  recordType &=~ 0x80;
+
+  if (fMPEGVersion == 5) return recordType == 5/*SPS*/; // H.264
+  if (fMPEGVersion == 6) return recordType == 11/*VPS*/; // H.265
+  return recordType == 1/*VSH*/ || recordType == 2/*GOP*/; // MPEG-1, 2, or 4
+}
+
 Boolean MPEG2TransportStreamIndexFile::rewindToCleanPoint(unsigned long&ixFound) {
   Boolean success = False; // until we learn otherwise
 
@@ -0,0 +1,346 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A sink that records a MPEG Transport Stream into a sequence of segment files - each beginning at a key frame, with
+// the stream's most recent PAT and PMT - and lists them (as they are completed) in a HLS-style ".m3u8" playlist.
+// Implementation
+
+#include "MPEG2TransportStreamSegmentSink.hh"
+#include "GOPCache.hh"
+#include "MPEG2TransportStreamMultiplexor.hh" // for calculateCRC()
+#include "GroupsockHelper.hh"
+#include "OutputFile.hh"
+#include <time.h>
+
+#define TRANSPORT_PACKET_SIZE 188
+#define TRANSPORT_SYNC_BYTE 0x47
+
+static Boolean sectionIsIntact(unsigned char const* pkt, unsigned sectionOffset, unsigned section_length) {
+  // Checks the CRC of a PSI section that begins at "sectionOffset" in a Transport Stream packet.  (A section that
+  // continues into later packets can't be checked here, so we accept it.)
+  if (sectionOffset + 3 + section_length > TRANSPORT_PACKET_SIZE) return True;
+  return calculateCRC(&pkt[sectionOffset], 3 + section_length) == 0;
+}
+
+static unsigned payloadOffset(unsigned char const* pkt) {
+  // Returns the offset of a Transport Stream packet's payload (or TRANSPORT_PACKET_SIZE, if it has none):
+  u_int8_t const adaptation_field_control = (pkt[3]&0x30)>>4;
+  if ((adaptation_field_control&1) == 0) return TRANSPORT_PACKET_SIZE;
+  unsigned offset = 4;
+  if ((adaptation_field_control&2) != 0) offset += 1 + pkt[4];
+  return offset < TRANSPORT_PACKET_SIZE ? offset : TRANSPORT_PACKET_SIZE;
+}
+
+MPEG2TransportStreamSegmentSink*
+MPEG2TransportStreamSegmentSink::createNew(UsageEnvironment& env, char const* fileNamePrefix,
+					   unsigned segmentSeconds, unsigned maxSegmentBytes,
+					   unsigned bufferSize) {
+  char* playlistFileName = new char[strlen(fileNamePrefix) + 10];
+  sprintf(playlistFileName, "%s.m3u8", fileNamePrefix);
+  FILE* playlistFid = OpenOutputFile(env, playlistFileName);
+  delete[] playlistFileName;
+  if (playlistFid == NULL) return NULL;
+
+  return new MPEG2TransportStreamSegmentSink(env, playlistFid, fileNamePrefix,
+					     segmentSeconds, maxSegmentBytes, bufferSize);
+}
+
+MPEG2TransportStreamSegmentSink
+::MPEG2TransportStreamSegmentSink(UsageEnvironment& env, FILE* playlistFid, char const* fileNamePrefix,
+				  unsigned segmentSeconds, unsigned maxSegmentBytes, unsigned bufferSize)
+  : MediaSink(env),
+    fSegmentSeconds(segmentSeconds == 0 ? 1 : segmentSeconds), fMaxSegmentBytes(maxSegmentBytes),
+    fNumLeftoverBytes(0),
+    fHavePAT(False), fHavePMT(False), fPMT_PID(0), fPCR_PID(0), fVideoPID(0), fVideoStreamType(0),
+    fLastVideoUnitWasKey(False),
+    fSegmentFid(NULL), fSegmentNum(0), fSegmentBytes(0), fSegmentStartPCR(-1.0), fLastPCR(-1.0),
+    fPlaylistFid(playlistFid), fTargetDuration(fSegmentSeconds) {
+  fFileNamePrefix = strDup(fileNamePrefix);
+  char const* lastSlash = strrchr(fFileNamePrefix, '/');
+  fSegmentFileNameBase = lastSlash == NULL ? fFileNamePrefix : lastSlash + 1;
+
+  // Our buffer must be able to hold an incomplete packet (left over from one frame), plus at least one more packet:
+  if (bufferSize < 2*TRANSPORT_PACKET_SIZE) bufferSize = 2*TRANSPORT_PACKET_SIZE;
+  fBufferSize = bufferSize;
+  fBuffer = new unsigned char[fBufferSize];
+
+  gettimeofday(&fLastPacketTime, NULL);
+  fSegmentStartTime = fLastPacketTime;
+
+  // Begin the playlist.  We write the target duration with a fixed width, so that it can be updated in place if a
+  // segment turns out to be longer than "segmentSeconds" (because of a long GOP):
+  fprintf(fPlaylistFid, "#EXTM3U\n#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:");
+  fTargetDurationPosition = ftell(fPlaylistFid);
+  fprintf(fPlaylistFid, "%06u\n#EXT-X-MEDIA-SEQUENCE:0\n", fTargetDuration);
+  fflush(fPlaylistFid);
+}
+
+MPEG2TransportStreamSegmentSink::~MPEG2TransportStreamSegmentSink() {
+  endSegment();
+  fprintf(fPlaylistFid, "#EXT-X-ENDLIST\n");
+  CloseOutputFile(fPlaylistFid);
+
+  delete[] fBuffer;
+  delete[] fFileNamePrefix;
+}
+
+Boolean MPEG2TransportStreamSegmentSink::continuePlaying() {
+  if (fSource == NULL) return False;
+
+  fSource->getNextFrame(&fBuffer[fNumLeftoverBytes], fBufferSize - fNumLeftoverBytes,
+			afterGettingFrame, this,
+			onSourceClosure, this);
+
+  return True;
+}
+
+void MPEG2TransportStreamSegmentSink::afterGettingFrame(void* clientData, unsigned frameSize,
+							unsigned numTruncatedBytes,
+							struct timeval /*presentationTime*/,
+							unsigned /*durationInMicroseconds*/) {
+  MPEG2TransportStreamSegmentSink* sink = (MPEG2TransportStreamSegmentSink*)clientData;
+  sink->afterGettingFrame(frameSize, numTruncatedBytes);
+}
+
+void MPEG2TransportStreamSegmentSink::afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes) {
+  if (numTruncatedBytes > 0) {
+    envir() << "MPEG2TransportStreamSegmentSink::afterGettingFrame(): The input frame data was too large for our buffer size ("
+	    << fBufferSize << ").  "
+	    << numTruncatedBytes << " bytes of trailing data was dropped!  Correct this by increasing the \"bufferSize\" parameter in the \"createNew()\" call to at least "
+	    << fNumLeftoverBytes + frameSize + numTruncatedBytes << "\n";
+  }
+  gettimeofday(&fLastPacketTime, NULL);
+
+  // Handle each complete Transport Stream packet in the buffer:
+  unsigned char* ptr = fBuffer;
+  unsigned char* const limit = &fBuffer[fNumLeftoverBytes + frameSize];
+  while (limit - ptr >= TRANSPORT_PACKET_SIZE) {
+    if (ptr[0] != TRANSPORT_SYNC_BYTE) {
+      // We've lost packet synchronization (e.g., because data was truncated).  Look for the next sync byte:
+      ++ptr;
+      continue;
+    }
+
+    if (!handlePacket(ptr)) {
+      // We couldn't write our output.  Handle this the same way as if the input source had closed:
+      if (fSource != NULL) fSource->stopGettingFrames();
+      onSourceClosure();
+      return;
+    }
+    ptr += TRANSPORT_PACKET_SIZE;
+  }
+
+  // Keep any remaining (incomplete packet) data, to be completed by the next frame:
+  fNumLeftoverBytes = (unsigned)(limit - ptr);
+  if (fNumLeftoverBytes > 0) memmove(fBuffer, ptr, fNumLeftoverBytes);
+
+  // Then try getting the next frame:
+  continuePlaying();
+}
+
+Boolean MPEG2TransportStreamSegmentSink::handlePacket(unsigned char* pkt) {
+  u_int16_t const PID = ((pkt[1]&0x1F)<<8) | pkt[2];
+  Boolean const payload_unit_start_indicator = (pkt[1]&0x40) != 0;
+
+  if (PID == fPCR_PID && (pkt[3]&0x20) != 0 && pkt[4] >= 7 && (pkt[5]&0x10) != 0) {
+    // This packet has a PCR.  Note its 33-bit 'base' (in 90 kHz units):
+    u_int32_t const pcrHigh32Bits = (pkt[6]<<24) | (pkt[7]<<16) | (pkt[8]<<8) | pkt[9];
+    fLastPCR = pcrHigh32Bits/45000.0 + ((pkt[10]&0x80) != 0 ? 1/90000.0 : 0.0);
+    if (fSegmentStartPCR < 0.0) fSegmentStartPCR = fLastPCR;
+  }
+
+  if (payload_unit_start_indicator) {
+    if (PID == 0x0000) {
+      noteProgramAssociationTable(pkt);
+    } else if (PID == fPMT_PID && fPMT_PID != 0) {
+      noteProgramMapTable(pkt);
+    } else if (isSegmentBoundary(pkt, PID)) {
+      if (fSegmentFid == NULL) {
+	// This is our first key frame, so we can begin recording:
+	fSegmentStartPCR = fLastPCR;
+	if (!beginNewSegment()) return False;
+      } else if (segmentDuration() + 0.01/*allow for timestamp rounding*/ >= fSegmentSeconds
+		 || (fMaxSegmentBytes > 0 && fSegmentBytes >= fMaxSegmentBytes)) {
+	endSegment();
+	fSegmentStartPCR = fLastPCR;
+	if (!beginNewSegment()) return False;
+      }
+    }
+  }
+
+  if (fSegmentFid == NULL) return True; // we're still waiting for a key frame
+  return writeOutput(pkt, TRANSPORT_PACKET_SIZE);
+}
+
+Boolean MPEG2TransportStreamSegmentSink::isSegmentBoundary(unsigned char const* pkt, u_int16_t pid) {
+  // Called for each packet that begins a PES packet.
+  if (!fHavePMT) return False; // we don't yet know which stream is which
+
+  // If there's no video stream that we recognize, then we can begin a segment at any PES packet of the PCR stream:
+  if (fVideoPID == 0) return pid == fPCR_PID;
+  if (pid != fVideoPID) return False;
+
+  // Skip over the PES packet header:
+  unsigned char const* ptr = &pkt[payloadOffset(pkt)];
+  unsigned char const* const limit = &pkt[TRANSPORT_PACKET_SIZE];
+  if (limit - ptr < 9 || ptr[0] != 0 || ptr[1] != 0 || ptr[2] != 1) return False;
+  ptr += 9 + ptr[8]; // PES_header_data_length
+
+  // Look for the first start code that tells us whether this is a key frame:
+  Boolean const isH264or5 = fVideoStreamType == 0x1B || fVideoStreamType == 0x24;
+  for (; limit - ptr >= 4; ++ptr) {
+    if (ptr[0] != 0 || ptr[1] != 0 || ptr[2] != 1) continue;
+
+    Boolean isKey;
+    if (isH264or5) {
+      GOPCache::NALKind const kind = GOPCache::nalKind(ptr[3], fVideoStreamType == 0x24);
+      if (kind == GOPCache::NEUTRAL_NAL) continue;
+      isKey = kind == GOPCache::KEY_NAL;
+    } else { // MPEG-1 or 2 video
+      if (ptr[3] == 0xB3/*sequence header*/ || ptr[3] == 0xB8/*GOP header*/) {
+	isKey = True;
+      } else if (ptr[3] == 0x00/*picture header*/) {
+	isKey = False;
+      } else {
+	continue;
+      }
+    }
+
+    // A GOP begins with the first key data that follows non-key data:
+    Boolean const result = isKey && !fLastVideoUnitWasKey;
+    fLastVideoUnitWasKey = isKey;
+    return result;
+  }
+
+  return False;
+}
+
+void MPEG2TransportStreamSegmentSink::noteProgramAssociationTable(unsigned char const* pkt) {
+  // Keep a copy of the PAT (to begin each segment), and note the PID of the (first) program's PMT:
+  unsigned offset = payloadOffset(pkt);
+  if (offset >= TRANSPORT_PACKET_SIZE) return;
+  offset += 1 + pkt[offset]; // pointer_field
+  if (offset + 8 > TRANSPORT_PACKET_SIZE || pkt[offset] != 0x00/*table_id*/) return;
+
+  unsigned const section_length = ((pkt[offset+1]&0x0F)<<8) | pkt[offset+2];
+  if (!sectionIsIntact(pkt, offset, section_length)) return;
+  memmove(fPAT, pkt, TRANSPORT_PACKET_SIZE);
+  fHavePAT = True;
+
+  unsigned loopEnd = offset + 3 + section_length - 4/*CRC*/;
+  if (loopEnd > TRANSPORT_PACKET_SIZE) loopEnd = TRANSPORT_PACKET_SIZE;
+  for (offset += 8; offset + 4 <= loopEnd; offset += 4) {
+    u_int16_t const program_number = (pkt[offset]<<8) | pkt[offset+1];
+    if (program_number != 0) {
+      fPMT_PID = ((pkt[offset+2]&0x1F)<<8) | pkt[offset+3];
+      break;
+    }
+  }
+}
+
+void MPEG2TransportStreamSegmentSink::noteProgramMapTable(unsigned char const* pkt) {
+  // Keep a copy of the PMT (to begin each segment), and note the PCR PID, and the video stream (if any):
+  unsigned offset = payloadOffset(pkt);
+  if (offset >= TRANSPORT_PACKET_SIZE) return;
+  offset += 1 + pkt[offset]; // pointer_field
+  if (offset + 12 > TRANSPORT_PACKET_SIZE || pkt[offset] != 0x02/*table_id*/) return;
+
+  unsigned const section_length = ((pkt[offset+1]&0x0F)<<8) | pkt[offset+2];
+  if (!sectionIsIntact(pkt, offset, section_length)) return;
+  memmove(fPMT, pkt, TRANSPORT_PACKET_SIZE);
+  fHavePMT = True;
+
+  unsigned loopEnd = offset + 3 + section_length - 4/*CRC*/;
+  if (loopEnd > TRANSPORT_PACKET_SIZE) loopEnd = TRANSPORT_PACKET_SIZE;
+  fPCR_PID = ((pkt[offset+8]&0x1F)<<8) | pkt[offset+9];
+  unsigned const program_info_length = ((pkt[offset+10]&0x0F)<<8) | pkt[offset+11];
+
+  u_int16_t videoPID = 0;
+  for (offset += 12 + program_info_length; offset + 5 <= loopEnd;
+       offset += 5 + (((pkt[offset+3]&0x0F)<<8) | pkt[offset+4])/*ES_info_length*/) {
+    u_int8_t const stream_type = pkt[offset];
+    if (stream_type == 0x01 || stream_type == 0x02 /* MPEG-1 or 2 video */ ||
+	stream_type == 0x1B /* H.264 */ || stream_type == 0x24 /* H.265 */) {
+      videoPID = ((pkt[offset+1]&0x1F)<<8) | pkt[offset+2];
+      fVideoStreamType = stream_type;
+      break;
+    }
+  }
+  if (videoPID != fVideoPID) {
+    fVideoPID = videoPID;
+    fLastVideoUnitWasKey = False;
+  }
+}
+
+Boolean MPEG2TransportStreamSegmentSink::writeOutput(unsigned char const* data, unsigned dataSize) {
+  if (fwrite(data, 1, dataSize, fSegmentFid) != dataSize) return False;
+  fSegmentBytes += dataSize;
+  return True;
+}
+
+Boolean MPEG2TransportStreamSegmentSink::beginNewSegment() {
+  char* fileName = new char[strlen(fFileNamePrefix) + 20];
+  sprintf(fileName, "%s-%u.ts", fFileNamePrefix, fSegmentNum);
+  fSegmentFid = OpenOutputFile(envir(), fileName);
+  delete[] fileName;
+  if (fSegmentFid == NULL) return False;
+
+  fSegmentBytes = 0;
+  fSegmentStartTime = fLastPacketTime;
+
+  // Begin the segment with the PAT and PMT, so that it can be played on its own:
+  if (fHavePAT && !writeOutput(fPAT, TRANSPORT_PACKET_SIZE)) return False;
+  if (fHavePMT && !writeOutput(fPMT, TRANSPORT_PACKET_SIZE)) return False;
+  return True;
+}
+
+void MPEG2TransportStreamSegmentSink::endSegment() {
+  if (fSegmentFid == NULL) return;
+  CloseOutputFile(fSegmentFid);
+  fSegmentFid = NULL;
+
+  double const duration = segmentDuration();
+  unsigned const roundedDuration = (unsigned)(duration + 0.5);
+  if (roundedDuration > fTargetDuration && fTargetDurationPosition >= 0) {
+    // Update the playlist's target duration (in place):
+    fTargetDuration = roundedDuration;
+    fseek(fPlaylistFid, fTargetDurationPosition, SEEK_SET);
+    fprintf(fPlaylistFid, "%06u", fTargetDuration);
+    fseek(fPlaylistFid, 0, SEEK_END);
+  }
+
+  // Add the segment to the playlist:
+  time_t const startTime = fSegmentStartTime.tv_sec;
+  char startTimeStr[100];
+  strftime(startTimeStr, sizeof startTimeStr, "%Y-%m-%dT%H:%M:%S", gmtime(&startTime));
+  fprintf(fPlaylistFid, "#EXT-X-PROGRAM-DATE-TIME:%s.%03uZ\n#EXTINF:%.3f,\n%s-%u.ts\n",
+	  startTimeStr, (unsigned)(fSegmentStartTime.tv_usec/1000), duration, fSegmentFileNameBase, fSegmentNum);
+  fflush(fPlaylistFid);
+  ++fSegmentNum;
+}
+
+double MPEG2TransportStreamSegmentSink::segmentDuration() const {
+  if (fSegmentStartPCR >= 0.0 && fLastPCR >= 0.0) {
+    double duration = fLastPCR - fSegmentStartPCR;
+    if (duration < 0.0) duration += 0x200000000LL/90000.0; // the PCR wrapped around
+    return duration;
+  }
+
+  // We haven't seen PCRs, so use wall-clock time instead:
+  return (fLastPacketTime.tv_sec - fSegmentStartTime.tv_sec)
+    + (fLastPacketTime.tv_usec - fSegmentStartTime.tv_usec)/1000000.0;
+}
@@ -55,6 +55,16 @@ MPEG2TransportStreamTrickModeFilter
 MPEG2TransportStreamTrickModeFilter::~MPEG2TransportStreamTrickModeFilter() {
 }
 
+char* MPEG2TransportStreamTrickModeFilter::preRenderedFileName(char const* tsFileName, int scale) {
+  if (tsFileName == NULL) return NULL;
+  int len = strlen(tsFileName);
+  if (len < 3 || strcmp(&tsFileName[len-3], ".ts") != 0) return NULL;
+
+  char* fileName = new char[len + 16]; // more than enough for ".ff<scale>" or ".fr<scale>"
+  sprintf(fileName, "%.*s.f%c%d.ts", len-3, tsFileName, scale < 0 ? 'r' : 'f', scale < 0 ? -scale : scale);
+  return fileName;
+}
+
 Boolean MPEG2TransportStreamTrickModeFilter::seekTo(unsigned long tsPacketNumber,
 						    unsigned long indexRecordNumber) {
   seekToTransportPacket(tsPacketNumber);
@@ -34,37 +34,40 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include <TheoraVideoRTPSink.hh>
 #include <T140TextRTPSink.hh>
 
-////////// CuePoint definition //////////
+////////// CuePointTable definition //////////
 
 class CuePoint {
 public:
-  CuePoint(double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster/* 1-based */);
-  virtual ~CuePoint();
+  double cueTime;
+  u_int64_t clusterOffsetInFile;
+  unsigned blockNumWithinCluster; // 0-based
+};
 
-  static void addCuePoint(CuePoint*& root, double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster/* 1-based */,
-			  Boolean& needToReviseBalanceOfParent);
-    // If "cueTime" == "root.fCueTime", replace the existing data, otherwise add to the left or right subtree.
-    // (Note that this is a static member function because - as a result of tree rotation - "root" might change.)
+// The file's cue points, kept - sorted by "cueTime" - in a single contiguous array, so that lookups can use a binary search:
+class CuePointTable {
+public:
+  CuePointTable();
+  virtual ~CuePointTable();
 
-  Boolean lookup(double& cueTime, u_int64_t& resultClusterOffsetInFile, unsigned& resultBlockNumWithinCluster);
+  void add(double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster/* 1-based */);
+    // If there's already an entry for "cueTime", replace its data; otherwise insert a new entry.
+    // (Cue points are usually added in increasing "cueTime" order, in which case this is just an append.)
 
-  static void fprintf(FILE* fid, CuePoint* cuePoint); // used for debugging; it's static to allow for "cuePoint == NULL"
+  void lookup(double& cueTime, u_int64_t& resultClusterOffsetInFile, unsigned& resultBlockNumWithinCluster) const;
+    // Finds the last entry whose "cueTime" is <= "cueTime", and updates "cueTime" to the time of this entry.
+    // If there's no such entry, then "resultClusterOffsetInFile" and "resultBlockNumWithinCluster" are set to 0.
 
-private:
-  // The "CuePoint" tree is implemented as an AVL Tree, to keep it balanced (for efficient lookup).
-  CuePoint* fSubTree[2]; // 0 => left; 1 => right
-  CuePoint* left() const { return fSubTree[0]; }
-  CuePoint* right() const { return fSubTree[1]; }
-  char fBalance; // height of right subtree - height of left subtree
+  unsigned numEntries() const { return fNumEntries; }
 
-  static void rotate(unsigned direction/*0 => left; 1 => right*/, CuePoint*& root); // used to keep the tree in balance
+  void fprintf(FILE* fid) const; // used for debugging
 
-  double fCueTime;
-  u_int64_t fClusterOffsetInFile;
-  unsigned fBlockNumWithinCluster; // 0-based
-};
+private:
+  unsigned firstIndexAfter(double cueTime) const; // the index of the first entry whose "cueTime" is > "cueTime"
 
-UsageEnvironment& operator<<(UsageEnvironment& env, const CuePoint* cuePoint); // used for debugging
+private:
+  CuePoint* fEntries;
+  unsigned fNumEntries, fMaxEntries;
+};
 
 
 ////////// MatroskaTrackTable definition /////////
@@ -110,11 +113,13 @@ MatroskaFile::MatroskaFile(UsageEnvironment& env, char const* fileName, onCreati
     fFileName(strDup(fileName)), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
     fPreferredLanguage(strDup(preferredLanguage)),
     fTimecodeScale(1000000), fSegmentDuration(0.0), fSegmentDataOffset(0), fClusterOffset(0), fCuesOffset(0), fCuePoints(NULL),
-    fChosenVideoTrackNumber(0), fChosenAudioTrackNumber(0), fChosenSubtitleTrackNumber(0) {
+    fChosenVideoTrackNumber(0), fChosenAudioTrackNumber(0), fChosenSubtitleTrackNumber(0),
+    fScanClustersTask(NULL), fHaveSignalledCreation(False) {
   fTrackTable = new MatroskaTrackTable;
   fDemuxesTable = HashTable::create(ONE_WORD_HASH_KEYS);
 
-  FramedSource* inputSource = ByteStreamFileSource::createNew(envir(), fileName);
+  // Read the file in small chunks, because - if the file has no 'Cues' - we'll be seeking from one 'Cluster' header to the next:
+  FramedSource* inputSource = ByteStreamFileSource::createNew(envir(), fileName, 8192);
   if (inputSource == NULL) {
     // The specified input file does not exist!
     fParserForInitialization = NULL;
@@ -126,6 +131,7 @@ MatroskaFile::MatroskaFile(UsageEnvironment& env, char const* fileName, onCreati
 }
 
 MatroskaFile::~MatroskaFile() {
+  envir().taskScheduler().unscheduleDelayedTask(fScanClustersTask);
   delete fParserForInitialization;
   delete fCuePoints;
 
@@ -152,7 +158,19 @@ public:
   unsigned choiceFlags;
 };
 
+void MatroskaFile::continueScanningClusters(void* clientData) {
+  MatroskaFile* file = (MatroskaFile*)clientData;
+  file->fScanClustersTask = NULL;
+  file->fParserForInitialization->continueParsing();
+}
+
 void MatroskaFile::handleEndOfTrackHeaderParsing() {
+  if (fHaveSignalledCreation) {
+    // Our parser has now finished scanning the file's 'Cluster' headers (see below), so we no longer need it:
+    delete fParserForInitialization; fParserForInitialization = NULL;
+    return;
+  }
+
   // Having parsed all of our track headers, iterate through the tracks to figure out which ones should be played.
   // The Matroska 'specification' is rather imprecise about this (as usual).  However, we use the following algorithm:
   // - Use one (but no more) enabled track of each type (video, audio, subtitle).  (Ignore all tracks that are not 'enabled'.)
@@ -215,10 +233,18 @@ void MatroskaFile::handleEndOfTrackHeaderParsing() {
   if (fChosenSubtitleTrackNumber > 0) fprintf(stderr, "Chosen subtitle track: #%d\n", fChosenSubtitleTrackNumber); else fprintf(stderr, "No chosen subtitle track\n");
 #endif
 
-  // Delete our parser, because it's done its job now:
-  delete fParserForInitialization; fParserForInitialization = NULL;
+  if (fParserForInitialization != NULL && fParserForInitialization->isScanningClusters()) {
+    // The file has no 'Cues', so our parser still needs to scan its 'Cluster' headers (to build cue points).  It does this
+    // - one 'Cluster' at a time - from the event loop, after we've signalled our creation (so that a large file doesn't
+    // delay this).  (We get called again once it's done.)
+    fScanClustersTask = envir().taskScheduler().scheduleDelayedTask(0, continueScanningClusters, this);
+  } else {
+    // Delete our parser, because it's done its job now:
+    delete fParserForInitialization; fParserForInitialization = NULL;
+  }
 
   // Finally, signal our caller that we've been created and initialized:
+  fHaveSignalledCreation = True;
   if (fOnCreation != NULL) (*fOnCreation)(this, fOnCreationClientData);
 }
 
@@ -238,7 +264,11 @@ void MatroskaFile::removeDemux(MatroskaDemux* demux) {
 }
 
 float MatroskaFile::fileDuration() {
-  if (fCuePoints == NULL) return 0.0; // Hack, because the RTSP server code assumes that duration > 0 => seekable. (fix this) #####
+  if (fCuePoints == NULL && fParserForInitialization == NULL) {
+    return 0.0; // Hack, because the RTSP server code assumes that duration > 0 => seekable. (fix this) #####
+  }
+  // Note: While we're still scanning 'Cluster' headers (in a file with no 'Cues'), a seek can go only as far as the most
+  // recently-scanned 'Cluster'.  (The seek's NPT is then adjusted to that 'Cluster's time.)
 
   return segmentDuration()*(timecodeScale()/1000000000.0f);
 }
@@ -640,19 +670,19 @@ void MatroskaFile::addTrack(MatroskaTrack* newTrack, unsigned trackNumber) {
 }
 
 void MatroskaFile::addCuePoint(double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster) {
-  Boolean dummy = False; // not used
-  CuePoint::addCuePoint(fCuePoints, cueTime, clusterOffsetInFile, blockNumWithinCluster, dummy);
+  if (fCuePoints == NULL) fCuePoints = new CuePointTable;
+  fCuePoints->add(cueTime, clusterOffsetInFile, blockNumWithinCluster);
 }
 
 Boolean MatroskaFile::lookupCuePoint(double& cueTime, u_int64_t& resultClusterOffsetInFile, unsigned& resultBlockNumWithinCluster) {
   if (fCuePoints == NULL) return False;
 
-  (void)fCuePoints->lookup(cueTime, resultClusterOffsetInFile, resultBlockNumWithinCluster);
+  fCuePoints->lookup(cueTime, resultClusterOffsetInFile, resultBlockNumWithinCluster);
   return True;
 }
 
 void MatroskaFile::printCuePoints(FILE* fid) {
-  CuePoint::fprintf(fid, fCuePoints);
+  if (fCuePoints != NULL) fCuePoints->fprintf(fid);
 }
 
 
@@ -819,108 +849,74 @@ void MatroskaDemux::handleEndOfFile() {
 }
 
 
-////////// CuePoint implementation //////////
+////////// CuePointTable implementation //////////
 
-CuePoint::CuePoint(double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster)
-  : fBalance(0),
-    fCueTime(cueTime), fClusterOffsetInFile(clusterOffsetInFile), fBlockNumWithinCluster(blockNumWithinCluster - 1) {
-  fSubTree[0] = fSubTree[1] = NULL;
+CuePointTable::CuePointTable()
+  : fEntries(NULL), fNumEntries(0), fMaxEntries(0) {
 }
 
-CuePoint::~CuePoint() {
-  delete fSubTree[0]; delete fSubTree[1];
+CuePointTable::~CuePointTable() {
+  delete[] fEntries;
 }
 
-void CuePoint::addCuePoint(CuePoint*& root, double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster,
-			   Boolean& needToReviseBalanceOfParent) {
-  needToReviseBalanceOfParent = False; // by default; may get changed below
-
-  if (root == NULL) {
-    root = new CuePoint(cueTime, clusterOffsetInFile, blockNumWithinCluster);
-    needToReviseBalanceOfParent = True;
-  } else if (cueTime == root->fCueTime) {
-    // Replace existing data:
-    root->fClusterOffsetInFile = clusterOffsetInFile;
-    root->fBlockNumWithinCluster = blockNumWithinCluster - 1;
+void CuePointTable::add(double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster) {
+  unsigned i;
+  if (fNumEntries == 0 || cueTime > fEntries[fNumEntries-1].cueTime) {
+    i = fNumEntries; // common case: append
   } else {
-    // Add to our left or right subtree:
-    int direction = cueTime > root->fCueTime; // 0 (left) or 1 (right)
-    Boolean needToReviseOurBalance = False;
-    addCuePoint(root->fSubTree[direction], cueTime, clusterOffsetInFile, blockNumWithinCluster, needToReviseOurBalance);
-
-    if (needToReviseOurBalance) {
-      // We need to change our 'balance' number, perhaps while also performing a rotation to bring ourself back into balance:
-      if (root->fBalance == 0) {
-	// We were balanced before, but now we're unbalanced (by 1) on the "direction" side:
-	root->fBalance = -1 + 2*direction; // -1 for "direction" 0; 1 for "direction" 1
-	needToReviseBalanceOfParent = True;
-      } else if (root->fBalance == 1 - 2*direction) { // 1 for "direction" 0; -1 for "direction" 1
-	// We were unbalanced (by 1) on the side opposite to where we added an entry, so now we're balanced:
-	root->fBalance = 0;
-      } else {
-	// We were unbalanced (by 1) on the side where we added an entry, so now we're unbalanced by 2, and have to rebalance:
-	if (root->fSubTree[direction]->fBalance == -1 + 2*direction) { // -1 for "direction" 0; 1 for "direction" 1
-	  // We're 'doubly-unbalanced' on this side, so perform a single rotation in the opposite direction:
-	  root->fBalance = root->fSubTree[direction]->fBalance = 0;
-	  rotate(1-direction, root);
-	} else {
-	  // This is the Left-Right case (for "direction" 0) or the Right-Left case (for "direction" 1); perform two rotations:
-	  char newParentCurBalance = root->fSubTree[direction]->fSubTree[1-direction]->fBalance;
-	  if (newParentCurBalance == 1 - 2*direction) { // 1 for "direction" 0; -1 for "direction" 1
-	    root->fBalance = 0;
-	    root->fSubTree[direction]->fBalance = -1 + 2*direction; // -1 for "direction" 0; 1 for "direction" 1
-	  } else if (newParentCurBalance == 0) {
-	    root->fBalance = 0;
-	    root->fSubTree[direction]->fBalance = 0;
-	  } else {
-	    root->fBalance = 1 - 2*direction; // 1 for "direction" 0; -1 for "direction" 1
-	    root->fSubTree[direction]->fBalance = 0;
-	  }
-	  rotate(direction, root->fSubTree[direction]);
-
-	  root->fSubTree[direction]->fBalance = 0; // the new root will be balanced
-	  rotate(1-direction, root);
-	}
-      }
+    i = firstIndexAfter(cueTime);
+    if (i > 0 && fEntries[i-1].cueTime == cueTime) {
+      // Replace existing data:
+      fEntries[i-1].clusterOffsetInFile = clusterOffsetInFile;
+      fEntries[i-1].blockNumWithinCluster = blockNumWithinCluster - 1;
+      return;
     }
   }
+
+  if (fNumEntries == fMaxEntries) {
+    // Grow our array (doubling its size, so that the total cost of building a table of "n" entries is O(n)):
+    unsigned newMaxEntries = fMaxEntries == 0 ? 64 : 2*fMaxEntries;
+    CuePoint* newEntries = new CuePoint[newMaxEntries];
+    if (fNumEntries > 0) memmove(newEntries, fEntries, fNumEntries*sizeof (CuePoint));
+    delete[] fEntries; fEntries = newEntries;
+    fMaxEntries = newMaxEntries;
+  }
+
+  if (i < fNumEntries) memmove(&fEntries[i+1], &fEntries[i], (fNumEntries-i)*sizeof (CuePoint));
+  fEntries[i].cueTime = cueTime;
+  fEntries[i].clusterOffsetInFile = clusterOffsetInFile;
+  fEntries[i].blockNumWithinCluster = blockNumWithinCluster - 1;
+  ++fNumEntries;
 }
 
-Boolean CuePoint::lookup(double& cueTime, u_int64_t& resultClusterOffsetInFile, unsigned& resultBlockNumWithinCluster) {
-  if (cueTime < fCueTime) {
-    if (left() == NULL) {
-      resultClusterOffsetInFile = 0;
-      resultBlockNumWithinCluster = 0;
-      return False;
-    } else {
-      return left()->lookup(cueTime, resultClusterOffsetInFile, resultBlockNumWithinCluster);
-    }
+void CuePointTable::lookup(double& cueTime, u_int64_t& resultClusterOffsetInFile, unsigned& resultBlockNumWithinCluster) const {
+  unsigned i = firstIndexAfter(cueTime);
+  if (i == 0) {
+    // "cueTime" is before our first entry:
+    resultClusterOffsetInFile = 0;
+    resultBlockNumWithinCluster = 0;
   } else {
-    if (right() == NULL || !right()->lookup(cueTime, resultClusterOffsetInFile, resultBlockNumWithinCluster)) {
-      // Use this record:
-      cueTime = fCueTime;
-      resultClusterOffsetInFile = fClusterOffsetInFile;
-      resultBlockNumWithinCluster = fBlockNumWithinCluster;
-    }
-    return True;
+    // Use the entry before "i":
+    CuePoint const& entry = fEntries[i-1];
+    cueTime = entry.cueTime;
+    resultClusterOffsetInFile = entry.clusterOffsetInFile;
+    resultBlockNumWithinCluster = entry.blockNumWithinCluster;
   }
 }
 
-void CuePoint::fprintf(FILE* fid, CuePoint* cuePoint) {
-  if (cuePoint != NULL) {
-    ::fprintf(fid, "[");
-    fprintf(fid, cuePoint->left());
-
-    ::fprintf(fid, ",%.1f{%d},", cuePoint->fCueTime, cuePoint->fBalance);
-
-    fprintf(fid, cuePoint->right());
-    ::fprintf(fid, "]");
+void CuePointTable::fprintf(FILE* fid) const {
+  ::fprintf(fid, "[");
+  for (unsigned i = 0; i < fNumEntries; ++i) {
+    ::fprintf(fid, "%s%.1f", i == 0 ? "" : ",", fEntries[i].cueTime);
   }
+  ::fprintf(fid, "]");
 }
 
-void CuePoint::rotate(unsigned direction/*0 => left; 1 => right*/, CuePoint*& root) {
-  CuePoint* pivot = root->fSubTree[1-direction]; // ASSERT: pivot != NULL
-  root->fSubTree[1-direction] = pivot->fSubTree[direction];
-  pivot->fSubTree[direction] = root;
-  root = pivot;
+unsigned CuePointTable::firstIndexAfter(double cueTime) const {
+  unsigned lo = 0, hi = fNumEntries;
+  while (lo < hi) {
+    unsigned mid = lo + (hi - lo)/2;
+    if (fEntries[mid].cueTime <= cueTime) lo = mid + 1; else hi = mid;
+  }
+  return lo;
 }
@@ -31,7 +31,7 @@ MatroskaFileParser::MatroskaFileParser(MatroskaFile& ourFile, FramedSource* inpu
     fOnEndFunc(onEndFunc), fOnEndClientData(onEndClientData),
     fOurDemux(ourDemux),
     fCurOffsetInFile(0), fSavedCurOffsetInFile(0), fLimitOffsetInFile(0),
-    fNumHeaderBytesToSkip(0), fClusterTimecode(0), fBlockTimecode(0),
+    fNumHeaderBytesToSkip(0), fScanOffsetInFile(0), fClusterTimecode(0), fBlockTimecode(0),
     fFrameSizesWithinBlock(NULL),
     fPresentationTimeOffset(0.0) {
   if (ourDemux == NULL) {
@@ -69,6 +69,16 @@ void MatroskaFileParser::seekToTime(double& seekNPT) {
     u_int64_t clusterOffsetInFile;
     unsigned blockNumWithinCluster;
     if (!fOurFile.lookupCuePoint(seekNPT, clusterOffsetInFile, blockNumWithinCluster)) {
+      if (fOurFile.fParserForInitialization != NULL) {
+	// We're still scanning the file's 'Cluster' headers (to build cue points), and haven't yet found any.  So the best that
+	// we can do is seek to the start of the file:
+#ifdef DEBUG
+	fprintf(stderr, "\t=> no cue points yet; start of file\n");
+#endif
+	seekNPT = 0.0;
+	seekToFilePosition(0);
+	return;
+      }
 #ifdef DEBUG
       fprintf(stderr, "\t=> not supported\n");
 #endif
@@ -130,6 +140,19 @@ Boolean MatroskaFileParser::parse() {
 	    seekToFilePosition(fOurFile.fCuesOffset);
 	    fCurrentParseState = PARSING_CUES;
 	    areDone = False;
+	  } else if (areDone) {
+	    // We've finished parsing the 'Track' information, but the file has no 'Cues'.  So that we can still seek within the
+	    // file, we'll build our own cue points, by scanning the file's 'Cluster' headers.  But we don't do that now (because it
+	    // can take a long time, for a large file).  Instead, we return (so that our 'done' function can be called), and our
+	    // "MatroskaFile" then has us continue parsing - from the event loop - in the new state:
+	    if (fOurFile.fClusterOffset > 0) {
+#ifdef DEBUG
+	      fprintf(stderr, "Seeking to file position %llu (the previously-reported location of a 'Cluster')\n", fOurFile.fClusterOffset);
+#endif
+	      seekToFilePosition(fOurFile.fClusterOffset);
+	      fScanOffsetInFile = fOurFile.fClusterOffset;
+	    }
+	    fCurrentParseState = SCANNING_CLUSTERS;
 	  }
 	  break;
 	}
@@ -137,6 +160,10 @@ Boolean MatroskaFileParser::parse() {
 	  areDone = parseCues();
 	  break;
 	}
+        case SCANNING_CLUSTERS: {
+	  areDone = scanClusters();
+	  break;
+	}
         case LOOKING_FOR_CLUSTER: {
 	  if (fOurFile.fClusterOffset > 0) {
 	    // Optimization: Seek to the specified position in the file.  We were already told that the 'Cluster' begins there:
@@ -848,13 +875,77 @@ Boolean MatroskaFileParser::parseCues() {
   fprintf(stderr, "done parsing Cues\n");
 #endif
 #ifdef DEBUG_CUES
-  fprintf(stderr, "Cue Point tree: ");
+  fprintf(stderr, "Cue Point table: ");
   fOurFile.printCuePoints(stderr);
   fprintf(stderr, "\n");
 #endif
   return True; // we're done parsing Cues
 }
 
+Boolean MatroskaFileParser::scanClusters() {
+#if defined(DEBUG) || defined(DEBUG_CUES)
+  fprintf(stderr, "scanning Clusters\n");
+#endif
+  // Read just the header of each top-level element (and - for a 'Cluster' - its 'Timecode'), then seek directly to the next
+  // element, so that we don't read the (much larger) data in between.  Each 'Cluster' becomes a cue point.
+  u_int64_t fileSize = ((ByteStreamFileSource*)fInputSource)->fileSize(); // we know it's a "ByteStreamFileSource"
+  EBMLId id;
+  EBMLDataSize size;
+
+  while (fileSize == 0 || fScanOffsetInFile + fCurOffsetInFile < fileSize) {
+    u_int64_t elementOffsetInFile = fScanOffsetInFile + fCurOffsetInFile;
+    if (!parseEBMLIdAndSize(id, size)) break;
+    u_int64_t dataOffsetInFile = fScanOffsetInFile + fCurOffsetInFile;
+#ifdef DEBUG_CUES
+    fprintf(stderr, "MatroskaFileParser::scanClusters(): Parsed id 0x%s (%s), size: %lld, at file position %llu\n", id.hexString(), id.stringName(), size.val(), elementOffsetInFile);
+#endif
+    if (id == MATROSKA_ID_SEGMENT) { // 'Segment' header: enter this
+      setParseState();
+      continue;
+    }
+    if (size.val() == ((u_int64_t)1<<(7*size.len)) - 1) break; // 'unknown' size; we can't seek past this element
+
+    if (id == MATROSKA_ID_CLUSTER) {
+      // The 'Timecode' should be the cluster's first element (perhaps after a 'CRC-32' or 'Void'):
+      u_int64_t clusterEndOffsetInFile = dataOffsetInFile + size.val();
+      EBMLId childId;
+      EBMLDataSize childSize;
+      while (fScanOffsetInFile + fCurOffsetInFile < clusterEndOffsetInFile && parseEBMLIdAndSize(childId, childSize)) {
+	if (childId == MATROSKA_ID_TIMECODE) {
+	  unsigned timecode;
+	  if (parseEBMLVal_unsigned(childSize, timecode)) {
+	    double cueTime = timecode*(fOurFile.fTimecodeScale/1000000000.0);
+#ifdef DEBUG_CUES
+	    fprintf(stderr, "\tCluster timecode %d (== %f seconds)\n", timecode, cueTime);
+#endif
+	    fOurFile.addCuePoint(cueTime, elementOffsetInFile, 1);
+	  }
+	  break;
+	} else if ((childId == MATROSKA_ID_CRC_32 || childId == MATROSKA_ID_VOID) && childSize.val() <= 1000) {
+	  skipBytes((unsigned)childSize.val());
+	  fCurOffsetInFile += childSize.val();
+	} else {
+	  break; // no 'Timecode'; don't use this cluster
+	}
+      }
+    }
+
+    // Seek to the next element:
+    seekToFilePosition(dataOffsetInFile + size.val());
+    fScanOffsetInFile = dataOffsetInFile + size.val();
+  }
+
+#if defined(DEBUG) || defined(DEBUG_CUES)
+  fprintf(stderr, "done scanning Clusters\n");
+#endif
+#ifdef DEBUG_CUES
+  fprintf(stderr, "Cue Point table: ");
+  fOurFile.printCuePoints(stderr);
+  fprintf(stderr, "\n");
+#endif
+  return True; // we're done scanning
+}
+
 typedef enum { NoLacing, XiphLacing, FixedSizeLacing, EBMLLacing } MatroskaLacingType;
 
 void MatroskaFileParser::parseBlock() {
@@ -36,6 +36,7 @@ enum MatroskaParseState {
   LOOKING_FOR_TRACKS,
   PARSING_TRACK,
   PARSING_CUES,
+  SCANNING_CLUSTERS,
   LOOKING_FOR_CLUSTER,
   LOOKING_FOR_BLOCK,
   PARSING_BLOCK,
@@ -52,6 +53,9 @@ public:
 
   void seekToTime(double& seekNPT);
 
+  Boolean isScanningClusters() const { return fCurrentParseState == SCANNING_CLUSTERS; }
+      // True (on initialization) if - after the 'Track' headers - we still need to scan 'Cluster' headers (to build cue points)
+
   // StreamParser 'client continue' function:
   static void continueParsing(void* clientData, unsigned char* ptr, unsigned size, struct timeval presentationTime);
   void continueParsing();
@@ -59,12 +63,14 @@ public:
 private:
   // Parsing functions:
   Boolean parse();
-    // returns True iff we have finished parsing to the end of all 'Track' headers (on initialization)
+    // returns True iff we have finished parsing to the end of all 'Track' headers (on initialization) - or, if we then
+    // went on to scan 'Cluster' headers, iff we have finished that
 
   Boolean parseStartOfFile();
   void lookForNextTrack();
   Boolean parseTrack();
   Boolean parseCues();
+  Boolean scanClusters();
 
   void lookForNextBlock();
   void parseBlock();
@@ -110,6 +116,9 @@ private:
   // For parsing 'Seek ID's:
   EBMLId fLastSeekId;
 
+  // For scanning 'Cluster's (if the file has no 'Cues'):
+  u_int64_t fScanOffsetInFile; // the file position that "fCurOffsetInFile" is relative to
+
   // Parameters of the most recently-parsed 'Cluster':
   unsigned fClusterTimecode;
 
@@ -21,6 +21,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "MatroskaFileServerDemux.hh"
 #include "MP3AudioMatroskaFileServerMediaSubsession.hh"
 #include "MatroskaFileServerMediaSubsession.hh"
+#include "MediaFileCache.hh"
 
 void MatroskaFileServerDemux
 ::createNew(UsageEnvironment& env, char const* fileName,
@@ -100,17 +101,42 @@ MatroskaFileServerDemux
 			  onCreationFunc* onCreation, void* onCreationClientData,
 			  char const* preferredLanguage)
   : Medium(env),
-    fFileName(fileName), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
+    fFileName(fileName), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData), fOurMatroskaFile(NULL),
     fNextTrackTypeToCheck(0x1), fLastClientSessionId(0), fLastCreatedDemux(NULL) {
-  MatroskaFile::createNew(env, fileName, onMatroskaFileCreation, this, preferredLanguage);
+  // The choice of tracks depends upon "preferredLanguage", so that's part of the key for our "MatroskaFile":
+  char const* language = preferredLanguage == NULL ? "" : preferredLanguage;
+  fCacheKey = new char[strlen(fileName) + strlen(language) + 20];
+  sprintf(fCacheKey, "MatroskaFile:%s:%s", language, fileName);
+
+  MatroskaFile* cachedFile = (MatroskaFile*)MediaFileCache::attach(env, fCacheKey, fileName);
+  if (cachedFile != NULL) {
+    // This file has already been parsed (and hasn't changed since), so we can use it right away.  But we still signal our
+    // creation from the event loop (as we do for a newly-parsed file), rather than from within "createNew()":
+    fOurMatroskaFile = cachedFile;
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)onCachedMatroskaFile, this);
+  } else {
+    MatroskaFile::createNew(env, fileName, onMatroskaFileCreation, this, preferredLanguage);
+  }
 }
 
 MatroskaFileServerDemux::~MatroskaFileServerDemux() {
-  Medium::close(fOurMatroskaFile);
+  MediaFileCache::detach(envir(), fOurMatroskaFile);
+  delete[] fCacheKey;
 }
 
 void MatroskaFileServerDemux::onMatroskaFileCreation(MatroskaFile* newFile, void* clientData) {
-  ((MatroskaFileServerDemux*)clientData)->onMatroskaFileCreation(newFile);
+  MatroskaFileServerDemux* demux = (MatroskaFileServerDemux*)clientData;
+
+  // Cache the newly-parsed file, so that other demultiplexors can use it:
+  MediaFileCache::add(demux->envir(), demux->fCacheKey, demux->fFileName, newFile);
+  demux->onMatroskaFileCreation(newFile);
+}
+
+void MatroskaFileServerDemux::onCachedMatroskaFile(void* clientData) {
+  MatroskaFileServerDemux* demux = (MatroskaFileServerDemux*)clientData;
+
+  demux->nextTask() = NULL;
+  demux->onMatroskaFileCreation(demux->fOurMatroskaFile);
 }
 
 void MatroskaFileServerDemux::onMatroskaFileCreation(MatroskaFile* newFile) {
@@ -106,14 +106,14 @@ _Tables* _Tables::getOurTables(UsageEnvironment& env, Boolean createIfNotPresent
 
 void _Tables::reclaimIfPossible() {
 	// mediaTablesocketTableΪյĻɾ󣬻Դ
-	if (mediaTable == NULL && socketTable == NULL) {
+	if (mediaTable == NULL && socketTable == NULL && mediaFileCache == NULL) {
 		fEnv.liveMediaPriv = NULL;
 		delete this;
 	}
 }
  //_TableĹ캯
 _Tables::_Tables(UsageEnvironment& env)
-: mediaTable(NULL), socketTable(NULL), fEnv(env) {
+: mediaTable(NULL), socketTable(NULL), mediaFileCache(NULL), fEnv(env) {
 }
 
 _Tables::~_Tables() {
@@ -0,0 +1,183 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A cache of media file objects (e.g., "MatroskaFile"s or "OggFile"s) whose headers have already been parsed, so that
+// other users of the same (unchanged) file can share them, rather than reading and parsing the file again.
+// Implementation
+
+#include "MediaFileCache.hh"
+#include <sys/stat.h>
+
+unsigned MediaFileCache::maxUnusedFiles = 10;
+
+////////// MediaFileCacheEntry //////////
+
+class MediaFileCacheEntry {
+public:
+  MediaFileCacheEntry(char const* key, Medium* file, struct stat const& sb)
+    : fKey(strDup(key)), fFile(file), fModificationTime(sb.st_mtime), fFileSize((u_int64_t)sb.st_size),
+      fNumUsers(1), fLastUse(0) {
+  }
+  virtual ~MediaFileCacheEntry() {
+    delete[] fKey;
+  }
+
+  Boolean isCurrentFor(struct stat const& sb) const {
+    return sb.st_mtime == fModificationTime && (u_int64_t)sb.st_size == fFileSize;
+  }
+
+  char* fKey; // NULL once we've been retired
+  Medium* fFile;
+  time_t fModificationTime;
+  u_int64_t fFileSize;
+  unsigned fNumUsers;
+  unsigned fLastUse;
+};
+
+
+////////// MediaFileCache //////////
+
+Medium* MediaFileCache::attach(UsageEnvironment& env, char const* key, char const* fileName) {
+  MediaFileCache* cache = ourCache(env, False);
+  if (cache == NULL || key == NULL) return NULL;
+
+  MediaFileCacheEntry* entry = (MediaFileCacheEntry*)(cache->fEntriesByKey->Lookup(key));
+  if (entry == NULL) return NULL;
+
+  struct stat sb;
+  if (stat(fileName, &sb) != 0 || !entry->isCurrentFor(sb)) {
+    // The file has changed (or gone away) since we parsed it, so don't give out this object again:
+    cache->retire(entry);
+    reclaimIfEmpty(env);
+    return NULL;
+  }
+
+  if (entry->fNumUsers++ == 0) --cache->fNumUnusedEntries;
+  entry->fLastUse = ++cache->fUseCounter;
+  return entry->fFile;
+}
+
+void MediaFileCache::add(UsageEnvironment& env, char const* key, char const* fileName, Medium* file) {
+  struct stat sb;
+  if (file == NULL || key == NULL || stat(fileName, &sb) != 0) return; // we can't cache this object; "detach()" will just close it
+
+  MediaFileCache* cache = ourCache(env, True);
+  MediaFileCacheEntry* oldEntry = (MediaFileCacheEntry*)(cache->fEntriesByKey->Lookup(key));
+  if (oldEntry != NULL) cache->retire(oldEntry);
+
+  MediaFileCacheEntry* entry = new MediaFileCacheEntry(key, file, sb);
+  entry->fLastUse = ++cache->fUseCounter;
+  cache->fEntriesByKey->Add(entry->fKey, entry);
+  cache->fEntriesByFile->Add((char const*)file, entry);
+}
+
+void MediaFileCache::detach(UsageEnvironment& env, Medium* file) {
+  if (file == NULL) return;
+
+  MediaFileCache* cache = ourCache(env, False);
+  MediaFileCacheEntry* entry
+    = cache == NULL ? NULL : (MediaFileCacheEntry*)(cache->fEntriesByFile->Lookup((char const*)file));
+  if (entry == NULL) {
+    // This object was never cached:
+    Medium::close(file);
+    return;
+  }
+
+  if (entry->fNumUsers > 0 && --entry->fNumUsers == 0) {
+    if (entry->fKey == NULL) {
+      // This entry has already been retired, so it's no longer needed:
+      cache->closeEntry(entry);
+    } else {
+      // Keep this object around, in case it's used again:
+      ++cache->fNumUnusedEntries;
+      entry->fLastUse = ++cache->fUseCounter;
+      cache->closeUnusedEntriesIfNeeded();
+    }
+  }
+  reclaimIfEmpty(env);
+}
+
+MediaFileCache::MediaFileCache()
+  : fNumUnusedEntries(0), fUseCounter(0) {
+  fEntriesByKey = HashTable::create(STRING_HASH_KEYS);
+  fEntriesByFile = HashTable::create(ONE_WORD_HASH_KEYS);
+}
+
+MediaFileCache::~MediaFileCache() {
+  // Close any remaining entries (although normally we're deleted only when there are none):
+  MediaFileCacheEntry* entry;
+  while ((entry = (MediaFileCacheEntry*)fEntriesByFile->RemoveNext()) != NULL) {
+    Medium::close(entry->fFile);
+    delete entry;
+  }
+  delete fEntriesByFile;
+  delete fEntriesByKey;
+}
+
+MediaFileCache* MediaFileCache::ourCache(UsageEnvironment& env, Boolean createIfNotPresent) {
+  _Tables* ourTables = _Tables::getOurTables(env, createIfNotPresent);
+  if (ourTables == NULL) return NULL;
+
+  if (ourTables->mediaFileCache == NULL && createIfNotPresent) {
+    ourTables->mediaFileCache = new MediaFileCache;
+  }
+  return ourTables->mediaFileCache;
+}
+
+void MediaFileCache::reclaimIfEmpty(UsageEnvironment& env) {
+  _Tables* ourTables = _Tables::getOurTables(env, False);
+  if (ourTables == NULL || ourTables->mediaFileCache == NULL) return;
+
+  if (ourTables->mediaFileCache->fEntriesByFile->IsEmpty()) {
+    delete ourTables->mediaFileCache;
+    ourTables->mediaFileCache = NULL;
+    ourTables->reclaimIfPossible();
+  }
+}
+
+void MediaFileCache::retire(MediaFileCacheEntry* entry) {
+  fEntriesByKey->Remove(entry->fKey);
+  delete[] entry->fKey; entry->fKey = NULL;
+
+  if (entry->fNumUsers == 0) {
+    --fNumUnusedEntries;
+    closeEntry(entry);
+  } // else the entry will be closed when its last user detaches
+}
+
+void MediaFileCache::closeEntry(MediaFileCacheEntry* entry) {
+  fEntriesByFile->Remove((char const*)(entry->fFile));
+  Medium::close(entry->fFile);
+  delete entry;
+}
+
+void MediaFileCache::closeUnusedEntriesIfNeeded() {
+  while (fNumUnusedEntries > maxUnusedFiles) {
+    // Retire the least recently used entry that has no users:
+    MediaFileCacheEntry* lruEntry = NULL;
+    HashTable::Iterator* iter = HashTable::Iterator::create(*fEntriesByKey);
+    MediaFileCacheEntry* entry;
+    char const* key;
+    while ((entry = (MediaFileCacheEntry*)(iter->next(key))) != NULL) {
+      if (entry->fNumUsers == 0 && (lruEntry == NULL || entry->fLastUse < lruEntry->fLastUse)) lruEntry = entry;
+    }
+    delete iter;
+
+    if (lruEntry == NULL) break; // shouldn't happen
+    retire(lruEntry);
+  }
+}
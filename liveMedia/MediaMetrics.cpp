@@ -0,0 +1,284 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A class for collecting a snapshot of (e.g., per-stream) metrics, and rendering it in the
+// Prometheus text exposition format (for serving - e.g. - via a "/metrics" HTTP URL).
+// Implementation
+
+#include "MediaMetrics.hh"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+////////// MetricFamily //////////
+
+// The samples for a single metric name, kept in a growable text buffer (already formatted):
+
+class MetricFamily {
+public:
+  MetricFamily(char const* name, MediaMetricsWriter::MetricType type, char const* helpText);
+  virtual ~MetricFamily();
+
+  void append(char const* str, unsigned strLength);
+  void append(char const* str) { append(str, strlen(str)); }
+
+  unsigned headerLength() const;
+  void writeHeader(char* to) const; // writes exactly "headerLength()" bytes
+
+public:
+  MetricFamily* fNext;
+  char const* fName;
+  MediaMetricsWriter::MetricType fType;
+  char const* fHelpText;
+  char* fSamples;
+  unsigned fSamplesLength, fSamplesMaxLength;
+};
+
+MetricFamily::MetricFamily(char const* name, MediaMetricsWriter::MetricType type, char const* helpText)
+  : fNext(NULL), fName(name), fType(type), fHelpText(helpText),
+    fSamples(NULL), fSamplesLength(0), fSamplesMaxLength(0) {
+}
+
+MetricFamily::~MetricFamily() {
+  delete[] fSamples;
+  delete fNext;
+}
+
+void MetricFamily::append(char const* str, unsigned strLength) {
+  if (fSamplesLength + strLength > fSamplesMaxLength) {
+    unsigned newMaxLength = fSamplesMaxLength == 0 ? 256 : 2*fSamplesMaxLength;
+    while (newMaxLength < fSamplesLength + strLength) newMaxLength *= 2;
+
+    char* newSamples = new char[newMaxLength];
+    if (fSamplesLength > 0) memmove(newSamples, fSamples, fSamplesLength);
+    delete[] fSamples; fSamples = newSamples;
+    fSamplesMaxLength = newMaxLength;
+  }
+  memmove(&fSamples[fSamplesLength], str, strLength);
+  fSamplesLength += strLength;
+}
+
+static char const* typeName(MediaMetricsWriter::MetricType type) {
+  switch (type) {
+    case MediaMetricsWriter::COUNTER: return "counter";
+    case MediaMetricsWriter::HISTOGRAM: return "histogram";
+    default: return "gauge";
+  }
+}
+
+unsigned MetricFamily::headerLength() const {
+  // "# HELP <name> <help>\n# TYPE <name> <type>\n"
+  return 7 + strlen(fName) + 1 + (fHelpText == NULL ? 0 : strlen(fHelpText)) + 1
+    + 7 + strlen(fName) + 1 + strlen(typeName(fType)) + 1;
+}
+
+void MetricFamily::writeHeader(char* to) const {
+  sprintf(to, "# HELP %s %s\n# TYPE %s %s\n",
+	  fName, fHelpText == NULL ? "" : fHelpText, fName, typeName(fType));
+}
+
+
+////////// MediaMetricsWriter //////////
+
+MediaMetricsWriter::MediaMetricsWriter()
+  : fFamilies(NULL), fLastFamily(NULL), fNumLabels(0) {
+}
+
+MediaMetricsWriter::~MediaMetricsWriter() {
+  clearLabels();
+  delete fFamilies;
+}
+
+static char* escapedLabelValue(char const* value) {
+  // Label values are quoted; '\', '"' and newline must be escaped:
+  if (value == NULL) value = "";
+  unsigned len = 0;
+  char const* from;
+  for (from = value; *from != '\0'; ++from) {
+    len += (*from == '\\' || *from == '"' || *from == '\n') ? 2 : 1;
+  }
+
+  char* result = new char[len+1];
+  char* to = result;
+  for (from = value; *from != '\0'; ++from) {
+    if (*from == '\n') {
+      *to++ = '\\'; *to++ = 'n';
+    } else {
+      if (*from == '\\' || *from == '"') *to++ = '\\';
+      *to++ = *from;
+    }
+  }
+  *to = '\0';
+
+  return result;
+}
+
+void MediaMetricsWriter::setLabel(char const* labelName, char const* labelValue) {
+  unsigned i;
+  for (i = 0; i < fNumLabels; ++i) {
+    if (strcmp(fLabels[i].name, labelName) == 0) break;
+  }
+  if (i == fNumLabels) {
+    if (fNumLabels == MEDIA_METRICS_MAX_LABELS) return; // no room (shouldn't happen)
+    ++fNumLabels;
+  } else {
+    delete[] fLabels[i].value;
+  }
+  fLabels[i].name = labelName;
+  fLabels[i].value = escapedLabelValue(labelValue);
+}
+
+void MediaMetricsWriter::setLabel(char const* labelName, unsigned labelValue) {
+  char buf[20];
+  sprintf(buf, "%u", labelValue);
+  setLabel(labelName, buf);
+}
+
+void MediaMetricsWriter::clearLabel(char const* labelName) {
+  for (unsigned i = 0; i < fNumLabels; ++i) {
+    if (strcmp(fLabels[i].name, labelName) == 0) {
+      delete[] fLabels[i].value;
+      // Keep the remaining labels in the order in which they were set:
+      for (unsigned j = i+1; j < fNumLabels; ++j) fLabels[j-1] = fLabels[j];
+      --fNumLabels;
+      return;
+    }
+  }
+}
+
+void MediaMetricsWriter::clearLabels() {
+  for (unsigned i = 0; i < fNumLabels; ++i) delete[] fLabels[i].value;
+  fNumLabels = 0;
+}
+
+MetricFamily* MediaMetricsWriter
+::lookupFamily(char const* metricName, MetricType metricType, char const* helpText) {
+  MetricFamily* family;
+  for (family = fFamilies; family != NULL; family = family->fNext) {
+    if (strcmp(family->fName, metricName) == 0) return family;
+  }
+
+  family = new MetricFamily(metricName, metricType, helpText);
+  if (fLastFamily == NULL) {
+    fFamilies = family;
+  } else {
+    fLastFamily->fNext = family;
+  }
+  fLastFamily = family;
+
+  return family;
+}
+
+static void formatValue(char* buf, unsigned bufSize, double value) {
+  // Note: We don't use "%g" (or "%f") for non-integral values in the usual range, because their output depends on the
+  // current locale.
+  if (value != value) {
+    snprintf(buf, bufSize, "NaN");
+  } else if (value > 1e15 || value < -1e15) {
+    if (value == HUGE_VAL) snprintf(buf, bufSize, "+Inf");
+    else if (value == -HUGE_VAL) snprintf(buf, bufSize, "-Inf");
+    else {
+      snprintf(buf, bufSize, "%.17g", value); // e.g., "1.0000000000000001e+20"
+      // In case the current locale uses some other decimal point character, replace it with '.':
+      for (char* p = buf; *p != '\0'; ++p) {
+	if ((*p < '0' || *p > '9') && *p != '-' && *p != '+' && *p != 'e') *p = '.';
+      }
+    }
+  } else {
+    char const* sign = "";
+    if (value < 0) { sign = "-"; value = -value; }
+    double intPart = floor(value);
+    unsigned fracPart = (unsigned)((value - intPart)*1000000.0 + 0.5); // microsecond precision
+    if (fracPart >= 1000000) { intPart += 1.0; fracPart -= 1000000; }
+
+    if (fracPart == 0) {
+      snprintf(buf, bufSize, "%s%.0f", sign, intPart);
+    } else {
+      snprintf(buf, bufSize, "%s%.0f.%06u", sign, intPart, fracPart);
+      char* end = &buf[strlen(buf)-1];
+      while (*end == '0') *end-- = '\0';
+    }
+  }
+}
+
+void MediaMetricsWriter
+::addSample(char const* metricName, MetricType metricType, char const* helpText, double value) {
+  appendSample(lookupFamily(metricName, metricType, helpText), "", NULL, value);
+}
+
+void MediaMetricsWriter::addHistogram(char const* metricName, char const* helpText, unsigned numBuckets,
+				      double const* bucketUpperBounds, double const* bucketCounts, double sum) {
+  MetricFamily* family = lookupFamily(metricName, HISTOGRAM, helpText);
+
+  double cumulativeCount = 0.0;
+  for (unsigned i = 0; i < numBuckets; ++i) {
+    char leStr[40];
+    formatValue(leStr, sizeof leStr, bucketUpperBounds[i]);
+    cumulativeCount += bucketCounts[i];
+    appendSample(family, "_bucket", leStr, cumulativeCount);
+  }
+  appendSample(family, "_sum", NULL, sum);
+  appendSample(family, "_count", NULL, cumulativeCount);
+}
+
+void MediaMetricsWriter
+::appendSample(MetricFamily* family, char const* nameSuffix, char const* leValue, double value) {
+  family->append(family->fName);
+  family->append(nameSuffix);
+  if (fNumLabels > 0 || leValue != NULL) {
+    for (unsigned i = 0; i < fNumLabels; ++i) {
+      family->append(i == 0 ? "{" : ",");
+      family->append(fLabels[i].name);
+      family->append("=\"", 2);
+      family->append(fLabels[i].value);
+      family->append("\"", 1);
+    }
+    if (leValue != NULL) {
+      family->append(fNumLabels == 0 ? "{le=\"" : ",le=\"");
+      family->append(leValue);
+      family->append("\"", 1);
+    }
+    family->append("}", 1);
+  }
+
+  char valueStr[40];
+  valueStr[0] = ' ';
+  formatValue(&valueStr[1], sizeof valueStr - 1, value);
+  family->append(valueStr);
+  family->append("\n", 1);
+}
+
+char* MediaMetricsWriter::text(unsigned& resultLength) const {
+  MetricFamily* family;
+
+  resultLength = 0;
+  for (family = fFamilies; family != NULL; family = family->fNext) {
+    resultLength += family->headerLength() + family->fSamplesLength;
+  }
+
+  char* result = new char[resultLength + 1];
+  char* to = result;
+  for (family = fFamilies; family != NULL; family = family->fNext) {
+    family->writeHeader(to);
+    to += family->headerLength();
+    memmove(to, family->fSamples, family->fSamplesLength);
+    to += family->fSamplesLength;
+  }
+  *to = '\0';
+
+  return result;
+}
@@ -223,6 +223,7 @@ void MultiFramedRTPSink
 		    struct timeval presentationTime,
 		    unsigned durationInMicroseconds) {
   MultiFramedRTPSink* sink = (MultiFramedRTPSink*)clientData;
+  ++sink->fTotNumFramesSent; // (overflow data from an earlier frame doesn't come through here, so isn't counted again)
   sink->afterGettingFrame1(numBytesRead, numTruncatedBytes,
 			   presentationTime, durationInMicroseconds);
 }
@@ -242,6 +243,7 @@ void MultiFramedRTPSink
   }    
 
   if (numTruncatedBytes > 0) {
+    fTotNumTruncatedBytes += numTruncatedBytes;
     unsigned const bufferSize = fOutBuf->totalBytesAvailable();
     envir() << "MultiFramedRTPSink::afterGettingFrame1(): The input frame data was too large for our buffer size ("
 	    << bufferSize << ").  "
@@ -366,6 +368,8 @@ void MultiFramedRTPSink::sendPacketIfNecessary() {
       }
     ++fPacketCount;
     fTotalOctetCount += fOutBuf->curPacketSize();
+    ++fTotNumPacketsSent;
+    fTotNumOctetsSent += fOutBuf->curPacketSize();
     fOctetCount += fOutBuf->curPacketSize()
       - rtpHeaderSize - fSpecialHeaderSize - fTotalFrameSpecificHeaderSizes;
 
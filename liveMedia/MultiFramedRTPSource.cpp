@@ -186,7 +186,9 @@ void MultiFramedRTPSource::doGetNextFrame1() {
 
     if (fCurrentPacketCompletesFrame) {
       // We have all the data that the client wants.
+      ++fTotNumFramesReceived;
       if (fNumTruncatedBytes > 0) {
+	fTotNumTruncatedBytes += fNumTruncatedBytes;
 	envir() << "MultiFramedRTPSource::doGetNextFrame1(): The total received frame size exceeds the client's buffer size ("
 		<< fSavedMaxSize << ").  "
 		<< fNumTruncatedBytes << " bytes of trailing data will be dropped!\n";
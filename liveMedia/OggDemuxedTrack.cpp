@@ -21,10 +21,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "OggDemuxedTrack.hh"
 #include "OggFile.hh"
 
+void OggDemuxedTrack::seekToTime(double& seekNPT) {
+  fOurSourceDemux.seekToTime(seekNPT);
+}
+
 OggDemuxedTrack::OggDemuxedTrack(UsageEnvironment& env, unsigned trackNumber, OggDemux& sourceDemux)
   : FramedSource(env),
     fOurTrackNumber(trackNumber), fOurSourceDemux(sourceDemux),
-    fCurrentPageIsContinuation(False) {
+    fCurrentPageIsContinuation(False), fSkipPartialPacket(False) {
   fNextPresentationTime.tv_sec = 0; fNextPresentationTime.tv_usec = 0;
 }
 
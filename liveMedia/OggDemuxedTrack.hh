@@ -28,6 +28,9 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 class OggDemux; // forward
 
 class OggDemuxedTrack: public FramedSource {
+public:
+  void seekToTime(double& seekNPT);
+
 private: // We are created only by a OggDemux (a friend)
   friend class OggDemux;
   OggDemuxedTrack(UsageEnvironment& env, unsigned trackNumber, OggDemux& sourceDemux);
@@ -52,6 +55,7 @@ private:
   unsigned fOurTrackNumber;
   OggDemux& fOurSourceDemux;
   Boolean fCurrentPageIsContinuation;
+  Boolean fSkipPartialPacket; // set after seeking, until we've seen the first page of this track
   struct timeval fNextPresentationTime;
 };
 
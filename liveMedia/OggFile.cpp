@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "OggFileParser.hh"
 #include "OggDemuxedTrack.hh"
+#include "OggPageIndex.hh"
 #include "ByteStreamFileSource.hh"
 #include "VorbisAudioRTPSink.hh"
 #include "SimpleRTPSink.hh"
@@ -67,6 +68,10 @@ unsigned OggFile::numTracks() const {
   return fTrackTable->numTracks();
 }
 
+float OggFile::fileDuration() const {
+  return fPageIndex == NULL ? 0.0f : fPageIndex->fileDuration();
+}
+
 FramedSource* OggFile
 ::createSourceForStreaming(FramedSource* baseSource, u_int32_t trackNumber,
                            unsigned& estBitrate, unsigned& numFiltersInFrontOfTrack) {
@@ -123,7 +128,7 @@ OggFile::OggFile(UsageEnvironment& env, char const* fileName,
 		 onCreationFunc* onCreation, void* onCreationClientData)
   : Medium(env),
     fFileName(strDup(fileName)),
-    fOnCreation(onCreation), fOnCreationClientData(onCreationClientData) {
+    fOnCreation(onCreation), fOnCreationClientData(onCreationClientData), fPageIndex(NULL) {
   fTrackTable = new OggTrackTable;
   fDemuxesTable = HashTable::create(ONE_WORD_HASH_KEYS);
 
@@ -141,6 +146,7 @@ OggFile::OggFile(UsageEnvironment& env, char const* fileName,
 
 OggFile::~OggFile() {
   delete fParserForInitialization;
+  delete fPageIndex;
 
   // Delete any outstanding "OggDemux"s, and the table for them:
   OggDemux* demux;
@@ -161,6 +167,9 @@ void OggFile::handleEndOfBosPageParsing() {
   // Delete our parser, because it's done its job now:
   delete fParserForInitialization; fParserForInitialization = NULL;
 
+  // Now that we know our tracks, look at the end of the file, to find our duration:
+  fPageIndex = new OggPageIndex(*this);
+
   // Finally, signal our caller that we've been created and initialized:
   if (fOnCreation != NULL) (*fOnCreation)(this, fOnCreationClientData);
 }
@@ -173,6 +182,10 @@ void OggFile::removeDemux(OggDemux* demux) {
   fDemuxesTable->Remove((char const*)demux);
 }
 
+Boolean OggFile::lookupSeekPosition(double& seekNPT, u_int64_t& offsetInFile, Boolean& resumeWithLastPacketInPage) {
+  return fPageIndex != NULL && fPageIndex->lookup(seekNPT, offsetInFile, resumeWithLastPacketInPage);
+}
+
 
 ////////// OggTrackTable implementation /////////
 
@@ -298,6 +311,24 @@ void OggDemux::continueReading() {
   fOurParser->continueParsing();
 }
 
+void OggDemux::seekToTime(double& seekNPT) {
+  u_int64_t offsetInFile;
+  Boolean resumeWithLastPacketInPage;
+  if (!fOurFile.lookupSeekPosition(seekNPT, offsetInFile, resumeWithLastPacketInPage)) return; // seeking not supported
+
+  fOurParser->seekToFilePosition(offsetInFile, resumeWithLastPacketInPage);
+
+  // The first page that we now read for each track might begin with the remainder of a packet whose start we skipped:
+  HashTable::Iterator* iter = HashTable::Iterator::create(*fDemuxedTracksTable);
+  OggDemuxedTrack* demuxedTrack;
+  char const* trackNumber;
+  while ((demuxedTrack = (OggDemuxedTrack*)iter->next(trackNumber)) != NULL) {
+    demuxedTrack->fCurrentPageIsContinuation = False;
+    demuxedTrack->fSkipPartialPacket = True;
+  }
+  delete iter;
+}
+
 void OggDemux::handleEndOfFile(void* clientData) {
   ((OggDemux*)clientData)->handleEndOfFile();
 }
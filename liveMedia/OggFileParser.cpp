@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "OggFileParser.hh"
 #include "OggDemuxedTrack.hh"
+#include "ByteStreamFileSource.hh"
 #include <GroupsockHelper.hh> // for "gettimeofday()
 
 PacketSizeTable::PacketSizeTable(unsigned number_page_segments)
@@ -40,7 +41,7 @@ OggFileParser::OggFileParser(OggFile& ourFile, FramedSource* inputSource,
     fOurFile(ourFile), fInputSource(inputSource),
     fOnEndFunc(onEndFunc), fOnEndClientData(onEndClientData),
     fOurDemux(ourDemux), fNumUnfulfilledTracks(0),
-    fPacketSizeTable(NULL), fCurrentTrackNumber(0), fSavedPacket(NULL) {
+    fPacketSizeTable(NULL), fCurrentTrackNumber(0), fSavedPacket(NULL), fResumeWithLastPacketInNextPage(False) {
   if (ourDemux == NULL) {
     // Initialization
     fCurrentParseState = PARSING_START_OF_FILE;
@@ -78,6 +79,18 @@ void OggFileParser::continueParsing() {
   if (fOnEndFunc != NULL) (*fOnEndFunc)(fOnEndClientData);
 }
 
+void OggFileParser::seekToFilePosition(u_int64_t offsetInFile, Boolean resumeWithLastPacketInPage) {
+  ByteStreamFileSource* fileSource = (ByteStreamFileSource*)fInputSource; // we know it's a "ByteStreamFileSource"
+  if (fileSource != NULL) {
+    fileSource->seekToByteAbsolute(offsetInFile);
+
+    // Because we're resuming parsing after seeking to a new position in the file, reset the parser state:
+    fCurrentParseState = PARSING_AND_DELIVERING_PAGES;
+    fResumeWithLastPacketInNextPage = resumeWithLastPacketInPage;
+    flushInput();
+  }
+}
+
 Boolean OggFileParser::parse() {
   try {
     while (1) {
@@ -803,6 +816,18 @@ Boolean OggFileParser::parseAndDeliverPage() {
   parseStartOfPage(header_type_flag, bitstream_serial_number);
 
   OggDemuxedTrack* demuxedTrack = fOurDemux->lookupDemuxedTrack(bitstream_serial_number);
+  if (fResumeWithLastPacketInNextPage) {
+    // This is the page that we seeked to.  Skip over all of its packets except the last (incomplete) one:
+    unsigned numBytesToSkip = 0;
+    for (unsigned i = 0; i < fPacketSizeTable->numCompletedPackets; ++i) numBytesToSkip += fPacketSizeTable->size[i];
+    skipBytes(numBytesToSkip);
+    fPacketSizeTable->totSizes -= numBytesToSkip;
+    fPacketSizeTable->nextPacketNumToDeliver = fPacketSizeTable->numCompletedPackets;
+    header_type_flag &=~ 0x01; // the remaining packet begins in this page
+    fResumeWithLastPacketInNextPage = False;
+    if (demuxedTrack != NULL) demuxedTrack->fSkipPartialPacket = False; // because we'll deliver the start of its packet
+  }
+
   if (demuxedTrack == NULL) { // this track is not being read
 #ifdef DEBUG
     fprintf(stderr, "\tIgnoring page from unread track; skipping %d remaining packet data bytes\n",
@@ -818,8 +843,32 @@ Boolean OggFileParser::parseAndDeliverPage() {
     return True;
   }
 
+  Boolean pageIsContinuation = (header_type_flag&0x01) != 0;
+  if (demuxedTrack->fSkipPartialPacket) {
+    // This is the first page that we've seen for this track since seeking.  If it begins with the remainder of a packet
+    // (whose start we skipped), then skip that too:
+    if (pageIsContinuation) {
+      if (fPacketSizeTable->numCompletedPackets == 0) {
+	// The whole page is part of this packet (which continues into the next page):
+	skipBytes(fPacketSizeTable->totSizes);
+	return True;
+      }
+      unsigned const partialPacketSize = fPacketSizeTable->size[0];
+      skipBytes(partialPacketSize);
+      fPacketSizeTable->totSizes -= partialPacketSize;
+      fPacketSizeTable->nextPacketNumToDeliver = 1;
+      pageIsContinuation = False;
+    }
+    demuxedTrack->fSkipPartialPacket = False;
+
+    if (fPacketSizeTable->nextPacketNumToDeliver == fPacketSizeTable->numCompletedPackets
+	&& !fPacketSizeTable->lastPacketIsIncomplete) {
+      return True; // there's nothing left in this page
+    }
+  }
+
   // Start delivering packets next:
-  demuxedTrack->fCurrentPageIsContinuation = (header_type_flag&0x01) != 0;
+  demuxedTrack->fCurrentPageIsContinuation = pageIsContinuation;
   fCurrentTrackNumber = bitstream_serial_number;
   fCurrentParseState = DELIVERING_PACKET_WITHIN_PAGE;
   saveParserState();
@@ -864,6 +913,9 @@ Boolean OggFileParser::deliverPacketWithinPage() {
     // This is the first delivery for this "doGetNextFrame()" call.
     demuxedTrack->frameSize() = numBytesDelivered;
   }
+  // Only the first packet in a continuation page completes the previous page's packet; any later packets in this page
+  // are new frames:
+  demuxedTrack->fCurrentPageIsContinuation = False;
   if (packetSize > demuxedTrack->maxSize()) {
     demuxedTrack->numTruncatedBytes() += packetSize - demuxedTrack->maxSize();
   }
@@ -58,6 +58,10 @@ public:
   static void continueParsing(void* clientData, unsigned char* ptr, unsigned size, struct timeval presentationTime);
   void continueParsing();
 
+  void seekToFilePosition(u_int64_t offsetInFile, Boolean resumeWithLastPacketInPage = False);
+      // "offsetInFile" is the start of a page.  If "resumeWithLastPacketInPage" is True, we skip all but the last packet
+      // of that page.
+
 private:
   Boolean needHeaders() { return fNumUnfulfilledTracks > 0; }
 
@@ -86,6 +90,7 @@ private:
   PacketSizeTable* fPacketSizeTable;
   u_int32_t fCurrentTrackNumber;
   u_int8_t* fSavedPacket; // used to temporarily save a copy of a 'packet' from a page
+  Boolean fResumeWithLastPacketInNextPage; // set after seeking
 };
 
 #endif
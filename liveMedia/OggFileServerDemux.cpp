@@ -20,6 +20,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #include "OggFileServerDemux.hh"
 #include "OggFileServerMediaSubsession.hh"
+#include "MediaFileCache.hh"
 
 void OggFileServerDemux
 ::createNew(UsageEnvironment& env, char const* fileName,
@@ -83,20 +84,43 @@ OggFileServerDemux
 ::OggFileServerDemux(UsageEnvironment& env, char const* fileName,
 		     onCreationFunc* onCreation, void* onCreationClientData)
   : Medium(env),
-    fFileName(fileName), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData),
+    fFileName(fileName), fOnCreation(onCreation), fOnCreationClientData(onCreationClientData), fOurOggFile(NULL),
     fIter(NULL/*until the OggFile is created*/),
     fLastClientSessionId(0), fLastCreatedDemux(NULL) {
-  OggFile::createNew(env, fileName, onOggFileCreation, this);
+  fCacheKey = new char[strlen(fileName) + 20];
+  sprintf(fCacheKey, "OggFile:%s", fileName);
+
+  OggFile* cachedFile = (OggFile*)MediaFileCache::attach(env, fCacheKey, fileName);
+  if (cachedFile != NULL) {
+    // This file has already been parsed (and hasn't changed since), so we can use it right away.  But we still signal our
+    // creation from the event loop (as we do for a newly-parsed file), rather than from within "createNew()":
+    fOurOggFile = cachedFile;
+    nextTask() = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)onCachedOggFile, this);
+  } else {
+    OggFile::createNew(env, fileName, onOggFileCreation, this);
+  }
 }
 
 OggFileServerDemux::~OggFileServerDemux() {
-  Medium::close(fOurOggFile);
+  MediaFileCache::detach(envir(), fOurOggFile);
+  delete[] fCacheKey;
 
   delete fIter;
 }
 
 void OggFileServerDemux::onOggFileCreation(OggFile* newFile, void* clientData) {
-  ((OggFileServerDemux*)clientData)->onOggFileCreation(newFile);
+  OggFileServerDemux* demux = (OggFileServerDemux*)clientData;
+
+  // Cache the newly-parsed file, so that other demultiplexors can use it:
+  MediaFileCache::add(demux->envir(), demux->fCacheKey, demux->fFileName, newFile);
+  demux->onOggFileCreation(newFile);
+}
+
+void OggFileServerDemux::onCachedOggFile(void* clientData) {
+  OggFileServerDemux* demux = (OggFileServerDemux*)clientData;
+
+  demux->nextTask() = NULL;
+  demux->onOggFileCreation(demux->fOurOggFile);
 }
 
 void OggFileServerDemux::onOggFileCreation(OggFile* newFile) {
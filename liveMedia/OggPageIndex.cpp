@@ -0,0 +1,328 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// An index of (some of) the pages in an Ogg file, used to find the file's duration, and to seek within it (by bisection
+// over the 'granule positions' of the pages of one of its tracks).
+// Implementation
+
+#include "OggPageIndex.hh"
+#include "InputFile.hh"
+
+// A summary of a page (of our 'reference' track), as seen when seeking:
+class OggPageSummary {
+public:
+  u_int64_t offset; // where the page begins in the file
+  u_int64_t endOffset; // where the next page begins
+  u_int64_t granulePosition;
+  double time; // "OggPageIndex::pageTime()" of the page
+  Boolean lastPacketIsIncomplete; // i.e., it continues into the next page
+};
+
+#define READ_CHUNK_SIZE 16384
+#define MAX_PAGE_HEADER_SIZE (27+255)
+#define MAX_PAGE_SIZE (MAX_PAGE_HEADER_SIZE+255*255)
+#define BISECTION_LIMIT 32768 /* once the range being searched is this small, we step through its pages one by one */
+#define MAX_CACHED_PAGES 1000
+
+static Boolean parsePageHeader(u_int8_t const* p, unsigned numBytesAvailable,
+			       u_int32_t& bitstream_serial_number, u_int64_t& granule_position, unsigned& pageSize,
+			       Boolean& lastPacketIsIncomplete) {
+  // Returns True iff "p" points to a complete Ogg page header (whose fields are then returned):
+  if (numBytesAvailable < 27 || p[0] != 'O' || p[1] != 'g' || p[2] != 'g' || p[3] != 'S'
+      || p[4] != 0/*stream_structure_version*/ || (p[5]&~0x07) != 0/*header_type_flag*/) return False;
+
+  u_int8_t number_page_segments = p[26];
+  if (numBytesAvailable < 27 + (unsigned)number_page_segments) return False;
+
+  // (The header's numeric fields are little-endian.)
+  granule_position = 0;
+  for (int i = 7; i >= 0; --i) granule_position = (granule_position<<8)|p[6+i];
+  bitstream_serial_number = (p[17]<<24)|(p[16]<<16)|(p[15]<<8)|p[14];
+
+  pageSize = 27 + number_page_segments;
+  for (unsigned i = 0; i < number_page_segments; ++i) pageSize += p[27+i];
+  lastPacketIsIncomplete = number_page_segments > 0 && p[27+number_page_segments-1] == 255;
+  return True;
+}
+
+static unsigned theoraFirstFrameNumber(OggTrack* track) {
+  // Before version 3.2.1 of the Theora bitstream, the frame numbers in granule positions began at 0, rather than 1:
+  u_int8_t const* hdr = track->vtoHdrs.header[0]; // "identification" header
+  unsigned version = (hdr[7]<<16)|(hdr[8]<<8)|hdr[9];
+  return version >= 0x030201 ? 1 : 0;
+}
+
+OggPageIndex::OggPageIndex(OggFile& ourFile)
+  : fOurFile(ourFile), fReferenceTrack(NULL), fReferenceTrackIsTheora(False), fFileSize(0), fFileDuration(0.0),
+    fCachedPages(NULL), fNumCachedPages(0),
+    fLastLookupNPT(-1.0), fLastLookupOffset(0), fLastLookupResumedWithLastPacketInPage(False) {
+  // Choose a 'reference' track - preferably a video track - whose granule positions we know how to interpret:
+  OggTrackTableIterator iter(fOurFile.trackTable());
+  OggTrack* track;
+  while ((track = iter.next()) != NULL) {
+    if (track->mimeType == NULL || track->weNeedHeaders()) continue;
+
+    if (strcmp(track->mimeType, "video/THEORA") == 0) {
+      fReferenceTrack = track;
+      fReferenceTrackIsTheora = True;
+      break;
+    }
+    if (fReferenceTrack == NULL) fReferenceTrack = track;
+  }
+  if (fReferenceTrack == NULL) return; // we can't seek within this file
+
+  findFileDuration();
+}
+
+OggPageIndex::~OggPageIndex() {
+  delete[] fCachedPages;
+}
+
+Boolean OggPageIndex::lookup(double& seekNPT, u_int64_t& offsetInFile, Boolean& resumeWithLastPacketInPage) {
+  if (fReferenceTrack == NULL || fFileSize == 0) return False;
+
+  if (seekNPT == fLastLookupNPT) {
+    // This is the result of our previous lookup (e.g., now being done for another track), so return the same position:
+    offsetInFile = fLastLookupOffset;
+    resumeWithLastPacketInPage = fLastLookupResumedWithLastPacketInPage;
+    return True;
+  }
+
+  OggPageSummary page;
+  Boolean foundPage = False;
+  if (seekNPT > 0.0) {
+    FILE* fid = OpenInputFile(fOurFile.envir(), fOurFile.fileName());
+    if (fid == NULL) return False;
+
+    foundPage = findLastPageNotAfter(fid, seekNPT, page);
+    if (foundPage && fReferenceTrackIsTheora) {
+      // The frames that follow this page can be decoded only from the key frame that they depend on, so begin there instead:
+      double keyFrameStartTime = keyFrameTime(page.granulePosition);
+      if (keyFrameStartTime < page.time) foundPage = findLastPageNotAfter(fid, keyFrameStartTime, page);
+    }
+    CloseInputFile(fid);
+  }
+
+  resumeWithLastPacketInPage = False;
+  if (foundPage) {
+    // The next packet (of our reference track) after this page begins at "page.time".  If that packet begins within this
+    // page, then resume reading with it; otherwise resume reading from the end of this page:
+    if (page.lastPacketIsIncomplete) {
+      offsetInFile = page.offset;
+      resumeWithLastPacketInPage = True;
+    } else {
+      offsetInFile = page.endOffset;
+    }
+    seekNPT = page.time;
+  } else {
+    // Resume reading from the start of the file:
+    offsetInFile = 0;
+    seekNPT = 0.0;
+  }
+
+  fLastLookupNPT = seekNPT;
+  fLastLookupOffset = offsetInFile;
+  fLastLookupResumedWithLastPacketInPage = resumeWithLastPacketInPage;
+  return True;
+}
+
+double OggPageIndex::pageTime(OggTrack* track, u_int64_t granulePosition) const {
+  if (strcmp(track->mimeType, "audio/VORBIS") == 0) {
+    // The granule position is a count of audio samples:
+    return granulePosition/(double)track->samplingFrequency;
+  } else if (strcmp(track->mimeType, "audio/OPUS") == 0) {
+    // The granule position is a count of 48 kHz audio samples, including the "pre_skip" samples (given in the
+    // "identification" header) that are not played:
+    u_int8_t const* hdr = track->vtoHdrs.header[0];
+    unsigned pre_skip = (hdr[11]<<8)|hdr[10];
+    return granulePosition > pre_skip ? (granulePosition - pre_skip)/48000.0 : 0.0;
+  } else { // "video/THEORA"
+    // The granule position is the number of the most recent key frame (shifted left by "KFGSHIFT" bits), plus the number
+    // of frames since then:
+    u_int8_t const shift = track->vtoHdrs.KFGSHIFT;
+    u_int64_t frameNumber = (granulePosition>>shift) + (granulePosition&(((u_int64_t)1<<shift) - 1));
+    u_int64_t numFrames = frameNumber + 1 - theoraFirstFrameNumber(track);
+    return numFrames*(track->vtoHdrs.uSecsPerFrame/1000000.0);
+  }
+}
+
+double OggPageIndex::keyFrameTime(u_int64_t granulePosition) const {
+  u_int64_t keyFrameNumber = granulePosition>>fReferenceTrack->vtoHdrs.KFGSHIFT;
+  unsigned firstFrameNumber = theoraFirstFrameNumber(fReferenceTrack);
+  if (keyFrameNumber < firstFrameNumber) return 0.0;
+
+  return (keyFrameNumber - firstFrameNumber)*(fReferenceTrack->vtoHdrs.uSecsPerFrame/1000000.0);
+}
+
+void OggPageIndex::findFileDuration() {
+  FILE* fid = OpenInputFile(fOurFile.envir(), fOurFile.fileName());
+  if (fid == NULL) return;
+  if (fid == stdin) return; // we can seek within only real files
+
+  fFileSize = GetFileSize(fOurFile.fileName(), fid);
+
+  // The file's last page (of each track) begins within the last "MAX_PAGE_SIZE" bytes of the file.  So, rather than
+  // reading the whole file, read (a little more than) this much, and look at the granule positions of the pages in it:
+  unsigned const tailSize = 2*MAX_PAGE_SIZE;
+  u_int64_t tailOffset = fFileSize > tailSize ? fFileSize - tailSize : 0;
+  u_int8_t* buf = new u_int8_t[tailSize];
+  unsigned bufLen = 0;
+  if (SeekFile64(fid, (int64_t)tailOffset, SEEK_SET) == 0) bufLen = fread(buf, 1, tailSize, fid);
+  CloseInputFile(fid);
+
+  double maxTime = 0.0;
+  unsigned i = 0;
+  while (i < bufLen) {
+    u_int32_t bitstream_serial_number;
+    u_int64_t granule_position;
+    unsigned pageSize;
+    Boolean lastPacketIsIncomplete;
+    if (!parsePageHeader(&buf[i], bufLen - i, bitstream_serial_number, granule_position, pageSize,
+			 lastPacketIsIncomplete)) {
+      ++i;
+      continue;
+    }
+
+    OggTrack* track = fOurFile.lookup(bitstream_serial_number);
+    if (track == NULL) { // not really a page header
+      ++i;
+      continue;
+    }
+    if (track->mimeType != NULL && !track->weNeedHeaders() && granule_position != ~(u_int64_t)0) {
+      double time = pageTime(track, granule_position);
+      if (time > maxTime) maxTime = time;
+    }
+    i += pageSize;
+  }
+  delete[] buf;
+
+  fFileDuration = (float)maxTime;
+}
+
+Boolean OggPageIndex::findLastPageNotAfter(FILE* fid, double seekNPT, OggPageSummary& result) {
+  // Find the last page (of our reference track) whose time is <= "seekNPT".
+  // Because a track's granule positions never decrease, the times of its pages increase with their offsets.  So we first
+  // use the pages that we've already seen to narrow the range of the file that we need to search:
+  Boolean foundPage = False;
+  u_int64_t lo = 0, hi = fFileSize;
+
+  unsigned l = 0, h = fNumCachedPages; // find the first cached page whose time is > "seekNPT"
+  while (l < h) {
+    unsigned m = (l+h)/2;
+    if (fCachedPages[m].time <= seekNPT) l = m+1; else h = m;
+  }
+  if (l > 0) {
+    result = fCachedPages[l-1];
+    foundPage = True;
+    lo = result.endOffset;
+  }
+  if (l < fNumCachedPages) hi = fCachedPages[l].offset;
+
+  // Then, bisect the remaining range, looking at the first page (of our reference track) after each midpoint:
+  OggPageSummary page;
+  while (hi > lo && hi - lo > BISECTION_LIMIT) {
+    u_int64_t mid = lo + (hi - lo)/2;
+    if (findPage(fid, mid, hi, page)) {
+      addToCache(page);
+      if (page.time <= seekNPT) {
+	result = page;
+	foundPage = True;
+	lo = page.endOffset;
+	continue;
+      }
+    }
+    hi = mid; // there's no page (of our reference track) in [mid, hi) whose time is <= "seekNPT"
+  }
+
+  // Finally, step through the pages in the (now small) remaining range:
+  while (lo < hi && findPage(fid, lo, hi, page)) {
+    addToCache(page);
+    if (page.time > seekNPT) break;
+
+    result = page;
+    foundPage = True;
+    lo = page.endOffset;
+  }
+
+  return foundPage;
+}
+
+Boolean OggPageIndex
+::findPage(FILE* fid, u_int64_t fromOffset, u_int64_t limitOffset, OggPageSummary& result) {
+  u_int8_t buf[READ_CHUNK_SIZE];
+  u_int64_t chunkOffset = fromOffset;
+
+  while (chunkOffset < limitOffset) {
+    if (SeekFile64(fid, (int64_t)chunkOffset, SEEK_SET) != 0) return False;
+    unsigned bufLen = fread(buf, 1, READ_CHUNK_SIZE, fid);
+    Boolean atEndOfFile = bufLen < READ_CHUNK_SIZE;
+
+    // Look for page headers only where we've read all of it (unless we're at the end of the file), and only before "limitOffset":
+    unsigned scanLimit = atEndOfFile ? bufLen : bufLen - MAX_PAGE_HEADER_SIZE;
+    if (limitOffset - chunkOffset < scanLimit) scanLimit = (unsigned)(limitOffset - chunkOffset);
+
+    unsigned i = 0;
+    while (i < scanLimit) {
+      u_int32_t bitstream_serial_number;
+      u_int64_t granule_position;
+      unsigned pageSize;
+      Boolean lastPacketIsIncomplete;
+      if (!parsePageHeader(&buf[i], bufLen - i, bitstream_serial_number, granule_position, pageSize,
+			   lastPacketIsIncomplete)) {
+	++i;
+	continue;
+      }
+
+      if (bitstream_serial_number == fReferenceTrack->trackNumber) {
+	if (granule_position != ~(u_int64_t)0) { // (a granule position of -1 means that no packet ends in this page)
+	  result.offset = chunkOffset + i;
+	  result.endOffset = result.offset + pageSize;
+	  result.granulePosition = granule_position;
+	  result.time = pageTime(fReferenceTrack, granule_position);
+	  result.lastPacketIsIncomplete = lastPacketIsIncomplete;
+	  return True;
+	}
+      } else if (fOurFile.lookup(bitstream_serial_number) == NULL) { // not really a page header
+	++i;
+	continue;
+      }
+      i += pageSize; // skip over this page
+    }
+    if (atEndOfFile) break;
+
+    chunkOffset += i;
+  }
+
+  return False;
+}
+
+void OggPageIndex::addToCache(OggPageSummary const& page) {
+  if (fCachedPages == NULL) fCachedPages = new OggPageSummary[MAX_CACHED_PAGES];
+  if (fNumCachedPages == MAX_CACHED_PAGES) return; // our cache is full
+
+  // Keep the cache sorted by offset:
+  unsigned l = 0, h = fNumCachedPages;
+  while (l < h) {
+    unsigned m = (l+h)/2;
+    if (fCachedPages[m].offset < page.offset) l = m+1; else h = m;
+  }
+  if (l < fNumCachedPages && fCachedPages[l].offset == page.offset) return; // we've already cached this page
+
+  for (unsigned i = fNumCachedPages; i > l; --i) fCachedPages[i] = fCachedPages[i-1];
+  fCachedPages[l] = page;
+  ++fNumCachedPages;
+}
@@ -0,0 +1,74 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// An index of (some of) the pages in an Ogg file, used to find the file's duration, and to seek within it (by bisection
+// over the 'granule positions' of the pages of one of its tracks).
+// C++ header
+
+#ifndef _OGG_PAGE_INDEX_HH
+#define _OGG_PAGE_INDEX_HH
+
+#ifndef _OGG_FILE_HH
+#include "OggFile.hh"
+#endif
+
+class OggPageSummary; // forward
+
+class OggPageIndex {
+public:
+  OggPageIndex(OggFile& ourFile); // called once the file's BOS pages (and track headers) have been parsed
+  virtual ~OggPageIndex();
+
+  float fileDuration() const { return fFileDuration; } // in seconds; 0 if unknown
+
+  Boolean lookup(double& seekNPT, u_int64_t& offsetInFile, Boolean& resumeWithLastPacketInPage);
+      // Sets "offsetInFile" to the start of the page from which we should resume reading the file, in order to play from
+      // (at, or just before) "seekNPT", and sets "seekNPT" to the actual time at that point.
+      // If "resumeWithLastPacketInPage" is set, then the page's last packet (which continues into the next page) is the
+      // first one to play; the packets that precede it in the page are to be skipped.
+      // Returns False if we can't seek within this file.
+
+private:
+  double pageTime(OggTrack* track, u_int64_t granulePosition) const;
+      // the time (in seconds) at the end of the last packet that's completed in the page
+  double keyFrameTime(u_int64_t granulePosition) const; // for a Theora reference track
+
+  void findFileDuration();
+  Boolean findLastPageNotAfter(FILE* fid, double seekNPT, OggPageSummary& result);
+  Boolean findPage(FILE* fid, u_int64_t fromOffset, u_int64_t limitOffset, OggPageSummary& result);
+      // finds the first page of our reference track that has a granule position, and begins in [fromOffset, limitOffset)
+  void addToCache(OggPageSummary const& page);
+
+private:
+  OggFile& fOurFile;
+  OggTrack* fReferenceTrack; // the track whose pages we use for seeking (a video track, if there is one); NULL if none
+  Boolean fReferenceTrackIsTheora;
+  u_int64_t fFileSize;
+  float fFileDuration;
+
+  // The pages (of our reference track) that we've seen so far, sorted by offset:
+  OggPageSummary* fCachedPages;
+  unsigned fNumCachedPages;
+
+  // The result of our most recent "lookup()", so that looking up its result again (e.g., for another track) returns the
+  // same position:
+  double fLastLookupNPT;
+  u_int64_t fLastLookupOffset;
+  Boolean fLastLookupResumedWithLastPacketInPage;
+};
+
+#endif
@@ -321,6 +321,13 @@ FramedSource* OnDemandServerMediaSubsession::getStreamSource(void* streamToken)
 	return streamState->mediaSource();
 }
 
+RTPSink* OnDemandServerMediaSubsession::getStreamRTPSink(void* streamToken) {
+	if (streamToken == NULL) return NULL;
+
+	StreamState* streamState = (StreamState*)streamToken;
+	return streamState->rtpSink();
+}
+
 void OnDemandServerMediaSubsession::deleteStream(unsigned clientSessionId,
 	void*& streamToken) {
 	StreamState* streamState = (StreamState*)streamToken;
@@ -382,6 +389,10 @@ void OnDemandServerMediaSubsession::closeStreamSource(FramedSource *inputSource)
 	Medium::close(inputSource);
 }
 
+void OnDemandServerMediaSubsession::handleKeyFrameRequest(FramedSource* /*inputSource*/) {
+	// Default implementation: Do nothing
+}
+
 void OnDemandServerMediaSubsession
 ::setSDPLinesFromRTPSink(RTPSink* rtpSink, FramedSource* inputSource, unsigned estBitrate) {
 	if (rtpSink == NULL) return;
@@ -457,6 +468,10 @@ static void afterPlayingStreamState(void* clientData) {
 	// (This can be done only on streams that have a known duration.)
 }
 
+static void keyFrameRequestHandler(void* clientData) {
+	((StreamState*)clientData)->handleKeyFrameRequest();
+}
+
 StreamState::StreamState(OnDemandServerMediaSubsession& master,
 	Port const& serverRTPPort, Port const& serverRTCPPort,
 	RTPSink* rtpSink, BasicUDPSink* udpSink,
@@ -487,6 +502,7 @@ void* serverRequestAlternativeByteHandlerClientData) {
 			fTotalBW, (unsigned char*)fMaster.fCNAME,
 			fRTPSink, NULL /* we're a server */);
 		// Note: This starts RTCP running automatically
+		if (fRTCPInstance != NULL) fRTCPInstance->setKeyFrameRequestHandler(keyFrameRequestHandler, this);
 	}
 
 	if (dests->isTCP) {
@@ -572,6 +588,10 @@ void StreamState::endPlaying(Destinations* dests) {
 	}
 }
 
+void StreamState::handleKeyFrameRequest() {
+	if (fMediaSource != NULL) fMaster.handleKeyFrameRequest(fMediaSource);
+}
+
 void StreamState::reclaim() {
 	// Delete allocated media objects
 	Medium::close(fRTCPInstance) /* will send a RTCP BYE */; fRTCPInstance = NULL;
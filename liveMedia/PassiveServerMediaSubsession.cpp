@@ -207,6 +207,10 @@ float PassiveServerMediaSubsession::getCurrentNPT(void* streamToken) {
   return (float)(timeNow.tv_sec - creationTime.tv_sec + (timeNow.tv_usec - creationTime.tv_usec)/1000000.0);
 }
 
+RTPSink* PassiveServerMediaSubsession::getStreamRTPSink(void* /*streamToken*/) {
+  return &fRTPSink;
+}
+
 void PassiveServerMediaSubsession::deleteStream(unsigned clientSessionId, void*& /*streamToken*/) {
   // Lookup and remove the 'RTCPSourceRecord' for this client.  Also turn off RTCP "RR" handling:
   RTCPSourceRecord* source = (RTCPSourceRecord*)(fClientRTCPSourceRecords->Lookup((char const*)clientSessionId));
@@ -22,6 +22,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "liveMedia.hh"
 #include "RTSPCommon.hh"
 #include "GroupsockHelper.hh" // for "our_random()"
+#include <time.h> // for "strftime()" and "gmtime()"
 
 #ifndef MILLION
 #define MILLION 1000000
@@ -31,15 +32,45 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 class ProxyServerMediaSubsession: public OnDemandServerMediaSubsession {
 public:
-  ProxyServerMediaSubsession(MediaSubsession& mediaSubsession);
+  ProxyServerMediaSubsession(MediaSubsession& mediaSubsession, unsigned gopCacheSize = 0, unsigned gopCacheReplaySpeedup = 4,
+			     unsigned dvrSeconds = 0, unsigned dvrMaxBytes = 0);
+      // If "gopCacheSize" > 0 (for a H.264 or H.265 track only), then each client gets its own copy of the stream,
+      // beginning with a replay of the most recent GOP.  If "dvrSeconds" > 0, then each client also gets its own copy,
+      // but it can begin anywhere in the most recent "dvrSeconds" of the stream (see "DVRBuffer.hh").
   virtual ~ProxyServerMediaSubsession();
 
-  char const* codecName() const { return fClientMediaSubsession.codecName(); }
+  char const* codecName() const { return fClientMediaSubsession->codecName(); }
+
+private:
+  friend class ProxyServerMediaSession;
+  void initiateInput(); // creates our input source (if we haven't already done so)
+  void setUpUpstream(); // sends "SETUP" (or resumes with "PLAY") to the back-end server, if necessary
+  void startDraining();
+  void stopDraining();
+  void detachFromUpstream(); // stops reading from the current back-end stream (but keeps our input source open)
+  void upstreamClosed(); // called when the back-end stream's source closes
+  RTPSource* upstreamRTPSource() const { return fClientMediaSubsession->rtpSource(); } // NULL while we're between back-end streams
+  void requestKeyFrameFromUpstream(); // sends a RTCP "PLI" to the back-end server (but not too often)
+  static void sendKeyFrameRequest(void* clientData);
+  void sendKeyFrameRequest();
+  Boolean hasFramer() const; // whether our codec needs a 'framer' in front of its "RTPSink"
+  FramedSource* createFramer(FramedSource* inputSource); // returns "inputSource" itself if we don't need a 'framer'
+  FramedSource* sourceBehindFramer(FramedSource* inputSource) const;
+  void enableRTCPReportsWhenSynchronized(RTPSink* rtpSink); // for a client that has its own copy of the stream
 
 private: // redefined virtual functions
+  virtual void startStream(unsigned clientSessionId, void* streamToken,
+			   TaskFunc* rtcpRRHandler, void* rtcpRRHandlerClientData,
+			   unsigned short& rtpSeqNum, unsigned& rtpTimestamp,
+			   ServerRequestAlternativeByteHandler* serverRequestAlternativeByteHandler,
+			   void* serverRequestAlternativeByteHandlerClientData);
   virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
                                               unsigned& estBitrate);
   virtual void closeStreamSource(FramedSource *inputSource);
+  virtual void handleKeyFrameRequest(FramedSource* inputSource);
+  virtual void seekStreamSource(FramedSource* inputSource, char*& absStart, char*& absEnd);
+  virtual void testScaleFactor(float& scale);
+  virtual void setStreamSourceScale(FramedSource* inputSource, float scale);
   virtual RTPSink* createNewRTPSink(Groupsock* rtpGroupsock,
                                     unsigned char rtpPayloadTypeIfDynamic,
                                     FramedSource* inputSource);
@@ -52,9 +83,142 @@ private:
 
 private:
   friend class ProxyRTSPClient;
-  MediaSubsession& fClientMediaSubsession; // the 'client' media subsession object that corresponds to this 'server' media subsession
+  friend class ProxyUpstreamSwitch;
+  friend class ProxyGOPCacheReader;
+  friend class ProxyDVRBufferReader;
+  MediaSubsession* fClientMediaSubsession; // the 'client' media subsession object that corresponds to this 'server' media subsession
   ProxyServerMediaSubsession* fNext; // used when we're part of a queue
   Boolean fHaveSetupStream;
+  class ProxyUpstreamSwitch* fUpstreamSwitch; // the first filter on our input source; it reads from "fClientMediaSubsession"
+  FramedSource* fInputSource; // the last filter on our input source (which we - rather than "fClientMediaSubsession" - own)
+  unsigned fGOPCacheSize, fGOPCacheReplaySpeedup;
+  GOPCache* fGOPCache; // the last filter on our input source, if "fGOPCacheSize" > 0
+  unsigned fDVRSeconds, fDVRMaxBytes;
+  DVRBuffer* fDVRBuffer; // the last filter on our input source, if "fDVRSeconds" > 0
+  StreamReplicator* fReplicator; // gives each client its own copy of "fGOPCache"'s (or "fDVRBuffer"'s) output
+  Boolean fHasClients;
+  PresentationTimeSubsessionNormalizer* fNormalizer;
+  class ProxyDrainSink* fDrainSink; // reads our input while we have no clients, but the back-end stream is kept playing
+  struct timeval fLastKeyFrameRequestTime;
+  TaskToken fKeyFrameRequestTask; // a (coalesced) key frame request that was too soon after the previous one
+};
+
+
+// The first filter on each "ProxyServerMediaSubsession"s input source.  It reads from the current back-end stream's source,
+// and can be switched to the source of a replacement back-end stream (after a failover), without disturbing the filters - and
+// clients - that read from it.
+
+class ProxyUpstreamSwitch: public FramedFilter {
+public:
+  ProxyUpstreamSwitch(ProxyServerMediaSubsession& subsession)
+    : FramedFilter(subsession.envir(), NULL), fSubsession(subsession) {
+  }
+  virtual ~ProxyUpstreamSwitch() {
+    switchInput(NULL); // because our input source belongs to the back-end "MediaSubsession", and mustn't be closed by us
+  }
+
+  void switchInput(FramedSource* newInputSource) {
+    if (fInputSource != NULL) fInputSource->stopGettingFrames();
+    fInputSource = newInputSource;
+
+    // If a read was pending (on the old input source, or while we had none), then continue it from the new input source:
+    if (fInputSource != NULL && isCurrentlyAwaitingData()) doGetNextFrame();
+  }
+
+private: // redefined virtual functions:
+  virtual void doGetNextFrame() {
+    if (fInputSource == NULL) return; // we're between back-end streams; we'll continue once we get a new input source
+
+    fInputSource->getNextFrame(fTo, fMaxSize, afterGettingFrame, this, inputClosure, this);
+  }
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize, unsigned numTruncatedBytes,
+				struct timeval presentationTime, unsigned durationInMicroseconds) {
+    ProxyUpstreamSwitch* upstreamSwitch = (ProxyUpstreamSwitch*)clientData;
+    upstreamSwitch->fFrameSize = frameSize;
+    upstreamSwitch->fNumTruncatedBytes = numTruncatedBytes;
+    upstreamSwitch->fPresentationTime = presentationTime;
+    upstreamSwitch->fDurationInMicroseconds = durationInMicroseconds;
+    FramedSource::afterGetting(upstreamSwitch);
+  }
+  static void inputClosure(void* clientData) {
+    ((ProxyUpstreamSwitch*)clientData)->fSubsession.upstreamClosed();
+  }
+
+private:
+  ProxyServerMediaSubsession& fSubsession;
+};
+
+
+// When clients have their own copies of a stream, each client's "RTPSink" has its RTCP "SR" reports enabled by its source
+// (rather than by our "PresentationTimeSubsessionNormalizer"), once its presentation times are RTCP-synchronized:
+
+class ProxyGOPCacheReader: public GOPCacheReader {
+public:
+  ProxyGOPCacheReader(UsageEnvironment& env, GOPCache& cache, FramedSource* liveSource, unsigned replaySpeedup,
+		      ProxyServerMediaSubsession& subsession)
+    : GOPCacheReader(env, cache, liveSource, replaySpeedup), fSubsession(subsession), fRTPSink(NULL) {
+  }
+
+  void setRTPSink(RTPSink* rtpSink) { fRTPSink = rtpSink; }
+
+private: // redefined virtual functions:
+  virtual void aboutToDeliverFrame() { fSubsession.enableRTCPReportsWhenSynchronized(fRTPSink); }
+
+private:
+  ProxyServerMediaSubsession& fSubsession;
+  RTPSink* fRTPSink;
+};
+
+class ProxyDVRBufferReader: public DVRBufferReader {
+public:
+  ProxyDVRBufferReader(UsageEnvironment& env, DVRBuffer& buffer, FramedSource* liveSource, unsigned replaySpeedup,
+		       ProxyServerMediaSubsession& subsession)
+    : DVRBufferReader(env, buffer, liveSource, replaySpeedup), fSubsession(subsession), fRTPSink(NULL) {
+  }
+
+  void setRTPSink(RTPSink* rtpSink) { fRTPSink = rtpSink; }
+
+private: // redefined virtual functions:
+  virtual void aboutToDeliverFrame() { fSubsession.enableRTCPReportsWhenSynchronized(fRTPSink); }
+
+private:
+  ProxyServerMediaSubsession& fSubsession;
+  RTPSink* fRTPSink;
+};
+
+
+// A sink that just reads - and discards - the frames of a back-end stream that's being kept playing while it has no clients.
+// (This keeps the stream's input - including any GOP cache - current, and stops its packets from backing up in the socket.)
+
+class ProxyDrainSink: public MediaSink {
+public:
+  ProxyDrainSink(UsageEnvironment& env)
+    : MediaSink(env), fBufferSize(OutPacketBuffer::maxSize) { // the same size as a "RTPSink"s input buffer, so frames aren't truncated
+    fBuffer = new unsigned char[fBufferSize];
+  }
+  virtual ~ProxyDrainSink() {
+    delete[] fBuffer;
+  }
+
+private: // redefined virtual functions:
+  virtual Boolean continuePlaying() {
+    if (fSource == NULL) return False;
+
+    fSource->getNextFrame(fBuffer, fBufferSize, afterGettingFrame, this, onSourceClosure, this);
+    return True;
+  }
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned /*frameSize*/, unsigned /*numTruncatedBytes*/,
+				struct timeval /*presentationTime*/, unsigned /*durationInMicroseconds*/) {
+    ((ProxyDrainSink*)clientData)->continuePlaying();
+  }
+
+private:
+  unsigned char* fBuffer;
+  unsigned fBufferSize;
 };
 
 
@@ -93,9 +257,16 @@ ProxyServerMediaSession
 			  createNewProxyRTSPClientFunc* ourCreateNewProxyRTSPClientFunc)
   : ServerMediaSession(env, streamName, NULL, NULL, False, NULL),
     describeCompletedFlag(0), fOurRTSPServer(ourRTSPServer), fClientMediaSession(NULL),
-    fVerbosityLevel(verbosityLevel),
+    fVerbosityLevel(verbosityLevel), fGOPCacheSize(0), fGOPCacheReplaySpeedup(4), fDVRSeconds(0), fDVRMaxBytes(0),
+    fUpstreamPolicy(UPSTREAM_LAZY), fLingerSeconds(0), fNumSubsessionsWithClients(0), fIsIdleUpstream(False), fLingerTask(NULL),
+    fNumUpstreamURLs(1), fCurrentUpstreamIndex(0), fNumUpstreamsFailedInARow(0), fNoDataTimeoutMS(0), fNumFailovers(0),
+    fIsFailingOver(False), fFailoverReason(NULL), fFailoverTask(NULL), fNoDataCheckTask(NULL),
+    fUpstreamWasPlayingAtLastCheck(False), fNumUpstreamPacketsAtLastCheck(0),
     fPresentationTimeSessionNormalizer(new PresentationTimeSessionNormalizer(envir())),
     fCreateNewProxyRTSPClientFunc(ourCreateNewProxyRTSPClientFunc) {
+  fUpstreamURLs = new char*[1];
+  fUpstreamURLs[0] = strDup(inputStreamURL);
+
   // Open a RTSP connection to the input stream, and send a "DESCRIBE" command.
   // We'll use the SDP description in the response to set ourselves up.
   fProxyRTSPClient
@@ -113,35 +284,384 @@ ProxyServerMediaSession::~ProxyServerMediaSession() {
 
   // Begin by sending a "TEARDOWN" command (without checking for a response):
   if (fProxyRTSPClient != NULL) fProxyRTSPClient->sendTeardownCommand(*fClientMediaSession, NULL, fProxyRTSPClient->auth());
+  releaseIdleUpstream();
+  deleteAllSubsessions(); // before their input sources get closed (along with "fClientMediaSession")
 
   // Then delete our state:
+  envir().taskScheduler().unscheduleDelayedTask(fFailoverTask);
+  envir().taskScheduler().unscheduleDelayedTask(fNoDataCheckTask);
   Medium::close(fClientMediaSession);
   Medium::close(fProxyRTSPClient);
   delete fPresentationTimeSessionNormalizer;
+
+  for (unsigned i = 0; i < fNumUpstreamURLs; ++i) delete[] fUpstreamURLs[i];
+  delete[] fUpstreamURLs;
 }
 
 char const* ProxyServerMediaSession::url() const {
   return fProxyRTSPClient == NULL ? NULL : fProxyRTSPClient->url();
 }
 
+void ProxyServerMediaSession::setGOPCacheSize(unsigned maxBytes, unsigned replaySpeedup) {
+  fGOPCacheSize = maxBytes;
+  fGOPCacheReplaySpeedup = replaySpeedup;
+}
+
+void ProxyServerMediaSession::setDVRWindow(unsigned seconds, unsigned maxBytesPerTrack) {
+  fDVRSeconds = seconds;
+  fDVRMaxBytes = maxBytesPerTrack;
+}
+
+unsigned ProxyServerMediaSession::fMaxIdleUpstreams = 0;
+unsigned ProxyServerMediaSession::fNumIdleUpstreams = 0;
+
+void ProxyServerMediaSession::setUpstreamPolicy(UpstreamPolicy policy, unsigned lingerSeconds) {
+  fUpstreamPolicy = policy;
+  fLingerSeconds = lingerSeconds;
+
+  if (policy == UPSTREAM_HOT && fClientMediaSession != NULL) startHotUpstream(); // if we've already been described
+}
+
+void ProxyServerMediaSession::addBackupURL(char const* backupStreamURL) {
+  char** newUpstreamURLs = new char*[fNumUpstreamURLs+1];
+  for (unsigned i = 0; i < fNumUpstreamURLs; ++i) newUpstreamURLs[i] = fUpstreamURLs[i];
+  newUpstreamURLs[fNumUpstreamURLs++] = strDup(backupStreamURL);
+  delete[] fUpstreamURLs; fUpstreamURLs = newUpstreamURLs;
+}
+
+void ProxyServerMediaSession::setFailureDetection(unsigned noDataTimeoutMS) {
+  fNoDataTimeoutMS = noDataTimeoutMS;
+
+  envir().taskScheduler().unscheduleDelayedTask(fNoDataCheckTask); fNoDataCheckTask = NULL;
+  fUpstreamWasPlayingAtLastCheck = False;
+  if (fNoDataTimeoutMS > 0) {
+    fNoDataCheckTask = envir().taskScheduler().scheduleDelayedTask(fNoDataTimeoutMS*1000, (TaskFunc*)checkUpstreamData, this);
+  }
+}
+
+void ProxyServerMediaSession::setMaxIdleUpstreams(unsigned maxIdleUpstreams) {
+  fMaxIdleUpstreams = maxIdleUpstreams;
+}
+
+void ProxyServerMediaSession::startHotUpstream() {
+  if (fNumSubsessionsWithClients > 0 || fIsIdleUpstream) return; // the back-end stream is already playing (or being set up)
+  if (!keepUpstreamPlaying()) return; // we're not allowed to (yet)
+
+  if (fVerbosityLevel > 0) {
+    envir() << *this << ": starting the back-end stream (because it's 'hot')\n";
+  }
+  ServerMediaSubsessionIterator iter(*this);
+  ProxyServerMediaSubsession* smss;
+  while ((smss = (ProxyServerMediaSubsession*)(iter.next())) != NULL) {
+    smss->initiateInput();
+    smss->setUpUpstream();
+    smss->startDraining();
+  }
+}
+
+void ProxyServerMediaSession::noteNewClient() {
+  ++fNumSubsessionsWithClients;
+  releaseIdleUpstream();
+}
+
+Boolean ProxyServerMediaSession::keepUpstreamPlaying() {
+  if (fUpstreamPolicy == UPSTREAM_LAZY) return False;
+  if (fNumSubsessionsWithClients > 0 || fIsIdleUpstream) return True; // the back-end stream is already being kept playing
+
+  if (fMaxIdleUpstreams > 0 && fNumIdleUpstreams >= fMaxIdleUpstreams) {
+    if (fVerbosityLevel > 0) {
+      envir() << *this << ": can't keep the back-end stream playing without clients, because "
+	      << fNumIdleUpstreams << " streams are already doing so\n";
+    }
+    return False;
+  }
+  fIsIdleUpstream = True;
+  ++fNumIdleUpstreams;
+
+  if (fUpstreamPolicy == UPSTREAM_LINGER) {
+    fLingerTask = envir().taskScheduler().scheduleDelayedTask(fLingerSeconds*MILLION, (TaskFunc*)lingerTimeout, this);
+  }
+  return True;
+}
+
+void ProxyServerMediaSession::releaseIdleUpstream() {
+  envir().taskScheduler().unscheduleDelayedTask(fLingerTask); fLingerTask = NULL;
+  if (fIsIdleUpstream) {
+    fIsIdleUpstream = False;
+    --fNumIdleUpstreams;
+  }
+}
+
+void ProxyServerMediaSession::lingerTimeout(void* clientData) {
+  ((ProxyServerMediaSession*)clientData)->lingerTimeout();
+}
+
+void ProxyServerMediaSession::lingerTimeout() {
+  fLingerTask = NULL;
+  releaseIdleUpstream();
+  if (fVerbosityLevel > 0) {
+    envir() << *this << ": no clients for " << fLingerSeconds << " seconds; pausing the back-end stream\n";
+  }
+
+  // None of our subsessions has any clients (otherwise this task would have been unscheduled), so stop reading their
+  // input, and "PAUSE" the back-end stream, as if our last client had just left:
+  ServerMediaSubsessionIterator iter(*this);
+  ProxyServerMediaSubsession* smss;
+  while ((smss = (ProxyServerMediaSubsession*)(iter.next())) != NULL) {
+    smss->stopDraining();
+    if (smss->fGOPCache != NULL) smss->fGOPCache->flush();
+    if (smss->fDVRBuffer != NULL) smss->fDVRBuffer->noteDiscontinuity();
+  }
+  if (fProxyRTSPClient != NULL && fProxyRTSPClient->fLastCommandWasPLAY && fClientMediaSession != NULL) {
+    fProxyRTSPClient->sendPauseCommand(*fClientMediaSession, NULL, fProxyRTSPClient->auth());
+    fProxyRTSPClient->fLastCommandWasPLAY = False;
+  }
+}
+
+void ProxyServerMediaSession::scheduleFailover(char const* reason) {
+  if (fFailoverTask != NULL || fIsFailingOver) return; // we're already failing over
+
+  // Do the failover from the event loop, because we might have been called from deep within the old back-end stream's code:
+  fFailoverReason = reason;
+  fFailoverTask = envir().taskScheduler().scheduleDelayedTask(0, (TaskFunc*)failover, this);
+}
+
+void ProxyServerMediaSession::failover(void* clientData) {
+  ((ProxyServerMediaSession*)clientData)->failover();
+}
+
+void ProxyServerMediaSession::failover() {
+  fFailoverTask = NULL;
+  unsigned const nextUpstreamIndex = (fCurrentUpstreamIndex+1)%fNumUpstreamURLs;
+  if (fVerbosityLevel > 0) {
+    envir() << *this << ": the back-end stream failed (" << fFailoverReason << "); switching to \""
+	    << fUpstreamURLs[nextUpstreamIndex] << "\"\n";
+  }
+  ++fNumFailovers;
+  fIsFailingOver = True;
+
+  // Stop reading from the old back-end stream, but keep our subsessions' input sources - and thus our clients' streams - open:
+  ServerMediaSubsessionIterator iter(*this);
+  ProxyServerMediaSubsession* smss;
+  while ((smss = (ProxyServerMediaSubsession*)(iter.next())) != NULL) {
+    smss->detachFromUpstream();
+  }
+
+  // Then, "DESCRIBE" the next back-end stream.  (We resume our subsessions once this has been done.)
+  fProxyRTSPClient->reset();
+  fCurrentUpstreamIndex = nextUpstreamIndex;
+  fNumUpstreamsFailedInARow = 1;
+  fProxyRTSPClient->setOurURL(fUpstreamURLs[fCurrentUpstreamIndex]);
+  ProxyRTSPClient::sendDESCRIBE(fProxyRTSPClient);
+}
+
+Boolean ProxyServerMediaSession::switchToNextUpstreamAfterDESCRIBEFailure() {
+  if (fNumUpstreamURLs <= 1) return False; // there's nothing to switch to
+
+  fCurrentUpstreamIndex = (fCurrentUpstreamIndex+1)%fNumUpstreamURLs;
+  fProxyRTSPClient->setOurURL(fUpstreamURLs[fCurrentUpstreamIndex]);
+  if (fVerbosityLevel > 0) {
+    envir() << *this << ": switching to back-end URL \"" << fUpstreamURLs[fCurrentUpstreamIndex] << "\"\n";
+  }
+
+  // Try each URL straight away, once.  But once they have all failed, back off before trying again:
+  if (++fNumUpstreamsFailedInARow < fNumUpstreamURLs) return True;
+  fNumUpstreamsFailedInARow = 0;
+  return False;
+}
+
+Boolean ProxyServerMediaSession::resumeAfterFailover(MediaSession* newClientMediaSession) {
+  if (newClientMediaSession == NULL || fClientMediaSession == NULL) return False;
+
+  // We can keep our clients' streams open only if the new back-end stream's tracks match the old one's:
+  ServerMediaSubsessionIterator iter(*this);
+  MediaSubsessionIterator newIter(*newClientMediaSession);
+  ProxyServerMediaSubsession* smss;
+  MediaSubsession* mss;
+  while (1) {
+    smss = (ProxyServerMediaSubsession*)(iter.next());
+    mss = newIter.next();
+    if (smss == NULL || mss == NULL) break;
+
+    if (strcmp(smss->fClientMediaSubsession->mediumName(), mss->mediumName()) != 0 ||
+	strcmp(smss->fClientMediaSubsession->codecName(), mss->codecName()) != 0) break;
+  }
+  if (smss != NULL || mss != NULL) {
+    if (fVerbosityLevel > 0) {
+      envir() << *this << ": the new back-end stream's tracks differ from the old one's; closing our clients\n";
+    }
+    return False;
+  }
+
+  // Switch each of our subsessions to its new 'client' media subsession:
+  iter.reset(); newIter.reset();
+  while ((smss = (ProxyServerMediaSubsession*)(iter.next())) != NULL) {
+    smss->fClientMediaSubsession = newIter.next();
+  }
+  Medium::close(fClientMediaSession);
+  fClientMediaSession = newClientMediaSession;
+  fPresentationTimeSessionNormalizer->resetSynchronization();
+  if (fVerbosityLevel > 0) {
+    envir() << *this << ": resumed from the new back-end stream\n";
+  }
+
+  // Then restart the back-end stream for those subsessions that are being read (by clients, or because it's being kept playing):
+  iter.reset();
+  while ((smss = (ProxyServerMediaSubsession*)(iter.next())) != NULL) {
+    if (smss->fHasClients || smss->fDrainSink != NULL) {
+      smss->initiateInput();
+      smss->setUpUpstream();
+    }
+  }
+  return True;
+}
+
+void ProxyServerMediaSession::checkUpstreamData(void* clientData) {
+  ((ProxyServerMediaSession*)clientData)->checkUpstreamData();
+}
+
+void ProxyServerMediaSession::checkUpstreamData() {
+  fNoDataCheckTask = envir().taskScheduler().scheduleDelayedTask(fNoDataTimeoutMS*1000, (TaskFunc*)checkUpstreamData, this);
+
+  // Count the RTP packets that we've received from the back-end stream, if it's currently playing:
+  Boolean const isPlaying = !fIsFailingOver && fProxyRTSPClient != NULL && fProxyRTSPClient->fLastCommandWasPLAY
+    && fClientMediaSession != NULL;
+  unsigned numPackets = 0;
+  if (isPlaying) {
+    MediaSubsessionIterator iter(*fClientMediaSession);
+    MediaSubsession* mss;
+    while ((mss = iter.next()) != NULL) {
+      if (mss->rtpSource() == NULL) continue;
+
+      RTPReceptionStatsDB::Iterator statsIter(mss->rtpSource()->receptionStatsDB());
+      RTPReceptionStats* stats;
+      while ((stats = statsIter.next(True)) != NULL) numPackets += stats->totNumPacketsReceived();
+    }
+  }
+
+  if (isPlaying && fUpstreamWasPlayingAtLastCheck && numPackets == fNumUpstreamPacketsAtLastCheck) {
+    // Nothing has arrived since our last check:
+    fUpstreamWasPlayingAtLastCheck = False;
+    scheduleFailover("no RTP packets received");
+    return;
+  }
+  fUpstreamWasPlayingAtLastCheck = isPlaying;
+  fNumUpstreamPacketsAtLastCheck = numPackets;
+}
+
+void ProxyServerMediaSession::addMetrics(MediaMetricsWriter& writer) {
+  writer.clearLabels();
+  writer.setLabel("stream", streamName());
+  writer.addSample("live555_upstream_described", MediaMetricsWriter::GAUGE,
+		   "1 if the back-end stream being proxied has been successfully described; 0 otherwise.",
+		   describeCompletedSuccessfully() ? 1 : 0);
+  writer.addSample("live555_upstream_idle_playing", MediaMetricsWriter::GAUGE,
+		   "1 if the back-end stream is being kept playing (because of its 'hot' or 'linger' policy) without any clients.",
+		   fIsIdleUpstream ? 1 : 0);
+  writer.addSample("live555_upstream_failovers_total", MediaMetricsWriter::COUNTER,
+		   "Times that the back-end stream has failed, and been replaced by the next of its URLs.", fNumFailovers);
+  writer.addSample("live555_upstream_url_index", MediaMetricsWriter::GAUGE,
+		   "The back-end URL currently being used (0 for the stream's primary URL; >0 for a backup URL).",
+		   fCurrentUpstreamIndex);
+  if (fClientMediaSession == NULL) return;
+
+  MediaSubsessionIterator iter(*fClientMediaSession);
+  MediaSubsession* subsession;
+  while ((subsession = iter.next()) != NULL) {
+    RTPSource* source = subsession->rtpSource();
+    if (source == NULL) continue; // this subsession isn't currently being received
+
+    writer.setLabel("medium", subsession->mediumName());
+    writer.setLabel("codec", subsession->codecName());
+    writer.addSample("live555_upstream_frames_received_total", MediaMetricsWriter::COUNTER,
+		     "Frames received from the back-end stream.", (double)source->totNumFramesReceived());
+    writer.addSample("live555_upstream_truncated_bytes_total", MediaMetricsWriter::COUNTER,
+		     "Bytes of frames received from the back-end stream that were dropped because they were too large for our buffer.",
+		     (double)source->totNumTruncatedBytes());
+
+    unsigned const timestampFrequency = source->timestampFrequency();
+    RTPReceptionStatsDB::Iterator statsIter(source->receptionStatsDB());
+    RTPReceptionStats* stats;
+    while ((stats = statsIter.next(True)) != NULL) {
+      writer.setLabel("ssrc", stats->SSRC());
+
+      unsigned const numPacketsExpected = stats->totNumPacketsExpected();
+      unsigned const numPacketsReceived = stats->totNumPacketsReceived();
+      writer.addSample("live555_upstream_packets_received_total", MediaMetricsWriter::COUNTER,
+		       "RTP packets received from the back-end stream.", numPacketsReceived);
+      writer.addSample("live555_upstream_bytes_received_total", MediaMetricsWriter::COUNTER,
+		       "RTP payload bytes received from the back-end stream.", stats->totNumKBytesReceived()*1000);
+      writer.addSample("live555_upstream_packets_lost_total", MediaMetricsWriter::COUNTER,
+		       "RTP packets from the back-end stream that were never received.",
+		       numPacketsExpected > numPacketsReceived ? numPacketsExpected - numPacketsReceived : 0);
+      if (timestampFrequency > 0) {
+	writer.addSample("live555_upstream_jitter_seconds", MediaMetricsWriter::GAUGE,
+			 "Interarrival jitter of the back-end stream.", stats->jitter()/(double)timestampFrequency);
+      }
+    }
+    writer.clearLabel("ssrc");
+  }
+
+  // Also describe the 'time-shift' window (if any) that we're recording for each track:
+  ServerMediaSubsessionIterator smssIter(*this);
+  ProxyServerMediaSubsession* smss;
+  while ((smss = (ProxyServerMediaSubsession*)(smssIter.next())) != NULL) {
+    if (smss->fDVRBuffer == NULL) continue;
+
+    writer.setLabel("medium", smss->fClientMediaSubsession->mediumName());
+    writer.setLabel("codec", smss->codecName());
+    writer.addSample("live555_dvr_recorded_seconds", MediaMetricsWriter::GAUGE,
+		     "How much of the back-end stream is currently recorded, for time-shifted playback.",
+		     smss->fDVRBuffer->recordedSeconds());
+    writer.addSample("live555_dvr_recorded_bytes", MediaMetricsWriter::GAUGE,
+		     "Bytes of the back-end stream that are currently recorded, for time-shifted playback.",
+		     smss->fDVRBuffer->bufferSize());
+  }
+  writer.clearLabels();
+}
+
 void ProxyServerMediaSession::continueAfterDESCRIBE(char const* sdpDescription) {
   describeCompletedFlag = 1;
+  fNumUpstreamsFailedInARow = 0;
 
   // Create a (client) "MediaSession" object from the stream's SDP description ("resultString"), then iterate through its
   // "MediaSubsession" objects, to set up corresponding "ServerMediaSubsession" objects that we'll use to serve the stream's tracks.
+  MediaSession* newClientMediaSession = MediaSession::createNew(envir(), sdpDescription);
+  if (fIsFailingOver) {
+    // This is the "DESCRIBE" of a replacement back-end stream.  Try to continue our existing subsessions from it:
+    fIsFailingOver = False;
+    if (resumeAfterFailover(newClientMediaSession)) return;
+
+    // We couldn't, so start again from scratch (as we would have done without failover):
+    resetDESCRIBEState();
+  }
+
   do {
-    fClientMediaSession = MediaSession::createNew(envir(), sdpDescription);
+    fClientMediaSession = newClientMediaSession;
     if (fClientMediaSession == NULL) break;
 
     MediaSubsessionIterator iter(*fClientMediaSession);
     for (MediaSubsession* mss = iter.next(); mss != NULL; mss = iter.next()) {
-      ServerMediaSubsession* smss = new ProxyServerMediaSubsession(*mss);
+      // Only H.264 and H.265 tracks get a GOP cache (if one has been asked for).  Also, the only video tracks that can be
+      // time-shifted are H.264 and H.265 (whose key frames we can find), and JPEG and DV (whose frames are all key frames):
+      unsigned gopCacheSize = 0, dvrSeconds = fDVRSeconds;
+      if (strcmp(mss->codecName(), "H264") == 0 || strcmp(mss->codecName(), "H265") == 0) {
+	gopCacheSize = fGOPCacheSize;
+      } else if (strcmp(mss->mediumName(), "video") == 0
+		 && strcmp(mss->codecName(), "JPEG") != 0 && strcmp(mss->codecName(), "DV") != 0) {
+	dvrSeconds = 0;
+      }
+
+      ServerMediaSubsession* smss
+	= new ProxyServerMediaSubsession(*mss, gopCacheSize, fGOPCacheReplaySpeedup, dvrSeconds, fDVRMaxBytes);
       addSubsession(smss);
       if (fVerbosityLevel > 0) {
 	envir() << *this << " added new \"ProxyServerMediaSubsession\" for "
 		<< mss->protocolName() << "/" << mss->mediumName() << "/" << mss->codecName() << " track\n";
       }
     }
+
+    if (fUpstreamPolicy == UPSTREAM_HOT) startHotUpstream();
   } while (0);
 }
 
@@ -152,6 +672,8 @@ void ProxyServerMediaSession::resetDESCRIBEState() {
     fOurRTSPServer->closeAllClientSessionsForServerMediaSession(this);
   }
   deleteAllSubsessions();
+  fNumSubsessionsWithClients = 0;
+  releaseIdleUpstream();
 
   // Finally, delete the client "MediaSession" object that we had set up after receiving the response to the previous "DESCRIBE":
   Medium::close(fClientMediaSession); fClientMediaSession = NULL;
@@ -212,7 +734,8 @@ ProxyRTSPClient::ProxyRTSPClient(ProxyServerMediaSession& ourServerMediaSession,
     fOurServerMediaSession(ourServerMediaSession), fOurURL(strDup(rtspURL)), fStreamRTPOverTCP(tunnelOverHTTPPortNum != 0),
     fSetupQueueHead(NULL), fSetupQueueTail(NULL), fNumSetupsDone(0), fNextDESCRIBEDelay(1),
     fServerSupportsGetParameter(False), fLastCommandWasPLAY(False),
-    fLivenessCommandTask(NULL), fDESCRIBECommandTask(NULL), fSubsessionTimerTask(NULL) { 
+    fLivenessCommandTask(NULL), fDESCRIBECommandTask(NULL), fSubsessionTimerTask(NULL),
+    fIsDoingHandshake(False), fIsWaitingForHandshake(False), fNextWaitingForHandshake(NULL), fHandshakeTimeoutTask(NULL) {
   if (username != NULL && password != NULL) {
     fOurAuthenticator = new Authenticator(username, password);
   } else {
@@ -225,6 +748,18 @@ void ProxyRTSPClient::reset() {
   envir().taskScheduler().unscheduleDelayedTask(fDESCRIBECommandTask); fDESCRIBECommandTask = NULL;
   envir().taskScheduler().unscheduleDelayedTask(fSubsessionTimerTask); fSubsessionTimerTask = NULL;
 
+  endHandshake();
+  if (fIsWaitingForHandshake) {
+    // Remove ourself from the queue of "ProxyRTSPClient"s that are waiting to start a handshake:
+    ProxyRTSPClient** ptr = &fHandshakeQueueHead;
+    ProxyRTSPClient* prev = NULL;
+    while (*ptr != this) { prev = *ptr; ptr = &((*ptr)->fNextWaitingForHandshake); }
+    *ptr = fNextWaitingForHandshake;
+    if (fHandshakeQueueTail == this) fHandshakeQueueTail = prev;
+    fIsWaitingForHandshake = False;
+    --fNumHandshakesWaiting;
+  }
+
   fSetupQueueHead = fSetupQueueTail = NULL;
   fNumSetupsDone = 0;
   fNextDESCRIBEDelay = 1;
@@ -233,6 +768,21 @@ void ProxyRTSPClient::reset() {
   RTSPClient::reset();
 }
 
+void ProxyRTSPClient::setOurURL(char const* url) {
+  RTSPClient::reset(); // closes our connection to the current server (if any)
+
+  delete[] fOurURL; fOurURL = strDup(url);
+  setBaseURL(fOurURL);
+}
+
+void ProxyRTSPClient::handleConnectionLoss() {
+  // If our session can fail over to another back-end stream, then do so now, rather than waiting for the next 'liveness'
+  // command to fail:
+  if (fOurServerMediaSession.failoverIsEnabled() && fOurServerMediaSession.describeCompletedSuccessfully()) {
+    fOurServerMediaSession.scheduleFailover("lost our RTSP connection to the server");
+  }
+}
+
 ProxyRTSPClient::~ProxyRTSPClient() {
   reset();
 
@@ -241,6 +791,8 @@ ProxyRTSPClient::~ProxyRTSPClient() {
 }
 
 void ProxyRTSPClient::continueAfterDESCRIBE(char const* sdpDescription) {
+  endHandshake();
+
   if (sdpDescription != NULL) {
     fOurServerMediaSession.continueAfterDESCRIBE(sdpDescription);
 
@@ -250,6 +802,10 @@ void ProxyRTSPClient::continueAfterDESCRIBE(char const* sdpDescription) {
     // ("OPTIONS" or "GET_PARAMETER") commands.  (The usual RTCP liveness mechanism wouldn't work here, because RTCP packets
     // don't get sent until after the "PLAY" command.)
     scheduleLivenessCommand();
+  } else if (fOurServerMediaSession.switchToNextUpstreamAfterDESCRIBEFailure()) {
+    // The "DESCRIBE" command failed, but our session has another back-end URL that we haven't yet tried.  Try it now:
+    // (We do this from the event loop, because we're being called from within a response handler.)
+    fDESCRIBECommandTask = envir().taskScheduler().scheduleDelayedTask(0, sendDESCRIBE, this);
   } else {
     // The "DESCRIBE" command failed, most likely because the server or the stream is not yet running.
     // Reschedule another "DESCRIBE" command to take place later:
@@ -266,6 +822,12 @@ void ProxyRTSPClient::continueAfterLivenessCommand(int resultCode, Boolean serve
 
     fServerSupportsGetParameter = False; // until we learn otherwise, in response to a future "OPTIONS" command
 
+    if (fOurServerMediaSession.failoverIsEnabled()) {
+      // Instead, switch to the next back-end stream, keeping our current clients:
+      fOurServerMediaSession.scheduleFailover("the 'liveness' command failed");
+      return;
+    }
+
     if (resultCode < 0) {
       // The 'liveness' command failed without getting a response from the server (otherwise "resultCode" would have been > 0).
       // This suggests that the RTSP connection itself has failed.  Print this error code, in case it's useful for debugging:
@@ -292,10 +854,10 @@ void ProxyRTSPClient::continueAfterLivenessCommand(int resultCode, Boolean serve
 
 void ProxyRTSPClient::continueAfterSETUP() {
   if (fVerbosityLevel > 0) {
-    envir() << *this << "::continueAfterSETUP(): head codec: " << fSetupQueueHead->fClientMediaSubsession.codecName()
+    envir() << *this << "::continueAfterSETUP(): head codec: " << fSetupQueueHead->fClientMediaSubsession->codecName()
 	    << "; numSubsessions " << fSetupQueueHead->fParentSession->numSubsessions() << "\n\tqueue:";
     for (ProxyServerMediaSubsession* p = fSetupQueueHead; p != NULL; p = p->fNext) {
-      envir() << "\t" << p->fClientMediaSubsession.codecName();
+      envir() << "\t" << p->fClientMediaSubsession->codecName();
     }
     envir() << "\n";
   }
@@ -309,7 +871,7 @@ void ProxyRTSPClient::continueAfterSETUP() {
   if (fSetupQueueHead != NULL) {
     // There are still entries in the queue, for tracks for which we have still to do a "SETUP".
     // "SETUP" the first of these now:
-    sendSetupCommand(fSetupQueueHead->fClientMediaSubsession, ::continueAfterSETUP,
+    sendSetupCommand(*fSetupQueueHead->fClientMediaSubsession, ::continueAfterSETUP,
 		     False, fStreamRTPOverTCP, False, fOurAuthenticator);
     ++fNumSetupsDone;
     fSetupQueueHead->fHaveSetupStream = True;
@@ -317,7 +879,7 @@ void ProxyRTSPClient::continueAfterSETUP() {
     if (fNumSetupsDone >= smss->fParentSession->numSubsessions()) {
       // We've now finished setting up each of our subsessions (i.e., 'tracks').
       // Continue by sending a "PLAY" command (an 'aggregate' "PLAY" command, on the whole session):
-      sendPlayCommand(smss->fClientMediaSubsession.parentSession(), NULL, -1.0f, -1.0f, 1.0f, fOurAuthenticator);
+      sendPlayCommand(smss->fClientMediaSubsession->parentSession(), NULL, -1.0f, -1.0f, 1.0f, fOurAuthenticator);
           // the "-1.0f" "start" parameter causes the "PLAY" to be sent without a "Range:" header, in case we'd already done
           // a "PLAY" before (as a result of a 'subsession timeout' (note below))
       fLastCommandWasPLAY = True;
@@ -379,16 +941,92 @@ void ProxyRTSPClient::scheduleDESCRIBECommand() {
   } else {
     secondsToDelay = 256 + (our_random()&0xFF); // [256..511] seconds
   }
+  // Also add random 'jitter' (so the actual delay is in [0.5,1.5)*"secondsToDelay"), so that streams that failed at the same
+  // time (e.g., because their network went down) don't all retry at the same time:
+  unsigned const uSecondsToDelay = secondsToDelay*(MILLION/2) + our_random()%(secondsToDelay*MILLION);
 
   if (fVerbosityLevel > 0) {
-    envir() << *this << ": RTSP \"DESCRIBE\" command failed; trying again in " << secondsToDelay << " seconds\n";
+    envir() << *this << ": RTSP \"DESCRIBE\" command failed; trying again in " << uSecondsToDelay/MILLION << " seconds\n";
   }
-  fDESCRIBECommandTask = envir().taskScheduler().scheduleDelayedTask(secondsToDelay*MILLION, sendDESCRIBE, this);
+  fDESCRIBECommandTask = envir().taskScheduler().scheduleDelayedTask(uSecondsToDelay, sendDESCRIBE, this);
 }
 
 void ProxyRTSPClient::sendDESCRIBE(void* clientData) {
   ProxyRTSPClient* rtspClient = (ProxyRTSPClient*)clientData;
-  if (rtspClient != NULL) rtspClient->sendDescribeCommand(::continueAfterDESCRIBE, rtspClient->auth());
+  if (rtspClient != NULL) {
+    rtspClient->fDESCRIBECommandTask = NULL;
+    rtspClient->requestDESCRIBE();
+  }
+}
+
+unsigned ProxyRTSPClient::fMaxHandshakes = 0;
+unsigned ProxyRTSPClient::fHandshakeTimeoutSeconds = 10;
+unsigned ProxyRTSPClient::fNumHandshakes = 0;
+unsigned ProxyRTSPClient::fNumHandshakesWaiting = 0;
+ProxyRTSPClient* ProxyRTSPClient::fHandshakeQueueHead = NULL;
+ProxyRTSPClient* ProxyRTSPClient::fHandshakeQueueTail = NULL;
+
+void ProxyRTSPClient::setMaxConcurrentHandshakes(unsigned maxHandshakes, unsigned handshakeTimeoutSeconds) {
+  fMaxHandshakes = maxHandshakes;
+  fHandshakeTimeoutSeconds = handshakeTimeoutSeconds;
+}
+
+void ProxyRTSPClient::requestDESCRIBE() {
+  if (fIsDoingHandshake || fIsWaitingForHandshake) return; // we've already asked
+
+  if (fMaxHandshakes == 0 || fNumHandshakes < fMaxHandshakes) {
+    startHandshake();
+    return;
+  }
+
+  // Too many other handshakes are in progress, so wait (at the end of the queue) for our turn:
+  fIsWaitingForHandshake = True;
+  fNextWaitingForHandshake = NULL;
+  if (fHandshakeQueueTail == NULL) {
+    fHandshakeQueueHead = this;
+  } else {
+    fHandshakeQueueTail->fNextWaitingForHandshake = this;
+  }
+  fHandshakeQueueTail = this;
+  ++fNumHandshakesWaiting;
+}
+
+void ProxyRTSPClient::startHandshake() {
+  fIsDoingHandshake = True;
+  ++fNumHandshakes;
+  if (fMaxHandshakes > 0 && fHandshakeTimeoutSeconds > 0) {
+    fHandshakeTimeoutTask
+      = envir().taskScheduler().scheduleDelayedTask(fHandshakeTimeoutSeconds*MILLION, (TaskFunc*)handshakeTimeout, this);
+  }
+
+  sendDescribeCommand(::continueAfterDESCRIBE, auth());
+}
+
+void ProxyRTSPClient::endHandshake() {
+  if (!fIsDoingHandshake) return;
+
+  envir().taskScheduler().unscheduleDelayedTask(fHandshakeTimeoutTask); fHandshakeTimeoutTask = NULL;
+  fIsDoingHandshake = False;
+  --fNumHandshakes;
+
+  // Let waiting "ProxyRTSPClient"s start their handshakes, in turn:
+  while (fHandshakeQueueHead != NULL && (fMaxHandshakes == 0 || fNumHandshakes < fMaxHandshakes)) {
+    ProxyRTSPClient* next = fHandshakeQueueHead;
+    fHandshakeQueueHead = next->fNextWaitingForHandshake;
+    if (fHandshakeQueueHead == NULL) fHandshakeQueueTail = NULL;
+    next->fIsWaitingForHandshake = False;
+    --fNumHandshakesWaiting;
+
+    next->startHandshake();
+  }
+}
+
+void ProxyRTSPClient::handshakeTimeout(void* clientData) {
+  // This handshake is taking too long (e.g., because the server isn't responding), so stop counting it.
+  // (Its "DESCRIBE" remains pending, however.)
+  ProxyRTSPClient* rtspClient = (ProxyRTSPClient*)clientData;
+  rtspClient->fHandshakeTimeoutTask = NULL;
+  rtspClient->endHandshake();
 }
 
 void ProxyRTSPClient::subsessionTimeout(void* clientData) {
@@ -405,9 +1043,16 @@ void ProxyRTSPClient::handleSubsessionTimeout() {
 
 //////// "ProxyServerMediaSubsession" implementation //////////
 
-ProxyServerMediaSubsession::ProxyServerMediaSubsession(MediaSubsession& mediaSubsession)
-  : OnDemandServerMediaSubsession(mediaSubsession.parentSession().envir(), True/*reuseFirstSource*/),
-    fClientMediaSubsession(mediaSubsession), fNext(NULL), fHaveSetupStream(False) {
+ProxyServerMediaSubsession::ProxyServerMediaSubsession(MediaSubsession& mediaSubsession,
+						       unsigned gopCacheSize, unsigned gopCacheReplaySpeedup,
+						       unsigned dvrSeconds, unsigned dvrMaxBytes)
+  : OnDemandServerMediaSubsession(mediaSubsession.parentSession().envir(),
+				  gopCacheSize == 0 && dvrSeconds == 0/*reuseFirstSource*/),
+    fClientMediaSubsession(&mediaSubsession), fNext(NULL), fHaveSetupStream(False), fUpstreamSwitch(NULL), fInputSource(NULL),
+    fGOPCacheSize(gopCacheSize), fGOPCacheReplaySpeedup(gopCacheReplaySpeedup), fGOPCache(NULL),
+    fDVRSeconds(dvrSeconds), fDVRMaxBytes(dvrMaxBytes), fDVRBuffer(NULL), fReplicator(NULL),
+    fHasClients(False), fNormalizer(NULL), fDrainSink(NULL), fKeyFrameRequestTask(NULL) {
+  fLastKeyFrameRequestTime.tv_sec = fLastKeyFrameRequestTime.tv_usec = 0;
 }
 
 UsageEnvironment& operator<<(UsageEnvironment& env, const ProxyServerMediaSubsession& psmss) { // used for debugging
@@ -418,114 +1063,373 @@ ProxyServerMediaSubsession::~ProxyServerMediaSubsession() {
   if (verbosityLevel() > 0) {
     envir() << *this << "::~ProxyServerMediaSubsession()\n";
   }
+
+  envir().taskScheduler().unscheduleDelayedTask(fKeyFrameRequestTask);
+  stopDraining();
+  if (fReplicator != NULL) {
+    fReplicator->detachInputSource(); // because "fGOPCache" (or "fDVRBuffer") gets closed (with the rest of our input source) below
+    Medium::close(fReplicator);
+  }
+  Medium::close(fInputSource); // this closes each of its filters, up to (and including) "fUpstreamSwitch"
 }
 
-FramedSource* ProxyServerMediaSubsession::createNewStreamSource(unsigned clientSessionId, unsigned& estBitrate) {
+void ProxyServerMediaSubsession::initiateInput() {
   ProxyServerMediaSession* const sms = (ProxyServerMediaSession*)fParentSession;
-
-  if (verbosityLevel() > 0) {
-    envir() << *this << "::createNewStreamSource(session id " << clientSessionId << ")\n";
-  }
+  if (sms->fIsFailingOver) return; // we'll be called again once the replacement back-end stream has been described
 
   // If we haven't yet created a data source from our 'media subsession' object, initiate() it to do so:
-  if (fClientMediaSubsession.readSource() == NULL) {
-    fClientMediaSubsession.receiveRawMP3ADUs(); // hack for MPA-ROBUST streams
-    fClientMediaSubsession.receiveRawJPEGFrames(); // hack for proxying JPEG/RTP streams. (Don't do this if we're transcoding.)
-    fClientMediaSubsession.initiate();
+  if (fClientMediaSubsession->readSource() == NULL) {
+    fClientMediaSubsession->receiveRawMP3ADUs(); // hack for MPA-ROBUST streams
+    fClientMediaSubsession->receiveRawJPEGFrames(); // hack for proxying JPEG/RTP streams. (Don't do this if we're transcoding.)
+    fClientMediaSubsession->initiate();
     if (verbosityLevel() > 0) {
       envir() << "\tInitiated: " << *this << "\n";
     }
 
-    if (fClientMediaSubsession.readSource() != NULL) {
-      // Add to the front of all data sources a filter that will 'normalize' their frames' presentation times,
-      // before the frames get re-transmitted by our server:
-      char const* const codecName = fClientMediaSubsession.codecName();
-      FramedFilter* normalizerFilter = sms->fPresentationTimeSessionNormalizer
-	->createNewPresentationTimeSubsessionNormalizer(fClientMediaSubsession.readSource(), fClientMediaSubsession.rtpSource(),
-							codecName);
-      fClientMediaSubsession.addFilter(normalizerFilter);
-
-      // Some data sources require a 'framer' object to be added, before they can be fed into
-      // a "RTPSink".  Adjust for this now:
-      if (strcmp(codecName, "H264") == 0) {
-	fClientMediaSubsession.addFilter(H264VideoStreamDiscreteFramer
-					 ::createNew(envir(), fClientMediaSubsession.readSource()));
-      } else if (strcmp(codecName, "H265") == 0) {
-	fClientMediaSubsession.addFilter(H265VideoStreamDiscreteFramer
-					 ::createNew(envir(), fClientMediaSubsession.readSource()));
-      } else if (strcmp(codecName, "MP4V-ES") == 0) {
-	fClientMediaSubsession.addFilter(MPEG4VideoStreamDiscreteFramer
-					 ::createNew(envir(), fClientMediaSubsession.readSource(),
-						     True/* leave PTs unmodified*/));
-      } else if (strcmp(codecName, "MPV") == 0) {
-	fClientMediaSubsession.addFilter(MPEG1or2VideoStreamDiscreteFramer
-					 ::createNew(envir(), fClientMediaSubsession.readSource(),
-						     False, 5.0, True/* leave PTs unmodified*/));
-      } else if (strcmp(codecName, "DV") == 0) {
-	fClientMediaSubsession.addFilter(DVVideoStreamFramer
-					 ::createNew(envir(), fClientMediaSubsession.readSource(),
-						     False, True/* leave PTs unmodified*/));
+    if (fClientMediaSubsession->readSource() != NULL) {
+      char const* const codecName = fClientMediaSubsession->codecName();
+      if (fInputSource == NULL) {
+	// Create our input source.  (We own this - rather than adding its filters to "fClientMediaSubsession" - so that it can
+	// outlive "fClientMediaSubsession", if we switch to a new back-end stream.)  It begins with a switch that reads from
+	// the current back-end stream.
+	fUpstreamSwitch = new ProxyUpstreamSwitch(*this);
+
+	// Next, add a filter that will 'normalize' frames' presentation times, before the frames get re-transmitted by our server:
+	fInputSource = fNormalizer = sms->fPresentationTimeSessionNormalizer
+	  ->createNewPresentationTimeSubsessionNormalizer(fUpstreamSwitch, fClientMediaSubsession->rtpSource(), codecName);
+
+	// Some data sources require a 'framer' object to be added, before they can be fed into
+	// a "RTPSink".  Adjust for this now:
+	if (fDVRSeconds > 0) {
+	  // Record the most recent part of the stream, and give each client its own copy of the stream (beginning somewhere in
+	  // this recording).  (In this case, each client's copy gets its own 'framer'; see below.)
+	  fInputSource = fDVRBuffer = DVRBuffer::createNew(envir(), fInputSource, codecName, fDVRSeconds, fDVRMaxBytes);
+	  fReplicator = StreamReplicator::createNew(envir(), fDVRBuffer, False);
+	} else if (fGOPCacheSize > 0) {
+	  // Cache the most recent GOP, and give each client its own copy of the stream (beginning with a replay of this GOP).
+	  // (In this case, each client's copy gets its own 'framer'; see below.)
+	  fInputSource = fGOPCache = GOPCache::createNew(envir(), fInputSource, strcmp(codecName, "H265") == 0, fGOPCacheSize);
+	  fReplicator = StreamReplicator::createNew(envir(), fGOPCache, False);
+	} else {
+	  fInputSource = createFramer(fInputSource);
+	}
       }
+
+      // Read from the (current) back-end stream:
+      fNormalizer->setUpstream(fClientMediaSubsession->rtpSource(), codecName);
+      fUpstreamSwitch->switchInput(fClientMediaSubsession->readSource());
     }
 
-    if (fClientMediaSubsession.rtcpInstance() != NULL) {
-      fClientMediaSubsession.rtcpInstance()->setByeHandler(subsessionByeHandler, this);
+    if (fClientMediaSubsession->rtcpInstance() != NULL) {
+      fClientMediaSubsession->rtcpInstance()->setByeHandler(subsessionByeHandler, this);
     }
   }
+}
+
+void ProxyServerMediaSubsession::setUpUpstream() {
+  if (((ProxyServerMediaSession*)fParentSession)->fIsFailingOver) return; // we'll be called again after the failover
+
+  ProxyRTSPClient* const proxyRTSPClient = ((ProxyServerMediaSession*)fParentSession)->fProxyRTSPClient;
+  if (!fHaveSetupStream) {
+    for (ProxyServerMediaSubsession* p = proxyRTSPClient->fSetupQueueHead; p != NULL; p = p->fNext) {
+      if (p == this) return; // our "SETUP" has already been queued
+    }
+
+    // This is our first "SETUP".  Send RTSP "SETUP" and later "PLAY" commands to the proxied server, to start streaming:
+    // (Before sending "SETUP", enqueue ourselves on the "RTSPClient"s 'SETUP queue', so we'll be able to get the correct
+    //  "ProxyServerMediaSubsession" to handle the response.  (Note that responses come back in the same order as requests.))
+    Boolean queueWasEmpty = proxyRTSPClient->fSetupQueueHead == NULL;
+    if (queueWasEmpty) {
+      proxyRTSPClient->fSetupQueueHead = this;
+    } else {
+      proxyRTSPClient->fSetupQueueTail->fNext = this;
+    }
+    proxyRTSPClient->fSetupQueueTail = this;
+    fNext = NULL;
+
+    // Hack: If there's already a pending "SETUP" request (for another track), don't send this track's "SETUP" right away, because
+    // the server might not properly handle 'pipelined' requests.  Instead, wait until after previous "SETUP" responses come back.
+    if (queueWasEmpty) {
+      proxyRTSPClient->sendSetupCommand(*fClientMediaSubsession, ::continueAfterSETUP,
+					False, proxyRTSPClient->fStreamRTPOverTCP, False, proxyRTSPClient->auth());
+      ++proxyRTSPClient->fNumSetupsDone;
+      fHaveSetupStream = True;
+    }
+  } else {
+    // This is a "SETUP" from a new client.  We know that there are no other currently active clients (otherwise we wouldn't
+    // have been called here), so we know that the substream was previously "PAUSE"d (unless it has been kept playing, because
+    // of our session's 'upstream policy').  Send "PLAY" downstream once again, to resume the stream:
+    // (But if other tracks' "SETUP"s are still pending, then the "PLAY" will be sent once they've been done.)
+    if (!proxyRTSPClient->fLastCommandWasPLAY // so that we send only one "PLAY"; not one for each subsession
+	&& proxyRTSPClient->fSetupQueueHead == NULL) {
+      proxyRTSPClient->sendPlayCommand(fClientMediaSubsession->parentSession(), NULL, -1.0f/*resume from previous point*/,
+				       -1.0f, 1.0f, proxyRTSPClient->auth());
+      proxyRTSPClient->fLastCommandWasPLAY = True;
+    }
+  }
+}
+
+void ProxyServerMediaSubsession::startDraining() {
+  if (fDrainSink != NULL || fInputSource == NULL) return;
+
+  // Our input's previous "RTPSink" (if any) has been closed:
+  if (fNormalizer != NULL) fNormalizer->setRTPSink(NULL);
+
+  fDrainSink = new ProxyDrainSink(envir());
+  FramedSource* source
+    = fReplicator != NULL ? fReplicator->createStreamReplica() : fInputSource;
+  fDrainSink->startPlaying(*source, NULL, NULL);
+}
+
+void ProxyServerMediaSubsession::detachFromUpstream() {
+  if (fUpstreamSwitch != NULL) fUpstreamSwitch->switchInput(NULL);
+  if (fNormalizer != NULL) fNormalizer->setUpstream(NULL, codecName());
+  if (fGOPCache != NULL) fGOPCache->flush(); // because the next back-end stream will begin with a new GOP
+  if (fDVRBuffer != NULL) fDVRBuffer->noteDiscontinuity(); // ditto
+  fHaveSetupStream = False;
+
+  // Close the old back-end stream's source (but not its description, which we keep using until the new one arrives):
+  fClientMediaSubsession->deInitiate();
+}
+
+void ProxyServerMediaSubsession::upstreamClosed() {
+  ProxyServerMediaSession* const sms = (ProxyServerMediaSession*)fParentSession;
+  if (sms->failoverIsEnabled()) {
+    sms->scheduleFailover("its source closed");
+    return;
+  }
+
+  // Otherwise, pass this closure on to our clients:
+  fUpstreamSwitch->handleClosure();
+}
+
+void ProxyServerMediaSubsession::stopDraining() {
+  if (fDrainSink == NULL) return;
+
+  FramedSource* source = fDrainSink->source();
+  fDrainSink->stopPlaying();
+  Medium::close(fDrainSink); fDrainSink = NULL;
+  if (fReplicator != NULL) Medium::close(source); // it was our own replica
+}
+
+void ProxyServerMediaSubsession::startStream(unsigned clientSessionId, void* streamToken,
+					     TaskFunc* rtcpRRHandler, void* rtcpRRHandlerClientData,
+					     unsigned short& rtpSeqNum, unsigned& rtpTimestamp,
+					     ServerRequestAlternativeByteHandler* serverRequestAlternativeByteHandler,
+					     void* serverRequestAlternativeByteHandlerClientData) {
+  OnDemandServerMediaSubsession::startStream(clientSessionId, streamToken, rtcpRRHandler, rtcpRRHandlerClientData,
+					     rtpSeqNum, rtpTimestamp,
+					     serverRequestAlternativeByteHandler, serverRequestAlternativeByteHandlerClientData);
+
+  // Unless we can replay the most recent GOP to this new client, ask the back-end server for a key frame, so that the
+  // client doesn't have to wait for the next one before it can start decoding:
+  if (fGOPCache == NULL && fDVRBuffer == NULL && fHaveSetupStream && strcmp(fClientMediaSubsession->mediumName(), "video") == 0) {
+    requestKeyFrameFromUpstream();
+  }
+}
+
+FramedSource* ProxyServerMediaSubsession::createNewStreamSource(unsigned clientSessionId, unsigned& estBitrate) {
+  if (verbosityLevel() > 0) {
+    envir() << *this << "::createNewStreamSource(session id " << clientSessionId << ")\n";
+  }
+
+  initiateInput();
+  if (fDVRBuffer == NULL) stopDraining(); // because our input is about to be read by a "RTPSink" instead
 
-  ProxyRTSPClient* const proxyRTSPClient = sms->fProxyRTSPClient;
   if (clientSessionId != 0) {
     // We're being called as a result of implementing a RTSP "SETUP".
-    if (!fHaveSetupStream) {
-      // This is our first "SETUP".  Send RTSP "SETUP" and later "PLAY" commands to the proxied server, to start streaming:
-      // (Before sending "SETUP", enqueue ourselves on the "RTSPClient"s 'SETUP queue', so we'll be able to get the correct
-      //  "ProxyServerMediaSubsession" to handle the response.  (Note that responses come back in the same order as requests.))
-      Boolean queueWasEmpty = proxyRTSPClient->fSetupQueueHead == NULL;
-      if (queueWasEmpty) {
-	proxyRTSPClient->fSetupQueueHead = this;
-      } else {
-	proxyRTSPClient->fSetupQueueTail->fNext = this;
-      }
-      proxyRTSPClient->fSetupQueueTail = this;
-
-      // Hack: If there's already a pending "SETUP" request (for another track), don't send this track's "SETUP" right away, because
-      // the server might not properly handle 'pipelined' requests.  Instead, wait until after previous "SETUP" responses come back.
-      if (queueWasEmpty) {
-	proxyRTSPClient->sendSetupCommand(fClientMediaSubsession, ::continueAfterSETUP,
-					  False, proxyRTSPClient->fStreamRTPOverTCP, False, proxyRTSPClient->auth());
-	++proxyRTSPClient->fNumSetupsDone;
-	fHaveSetupStream = True;
-      }
-    } else {
-      // This is a "SETUP" from a new client.  We know that there are no other currently active clients (otherwise we wouldn't
-      // have been called here), so we know that the substream was previously "PAUSE"d.  Send "PLAY" downstream once again,
-      // to resume the stream:
-      if (!proxyRTSPClient->fLastCommandWasPLAY) { // so that we send only one "PLAY"; not one for each subsession
-	proxyRTSPClient->sendPlayCommand(fClientMediaSubsession.parentSession(), NULL, -1.0f/*resume from previous point*/,
-					 -1.0f, 1.0f, proxyRTSPClient->auth());
-	proxyRTSPClient->fLastCommandWasPLAY = True;
-      }
+    if (!fHasClients) {
+      fHasClients = True;
+      ((ProxyServerMediaSession*)fParentSession)->noteNewClient();
     }
+    setUpUpstream();
   }
 
-  estBitrate = fClientMediaSubsession.bandwidth();
+  estBitrate = fClientMediaSubsession->bandwidth();
   if (estBitrate == 0) estBitrate = 50; // kbps, estimate
-  return fClientMediaSubsession.readSource();
+  if (fDVRBuffer != NULL) {
+    // Keep reading our input (and so recording it) even while none of our clients is reading it live (e.g., because they're
+    // all playing earlier parts of the recording):
+    startDraining();
+
+    return createFramer(new ProxyDVRBufferReader(envir(), *fDVRBuffer, fReplicator->createStreamReplica(),
+						 fGOPCacheReplaySpeedup, *this));
+  }
+  if (fGOPCache != NULL) {
+    return createFramer(new ProxyGOPCacheReader(envir(), *fGOPCache, fReplicator->createStreamReplica(),
+						fGOPCacheReplaySpeedup, *this));
+  }
+  return fInputSource;
+}
+
+Boolean ProxyServerMediaSubsession::hasFramer() const {
+  char const* const codecName = fClientMediaSubsession->codecName();
+  return strcmp(codecName, "H264") == 0 ||
+    strcmp(codecName, "H265") == 0 ||
+    strcmp(codecName, "MP4V-ES") == 0 ||
+    strcmp(codecName, "MPV") == 0 ||
+    strcmp(codecName, "DV") == 0;
+}
+
+FramedSource* ProxyServerMediaSubsession::createFramer(FramedSource* inputSource) {
+  char const* const codecName = fClientMediaSubsession->codecName();
+  if (strcmp(codecName, "H264") == 0) {
+    return H264VideoStreamDiscreteFramer::createNew(envir(), inputSource);
+  } else if (strcmp(codecName, "H265") == 0) {
+    return H265VideoStreamDiscreteFramer::createNew(envir(), inputSource);
+  } else if (strcmp(codecName, "MP4V-ES") == 0) {
+    return MPEG4VideoStreamDiscreteFramer::createNew(envir(), inputSource, True/* leave PTs unmodified*/);
+  } else if (strcmp(codecName, "MPV") == 0) {
+    return MPEG1or2VideoStreamDiscreteFramer::createNew(envir(), inputSource, False, 5.0, True/* leave PTs unmodified*/);
+  } else if (strcmp(codecName, "DV") == 0) {
+    return DVVideoStreamFramer::createNew(envir(), inputSource, False, True/* leave PTs unmodified*/);
+  }
+  return inputSource;
+}
+
+FramedSource* ProxyServerMediaSubsession::sourceBehindFramer(FramedSource* inputSource) const {
+  return hasFramer() ? ((FramedFilter*)inputSource)->inputSource() : inputSource;
+}
+
+void ProxyServerMediaSubsession::enableRTCPReportsWhenSynchronized(RTPSink* rtpSink) {
+  if (rtpSink == NULL) return;
+
+  RTPSource* rtpSource = upstreamRTPSource(); // this can change, if we switch to a new back-end stream
+  if (rtpSource != NULL && rtpSource->hasBeenSynchronizedUsingRTCP()) rtpSink->enableRTCPReports() = True;
+}
+
+// Parses a UTC time of the form "YYYYMMDDTHHMMSS[.fraction]Z" (as used in a "Range: clock=" header):
+static Boolean parseUTCTime(char const* str, struct timeval& result) {
+  unsigned year, month, day, hour, minute, second;
+  int numCharsMatched = 0;
+  if (sscanf(str, "%4u%2u%2uT%2u%2u%2u%n", &year, &month, &day, &hour, &minute, &second, &numCharsMatched) != 6
+      || numCharsMatched == 0 || year < 1970 || month < 1 || month > 12 || day < 1 || day > 31
+      || hour > 23 || minute > 59 || second > 60) return False;
+
+  char const* p = &str[numCharsMatched];
+  unsigned uSeconds = 0;
+  if (*p == '.') {
+    for (unsigned scale = 100000; *++p >= '0' && *p <= '9'; scale /= 10) uSeconds += (*p - '0')*scale;
+  }
+  if (*p != 'Z' && *p != '\0') return False;
+
+  // Count the days since 1970-01-01, treating each year as beginning in March (so that leap days come at the end):
+  unsigned const y = month <= 2 ? year - 1 : year;
+  unsigned const dayOfYear = (153*(month > 2 ? month - 3 : month + 9) + 2)/5 + day - 1;
+  unsigned const days = y*365 + y/4 - y/100 + y/400 + dayOfYear - 719468;
+
+  result.tv_sec = (time_t)days*86400 + hour*3600 + minute*60 + second;
+  result.tv_usec = uSeconds;
+  return True;
+}
+
+void ProxyServerMediaSubsession::seekStreamSource(FramedSource* inputSource, char*& absStart, char*& absEnd) {
+  // We don't stop at an end time; instead, we always play on into the live stream:
+  delete[] absEnd; absEnd = NULL;
+
+  struct timeval seekTime;
+  if (fDVRBuffer == NULL || absStart == NULL || !parseUTCTime(absStart, seekTime)
+      || !((ProxyDVRBufferReader*)sourceBehindFramer(inputSource))->seekToTime(seekTime)) {
+    // We can't seek:
+    delete[] absStart; absStart = NULL;
+    return;
+  }
+  if (verbosityLevel() > 0) {
+    envir() << *this << ": time-shifting to \"" << absStart << "\"\n";
+  }
+
+  // Report the time that we'll actually play from (the start of a GOP).  (Our session's later tracks also get seeked to
+  // this time, which keeps them in step with us.)
+  time_t const seekSeconds = seekTime.tv_sec;
+  char buf[50];
+  strftime(buf, sizeof buf, "%Y%m%dT%H%M%S", gmtime(&seekSeconds));
+  sprintf(&buf[strlen(buf)], ".%03uZ", (unsigned)seekTime.tv_usec/1000);
+  delete[] absStart; absStart = strDup(buf);
+}
+
+void ProxyServerMediaSubsession::testScaleFactor(float& scale) {
+  // We can play the stream faster (or slower) than real time only if clients have their own - time-shiftable - copies of it:
+  if (fDVRSeconds == 0 || scale <= 0.0f) scale = 1.0f;
+}
+
+void ProxyServerMediaSubsession::setStreamSourceScale(FramedSource* inputSource, float scale) {
+  if (fDVRBuffer == NULL) return;
+
+  ((ProxyDVRBufferReader*)sourceBehindFramer(inputSource))->setScale(scale);
+}
+
+#define KEY_FRAME_REQUEST_MIN_INTERVAL_MS 500
+    // Requests from clients that arrive more often than this get combined into a single request to the back-end server
+
+void ProxyServerMediaSubsession::handleKeyFrameRequest(FramedSource* /*inputSource*/) {
+  // One of our clients has lost data, and can't continue decoding until the next key frame.
+  // (Note that - because the back-end stream is shared - a key frame requested by one client is seen by all of them.)
+  requestKeyFrameFromUpstream();
+}
+
+void ProxyServerMediaSubsession::requestKeyFrameFromUpstream() {
+  if (fKeyFrameRequestTask != NULL) return; // a request is already due to be sent
+
+  struct timeval timeNow;
+  gettimeofday(&timeNow, NULL);
+  int64_t uSecondsSinceLastRequest
+    = (timeNow.tv_sec - fLastKeyFrameRequestTime.tv_sec)*(int64_t)MILLION + (timeNow.tv_usec - fLastKeyFrameRequestTime.tv_usec);
+  int64_t uSecondsToWait = KEY_FRAME_REQUEST_MIN_INTERVAL_MS*1000 - uSecondsSinceLastRequest;
+  if (uSecondsToWait <= 0) {
+    sendKeyFrameRequest();
+  } else {
+    fKeyFrameRequestTask = envir().taskScheduler().scheduleDelayedTask(uSecondsToWait, (TaskFunc*)sendKeyFrameRequest, this);
+  }
+}
+
+void ProxyServerMediaSubsession::sendKeyFrameRequest(void* clientData) {
+  ((ProxyServerMediaSubsession*)clientData)->sendKeyFrameRequest();
+}
+
+void ProxyServerMediaSubsession::sendKeyFrameRequest() {
+  fKeyFrameRequestTask = NULL;
+  gettimeofday(&fLastKeyFrameRequestTime, NULL);
+
+  RTCPInstance* rtcp = fClientMediaSubsession->rtcpInstance();
+  if (rtcp == NULL) return; // the back-end stream hasn't been set up (or we're failing over); it'll begin with a key frame anyway
+  if (verbosityLevel() > 0) {
+    envir() << *this << ": Sending a key frame request (RTCP \"PLI\") to the back-end server\n";
+  }
+  rtcp->sendPLI();
 }
 
 void ProxyServerMediaSubsession::closeStreamSource(FramedSource* inputSource) {
   if (verbosityLevel() > 0) {
     envir() << *this << "::closeStreamSource()\n";
   }
+  if (fReplicator != NULL) {
+    // Each client has its own source, which we close.  We continue only if this was the last client:
+    Medium::close(inputSource);
+    if (fReplicator->numReplicas() > (fDrainSink != NULL ? 1u : 0u)) return;
+  }
+
+  ProxyServerMediaSession* const sms = (ProxyServerMediaSession*)fParentSession;
+  if (fHasClients) {
+    fHasClients = False;
+    --sms->fNumSubsessionsWithClients;
+  }
+  if (fHaveSetupStream && sms->keepUpstreamPlaying()) {
+    // Our session's 'upstream policy' says to keep the back-end stream playing, so keep reading our input until a new client arrives:
+    startDraining();
+    return;
+  }
+
+  if (fGOPCache != NULL) fGOPCache->flush(); // because the stream is about to be paused, making the cached GOP stale
+  if (fDVRBuffer != NULL) fDVRBuffer->noteDiscontinuity();
+
   // Because there's only one input source for this 'subsession' (regardless of how many downstream clients are proxying it),
   // we don't close the input source here.  (Instead, we wait until *this* object gets deleted.)
   // However, because (as evidenced by this function having been called) we no longer have any clients accessing the stream,
   // then we "PAUSE" the downstream proxied stream, until a new client arrives:
   if (fHaveSetupStream) {
-    ProxyServerMediaSession* const sms = (ProxyServerMediaSession*)fParentSession;
     ProxyRTSPClient* const proxyRTSPClient = sms->fProxyRTSPClient;
     if (proxyRTSPClient->fLastCommandWasPLAY) { // so that we send only one "PAUSE"; not one for each subsession
-      proxyRTSPClient->sendPauseCommand(fClientMediaSubsession.parentSession(), NULL, proxyRTSPClient->auth());
+      proxyRTSPClient->sendPauseCommand(fClientMediaSubsession->parentSession(), NULL, proxyRTSPClient->auth());
       proxyRTSPClient->fLastCommandWasPLAY = False;
     }
   }
@@ -539,15 +1443,15 @@ RTPSink* ProxyServerMediaSubsession
 
   // Create (and return) the appropriate "RTPSink" object for our codec:
   RTPSink* newSink;
-  char const* const codecName = fClientMediaSubsession.codecName();
+  char const* const codecName = fClientMediaSubsession->codecName();
   if (strcmp(codecName, "AC3") == 0 || strcmp(codecName, "EAC3") == 0) {
     newSink = AC3AudioRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					 fClientMediaSubsession.rtpTimestampFrequency()); 
+					 fClientMediaSubsession->rtpTimestampFrequency()); 
 #if 0 // This code does not work; do *not* enable it:
   } else if (strcmp(codecName, "AMR") == 0 || strcmp(codecName, "AMR-WB") == 0) {
     Boolean isWideband = strcmp(codecName, "AMR-WB") == 0;
     newSink = AMRAudioRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					 isWideband, fClientMediaSubsession.numChannels());
+					 isWideband, fClientMediaSubsession->numChannels());
 #endif
   } else if (strcmp(codecName, "DV") == 0) {
     newSink = DVVideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic);
@@ -555,44 +1459,44 @@ RTPSink* ProxyServerMediaSubsession
     newSink = GSMAudioRTPSink::createNew(envir(), rtpGroupsock);
   } else if (strcmp(codecName, "H263-1998") == 0 || strcmp(codecName, "H263-2000") == 0) {
     newSink = H263plusVideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					      fClientMediaSubsession.rtpTimestampFrequency()); 
+					      fClientMediaSubsession->rtpTimestampFrequency()); 
   } else if (strcmp(codecName, "H264") == 0) {
     newSink = H264VideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					  fClientMediaSubsession.fmtp_spropparametersets(),
-					  fClientMediaSubsession.attrVal_unsigned("profile-level-id"));
+					  fClientMediaSubsession->fmtp_spropparametersets(),
+					  fClientMediaSubsession->attrVal_unsigned("profile-level-id"));
   } else if (strcmp(codecName, "H265") == 0) {
     newSink = H265VideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					  fClientMediaSubsession.fmtp_spropvps(),
-					  fClientMediaSubsession.fmtp_spropsps(),
-					  fClientMediaSubsession.fmtp_sproppps(),
-					  fClientMediaSubsession.attrVal_unsigned("profile-space"),
-					  fClientMediaSubsession.attrVal_unsigned("profile-id"),
-					  fClientMediaSubsession.attrVal_unsigned("tier-flag"),
-					  fClientMediaSubsession.attrVal_unsigned("level-id"),
-					  fClientMediaSubsession.attrVal_str("interop-constraints"));
+					  fClientMediaSubsession->fmtp_spropvps(),
+					  fClientMediaSubsession->fmtp_spropsps(),
+					  fClientMediaSubsession->fmtp_sproppps(),
+					  fClientMediaSubsession->attrVal_unsigned("profile-space"),
+					  fClientMediaSubsession->attrVal_unsigned("profile-id"),
+					  fClientMediaSubsession->attrVal_unsigned("tier-flag"),
+					  fClientMediaSubsession->attrVal_unsigned("level-id"),
+					  fClientMediaSubsession->attrVal_str("interop-constraints"));
   } else if (strcmp(codecName, "JPEG") == 0) {
     newSink = SimpleRTPSink::createNew(envir(), rtpGroupsock, 26, 90000, "video", "JPEG",
 				       1/*numChannels*/, False/*allowMultipleFramesPerPacket*/, False/*doNormalMBitRule*/);
   } else if (strcmp(codecName, "MP4A-LATM") == 0) {
     newSink = MPEG4LATMAudioRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					       fClientMediaSubsession.rtpTimestampFrequency(),
-					       fClientMediaSubsession.fmtp_config(),
-					       fClientMediaSubsession.numChannels());
+					       fClientMediaSubsession->rtpTimestampFrequency(),
+					       fClientMediaSubsession->fmtp_config(),
+					       fClientMediaSubsession->numChannels());
   } else if (strcmp(codecName, "MP4V-ES") == 0) {
     newSink = MPEG4ESVideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					     fClientMediaSubsession.rtpTimestampFrequency(),
-					     fClientMediaSubsession.attrVal_unsigned("profile-level-id"),
-					     fClientMediaSubsession.fmtp_config()); 
+					     fClientMediaSubsession->rtpTimestampFrequency(),
+					     fClientMediaSubsession->attrVal_unsigned("profile-level-id"),
+					     fClientMediaSubsession->fmtp_config()); 
   } else if (strcmp(codecName, "MPA") == 0) {
     newSink = MPEG1or2AudioRTPSink::createNew(envir(), rtpGroupsock);
   } else if (strcmp(codecName, "MPA-ROBUST") == 0) {
     newSink = MP3ADURTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic);
   } else if (strcmp(codecName, "MPEG4-GENERIC") == 0) {
     newSink = MPEG4GenericRTPSink::createNew(envir(), rtpGroupsock,
-					     rtpPayloadTypeIfDynamic, fClientMediaSubsession.rtpTimestampFrequency(),
-					     fClientMediaSubsession.mediumName(),
-					     fClientMediaSubsession.attrVal_str("mode"),
-					     fClientMediaSubsession.fmtp_config(), fClientMediaSubsession.numChannels());
+					     rtpPayloadTypeIfDynamic, fClientMediaSubsession->rtpTimestampFrequency(),
+					     fClientMediaSubsession->mediumName(),
+					     fClientMediaSubsession->attrVal_str("mode"),
+					     fClientMediaSubsession->fmtp_config(), fClientMediaSubsession->numChannels());
   } else if (strcmp(codecName, "MPV") == 0) {
     newSink = MPEG1or2VideoRTPSink::createNew(envir(), rtpGroupsock);
   } else if (strcmp(codecName, "OPUS") == 0) {
@@ -602,11 +1506,11 @@ RTPSink* ProxyServerMediaSubsession
     newSink = T140TextRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic);
   } else if (strcmp(codecName, "THEORA") == 0) {
     newSink = TheoraVideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					    fClientMediaSubsession.fmtp_config()); 
+					    fClientMediaSubsession->fmtp_config()); 
   } else if (strcmp(codecName, "VORBIS") == 0) {
     newSink = VorbisAudioRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic,
-					    fClientMediaSubsession.rtpTimestampFrequency(), fClientMediaSubsession.numChannels(),
-					    fClientMediaSubsession.fmtp_config()); 
+					    fClientMediaSubsession->rtpTimestampFrequency(), fClientMediaSubsession->numChannels(),
+					    fClientMediaSubsession->fmtp_config()); 
   } else if (strcmp(codecName, "VP8") == 0) {
     newSink = VP8VideoRTPSink::createNew(envir(), rtpGroupsock, rtpPayloadTypeIfDynamic);
   } else if (strcmp(codecName, "AMR") == 0 || strcmp(codecName, "AMR-WB") == 0) {
@@ -614,7 +1518,7 @@ RTPSink* ProxyServerMediaSubsession
     // form that can be fed directly into a corresponding "RTPSink" object.
     if (verbosityLevel() > 0) {
       envir() << "\treturns NULL (because we currently don't support the proxying of \""
-	      << fClientMediaSubsession.mediumName() << "/" << codecName << "\" streams)\n";
+	      << fClientMediaSubsession->mediumName() << "/" << codecName << "\" streams)\n";
     }
     return NULL;
   } else if (strcmp(codecName, "QCELP") == 0 ||
@@ -635,27 +1539,29 @@ RTPSink* ProxyServerMediaSubsession
       doNormalMBitRule = False; // no RTP 'M' bit
     }
     newSink = SimpleRTPSink::createNew(envir(), rtpGroupsock,
-				       rtpPayloadTypeIfDynamic, fClientMediaSubsession.rtpTimestampFrequency(),
-				       fClientMediaSubsession.mediumName(), fClientMediaSubsession.codecName(),
-				       fClientMediaSubsession.numChannels(), allowMultipleFramesPerPacket, doNormalMBitRule);
+				       rtpPayloadTypeIfDynamic, fClientMediaSubsession->rtpTimestampFrequency(),
+				       fClientMediaSubsession->mediumName(), fClientMediaSubsession->codecName(),
+				       fClientMediaSubsession->numChannels(), allowMultipleFramesPerPacket, doNormalMBitRule);
   }
 
   // Because our relayed frames' presentation times are inaccurate until the input frames have been RTCP-synchronized,
   // we temporarily disable RTCP "SR" reports for this "RTPSink" object:
   newSink->enableRTCPReports() = False;
 
-  // Also tell our "PresentationTimeSubsessionNormalizer" object about the "RTPSink", so it can enable RTCP "SR" reports later:
-  PresentationTimeSubsessionNormalizer* ssNormalizer;
-  if (strcmp(codecName, "H264") == 0 ||
-      strcmp(codecName, "H265") == 0 ||
-      strcmp(codecName, "MP4V-ES") == 0 ||
-      strcmp(codecName, "MPV") == 0 ||
-      strcmp(codecName, "DV") == 0) {
-    // There was a separate 'framer' object in front of the "PresentationTimeSubsessionNormalizer", so go back one object to get it:
-    ssNormalizer = (PresentationTimeSubsessionNormalizer*)(((FramedFilter*)inputSource)->inputSource());
-  } else {
-    ssNormalizer = (PresentationTimeSubsessionNormalizer*)inputSource;
+  // Each client that has its own "RTPSink" has its RTCP "SR" reports enabled (later) by the client's own source
+  // (which is behind the client's 'framer', if any):
+  if (fDVRBuffer != NULL) {
+    ((ProxyDVRBufferReader*)sourceBehindFramer(inputSource))->setRTPSink(newSink);
+    return newSink;
   }
+  if (fGOPCache != NULL) {
+    ((ProxyGOPCacheReader*)sourceBehindFramer(inputSource))->setRTPSink(newSink);
+    return newSink;
+  }
+
+  // Also tell our "PresentationTimeSubsessionNormalizer" object about the "RTPSink", so it can enable RTCP "SR" reports later:
+  // (If there was a separate 'framer' object in front of the "PresentationTimeSubsessionNormalizer", we go back one object to get it.)
+  PresentationTimeSubsessionNormalizer* ssNormalizer = (PresentationTimeSubsessionNormalizer*)sourceBehindFramer(inputSource);
   ssNormalizer->setRTPSink(newSink);
 
   return newSink;
@@ -670,13 +1576,19 @@ void ProxyServerMediaSubsession::subsessionByeHandler() {
     envir() << *this << ": received RTCP \"BYE\".  (The back-end stream has ended.)\n";
   }
 
+  ProxyServerMediaSession* const sms = (ProxyServerMediaSession*)fParentSession;
+  if (sms->failoverIsEnabled()) {
+    // Switch to the next back-end stream, keeping our current clients:
+    sms->scheduleFailover("received RTCP \"BYE\"");
+    return;
+  }
+
   // This "BYE" signals that our input source has (effectively) closed, so pass this onto the front-end clients:
   fHaveSetupStream = False; // hack to stop "PAUSE" getting sent by:
-  fClientMediaSubsession.readSource()->handleClosure();
+  fInputSource->handleClosure();
 
   // And then treat this as if we had lost connection to the back-end server,
   // and can reestablish streaming from it only by sending another "DESCRIBE":
-  ProxyServerMediaSession* const sms = (ProxyServerMediaSession*)fParentSession;
   ProxyRTSPClient* const proxyRTSPClient = sms->fProxyRTSPClient;
   proxyRTSPClient->continueAfterLivenessCommand(1/*hack*/, proxyRTSPClient->fServerSupportsGetParameter);
 }
@@ -788,7 +1700,9 @@ void PresentationTimeSubsessionNormalizer::afterGettingFrame(unsigned frameSize,
 
   // Hack for JPEG/RTP proxying.  Because we're proxying JPEG by just copying the raw JPEG/RTP payloads, without interpreting them,
   // we need to also 'copy' the RTP 'M' (marker) bit from the "RTPSource" to the "RTPSink":
-  if (fRTPSource->curPacketMarkerBit() && strcmp(fCodecName, "JPEG") == 0) ((SimpleRTPSink*)fRTPSink)->setMBitOnNextPacket();
+  if (fRTPSource->curPacketMarkerBit() && strcmp(fCodecName, "JPEG") == 0 && fRTPSink != NULL) {
+    ((SimpleRTPSink*)fRTPSink)->setMBitOnNextPacket();
+  }
 
   // Complete delivery:
   FramedSource::afterGetting(this);
@@ -132,7 +132,9 @@ RTCPInstance::RTCPInstance(UsageEnvironment& env, Groupsock* RTCPgs,
     fByeHandlerTask(NULL), fByeHandlerClientData(NULL),
     fSRHandlerTask(NULL), fSRHandlerClientData(NULL),
     fRRHandlerTask(NULL), fRRHandlerClientData(NULL),
-    fSpecificRRHandlerTable(NULL) {
+    fSpecificRRHandlerTable(NULL),
+    fKeyFrameRequestHandlerTask(NULL), fKeyFrameRequestHandlerClientData(NULL),
+    fLastIncomingFIRSeqNum(0), fNextOutgoingFIRSeqNum(0), fHaveReceivedFIR(False) {
 #ifdef DEBUG
   fprintf(stderr, "RTCPInstance[%p]::RTCPInstance()\n", this);
 #endif
@@ -288,6 +290,11 @@ void RTCPInstance
   }
 }
 
+void RTCPInstance::setKeyFrameRequestHandler(TaskFunc* handlerTask, void* clientData) {
+  fKeyFrameRequestHandlerTask = handlerTask;
+  fKeyFrameRequestHandlerClientData = clientData;
+}
+
 void RTCPInstance::setStreamSocket(int sockNum,
 				   unsigned char streamChannelId) {
   // Turn off background read handling:
@@ -425,10 +432,12 @@ void RTCPInstance
     // Check the RTCP packet for validity:
     // It must at least contain a header (4 bytes), and this header
     // must be version=2, with no padding bit, and a payload type of
-    // SR (200) or RR (201):
+    // SR (200) or RR (201) - or, for a 'reduced-size' RTCP packet (RFC 5506), a feedback message:
     if (packetSize < 4) break;
     unsigned rtcpHdr = ntohl(*(u_int32_t*)pkt);
-    if ((rtcpHdr & 0xE0FE0000) != (0x80000000 | (RTCP_PT_SR<<16))) {
+    if ((rtcpHdr & 0xE0FE0000) != (0x80000000 | (RTCP_PT_SR<<16))
+	&& (rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_RTPFB<<16))
+	&& (rtcpHdr & 0xE0FF0000) != (0x80000000 | (RTCP_PT_PSFB<<16))) {
 #ifdef DEBUG
       fprintf(stderr, "rejected bad RTCP packet: header 0x%08x\n", rtcpHdr);
 #endif
@@ -564,6 +573,40 @@ void RTCPInstance
 	  typeOfPacket = PACKET_BYE;
 	  break;
 	}
+        case RTCP_PT_PSFB: {
+#ifdef DEBUG
+	  fprintf(stderr, "PSFB (FMT %d)\n", rc);
+#endif
+	  // The 'media source' SSRC follows the sender's SSRC:
+	  if (length < 4) break; length -= 4;
+	  unsigned mediaSSRC = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
+
+	  Boolean isKeyFrameRequest = False;
+	  if (fSink != NULL) {
+	    if (rc == RTCP_PSFB_PLI) {
+	      isKeyFrameRequest = mediaSSRC == fSink->SSRC();
+	    } else if (rc == RTCP_PSFB_FIR) {
+	      // Each 'FCI' entry (8 bytes) contains the SSRC that's being asked for a key frame, and a sequence number:
+	      while (length >= 8) {
+		unsigned ssrc = ntohl(*(u_int32_t*)pkt); ADVANCE(4);
+		u_int8_t seqNum = pkt[0]; ADVANCE(4);
+		length -= 8;
+		if (ssrc == fSink->SSRC() && !(fHaveReceivedFIR && seqNum == fLastIncomingFIRSeqNum)) {
+		  fLastIncomingFIRSeqNum = seqNum;
+		  fHaveReceivedFIR = True;
+		  isKeyFrameRequest = True;
+		}
+	      }
+	    }
+	  }
+	  if (isKeyFrameRequest && fKeyFrameRequestHandlerTask != NULL) {
+	    (*fKeyFrameRequestHandlerTask)(fKeyFrameRequestHandlerClientData);
+	  }
+
+	  subPacketOK = True;
+	  typeOfPacket = PACKET_RTCP_REPORT;
+	  break;
+	}
 	// Later handle SDES, APP, and compound RTCP packets #####
         default:
 #ifdef DEBUG
@@ -676,6 +719,31 @@ void RTCPInstance::sendBYE() {
   sendBuiltPacket();
 }
 
+void RTCPInstance::sendPLI() {
+#ifdef DEBUG
+  fprintf(stderr, "sending PLI\n");
+#endif
+  // Feedback messages are sent in a compound RTCP packet that begins with a SR and/or RR report, and a SDES:
+  if (fSource == NULL) return; // we don't receive anything, so there's nothing to ask about
+  (void)addReport(True);
+  addSDES();
+
+  addPSFB(RTCP_PSFB_PLI);
+  sendBuiltPacket();
+}
+
+void RTCPInstance::sendFIR() {
+#ifdef DEBUG
+  fprintf(stderr, "sending FIR\n");
+#endif
+  if (fSource == NULL) return; // we don't receive anything, so there's nothing to ask about
+  (void)addReport(True);
+  addSDES();
+
+  addPSFB(RTCP_PSFB_FIR);
+  sendBuiltPacket();
+}
+
 void RTCPInstance::sendBuiltPacket() {
 #ifdef DEBUG
   fprintf(stderr, "sending RTCP packet\n");
@@ -924,6 +992,26 @@ void RTCPInstance::addBYE() {
   }
 }
 
+void RTCPInstance::addPSFB(unsigned char fmt) {
+  // ASSERT: fSource != NULL
+  u_int32_t const mediaSSRC = fSource->lastReceivedSSRC();
+
+  unsigned rtcpHdr = 0x80000000; // version 2, no padding
+  rtcpHdr |= (fmt<<24);
+  rtcpHdr |= (RTCP_PT_PSFB<<16);
+  rtcpHdr |= fmt == RTCP_PSFB_FIR ? 4 : 2; // 32-bit words, not counting the header: SSRCs (and, for a FIR, one 'FCI' entry)
+  fOutBuf->enqueueWord(rtcpHdr);
+
+  fOutBuf->enqueueWord(fSource->SSRC()); // the sender of this packet
+  if (fmt == RTCP_PSFB_FIR) {
+    fOutBuf->enqueueWord(0); // the 'media source' SSRC is unused in a FIR; instead:
+    fOutBuf->enqueueWord(mediaSSRC);
+    fOutBuf->enqueueWord(((unsigned)fNextOutgoingFIRSeqNum++)<<24); // sequence number, then 3 reserved bytes
+  } else {
+    fOutBuf->enqueueWord(mediaSSRC);
+  }
+}
+
 void RTCPInstance::schedule(double nextTime) {
   fNextReportTime = nextTime;
 
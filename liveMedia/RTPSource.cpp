@@ -55,6 +55,7 @@ RTPSource::RTPSource(UsageEnvironment& env, Groupsock* RTPgs,
     fRTPInterface(this, RTPgs),
     fCurPacketHasBeenSynchronizedUsingRTCP(False), fLastReceivedSSRC(0),
     fRTCPInstanceForMultiplexedRTCPPackets(NULL),
+    fTotNumFramesReceived(0), fTotNumTruncatedBytes(0),
     fRTPPayloadFormat(rtpPayloadFormat), fTimestampFrequency(rtpTimestampFrequency),
     fSSRC(our_random32()), fEnableRTCPReports(True) {
   fReceptionStatsDB = new RTPReceptionStatsDB();
@@ -23,6 +23,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "Base64.hh"
 #include "Locale.hh"
 #include <GroupsockHelper.hh>
+#include <DNSResolver.hh>
 #include "ourMD5.hh"
 
 ////////// RTSPClient implementation //////////
@@ -215,6 +216,26 @@ Boolean RTSPClient::parseRTSPURL(UsageEnvironment& env, char const* url,
 				 NetAddress& address,
 				 portNumBits& portNum,
 				 char const** urlSuffix) {
+  char hostName[100];
+  if (!parseRTSPURLHostName(env, url, username, password, hostName, portNum, urlSuffix)) return False;
+
+  NetAddressList addresses(hostName);
+  if (addresses.numAddresses() == 0) {
+    env.setResultMsg("Failed to find network address for \"",
+		     hostName, "\"");
+    delete[] username; username = NULL;
+    delete[] password; password = NULL;
+    return False;
+  }
+  address = *(addresses.firstAddress());
+
+  return True;
+}
+
+Boolean RTSPClient::parseRTSPURLHostName(UsageEnvironment& env, char const* url,
+					 char*& username, char*& password, char* hostName,
+					 portNumBits& portNum,
+					 char const** urlSuffix) {
   do {
     // Parse the URL as "rtsp://[<username>[:<password>]@]<server-address-or-name>[:<port>][/<stream-name>]"
     char const* prefix = "rtsp://";
@@ -225,7 +246,7 @@ Boolean RTSPClient::parseRTSPURL(UsageEnvironment& env, char const* url,
     }
 
     unsigned const parseBufferSize = 100;
-    char parseBuffer[parseBufferSize];
+    char* parseBuffer = hostName;
     char const* from = &url[prefixLength];
 
     // Check whether "<username>[:<password>]@" occurs next.
@@ -274,14 +295,6 @@ Boolean RTSPClient::parseRTSPURL(UsageEnvironment& env, char const* url,
       break;
     }
 
-    NetAddressList addresses(parseBuffer);
-    if (addresses.numAddresses() == 0) {
-      env.setResultMsg("Failed to find network address for \"",
-		       parseBuffer, "\"");
-      break;
-    }
-    address = *(addresses.firstAddress());
-
     portNum = 554; // default value
     char nextChar = *from;
     if (nextChar == ':') {
@@ -326,7 +339,7 @@ RTSPClient::RTSPClient(UsageEnvironment& env, char const* rtspURL,
 		       portNumBits tunnelOverHTTPPortNum, int socketNumToServer)
   : Medium(env),
     fVerbosityLevel(verbosityLevel), fCSeq(1), fServerAddress(0),
-    fTunnelOverHTTPPortNum(tunnelOverHTTPPortNum), fUserAgentHeaderStr(NULL), fUserAgentHeaderStrLen(0),
+    fTunnelOverHTTPPortNum(tunnelOverHTTPPortNum), fServerPortNum(0), fUserAgentHeaderStr(NULL), fUserAgentHeaderStrLen(0),
     fInputSocketNum(-1), fOutputSocketNum(-1), fBaseURL(NULL), fTCPStreamIdCount(0),
     fLastSessionId(NULL), fSessionTimeoutParameter(0), fSessionCookieCounter(0), fHTTPTunnelingConnectionIsPending(False) {
   setBaseURL(rtspURL);
@@ -369,6 +382,7 @@ RTSPClient::~RTSPClient() {
 }
 
 void RTSPClient::reset() {
+  DNSResolver::cancelLookups(envir(), this);
   resetTCPSockets();
   resetResponseBuffer();
   fServerAddress = 0;
@@ -665,16 +679,16 @@ Boolean RTSPClient::setRequestFields(RequestRecord* request,
     // We will be sending a HTTP (not a RTSP) request.
     // Begin by re-parsing our RTSP URL, to get the stream name (which we'll use as our 'cmdURL'
     // in the subsequent request), and the server address (which we'll use in a "Host:" header):
+    // (We've already connected to the server, so we use its address - rather than looking up its name again.)
     char* username;
     char* password;
-    NetAddress destAddress;
+    char hostName[100];
     portNumBits urlPortNum;
-    if (!parseRTSPURL(envir(), fBaseURL, username, password, destAddress, urlPortNum, (char const**)&cmdURL)) return False;
+    if (!parseRTSPURLHostName(envir(), fBaseURL, username, password, hostName, urlPortNum, (char const**)&cmdURL)) return False;
     if (cmdURL[0] == '\0') cmdURL = (char*)"/";
     delete[] username;
     delete[] password;
-    netAddressBits serverAddress = *(netAddressBits*)(destAddress.data());
-    AddressString serverAddressString(serverAddress);
+    AddressString serverAddressString(fServerAddress);
     
     protocolStr = "HTTP/1.1";
     
@@ -795,25 +809,46 @@ int RTSPClient::openConnection() {
     
     char* username;
     char* password;
-    NetAddress destAddress;
+    char hostName[100];
     portNumBits urlPortNum;
     char const* urlSuffix;
-    if (!parseRTSPURL(envir(), fBaseURL, username, password, destAddress, urlPortNum, &urlSuffix)) break;
-    portNumBits destPortNum = fTunnelOverHTTPPortNum == 0 ? urlPortNum : fTunnelOverHTTPPortNum;
+    if (!parseRTSPURLHostName(envir(), fBaseURL, username, password, hostName, urlPortNum, &urlSuffix)) break;
+    fServerPortNum = fTunnelOverHTTPPortNum == 0 ? urlPortNum : fTunnelOverHTTPPortNum;
     if (username != NULL || password != NULL) {
       fCurrentAuthenticator.setUsernameAndPassword(username, password);
       delete[] username;
       delete[] password;
     }
-    
+
+    // Look up the server's address.  If this can't be done immediately, then we'll continue (in "dnsLookupHandler1()")
+    // once the answer arrives - without blocking the event loop while we wait:
+    netAddressBits serverAddress;
+    if (!DNSResolver::lookup(envir(), hostName, serverAddress, dnsLookupHandler, this)) {
+      if (fVerbosityLevel >= 1) envir() << "Looking up the address of \"" << hostName << "\"...\n";
+      return 0;
+    }
+    if (serverAddress == 0) {
+      envir().setResultMsg("Failed to find network address for \"", hostName, "\"");
+      break;
+    }
+
+    return connectToServerAddress(serverAddress);
+  } while (0);
+  
+  resetTCPSockets();
+  return -1;
+}
+
+int RTSPClient::connectToServerAddress(netAddressBits serverAddress) {
+  do {
     // We don't yet have a TCP socket (or we used to have one, but it got closed).  Set it up now.
     fInputSocketNum = fOutputSocketNum = setupStreamSocket(envir(), 0);
     if (fInputSocketNum < 0) break;
     ignoreSigPipeOnSocket(fInputSocketNum); // so that servers on the same host that get killed don't also kill us
       
     // Connect to the remote endpoint:
-    fServerAddress = *(netAddressBits*)(destAddress.data());
-    int connectResult = connectToServer(fInputSocketNum, destPortNum);
+    fServerAddress = serverAddress;
+    int connectResult = connectToServer(fInputSocketNum, fServerPortNum);
     if (connectResult < 0) break;
     else if (connectResult > 0) {
       // The connection succeeded.  Arrange to handle responses to requests sent on it:
@@ -1433,6 +1468,54 @@ void RTSPClient::connectionHandler1() {
   }
 }
 
+void RTSPClient::dnsLookupHandler(void* clientData, netAddressBits serverAddress) {
+  RTSPClient* client = (RTSPClient*)clientData;
+  client->dnsLookupHandler1(serverAddress);
+}
+
+void RTSPClient::dnsLookupHandler1(netAddressBits serverAddress) {
+  int connectResult;
+  if (serverAddress == 0) {
+    char* username;
+    char* password;
+    char hostName[100];
+    portNumBits urlPortNum;
+    if (parseRTSPURLHostName(envir(), fBaseURL, username, password, hostName, urlPortNum)) {
+      envir().setResultMsg("Failed to find network address for \"", hostName, "\"");
+      delete[] username;
+      delete[] password;
+    }
+    if (fVerbosityLevel >= 1) envir() << "..." << envir().getResultMsg() << "\n";
+    connectResult = -1;
+  } else {
+    connectResult = connectToServerAddress(serverAddress);
+  }
+  if (connectResult == 0) return; // The connection is pending; "connectionHandler1()" will send the waiting requests
+
+  // Move all requests awaiting connection into a new, temporary queue (as "connectionHandler1()" does):
+  RequestQueue tmpRequestQueue(fRequestsAwaitingConnection);
+  RequestRecord* request;
+
+  if (connectResult > 0) {
+    // The connection succeeded.  Resume sending all pending requests:
+    while ((request = tmpRequestQueue.dequeue()) != NULL) {
+      sendRequest(request);
+    }
+    return;
+  }
+
+  // An error occurred.  Tell all pending requests about the error:
+  resetTCPSockets(); // do this now, in case an error handler deletes "this"
+  while ((request = tmpRequestQueue.dequeue()) != NULL) {
+    handleRequestError(request);
+    delete request;
+  }
+}
+
+void RTSPClient::handleConnectionLoss() {
+  // By default, we do nothing; our pending requests (if any) are about to be told about the error
+}
+
 void RTSPClient::incomingDataHandler(void* instance, int /*mask*/) {
   RTSPClient* client = (RTSPClient*)instance;
   client->incomingDataHandler1();
@@ -1485,6 +1568,7 @@ void RTSPClient::handleResponseBytes(int newBytesRead) {
     } else {
       RequestQueue requestQueue(fRequestsAwaitingResponse);
       resetTCPSockets(); // do this now, in case an error handler deletes "this"
+      handleConnectionLoss();
 
       while ((request = requestQueue.dequeue()) != NULL) {
 	handleRequestError(request);
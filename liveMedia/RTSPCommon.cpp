@@ -54,21 +54,16 @@ static void decodeURL(char* url) {
   *url = '\0';
 }
 
-Boolean parseRTSPRequestString(char const* reqStr,
-			       unsigned reqStrSize,
-			       char* resultCmdName,
-			       unsigned resultCmdNameMaxSize,
-			       char* resultURLPreSuffix,
-			       unsigned resultURLPreSuffixMaxSize,
-			       char* resultURLSuffix,
-			       unsigned resultURLSuffixMaxSize,
-			       char* resultCSeq,
-			       unsigned resultCSeqMaxSize,
-                               char* resultSessionIdStr,
-                               unsigned resultSessionIdStrMaxSize,
-			       unsigned& contentLength) {
-  // This parser is currently rather dumb; it should be made smarter #####
-
+// Parses the request line (command name and URL) of a RTSP request, setting "endIndex" to the index just past the " RTSP/":
+static Boolean parseRTSPRequestLine(char const* reqStr,
+				    unsigned reqStrSize,
+				    char* resultCmdName,
+				    unsigned resultCmdNameMaxSize,
+				    char* resultURLPreSuffix,
+				    unsigned resultURLPreSuffixMaxSize,
+				    char* resultURLSuffix,
+				    unsigned resultURLSuffixMaxSize,
+				    unsigned& endIndex) {
   // "Be liberal in what you accept": Skip over any whitespace at the start of the request:
   unsigned i;
   for (i = 0; i < reqStrSize; ++i) {
@@ -155,9 +150,33 @@ Boolean parseRTSPRequestString(char const* reqStr,
   }
   if (!parseSucceeded) return False;
 
+  endIndex = i;
+  return True;
+}
+
+Boolean parseRTSPRequestString(char const* reqStr,
+			       unsigned reqStrSize,
+			       char* resultCmdName,
+			       unsigned resultCmdNameMaxSize,
+			       char* resultURLPreSuffix,
+			       unsigned resultURLPreSuffixMaxSize,
+			       char* resultURLSuffix,
+			       unsigned resultURLSuffixMaxSize,
+			       char* resultCSeq,
+			       unsigned resultCSeqMaxSize,
+                               char* resultSessionIdStr,
+                               unsigned resultSessionIdStrMaxSize,
+			       unsigned& contentLength) {
+  // This parser is currently rather dumb; it should be made smarter #####
+  unsigned i, j;
+  if (!parseRTSPRequestLine(reqStr, reqStrSize,
+			    resultCmdName, resultCmdNameMaxSize,
+			    resultURLPreSuffix, resultURLPreSuffixMaxSize,
+			    resultURLSuffix, resultURLSuffixMaxSize, i)) return False;
+
   // Look for "CSeq:" (mandatory, case insensitive), skip whitespace,
   // then read everything up to the next \r or \n as 'CSeq':
-  parseSucceeded = False;
+  Boolean parseSucceeded = False;
   for (j = i; (int)j < (int)(reqStrSize-5); ++j) {
     if (_strncasecmp("CSeq:", &reqStr[j], 5) == 0) {
       j += 5;
@@ -214,6 +233,159 @@ Boolean parseRTSPRequestString(char const* reqStr,
   return True;
 }
 
+Boolean parseRTSPRequestString(RTSPRequestHeaderIndex const& headers,
+			       char* resultCmdName,
+			       unsigned resultCmdNameMaxSize,
+			       char* resultURLPreSuffix,
+			       unsigned resultURLPreSuffixMaxSize,
+			       char* resultURLSuffix,
+			       unsigned resultURLSuffixMaxSize,
+			       char* resultCSeq,
+			       unsigned resultCSeqMaxSize,
+			       char* resultSessionIdStr,
+			       unsigned resultSessionIdStrMaxSize,
+			       unsigned& contentLength) {
+  unsigned requestLineSize;
+  char const* requestLine = headers.requestLine(requestLineSize);
+  if (requestLine == NULL) return False;
+
+  // Parse just the request line.  (Note that we include the <CR><LF> that follows it in the request buffer,
+  // so that "RTSP/" at the very end of the line is parsed the same way as it is above.)
+  unsigned i;
+  if (!parseRTSPRequestLine(requestLine, requestLineSize+2,
+			    resultCmdName, resultCmdNameMaxSize,
+			    resultURLPreSuffix, resultURLPreSuffixMaxSize,
+			    resultURLSuffix, resultURLSuffixMaxSize, i)) return False;
+
+  // "CSeq:" is mandatory; "Session:" and "Content-Length:" are optional:
+  if (!headers.copyValue("CSeq", resultCSeq, resultCSeqMaxSize)) return False;
+
+  unsigned valueSize;
+  char const* value = headers.lookupValue("Session", valueSize);
+  unsigned n = 0;
+  if (value != NULL) {
+    for (; n < resultSessionIdStrMaxSize-1 && n < valueSize; ++n) resultSessionIdStr[n] = value[n];
+  }
+  resultSessionIdStr[n] = '\0';
+
+  contentLength = 0; // default value
+  value = headers.lookupValue("Content-Length", valueSize);
+  if (value != NULL) {
+    unsigned num;
+    if (sscanf(value, "%u", &num) == 1) contentLength = num;
+  }
+
+  return True;
+}
+
+////////// RTSPRequestHeaderIndex implementation //////////
+
+RTSPRequestHeaderIndex::RTSPRequestHeaderIndex()
+  : fHeaders(new HeaderEntry[RTSP_INITIAL_NUM_INDEXED_HEADERS]), fMaxNumHeaders(RTSP_INITIAL_NUM_INDEXED_HEADERS) {
+  reset();
+}
+
+RTSPRequestHeaderIndex::~RTSPRequestHeaderIndex() {
+  delete[] fHeaders;
+}
+
+void RTSPRequestHeaderIndex::reset() {
+  fRequestLine = NULL;
+  fRequestLineSize = 0;
+  fNumHeaders = 0;
+}
+
+void RTSPRequestHeaderIndex::addLine(char* line, unsigned lineSize) {
+  if (fRequestLine == NULL) {
+    // This is the request line, unless it's empty.  ("Be liberal in what you accept": Allow for blank lines before the request.)
+    if (lineSize > 0) {
+      fRequestLine = line;
+      fRequestLineSize = lineSize;
+    }
+    return;
+  }
+
+  // The header name is everything up to the ':':
+  unsigned colonOffset = 0;
+  while (colonOffset < lineSize && line[colonOffset] != ':') ++colonOffset;
+  if (colonOffset == 0 || colonOffset == lineSize) return; // not a header line; ignore it
+
+  // The value is what follows the ':', without any leading or trailing whitespace:
+  unsigned valueOffset = colonOffset + 1;
+  while (valueOffset < lineSize && (line[valueOffset] == ' ' || line[valueOffset] == '\t')) ++valueOffset;
+  unsigned valueEnd = lineSize;
+  while (valueEnd > valueOffset && (line[valueEnd-1] == ' ' || line[valueEnd-1] == '\t')) --valueEnd;
+  unsigned const valueSize = valueEnd - valueOffset;
+
+  // If there's whitespace between the header name and the ':', then move the name to the right, over it:
+  unsigned nameSize = colonOffset;
+  while (nameSize > 0 && (line[nameSize-1] == ' ' || line[nameSize-1] == '\t')) --nameSize;
+  unsigned const shift = colonOffset - nameSize;
+  if (shift > 0) {
+    memmove(&line[shift], line, nameSize);
+    memset(line, ' ', shift);
+    line += shift;
+    valueOffset -= shift;
+  }
+
+  if (fNumHeaders == fMaxNumHeaders) {
+    // Grow the index (rather than ignoring the remaining headers):
+    HeaderEntry* newHeaders = new HeaderEntry[2*fMaxNumHeaders];
+    for (unsigned i = 0; i < fNumHeaders; ++i) newHeaders[i] = fHeaders[i];
+    delete[] fHeaders; fHeaders = newHeaders;
+    fMaxNumHeaders *= 2;
+  }
+
+  HeaderEntry& entry = fHeaders[fNumHeaders++];
+  entry.line = line;
+  entry.nameSize = nameSize;
+  entry.valueOffset = valueOffset;
+  entry.valueSize = valueSize;
+}
+
+char const* RTSPRequestHeaderIndex::requestLine(unsigned& requestLineSize) const {
+  requestLineSize = fRequestLineSize;
+  return fRequestLine;
+}
+
+int RTSPRequestHeaderIndex::lookup(char const* headerName) const {
+  unsigned const headerNameSize = strlen(headerName);
+  for (unsigned i = 0; i < fNumHeaders; ++i) {
+    if (fHeaders[i].nameSize == headerNameSize
+	&& _strncasecmp(fHeaders[i].line, headerName, headerNameSize) == 0) return (int)i;
+  }
+
+  return -1;
+}
+
+char const* RTSPRequestHeaderIndex::lookupLine(char const* headerName) const {
+  int i = lookup(headerName);
+  return i < 0 ? NULL : fHeaders[i].line;
+}
+
+char const* RTSPRequestHeaderIndex::lookupValue(char const* headerName, unsigned& valueSize) const {
+  int i = lookup(headerName);
+  if (i < 0) {
+    valueSize = 0;
+    return NULL;
+  }
+
+  valueSize = fHeaders[i].valueSize;
+  return &fHeaders[i].line[fHeaders[i].valueOffset];
+}
+
+Boolean RTSPRequestHeaderIndex::copyValue(char const* headerName, char* resultStr, unsigned resultMaxSize) const {
+  resultStr[0] = '\0'; // by default, return an empty string
+
+  unsigned valueSize;
+  char const* value = lookupValue(headerName, valueSize);
+  if (value == NULL || valueSize + 1 > resultMaxSize) return False;
+
+  memcpy(resultStr, value, valueSize);
+  resultStr[valueSize] = '\0';
+  return True;
+}
+
 Boolean parseRangeParam(char const* paramStr,
 			double& rangeStart, double& rangeEnd,
 			char*& absStartTime, char*& absEndTime,
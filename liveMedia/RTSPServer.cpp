@@ -23,7 +23,14 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "RTSPRegisterSender.hh"
 #include "ProxyServerMediaSession.hh"
 #include "Base64.hh"
+#include "MediaMetrics.hh"
+#include "RTPSink.hh"
+#include "ByteStreamMemoryBufferSource.hh"
+#include "TCPStreamSink.hh"
+#include "EventLoopStats.hh"
+#include "RTSPServerWorkers.hh"
 #include <GroupsockHelper.hh>
+#include <math.h>
 
 ////////// RTSPServer implementation //////////
 
@@ -261,7 +268,240 @@ portNumBits RTSPServer::httpServerPortNum() const {
 	return ntohs(fHTTPServerPort.num());
 }
 
+void RTSPServer::setConnectionLimits(unsigned maxConnections, unsigned maxConnectionsPerClientAddress) {
+	fMaxConnections = maxConnections;
+	fMaxConnectionsPerClientAddress = maxConnectionsPerClientAddress;
+
+	if (fMaxConnectionsPerClientAddress > 0 && fNumConnectionsPerClientAddress == NULL) {
+		// Start counting the connections from each client address (including those that we already have):
+		fNumConnectionsPerClientAddress = HashTable::create(ONE_WORD_HASH_KEYS);
+
+		HashTable::Iterator* iter = HashTable::Iterator::create(*fClientConnections);
+		RTSPServer::RTSPClientConnection* connection;
+		char const* key; // dummy
+		while ((connection = (RTSPServer::RTSPClientConnection*)(iter->next(key))) != NULL) {
+			noteNewClientConnection(connection->fClientAddr);
+		}
+		delete iter;
+	}
+}
+
+unsigned RTSPServer::numClientConnections() const {
+	return fClientConnections->numEntries();
+}
+
+void RTSPServer::enableMetrics(char const* urlSuffix) {
+	delete[] fMetricsURLSuffix;
+	fMetricsURLSuffix = strDup(urlSuffix);
+}
+
+static void addHistogram(MediaMetricsWriter& writer, char const* metricName, char const* helpText,
+	EventLoopHistogram const& histogram) {
+	// An "EventLoopHistogram" bucket counts (integral) durations that are < its upper bound - i.e., <= (its upper bound - 1us):
+	double upperBounds[EVENT_LOOP_HISTOGRAM_NUM_BUCKETS], counts[EVENT_LOOP_HISTOGRAM_NUM_BUCKETS];
+	for (unsigned i = 0; i < EVENT_LOOP_HISTOGRAM_NUM_BUCKETS; ++i) {
+		upperBounds[i] = i == EVENT_LOOP_HISTOGRAM_NUM_BUCKETS-1 ? HUGE_VAL
+			: (EventLoopHistogram::bucketUpperBoundUSecs(i) - 1)/1000000.0;
+		counts[i] = (double)histogram.bucketCount(i);
+	}
+	writer.addHistogram(metricName, helpText, EVENT_LOOP_HISTOGRAM_NUM_BUCKETS, upperBounds, counts,
+		histogram.totalUSecs()/1000000.0);
+}
+
+static void addEventLoopMetrics(MediaMetricsWriter& writer, EventLoopStats const& stats) {
+	EventLoopHistogram const& lateness = stats.alarmLateness();
+	EventLoopHistogram const& busyTime = stats.iterationBusyTime();
+
+	addHistogram(writer, "live555_event_loop_iteration_busy_seconds",
+		"Time spent handling events (i.e., not waiting in select()) in each iteration of the event loop.", busyTime);
+	writer.addSample("live555_event_loop_max_iteration_busy_seconds", MediaMetricsWriter::GAUGE,
+		"Longest time spent handling events in a single iteration of the event loop.", busyTime.maxUSecs()/1000000.0);
+	writer.addSample("live555_event_loop_pending_delayed_tasks", MediaMetricsWriter::GAUGE,
+		"Number of delayed tasks that are waiting to be run.", stats.numPendingDelayedTasks());
+
+	addHistogram(writer, "live555_event_loop_alarm_lateness_seconds",
+		"How much later than scheduled each delayed task was run.", lateness);
+	writer.addSample("live555_event_loop_max_alarm_lateness_seconds", MediaMetricsWriter::GAUGE,
+		"Most that a delayed task has been run later than scheduled.", lateness.maxUSecs()/1000000.0);
+	writer.addSample("live555_event_loop_slow_handler_calls_total", MediaMetricsWriter::COUNTER,
+		"Handler calls that took at least the configured 'slow handler' threshold.", stats.numSlowHandlerCalls());
+
+	// Then, add samples for each handler (labelled by name, if it has one; otherwise by address):
+	EventLoopStats::Iterator iter(stats);
+	EventLoopHistogram const* durations;
+	void const* handlerAddress;
+	EventLoopStats::HandlerKind kind;
+	while ((durations = iter.next(handlerAddress, kind)) != NULL) {
+		char const* name = stats.handlerName(handlerAddress);
+		char addressStr[2 + 2*sizeof (void*) + 1];
+		if (name == NULL) {
+			sprintf(addressStr, "%p", handlerAddress);
+			name = addressStr;
+		}
+		writer.setLabel("handler", name);
+		writer.setLabel("kind", EventLoopStats::handlerKindName(kind));
+
+		addHistogram(writer, "live555_event_loop_handler_seconds",
+			"Time spent in each call made by the event loop to this handler.", *durations);
+		writer.addSample("live555_event_loop_handler_max_seconds", MediaMetricsWriter::GAUGE,
+			"Longest single call to this handler.", durations->maxUSecs()/1000000.0);
+	}
+	writer.clearLabel("handler");
+	writer.clearLabel("kind");
+}
+
+// The metrics for one track of a stream, summed over the (distinct) "RTPSink"s that are being used to stream it to clients:
+class TrackMetrics {
+public:
+	TrackMetrics()
+		: fNumSinks(0), fNumPacketsSent(0), fNumOctetsSent(0), fNumFramesSent(0), fNumTruncatedBytes(0),
+		fNumReceivers(0), fNumPacketsLost(0), fMaxFractionLost(0.0), fMaxJitterSeconds(0.0), fMaxRTTSeconds(0.0) {
+	}
+
+	void addSink(RTPSink& sink) {
+		++fNumSinks;
+		fNumPacketsSent += sink.totNumPacketsSent();
+		fNumOctetsSent += sink.totNumOctetsSent();
+		fNumFramesSent += sink.totNumFramesSent();
+		fNumTruncatedBytes += sink.totNumTruncatedBytes();
+
+		// Also note what this sink's receivers have told us, in their RTCP "RR"s:
+		unsigned const timestampFrequency = sink.rtpTimestampFrequency();
+		RTPTransmissionStatsDB::Iterator statsIter(sink.transmissionStatsDB());
+		RTPTransmissionStats* stats;
+		while ((stats = statsIter.next()) != NULL) {
+			++fNumReceivers;
+
+			// The 'cumulative number of packets lost' in a RR is a signed 24-bit number (it's negative if there were duplicates):
+			int numPacketsLost = (int)stats->totNumPacketsLost();
+			if (numPacketsLost >= 0x00800000) numPacketsLost -= 0x01000000;
+			fNumPacketsLost += numPacketsLost;
+
+			double fractionLost = stats->packetLossRatio()/256.0;
+			if (fractionLost > fMaxFractionLost) fMaxFractionLost = fractionLost;
+			if (timestampFrequency > 0) {
+				double jitterSeconds = stats->jitter()/(double)timestampFrequency;
+				if (jitterSeconds > fMaxJitterSeconds) fMaxJitterSeconds = jitterSeconds;
+			}
+			double rttSeconds = stats->roundTripDelay()/65536.0;
+			if (rttSeconds > fMaxRTTSeconds) fMaxRTTSeconds = rttSeconds;
+		}
+	}
+
+	void addSamples(MediaMetricsWriter& writer) const {
+		writer.addSample("live555_stream_sinks", MediaMetricsWriter::GAUGE,
+			"RTP streams (one per client session, unless shared) currently sending this track.", fNumSinks);
+		writer.addSample("live555_stream_packets_sent", MediaMetricsWriter::GAUGE,
+			"RTP packets sent, summed over the track's current RTP streams.", (double)fNumPacketsSent);
+		writer.addSample("live555_stream_bytes_sent", MediaMetricsWriter::GAUGE,
+			"RTP bytes sent (including RTP headers), summed over the track's current RTP streams.", (double)fNumOctetsSent);
+		writer.addSample("live555_stream_frames_sent", MediaMetricsWriter::GAUGE,
+			"Frames packed into RTP packets, summed over the track's current RTP streams.", (double)fNumFramesSent);
+		writer.addSample("live555_stream_truncated_bytes", MediaMetricsWriter::GAUGE,
+			"Bytes of input frames dropped because they were too large for the RTP sink's buffer, summed over the track's current RTP streams.",
+			(double)fNumTruncatedBytes);
+
+		writer.addSample("live555_stream_receivers", MediaMetricsWriter::GAUGE,
+			"Receivers of the track that have sent us RTCP RRs.", fNumReceivers);
+		if (fNumReceivers == 0) return;
+		writer.addSample("live555_stream_receiver_packets_lost", MediaMetricsWriter::GAUGE,
+			"Cumulative RTP packets lost, as reported in RTCP RRs, summed over the track's receivers.", fNumPacketsLost);
+		writer.addSample("live555_stream_receiver_max_fraction_lost", MediaMetricsWriter::GAUGE,
+			"The largest fraction of RTP packets lost (since its previous RTCP RR) reported by any of the track's receivers.",
+			fMaxFractionLost);
+		writer.addSample("live555_stream_receiver_max_jitter_seconds", MediaMetricsWriter::GAUGE,
+			"The largest interarrival jitter reported (in RTCP RRs) by any of the track's receivers.", fMaxJitterSeconds);
+		writer.addSample("live555_stream_receiver_max_rtt_seconds", MediaMetricsWriter::GAUGE,
+			"The largest round-trip delay computed from any of the track's receivers' most recent RTCP RRs.", fMaxRTTSeconds);
+	}
+
+private:
+	unsigned fNumSinks;
+	u_int64_t fNumPacketsSent, fNumOctetsSent, fNumFramesSent, fNumTruncatedBytes;
+	unsigned fNumReceivers;
+	int fNumPacketsLost;
+	double fMaxFractionLost, fMaxJitterSeconds, fMaxRTTSeconds;
+};
+
+void RTSPServer::addMetrics(MediaMetricsWriter& writer) {
+	// If our event loop is recording timing statistics, then include these:
+	EventLoopStats* eventLoopStats = envir().taskScheduler().eventLoopStats();
+	if (eventLoopStats != NULL && eventLoopStats->isEnabled()) addEventLoopMetrics(writer, *eventLoopStats);
+
+	writer.addSample("live555_rtsp_client_connections", MediaMetricsWriter::GAUGE,
+		"Number of open RTSP (or HTTP) client connections.", fClientConnections->numEntries());
+	writer.addSample("live555_rtsp_client_sessions", MediaMetricsWriter::GAUGE,
+		"Number of RTSP client sessions.", fClientSessions->numEntries());
+	writer.addSample("live555_server_media_sessions", MediaMetricsWriter::GAUGE,
+		"Number of streams that we serve.", fServerMediaSessions->numEntries());
+
+	// Add samples for each track that's being streamed to clients.  These are summed over the "RTPSink"s that our client sessions
+	// are using for the track.  (We don't label samples with client session ids or client addresses, because anyone who can read
+	// our metrics could then use these to hijack, or tear down, other clients' sessions.)  Because "RTPSink"s may be shared
+	// (by multicast streams, or by unicast streams that use "reuseFirstSource"), we note the ones that we've already seen,
+	// and count each one just once:
+	HashTable* sinksSeen = HashTable::create(ONE_WORD_HASH_KEYS);
+	HashTable* trackMetrics = HashTable::create(ONE_WORD_HASH_KEYS); // maps each "ServerMediaSubsession" to its "TrackMetrics"
+	HashTable::Iterator* iter = HashTable::Iterator::create(*fClientSessions);
+	RTSPServer::RTSPClientSession* clientSession;
+	char const* key; // dummy
+	while ((clientSession = (RTSPServer::RTSPClientSession*)(iter->next(key))) != NULL) {
+		if (clientSession->fOurServerMediaSession == NULL) continue;
+
+		for (unsigned i = 0; i < clientSession->fNumStreamStates; ++i) {
+			ServerMediaSubsession* subsession = clientSession->fStreamStates[i].subsession;
+			if (subsession == NULL) continue;
+			RTPSink* sink = subsession->getStreamRTPSink(clientSession->fStreamStates[i].streamToken);
+			if (sink == NULL || sinksSeen->Lookup((char const*)sink) != NULL) continue;
+			sinksSeen->Add((char const*)sink, sink);
+
+			TrackMetrics* metrics = (TrackMetrics*)(trackMetrics->Lookup((char const*)subsession));
+			if (metrics == NULL) {
+				metrics = new TrackMetrics;
+				trackMetrics->Add((char const*)subsession, metrics);
+			}
+			metrics->addSink(*sink);
+		}
+	}
+	delete iter;
+	delete sinksSeen;
+
+	// Then output these, in the order of our streams (and their tracks):
+	ServerMediaSessionIterator smsIter(*this);
+	ServerMediaSession* serverMediaSession;
+	while ((serverMediaSession = smsIter.next()) != NULL) {
+		ServerMediaSubsessionIterator subsessionIter(*serverMediaSession);
+		ServerMediaSubsession* subsession;
+		while ((subsession = subsessionIter.next()) != NULL) {
+			TrackMetrics* metrics = (TrackMetrics*)(trackMetrics->Lookup((char const*)subsession));
+			if (metrics == NULL) continue;
+
+			writer.setLabel("stream", serverMediaSession->streamName());
+			writer.setLabel("track", subsession->trackId());
+			metrics->addSamples(writer);
+			trackMetrics->Remove((char const*)subsession);
+			delete metrics;
+		}
+		writer.clearLabels();
+
+		// Also add any metrics that are specific to this stream (e.g., for a proxied stream's input):
+		serverMediaSession->addMetrics(writer);
+		writer.clearLabels();
+	}
+	TrackMetrics* metrics;
+	while ((metrics = (TrackMetrics*)(trackMetrics->RemoveNext())) != NULL) delete metrics; // shouldn't happen
+	delete trackMetrics;
+}
+
+// A larger backlog lets the kernel queue a burst of (re)connecting clients - e.g., after a restart - rather than refusing them.
+// (We then accept them in batches; see "MAX_ACCEPTS_PER_EVENT" below.)
+#ifndef LISTEN_BACKLOG_SIZE
+#ifdef SOMAXCONN
+#define LISTEN_BACKLOG_SIZE SOMAXCONN
+#else
 #define LISTEN_BACKLOG_SIZE 20
+#endif
+#endif
 
 int RTSPServer::setUpOurSocket(UsageEnvironment& env, Port& ourPort) {
 	int ourSocket = -1;
@@ -340,12 +580,25 @@ RTSPServer::RTSPServer(UsageEnvironment& env,
 	fClientConnectionsForHTTPTunneling(NULL), // will get created if needed
 	fClientSessions(HashTable::create(STRING_HASH_KEYS)),
 	fPendingRegisterRequests(HashTable::create(ONE_WORD_HASH_KEYS)), fRegisterRequestCounter(0),
-	fAuthDB(authDatabase), fReclamationTestSeconds(reclamationTestSeconds) {
+	fAuthDB(authDatabase), fReclamationTestSeconds(reclamationTestSeconds),
+	fMaxConnections(0), fMaxConnectionsPerClientAddress(0), fNumConnectionsPerClientAddress(NULL),
+	fMetricsURLSuffix(NULL), fWorkers(NULL) {
 	ignoreSigPipeOnSocket(ourSocket); // so that clients on the same host that are killed don't also kill us
 
 	// Arrange to handle connections from others:
 	env.taskScheduler().turnOnBackgroundReadHandling(fRTSPServerSocket,
 		(TaskScheduler::BackgroundHandlerProc*)&incomingConnectionHandlerRTSP, this);
+
+	// Name our event loop handlers, for the event loop's statistics (if it keeps any):
+	EventLoopStats* eventLoopStats = env.taskScheduler().eventLoopStats();
+	if (eventLoopStats != NULL) {
+		eventLoopStats->setHandlerName((void const*)&incomingConnectionHandlerRTSP, "RTSPServer::incomingConnectionHandlerRTSP");
+		eventLoopStats->setHandlerName((void const*)&incomingConnectionHandlerHTTP, "RTSPServer::incomingConnectionHandlerHTTP");
+		eventLoopStats->setHandlerName((void const*)&RTSPClientConnection::incomingRequestHandler,
+			"RTSPServer::RTSPClientConnection::incomingRequestHandler");
+		eventLoopStats->setHandlerName((void const*)&RTSPClientSession::livenessTimeoutTask,
+			"RTSPServer::RTSPClientSession::livenessTimeoutTask");
+	}
 }
 
 RTSPServer::~RTSPServer() {
@@ -370,6 +623,7 @@ RTSPServer::~RTSPServer() {
 	}
 	delete fClientConnections;
 	delete fClientConnectionsForHTTPTunneling; // all content was already removed as a result of the loop above
+	delete fNumConnectionsPerClientAddress; // ditto
 
 	// Delete all server media sessions
 	ServerMediaSession* serverMediaSession;
@@ -384,6 +638,8 @@ RTSPServer::~RTSPServer() {
 		delete registerRequest;
 	}
 	delete fPendingRegisterRequests;
+
+	delete[] fMetricsURLSuffix;
 }
 
 Boolean RTSPServer::isRTSPServer() const {
@@ -406,26 +662,80 @@ void RTSPServer::incomingConnectionHandlerHTTP1() {
 	incomingConnectionHandler(fHTTPServerSocket);
 }
 
+// The maximum number of connections that we accept each time our server socket becomes readable.
+// (This drains a burst of new connections quickly, while still letting other event handlers run in between.)
+#ifndef MAX_ACCEPTS_PER_EVENT
+#define MAX_ACCEPTS_PER_EVENT 64
+#endif
+
 void RTSPServer::incomingConnectionHandler(int serverSocket) {
-	struct sockaddr_in clientAddr;
-	SOCKLEN_T clientAddrLen = sizeof clientAddr;
-	int clientSocket = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientAddrLen);
-	if (clientSocket < 0) {
-		int err = envir().getErrno();
-		if (err != EWOULDBLOCK) {
-			envir().setResultErrMsg("accept() failed: ");
+	for (unsigned i = 0; i < MAX_ACCEPTS_PER_EVENT; ++i) {
+		struct sockaddr_in clientAddr;
+		int clientSocket = acceptStreamSocket(serverSocket, clientAddr);
+		if (clientSocket < 0) {
+			int err = envir().getErrno();
+			if (err != EWOULDBLOCK && err != EAGAIN) {
+				envir().setResultErrMsg("accept() failed: ");
+			}
+			return;
 		}
-		return;
-	}
-	makeSocketNonBlocking(clientSocket);
-	increaseSendBufferTo(envir(), clientSocket, 50 * 1024);
 
+		if (!admitConnection(clientAddr)) {
+			// We're over one of our connection limits, so close this connection right away:
 #ifdef DEBUG
-	envir() << "accept()ed connection from " << AddressString(clientAddr).val() << "\n";
+			envir() << "rejected connection from " << AddressString(clientAddr).val() << " (over our connection limit)\n";
 #endif
+			::closeSocket(clientSocket);
+			continue;
+		}
+		increaseSendBufferTo(envir(), clientSocket, 50 * 1024);
+
+#ifdef DEBUG
+		envir() << "accept()ed connection from " << AddressString(clientAddr).val() << "\n";
+#endif
+
+		// Create a new object for handling this RTSP connection:
+		(void)createNewClientConnection(clientSocket, clientAddr);
+	}
+}
+
+Boolean RTSPServer::admitConnection(struct sockaddr_in const& clientAddr,
+				    unsigned numOtherConnections, unsigned numOtherConnectionsFromClientAddress) {
+	if (fMaxConnections > 0 && fClientConnections->numEntries() + numOtherConnections >= fMaxConnections) return False;
+
+	if (fMaxConnectionsPerClientAddress > 0) {
+		unsigned long numConnections = numOtherConnectionsFromClientAddress;
+		if (fNumConnectionsPerClientAddress != NULL) {
+			numConnections += (unsigned long)(fNumConnectionsPerClientAddress->Lookup((char const*)(long)clientAddr.sin_addr.s_addr));
+		}
+		if (numConnections >= fMaxConnectionsPerClientAddress) return False;
+	}
+
+	return True;
+}
+
+void RTSPServer::noteNewClientConnection(struct sockaddr_in const& clientAddr) {
+	if (fNumConnectionsPerClientAddress == NULL) return; // we're not counting
+
+	char const* key = (char const*)(long)clientAddr.sin_addr.s_addr;
+	unsigned long numConnections = (unsigned long)(fNumConnectionsPerClientAddress->Lookup(key));
+	fNumConnectionsPerClientAddress->Add(key, (void*)(numConnections + 1));
+}
+
+void RTSPServer::noteClosedClientConnection(struct sockaddr_in const& clientAddr) {
+	// If we're a worker process, then the original process (which checks our connection limits) also counts our connections:
+	if (fWorkers != NULL) fWorkers->reportClosedConnection(clientAddr);
+
+	if (fNumConnectionsPerClientAddress == NULL) return; // we're not counting
 
-	// Create a new object for handling this RTSP connection:
-	(void)createNewClientConnection(clientSocket, clientAddr);
+	char const* key = (char const*)(long)clientAddr.sin_addr.s_addr;
+	unsigned long numConnections = (unsigned long)(fNumConnectionsPerClientAddress->Lookup(key));
+	if (numConnections > 1) {
+		fNumConnectionsPerClientAddress->Add(key, (void*)(numConnections - 1));
+	}
+	else {
+		fNumConnectionsPerClientAddress->Remove(key);
+	}
 }
 
 
@@ -435,9 +745,11 @@ RTSPServer::RTSPClientConnection
 ::RTSPClientConnection(RTSPServer& ourServer, int clientSocket, struct sockaddr_in clientAddr)
 : fOurServer(ourServer), fIsActive(True),
 fClientInputSocket(clientSocket), fClientOutputSocket(clientSocket), fClientAddr(clientAddr),
-fRecursionCount(0), fOurSessionCookie(NULL) {
+fRequestBuffer(NULL), fRecursionCount(0), fOurSessionCookie(NULL),
+fMetricsSource(NULL), fMetricsSink(NULL) {
 	// Add ourself to our 'client connections' table:
 	fOurServer.fClientConnections->Add((char const*)this, this);
+	fOurServer.noteNewClientConnection(fClientAddr);
 
 	// Arrange to handle incoming requests:
 	resetRequestBuffer();
@@ -448,6 +760,7 @@ fRecursionCount(0), fOurSessionCookie(NULL) {
 RTSPServer::RTSPClientConnection::~RTSPClientConnection() {
 	// Remove ourself from the server's 'client connections' hash table before we go:
 	fOurServer.fClientConnections->Remove((char const*)this);
+	fOurServer.noteClosedClientConnection(fClientAddr);
 
 	if (fOurSessionCookie != NULL) {
 		// We were being used for RTSP-over-HTTP tunneling. Also remove ourselves from the 'session cookie' hash table before we go:
@@ -455,7 +768,10 @@ RTSPServer::RTSPClientConnection::~RTSPClientConnection() {
 		delete[] fOurSessionCookie;
 	}
 
+	Medium::close(fMetricsSink);
+	Medium::close(fMetricsSource);
 	closeSockets();
+	delete[] fRequestBuffer;
 }
 
 // Special mechanism for handling our custom "REGISTER" command:
@@ -479,6 +795,21 @@ void RTSPServer::RTSPClientConnection::handleCmd_OPTIONS() {
 		fCurrentCSeq, dateHeader(), fOurServer.allowedCommandNames());
 }
 
+void RTSPServer::RTSPClientConnection::handleCmd_redirectToNewConnection() {
+	// Redirect the client to the request's own URL.  A client opens a new connection for a redirected request, and each
+	// new connection gets passed to the process that serves the stream that it names:
+	char* url = strDupSize((char*)fRequestBuffer);
+	if (sscanf((char*)fRequestBuffer, "%*s %s", url) == 1) {
+		snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+			"RTSP/1.0 302 Moved Temporarily\r\nCSeq: %s\r\n%sLocation: %s\r\n\r\n",
+			fCurrentCSeq, dateHeader(), url);
+	}
+	else {
+		handleCmd_bad();
+	}
+	delete[] url;
+}
+
 void RTSPServer::RTSPClientConnection
 ::handleCmd_GET_PARAMETER(char const* /*fullRequestStr*/) {
 	// By default, we implement "GET_PARAMETER" (on the entire server) just as a 'no op', and send back a dummy response.
@@ -556,28 +887,6 @@ void RTSPServer::RTSPClientConnection
 	delete[] rtspURL;
 }
 
-static void lookForHeader(char const* headerName, char const* source, unsigned sourceLen, char* resultStr, unsigned resultMaxSize) {
-	resultStr[0] = '\0';  // by default, return an empty string
-	unsigned headerNameLen = strlen(headerName);
-	for (int i = 0; i < (int)(sourceLen - headerNameLen); ++i) {
-		if (strncmp(&source[i], headerName, headerNameLen) == 0 && source[i + headerNameLen] == ':') {
-			// We found the header.  Skip over any whitespace, then copy the rest of the line to "resultStr":
-			for (i += headerNameLen + 1; i < (int)sourceLen && (source[i] == ' ' || source[i] == '\t'); ++i) {}
-			for (unsigned j = i; j < sourceLen; ++j) {
-				if (source[j] == '\r' || source[j] == '\n') {
-					// We've found the end of the line.  Copy it to the result (if it will fit):
-					if (j - i + 1 > resultMaxSize) break;
-					char const* resultSource = &source[i];
-					char const* resultSourceEnd = &source[j];
-					while (resultSource < resultSourceEnd) *resultStr++ = *resultSource++;
-					*resultStr = '\0';
-					break;
-				}
-			}
-		}
-	}
-}
-
 void RTSPServer
 ::RTSPClientConnection::handleCmd_REGISTER(char const* url, char const* urlSuffix, char const* fullRequestStr,
 Boolean reuseConnection, Boolean deliverViaTCP, char const* proxyURLSuffix) {
@@ -675,8 +984,8 @@ Boolean RTSPServer::RTSPClientConnection::parseHTTPRequestString(char* resultCmd
 	urlSuffix[n] = '\0';
 
 	// Look for various headers that we're interested in:
-	lookForHeader("x-sessioncookie", &reqStr[i], reqStrSize - i, sessionCookie, sessionCookieMaxSize);
-	lookForHeader("Accept", &reqStr[i], reqStrSize - i, acceptStr, acceptStrMaxSize);
+	fRequestHeaders.copyValue("x-sessioncookie", sessionCookie, sessionCookieMaxSize);
+	fRequestHeaders.copyValue("Accept", acceptStr, acceptStrMaxSize);
 
 	return True;
 }
@@ -762,13 +1071,83 @@ void RTSPServer::RTSPClientConnection::handleHTTPCmd_StreamingGET(char const* /*
 	handleHTTPCmd_notSupported();
 }
 
+void RTSPServer::RTSPClientConnection::handleHTTPCmd_metricsGET() {
+	// Our metrics are subject to the same access control (and authentication, if any) as our RTSP commands:
+	if (!authenticationOK("GET", fOurServer.fMetricsURLSuffix, (char const*)fRequestBuffer, True)) return;
+
+	MediaMetricsWriter writer;
+	fOurServer.addMetrics(writer);
+	unsigned metricsTextLength;
+	char* metricsText = writer.text(metricsTextLength);
+
+	// Send the response header now, because we're about to add more data (the metrics text):
+	snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+		"HTTP/1.1 200 OK\r\n"
+		"%s"
+		"Server: LIVE555 Streaming Media v%s\r\n"
+		"Cache-Control: no-cache\r\n"
+		"Connection: close\r\n"
+		"Content-Length: %u\r\n"
+		"Content-Type: %s\r\n"
+		"\r\n",
+		dateHeader(),
+		LIVEMEDIA_LIBRARY_VERSION_STRING,
+		metricsTextLength,
+		MediaMetricsWriter::contentType());
+	send(fClientOutputSocket, (char const*)fResponseBuffer, strlen((char*)fResponseBuffer), 0);
+	fResponseBuffer[0] = '\0'; // We've already sent the response.  This tells the calling code not to send it again.
+
+	// Then, send the metrics text.  Because it can be large, we stream it over the TCP socket (rather than using "send()"),
+	// and close the connection once it's all been sent:
+	Medium::close(fMetricsSink);
+	Medium::close(fMetricsSource);
+	fMetricsSource = ByteStreamMemoryBufferSource::createNew(envir(), (u_int8_t*)metricsText, metricsTextLength);
+	fMetricsSink = TCPStreamSink::createNew(envir(), fClientOutputSocket);
+	fMetricsSink->startPlaying(*fMetricsSource, afterSendingMetrics, this);
+}
+
+void RTSPServer::RTSPClientConnection::afterSendingMetrics(void* clientData) {
+	RTSPServer::RTSPClientConnection* clientConnection = (RTSPServer::RTSPClientConnection*)clientData;
+	// Arrange to delete the 'client connection' object:
+	if (clientConnection->fRecursionCount > 0) {
+		// We're still in the midst of handling a request
+		clientConnection->fIsActive = False; // will cause the object to get deleted at the end of handling the request
+	}
+	else {
+		// We're no longer handling a request; delete the object now:
+		delete clientConnection;
+	}
+}
+
 void RTSPServer::RTSPClientConnection::resetRequestBuffer() {
 	fRequestBytesAlreadySeen = 0;
-	fRequestBufferBytesLeft = sizeof fRequestBuffer;
-	fLastCRLF = &fRequestBuffer[-3]; // hack: Ensures that we don't think we have end-of-msg if the data starts with <CR><LF>
+	fRequestBufferBytesLeft = RTSP_BUFFER_SIZE;
+	fLastCRLF = fRequestBuffer == NULL ? NULL : &fRequestBuffer[-3];
+	// hack: Ensures that we don't think we have end-of-msg if the data starts with <CR><LF>
+	fRequestHeaders.reset();
 	fBase64RemainderCount = 0;
 }
 
+void RTSPServer::RTSPClientConnection::allocateRequestBuffer() {
+	// We don't allocate our request buffer until we first need it, so that connections that never send us anything
+	// (e.g., during a burst of new connections) cost us less:
+	if (fRequestBuffer != NULL) return;
+
+	fRequestBuffer = new unsigned char[RTSP_BUFFER_SIZE];
+	resetRequestBuffer();
+}
+
+char const* RTSPServer::RTSPClientConnection
+::requestHeaderLine(char const* headerName, char const* fullRequestStr) const {
+	// If "fullRequestStr" is the request that we're currently handling, then we use our index to go straight to the header's line
+	// (or to an empty string, if there's no such header), so that the caller's parsing routine doesn't need to scan the whole request.
+	// Otherwise, we return "fullRequestStr" itself, to be scanned in the usual way.
+	if (fullRequestStr != (char const*)fRequestBuffer) return fullRequestStr;
+
+	char const* line = fRequestHeaders.lookupLine(headerName);
+	return line == NULL ? "" : line;
+}
+
 void RTSPServer::RTSPClientConnection::closeSockets() {
 	// Turn off background handling on our input socket (and output socket, if different); then close it (or them):
 	if (fClientOutputSocket != fClientInputSocket) {
@@ -790,6 +1169,7 @@ void RTSPServer::RTSPClientConnection::incomingRequestHandler(void* instance, in
 void RTSPServer::RTSPClientConnection::incomingRequestHandler1() {
 	struct sockaddr_in dummy; // 'from' address, meaningless in this case
 
+	allocateRequestBuffer();
 	int bytesRead = readSocket(envir(), fClientInputSocket, &fRequestBuffer[fRequestBytesAlreadySeen], fRequestBufferBytesLeft, dummy);
 	handleRequestBytes(bytesRead);
 }
@@ -812,6 +1192,7 @@ void RTSPServer::RTSPClientConnection::handleAlternativeRequestByte1(u_int8_t re
 	else {
 		// Normal case: Add this character to our buffer; then try to handle the data that we have buffered so far:
 		if (fRequestBufferBytesLeft == 0 || fRequestBytesAlreadySeen >= RTSP_BUFFER_SIZE) return;
+		allocateRequestBuffer();
 		fRequestBuffer[fRequestBytesAlreadySeen] = requestByte;
 		handleRequestBytes(1);
 	}
@@ -892,9 +1273,16 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 			// We're doing RTSP-over-HTTP tunneling, and input commands are assumed to have been Base64-encoded.
 			// We therefore Base64-decode as much of this new data as we can (i.e., up to a multiple of 4 bytes).
 
-			// But first, we remove any whitespace that may be in the input data:
-			unsigned toIndex = 0;
-			for (int fromIndex = 0; fromIndex < newBytesRead; ++fromIndex) {
+			// But first, we remove any whitespace that may be in the input data.
+			// (There usually isn't any, so we don't start moving bytes until we find some.)
+			int fromIndex = 0;
+			while (fromIndex < newBytesRead) {
+				char c = ptr[fromIndex];
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\n') break;
+				++fromIndex;
+			}
+			unsigned toIndex = fromIndex;
+			for (; fromIndex < newBytesRead; ++fromIndex) {
 				char c = ptr[fromIndex];
 				if (!(c == ' ' || c == '\t' || c == '\r' || c == '\n')) { // not 'whitespace': space,tab,CR,NL
 					ptr[toIndex++] = c;
@@ -906,30 +1294,26 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 			unsigned newBase64RemainderCount = numBytesToDecode % 4;
 			numBytesToDecode -= newBase64RemainderCount;
 			if (numBytesToDecode > 0) {
-				ptr[newBytesRead] = '\0';
-				unsigned decodedSize;
-				unsigned char* decodedBytes = base64Decode((char const*)(ptr - fBase64RemainderCount), numBytesToDecode, decodedSize);
+				// Decode the new bytes in place (we can do this because there are fewer decoded bytes than original):
+				unsigned char* to = ptr - fBase64RemainderCount;
+				unsigned decodedSize = base64DecodeToBuffer((char const*)to, numBytesToDecode, to);
 #ifdef DEBUG
 				fprintf(stderr, "Base64-decoded %d input bytes into %d new bytes:", numBytesToDecode, decodedSize);
-				for (unsigned k = 0; k < decodedSize; ++k) fprintf(stderr, "%c", decodedBytes[k]);
+				for (unsigned k = 0; k < decodedSize; ++k) fprintf(stderr, "%c", to[k]);
 				fprintf(stderr, "\n");
 #endif
 
-				// Copy the new decoded bytes in place of the old ones (we can do this because there are fewer decoded bytes than original):
-				unsigned char* to = ptr - fBase64RemainderCount;
-				for (unsigned i = 0; i < decodedSize; ++i) *to++ = decodedBytes[i];
-
 				// Then copy any remaining (undecoded) bytes to the end:
-				for (unsigned j = 0; j < newBase64RemainderCount; ++j) *to++ = (ptr - fBase64RemainderCount + numBytesToDecode)[j];
+				memmove(&to[decodedSize], &to[numBytesToDecode], newBase64RemainderCount);
 
 				newBytesRead = decodedSize + newBase64RemainderCount; // adjust to allow for the size of the new decoded data (+ remainder)
-				delete[] decodedBytes;
 			}
 			fBase64RemainderCount = newBase64RemainderCount;
 			if (fBase64RemainderCount > 0) break; // because we know that we have more input bytes still to receive
 		}
 
 		// Look for the end of the message: <CR><LF><CR><LF>
+		// As we find the end of each line, we also add it to our index of the request's lines, so that we never need to rescan them:
 		unsigned char *tmpPtr = fLastCRLF + 2;
 		if (tmpPtr < fRequestBuffer) tmpPtr = fRequestBuffer;
 		while (tmpPtr < &ptr[newBytesRead - 1]) {
@@ -938,6 +1322,9 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 					endOfMsg = True;
 					break;
 				}
+				unsigned char* lineStart = fLastCRLF + 2;
+				if (lineStart < fRequestBuffer) lineStart = fRequestBuffer;
+				fRequestHeaders.addLine((char*)lineStart, tmpPtr - lineStart);
 				fLastCRLF = tmpPtr;
 			}
 			++tmpPtr;
@@ -956,15 +1343,13 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 		char cseq[RTSP_PARAM_STRING_MAX];
 		char sessionIdStr[RTSP_PARAM_STRING_MAX];
 		unsigned contentLength = 0;
-		fLastCRLF[2] = '\0'; // temporarily, for parsing
-		Boolean parseSucceeded = parseRTSPRequestString((char*)fRequestBuffer, fLastCRLF + 2 - fRequestBuffer,
+		Boolean parseSucceeded = parseRTSPRequestString(fRequestHeaders,
 			cmdName, sizeof cmdName,
 			urlPreSuffix, sizeof urlPreSuffix,
 			urlSuffix, sizeof urlSuffix,
 			cseq, sizeof cseq,
 			sessionIdStr, sizeof sessionIdStr,
 			contentLength);
-		fLastCRLF[2] = '\r'; // restore its value
 		Boolean playAfterSetup = False;
 		if (parseSucceeded) {
 #ifdef DEBUG
@@ -999,6 +1384,12 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 					handleCmd_notSupported();
 				}
 			}
+			else if (clientSession == NULL && fOurServer.fWorkers != NULL
+				&& fOurServer.fWorkers->requestIsForAnotherProcess(cmdName, urlPreSuffix, urlSuffix)) {
+				// This connection was passed to our process because of an earlier request, but this request is for a stream
+				// that another process serves:
+				handleCmd_redirectToNewConnection();
+			}
 			else if (strcmp(cmdName, "DESCRIBE") == 0) {
 				handleCmd_DESCRIBE(urlPreSuffix, urlSuffix, (char const*)fRequestBuffer);
 			}
@@ -1044,7 +1435,7 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 					// Check for special command-specific parameters in a "Transport:" header:
 					Boolean reuseConnection, deliverViaTCP;
 					char* proxyURLSuffix;
-					parseTransportHeaderForREGISTER((const char*)fRequestBuffer, reuseConnection, deliverViaTCP, proxyURLSuffix);
+					parseTransportHeaderForREGISTER(requestHeaderLine("Transport", (char const*)fRequestBuffer), reuseConnection, deliverViaTCP, proxyURLSuffix);
 
 					handleCmd_REGISTER(url, urlSuffix, (char const*)fRequestBuffer, reuseConnection, deliverViaTCP, proxyURLSuffix);
 					delete[] proxyURLSuffix;
@@ -1087,6 +1478,10 @@ void RTSPServer::RTSPClientConnection::handleRequestBytes(int newBytesRead) {
 					if (strcmp(acceptStr, "application/x-rtsp-tunnelled") == 0) {
 						isValidHTTPCmd = False;
 					}
+					else if (fOurServer.fMetricsURLSuffix != NULL && strcmp(cmdName, "GET") == 0
+						&& strcmp(urlSuffix, fOurServer.fMetricsURLSuffix) == 0) {
+						handleHTTPCmd_metricsGET();
+					}
 					else {
 						handleHTTPCmd_StreamingGET(urlSuffix, (char const*)fRequestBuffer);
 					}
@@ -1204,9 +1599,9 @@ static Boolean parseAuthorizationHeader(char const* buf,
 }
 
 Boolean RTSPServer::RTSPClientConnection
-::authenticationOK(char const* cmdName, char const* urlSuffix, char const* fullRequestStr) {
+::authenticationOK(char const* cmdName, char const* urlSuffix, char const* fullRequestStr, Boolean isHTTPRequest) {
 	if (!fOurServer.specialClientAccessCheck(fClientInputSocket, fClientAddr, urlSuffix)) {
-		setRTSPResponse("401 Unauthorized");
+		setUnauthorizedResponse(isHTTPRequest);
 		return False;
 	}
 
@@ -1226,7 +1621,7 @@ Boolean RTSPServer::RTSPClientConnection
 		// Next, the request needs to contain an "Authorization:" header,
 		// containing a username, (our) realm, (our) nonce, uri,
 		// and response string:
-		if (!parseAuthorizationHeader(fullRequestStr,
+		if (!parseAuthorizationHeader(requestHeaderLine("Authorization", fullRequestStr),
 			username, realm, nonce, uri, response)
 			|| username == NULL
 			|| realm == NULL || strcmp(realm, fCurrentAuthenticator.realm()) != 0
@@ -1260,7 +1655,7 @@ Boolean RTSPServer::RTSPClientConnection
 		if (!fOurServer.specialClientUserAccessCheck(fClientInputSocket, fClientAddr, urlSuffix, username)) {
 			// Note: We don't return a "WWW-Authenticate" header here, because the user is valid,
 			// even though the server has decided that they should not have access.
-			setRTSPResponse("401 Unauthorized");
+			setUnauthorizedResponse(isHTTPRequest);
 			delete[](char*)username;
 			return False;
 		}
@@ -1271,17 +1666,40 @@ Boolean RTSPServer::RTSPClientConnection
 	// If we get here, we failed to authenticate the user.
 	// Send back a "401 Unauthorized" response, with a new random nonce:
 	fCurrentAuthenticator.setRealmAndRandomNonce(authDB->realm());
-	snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
-		"RTSP/1.0 401 Unauthorized\r\n"
-		"CSeq: %s\r\n"
-		"%s"
-		"WWW-Authenticate: Digest realm=\"%s\", nonce=\"%s\"\r\n\r\n",
-		fCurrentCSeq,
-		dateHeader(),
-		fCurrentAuthenticator.realm(), fCurrentAuthenticator.nonce());
+	setUnauthorizedResponse(isHTTPRequest, True);
 	return False;
 }
 
+void RTSPServer::RTSPClientConnection
+::setUnauthorizedResponse(Boolean isHTTPRequest, Boolean includeChallenge) {
+	char challenge[200];
+	challenge[0] = '\0';
+	if (includeChallenge) {
+		snprintf(challenge, sizeof challenge, "WWW-Authenticate: Digest realm=\"%s\", nonce=\"%s\"\r\n",
+			fCurrentAuthenticator.realm(), fCurrentAuthenticator.nonce());
+	}
+
+	if (isHTTPRequest) {
+		snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+			"HTTP/1.1 401 Unauthorized\r\n"
+			"%s"
+			"%s"
+			"Content-Length: 0\r\n\r\n",
+			dateHeader(),
+			challenge);
+	}
+	else {
+		snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
+			"RTSP/1.0 401 Unauthorized\r\n"
+			"CSeq: %s\r\n"
+			"%s"
+			"%s\r\n",
+			fCurrentCSeq,
+			dateHeader(),
+			challenge);
+	}
+}
+
 void RTSPServer::RTSPClientConnection
 ::setRTSPResponse(char const* responseStr) {
 	snprintf((char*)fResponseBuffer, sizeof fResponseBuffer,
@@ -1353,6 +1771,7 @@ void RTSPServer::RTSPClientConnection
 
 	// Also write any extra data to our buffer, and handle it:
 	if (extraDataSize > 0 && extraDataSize <= fRequestBufferBytesLeft/*sanity check; should always be true*/) {
+		allocateRequestBuffer();
 		unsigned char* ptr = &fRequestBuffer[fRequestBytesAlreadySeen];
 		for (unsigned i = 0; i < extraDataSize; ++i) {
 			ptr[i] = extraData[i];
@@ -1639,7 +2058,7 @@ char const* urlPreSuffix, char const* urlSuffix, char const* fullRequestStr) {
 		u_int8_t clientsDestinationTTL;
 		portNumBits clientRTPPortNum, clientRTCPPortNum;
 		unsigned char rtpChannelId, rtcpChannelId;
-		parseTransportHeader(fullRequestStr, streamingMode, streamingModeString,
+		parseTransportHeader(ourClientConnection->requestHeaderLine("Transport", fullRequestStr), streamingMode, streamingModeString,
 			clientsDestinationAddressStr, clientsDestinationTTL,
 			clientRTPPortNum, clientRTCPPortNum,
 			rtpChannelId, rtcpChannelId);
@@ -1662,11 +2081,11 @@ char const* urlPreSuffix, char const* urlSuffix, char const* fullRequestStr) {
 		double rangeStart = 0.0, rangeEnd = 0.0;
 		char* absStart = NULL; char* absEnd = NULL;
 		Boolean startTimeIsNow;
-		if (parseRangeHeader(fullRequestStr, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow)) {
+		if (parseRangeHeader(ourClientConnection->requestHeaderLine("Range", fullRequestStr), rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow)) {
 			delete[] absStart; delete[] absEnd;
 			fStreamAfterSETUP = True;
 		}
-		else if (parsePlayNowHeader(fullRequestStr)) {
+		else if (parsePlayNowHeader(ourClientConnection->requestHeaderLine("x-playNow", fullRequestStr))) {
 			fStreamAfterSETUP = True;
 		}
 		else {
@@ -1917,7 +2336,7 @@ ServerMediaSubsession* subsession, char const* fullRequestStr) {
 
 	// Parse the client's "Scale:" header, if any:
 	float scale;
-	Boolean sawScaleHeader = parseScaleHeader(fullRequestStr, scale);
+	Boolean sawScaleHeader = parseScaleHeader(ourClientConnection->requestHeaderLine("Scale", fullRequestStr), scale);
 
 	// Try to set the stream's scale factor to this value:
 	if (subsession == NULL /*aggregate op*/) {
@@ -1943,7 +2362,7 @@ ServerMediaSubsession* subsession, char const* fullRequestStr) {
 	char* absStart = NULL; char* absEnd = NULL;
 	Boolean startTimeIsNow;
 	Boolean sawRangeHeader
-		= parseRangeHeader(fullRequestStr, rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow);
+		= parseRangeHeader(ourClientConnection->requestHeaderLine("Range", fullRequestStr), rangeStart, rangeEnd, absStart, absEnd, startTimeIsNow);
 
 	if (sawRangeHeader && absStart == NULL/*not seeking by 'absolute' time*/) {
 		// Use this information, plus the stream's duration (if known), to create our own "Range:" header, for the response:
@@ -0,0 +1,725 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// Shares out a RTSP server's streams among several worker processes - each with its own event loop - so that the server
+// can use more than one CPU core.  The original process accepts each incoming connection, and passes it to the worker
+// that owns the first stream that the connection's requests name.
+// Implementation
+
+#include "RTSPServerWorkers.hh"
+#include "RTSPCommon.hh"
+#include "GroupsockHelper.hh"
+#include "EventLoopStats.hh"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__WIN32__) || defined(_WIN32)
+#define NO_WORKER_PROCESSES 1
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
+// The most of a request line that we look at (to find the stream name):
+#define REQUEST_LINE_MAX_SIZE 2048
+// How long we wait for the rest of a request (that hasn't all arrived yet), before looking again:
+#define PARTIAL_REQUEST_RETRY_USECS 20000
+// How long we wait for a new connection to send a request that names a stream, before giving up on the connection:
+#define STREAM_REQUEST_TIMEOUT_SECONDS 10
+// The maximum number of connections that we accept (or receive from the original process) each time our socket becomes readable:
+#ifndef MAX_ACCEPTS_PER_EVENT
+#define MAX_ACCEPTS_PER_EVENT 64
+#endif
+// The maximum number of accepted connections (in the original process) that have not yet named a stream.  Beyond this, we
+// close new connections right away:
+#ifndef MAX_PENDING_CONNECTIONS
+#define MAX_PENDING_CONNECTIONS 1000
+#endif
+// How long we wait, after a worker dies, before replacing it (so that a worker that keeps failing doesn't keep us busy):
+#define WORKER_RESPAWN_DELAY_SECONDS 1
+
+////////// PendingConnection //////////
+
+// A connection (in the original process) that has not yet sent a request that names a stream.  We look at each request
+// without consuming it (using "MSG_PEEK"), so that it's still there for the worker (or our own server) to read.
+// Requests that name no stream ("OPTIONS", and "GET_PARAMETER" or "SET_PARAMETER" on "*") we answer (and consume) ourself.
+
+class PendingConnection {
+public:
+  PendingConnection(RTSPServerWorkers& workers, int clientSocket, struct sockaddr_in const& clientAddr);
+  virtual ~PendingConnection();
+
+private:
+  static void incomingDataHandler(void*, int /*mask*/);
+  void incomingDataHandler1();
+  void waitForMoreData();
+  static void retryHandler(void* clientData);
+  static void timeoutHandler(void* clientData);
+
+private:
+  friend class RTSPServerWorkers;
+  RTSPServerWorkers& fWorkers;
+  PendingConnection* fNext;
+  int fClientSocket; // -1 once the connection has been dispatched
+  struct sockaddr_in fClientAddr;
+  TaskToken fRetryTask, fTimeoutTask;
+};
+
+PendingConnection::PendingConnection(RTSPServerWorkers& workers, int clientSocket, struct sockaddr_in const& clientAddr)
+  : fWorkers(workers), fNext(workers.fPendingConnections), fClientSocket(clientSocket), fClientAddr(clientAddr),
+    fRetryTask(NULL) {
+  fWorkers.fPendingConnections = this;
+  fWorkers.notePendingConnection(fClientAddr, True);
+
+  fWorkers.envir().taskScheduler().turnOnBackgroundReadHandling(fClientSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&incomingDataHandler, this);
+  fTimeoutTask = fWorkers.envir().taskScheduler().scheduleDelayedTask(STREAM_REQUEST_TIMEOUT_SECONDS*1000000,
+								     (TaskFunc*)timeoutHandler, this);
+}
+
+PendingConnection::~PendingConnection() {
+  // Remove ourself from our list:
+  PendingConnection** ptr = &fWorkers.fPendingConnections;
+  while (*ptr != NULL && *ptr != this) ptr = &((*ptr)->fNext);
+  if (*ptr != NULL) *ptr = fNext;
+  fWorkers.notePendingConnection(fClientAddr, False);
+
+  fWorkers.envir().taskScheduler().unscheduleDelayedTask(fRetryTask);
+  fWorkers.envir().taskScheduler().unscheduleDelayedTask(fTimeoutTask);
+  if (fClientSocket >= 0) {
+    fWorkers.envir().taskScheduler().turnOffBackgroundReadHandling(fClientSocket);
+    ::closeSocket(fClientSocket);
+  }
+}
+
+void PendingConnection::incomingDataHandler(void* instance, int /*mask*/) {
+  PendingConnection* connection = (PendingConnection*)instance;
+  connection->incomingDataHandler1();
+}
+
+void PendingConnection::incomingDataHandler1() {
+  char request[RTSP_BUFFER_SIZE+1];
+  int bytesRead = recv(fClientSocket, request, RTSP_BUFFER_SIZE, MSG_PEEK);
+  if (bytesRead <= 0) {
+    int err = fWorkers.envir().getErrno();
+    if (bytesRead < 0 && (err == EWOULDBLOCK || err == EAGAIN)) return;
+    delete this; // the client went away before naming a stream
+    return;
+  }
+  request[bytesRead] = '\0';
+
+  // Wait until we have all of the request's headers:
+  char* endOfHeaders = strstr(request, "\r\n\r\n");
+  if (endOfHeaders == NULL && bytesRead < RTSP_BUFFER_SIZE) {
+    waitForMoreData();
+    return;
+  }
+  // (If the headers don't fit in our buffer, then we route the request by its first line alone.  Our server would reject it.)
+
+  // The request line is "<cmdName> <url> <protocol>".  Get the path from "<url>" - which (for RTSP) may begin
+  // "rtsp://<host>[:<port>]":
+  char requestLine[REQUEST_LINE_MAX_SIZE+1];
+  unsigned i;
+  for (i = 0; i < REQUEST_LINE_MAX_SIZE && request[i] != '\r' && request[i] != '\n' && request[i] != '\0'; ++i) {
+    requestLine[i] = request[i];
+  }
+  requestLine[i] = '\0';
+
+  char* cmdName = requestLine;
+  char* url = cmdName;
+  while (*url != ' ' && *url != '\0') ++url;
+  if (*url != '\0') *url++ = '\0';
+  while (*url == ' ') ++url;
+  char* urlEnd = url;
+  while (*urlEnd != ' ' && *urlEnd != '\0') ++urlEnd;
+  *urlEnd = '\0';
+
+  char* urlPath = strstr(url, "://");
+  if (urlPath != NULL) {
+    urlPath += 3;
+    while (*urlPath != '/' && *urlPath != '\0') ++urlPath; // skip over "<host>[:<port>]"
+  } else {
+    urlPath = url;
+  }
+  while (*urlPath == '/') ++urlPath;
+
+  int workerNum = fWorkers.workerForRequest(cmdName, urlPath);
+  if (workerNum >= (int)fWorkers.numWorkers()) workerNum = -1;
+
+  // If this is a RTSP request, then we also need its "CSeq:" (for any response that we send), and its "Content-Length:":
+  char rtspCmdName[RTSP_PARAM_STRING_MAX];
+  char urlPreSuffix[RTSP_PARAM_STRING_MAX];
+  char urlSuffix[RTSP_PARAM_STRING_MAX];
+  char cseq[RTSP_PARAM_STRING_MAX];
+  char sessionIdStr[RTSP_PARAM_STRING_MAX];
+  unsigned contentLength = 0;
+  Boolean const isRTSP = endOfHeaders != NULL
+    && parseRTSPRequestString(request, endOfHeaders + 4 - request, rtspCmdName, sizeof rtspCmdName,
+			      urlPreSuffix, sizeof urlPreSuffix, urlSuffix, sizeof urlSuffix,
+			      cseq, sizeof cseq, sessionIdStr, sizeof sessionIdStr, contentLength);
+
+  if (workerNum < 0 && isRTSP
+      && (strcmp(cmdName, "OPTIONS") == 0
+	  || ((strcmp(cmdName, "GET_PARAMETER") == 0 || strcmp(cmdName, "SET_PARAMETER") == 0) && strcmp(urlPath, "*") == 0))) {
+    // This request names no stream, so we answer it ourself (as "RTSPServer" would), and then wait for the next request.
+    // First, make sure that we have all of it (including any content):
+    unsigned const requestSize = (endOfHeaders + 4 - request) + contentLength;
+    if ((unsigned)bytesRead < requestSize) {
+      if (requestSize > RTSP_BUFFER_SIZE) { // too big for our server, too
+	delete this;
+	return;
+      }
+      waitForMoreData();
+      return;
+    }
+    (void)recv(fClientSocket, request, requestSize, 0); // consumes the request (which we've already seen)
+
+    char response[RTSP_BUFFER_SIZE];
+    if (strcmp(cmdName, "OPTIONS") == 0) {
+      snprintf(response, sizeof response, "RTSP/1.0 200 OK\r\nCSeq: %s\r\n%sPublic: %s\r\n\r\n",
+	       cseq, dateHeader(), fWorkers.allowedCommandNames());
+    } else if (strcmp(cmdName, "GET_PARAMETER") == 0) {
+      snprintf(response, sizeof response, "RTSP/1.0 200 OK\r\nCSeq: %s\r\n%sContent-Length: %d\r\n\r\n%s",
+	       cseq, dateHeader(), (int)strlen(LIVEMEDIA_LIBRARY_VERSION_STRING), LIVEMEDIA_LIBRARY_VERSION_STRING);
+    } else {
+      snprintf(response, sizeof response, "RTSP/1.0 200 OK\r\nCSeq: %s\r\n%s\r\n", cseq, dateHeader());
+    }
+    send(fClientSocket, response, strlen(response), 0);
+    return; // (If another request has already arrived, then our socket is still readable, so we'll get called again.)
+  }
+
+  fWorkers.envir().taskScheduler().turnOffBackgroundReadHandling(fClientSocket);
+  if (!fWorkers.dispatchConnection(fClientSocket, fClientAddr, workerNum)) {
+    // The worker can't take the connection (because it has died, or is too far behind in taking connections).
+    // Tell the client so, and close the connection:
+    char response[RTSP_PARAM_STRING_MAX + 200];
+    if (isRTSP) {
+      snprintf(response, sizeof response, "RTSP/1.0 503 Service Unavailable\r\nCSeq: %s\r\n%s\r\n", cseq, dateHeader());
+    } else {
+      snprintf(response, sizeof response, "HTTP/1.1 503 Service Unavailable\r\n%sContent-Length: 0\r\n\r\n", dateHeader());
+    }
+    send(fClientSocket, response, strlen(response), 0);
+    delete this;
+    return;
+  }
+  fClientSocket = -1; // it's no longer ours
+  delete this;
+}
+
+void PendingConnection::waitForMoreData() {
+  // Because we didn't consume what has arrived, our socket would stay 'readable', so stop watching it for a while,
+  // rather than spinning:
+  fWorkers.envir().taskScheduler().turnOffBackgroundReadHandling(fClientSocket);
+  fRetryTask = fWorkers.envir().taskScheduler().scheduleDelayedTask(PARTIAL_REQUEST_RETRY_USECS,
+								    (TaskFunc*)retryHandler, this);
+}
+
+void PendingConnection::retryHandler(void* clientData) {
+  PendingConnection* connection = (PendingConnection*)clientData;
+  connection->fRetryTask = NULL;
+  connection->fWorkers.envir().taskScheduler().turnOnBackgroundReadHandling(connection->fClientSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&incomingDataHandler, connection);
+}
+
+void PendingConnection::timeoutHandler(void* clientData) {
+  PendingConnection* connection = (PendingConnection*)clientData;
+  connection->fTimeoutTask = NULL;
+  delete connection;
+}
+
+
+////////// RTSPServerWorkers implementation //////////
+
+RTSPServerWorkers* RTSPServerWorkers::createNew(RTSPServer& server, unsigned numWorkers) {
+  RTSPServerWorkers* workers = new RTSPServerWorkers(server, numWorkers);
+  if (!workers->forkWorkers()) {
+    Medium::close(workers);
+    return NULL;
+  }
+
+  return workers;
+}
+
+RTSPServerWorkers::RTSPServerWorkers(RTSPServer& server, unsigned numWorkers)
+  : Medium(server.envir()),
+    fServer(server), fNumWorkers(numWorkers), fWorkerNum(-1), fWorkerProcesses(NULL),
+    fHandOffSocket(-1), fPendingConnections(NULL), fNumPendingConnections(0) {
+  fServer.fWorkers = this; // so that it can check that each request is for a stream that its process serves
+
+  // Name our event loop handlers, for the event loop's statistics (if it keeps any):
+  EventLoopStats* eventLoopStats = envir().taskScheduler().eventLoopStats();
+  if (eventLoopStats != NULL) {
+    eventLoopStats->setHandlerName((void const*)&incomingConnectionHandlerRTSP, "RTSPServerWorkers::incomingConnectionHandlerRTSP");
+    eventLoopStats->setHandlerName((void const*)&incomingConnectionHandlerHTTP, "RTSPServerWorkers::incomingConnectionHandlerHTTP");
+    eventLoopStats->setHandlerName((void const*)&PendingConnection::incomingDataHandler,
+				   "RTSPServerWorkers::PendingConnection::incomingDataHandler");
+    eventLoopStats->setHandlerName((void const*)&incomingHandOffHandler, "RTSPServerWorkers::incomingHandOffHandler");
+    eventLoopStats->setHandlerName((void const*)&workerSocketHandler, "RTSPServerWorkers::workerSocketHandler");
+  }
+}
+
+RTSPServerWorkers::~RTSPServerWorkers() {
+  while (fPendingConnections != NULL) delete fPendingConnections;
+
+  if (fWorkerProcesses != NULL) {
+    // We're the original process.  Hand back the accepting of connections to our server:
+    envir().taskScheduler().turnOnBackgroundReadHandling(fServer.fRTSPServerSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&RTSPServer::incomingConnectionHandlerRTSP, &fServer);
+    envir().taskScheduler().turnOnBackgroundReadHandling(fServer.fHTTPServerSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&RTSPServer::incomingConnectionHandlerHTTP, &fServer);
+
+    // Closing our end of each worker's socket pair tells the worker to exit:
+    for (unsigned i = 0; i < fNumWorkers; ++i) {
+      envir().taskScheduler().unscheduleDelayedTask(fWorkerProcesses[i].respawnTask);
+      if (fWorkerProcesses[i].socket >= 0) {
+	envir().taskScheduler().turnOffBackgroundReadHandling(fWorkerProcesses[i].socket);
+	::closeSocket(fWorkerProcesses[i].socket);
+      }
+      delete fWorkerProcesses[i].connectionsByClientAddress;
+    }
+    delete[] fWorkerProcesses;
+  }
+
+  if (fHandOffSocket >= 0) {
+    envir().taskScheduler().turnOffBackgroundReadHandling(fHandOffSocket);
+    ::closeSocket(fHandOffSocket);
+  }
+  fServer.fWorkers = NULL;
+}
+
+Boolean RTSPServerWorkers::forkWorkers() {
+#ifdef NO_WORKER_PROCESSES
+  envir().setResultMsg("Worker processes are not supported on this platform");
+  return False;
+#else
+  if (fNumWorkers == 0) {
+    envir().setResultMsg("There must be at least one worker process");
+    return False;
+  }
+
+  fWorkerProcesses = new WorkerProcess[fNumWorkers];
+  for (unsigned i = 0; i < fNumWorkers; ++i) {
+    fWorkerProcesses[i].workers = this;
+    fWorkerProcesses[i].workerNum = i;
+    fWorkerProcesses[i].socket = fWorkerProcesses[i].pid = -1;
+    fWorkerProcesses[i].respawnTask = NULL;
+    fWorkerProcesses[i].connectionsByClientAddress = HashTable::create(ONE_WORD_HASH_KEYS);
+    fWorkerProcesses[i].numConnections = 0;
+  }
+
+  for (unsigned i = 0; i < fNumWorkers; ++i) {
+    if (!forkWorker(i)) return False; // our destructor closes the sockets of any workers that we've already created, so that they exit
+    if (isWorker()) return True; // we're the new worker
+  }
+
+  // We're the original process.  From now on, we (rather than our server) accept connections:
+  envir().taskScheduler().turnOnBackgroundReadHandling(fServer.fRTSPServerSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&incomingConnectionHandlerRTSP, this);
+  envir().taskScheduler().turnOnBackgroundReadHandling(fServer.fHTTPServerSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&incomingConnectionHandlerHTTP, this);
+  return True;
+#endif
+}
+
+Boolean RTSPServerWorkers::forkWorker(unsigned workerNum) {
+#ifdef NO_WORKER_PROCESSES
+  return False;
+#else
+  int sockets[2];
+  // (We use a stream - rather than datagram - socket pair, so that each side sees 'end of file' if the other goes away.
+  // Each message to the worker is a client's address, with the client's socket attached.  Each message back is the client
+  // address of a connection that has closed.)
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0) {
+    envir().setResultErrMsg("socketpair() failed: ");
+    return False;
+  }
+
+  int pid = fork();
+  if (pid < 0) {
+    envir().setResultErrMsg("fork() failed: ");
+    ::closeSocket(sockets[0]); ::closeSocket(sockets[1]);
+    return False;
+  }
+
+  if (pid == 0) {
+    // We're the new worker:
+    ::closeSocket(sockets[0]);
+    becomeWorker(workerNum, sockets[1]);
+    return True;
+  }
+
+  ::closeSocket(sockets[1]);
+  WorkerProcess& worker = fWorkerProcesses[workerNum];
+  worker.socket = sockets[0];
+  worker.pid = pid;
+  ignoreSigPipeOnSocket(worker.socket); // so that passing a connection to a worker that has just died doesn't also kill us
+  makeSocketNonBlocking(worker.socket); // because our handler can be called when it's not readable (e.g., after a signal)
+
+  // Our end of the socket pair becomes readable when the worker reports a closed connection, or goes away:
+  envir().taskScheduler().turnOnBackgroundReadHandling(worker.socket,
+	(TaskScheduler::BackgroundHandlerProc*)&workerSocketHandler, &worker);
+  return True;
+#endif
+}
+
+void RTSPServerWorkers::becomeWorker(unsigned workerNum, int handOffSocket) {
+#ifndef NO_WORKER_PROCESSES
+  // We don't need the other workers' sockets, or anything else that the original process was using (if we're replacing a
+  // worker that died, then it may have been running for a while):
+  for (unsigned i = 0; i < fNumWorkers; ++i) {
+    envir().taskScheduler().unscheduleDelayedTask(fWorkerProcesses[i].respawnTask);
+    if (fWorkerProcesses[i].socket >= 0) {
+      envir().taskScheduler().turnOffBackgroundReadHandling(fWorkerProcesses[i].socket);
+      ::closeSocket(fWorkerProcesses[i].socket);
+    }
+    delete fWorkerProcesses[i].connectionsByClientAddress;
+  }
+  delete[] fWorkerProcesses; fWorkerProcesses = NULL;
+  while (fPendingConnections != NULL) delete fPendingConnections;
+  RTSPServer::RTSPClientConnection* connection;
+  while ((connection = (RTSPServer::RTSPClientConnection*)(fServer.fClientConnections->getFirst())) != NULL) {
+    delete connection; // one that the original process was handling itself
+  }
+  fWorkerNum = workerNum;
+
+  // Our 'random' numbers (e.g., for session ids and SSRCs) shouldn't be the same as those of the other workers:
+  our_srandom((int)(our_random()^getpid()));
+
+  // Only the original process accepts connections; we get ours from it:
+  envir().taskScheduler().turnOffBackgroundReadHandling(fServer.fRTSPServerSocket);
+  ::closeSocket(fServer.fRTSPServerSocket); fServer.fRTSPServerSocket = -1;
+  envir().taskScheduler().turnOffBackgroundReadHandling(fServer.fHTTPServerSocket);
+  ::closeSocket(fServer.fHTTPServerSocket); fServer.fHTTPServerSocket = -1;
+
+  fHandOffSocket = handOffSocket;
+  makeSocketNonBlocking(fHandOffSocket);
+  envir().taskScheduler().turnOnBackgroundReadHandling(fHandOffSocket,
+	(TaskScheduler::BackgroundHandlerProc*)&incomingHandOffHandler, this);
+#endif
+}
+
+void RTSPServerWorkers::workerSocketHandler(void* clientData, int /*mask*/) {
+  WorkerProcess* worker = (WorkerProcess*)clientData;
+  worker->workers->workerSocketHandler1(*worker);
+}
+
+void RTSPServerWorkers::workerSocketHandler1(WorkerProcess& worker) {
+  // The worker sends us the client address of each connection (that we passed to it) that closes.  (Each address is
+  // sent - and so arrives - whole.):
+  netAddressBits closedAddresses[MAX_ACCEPTS_PER_EVENT];
+  int bytesRead = recv(worker.socket, (char*)closedAddresses, sizeof closedAddresses, 0);
+  if (bytesRead < 0) {
+    int err = envir().getErrno();
+    if (err == EWOULDBLOCK || err == EAGAIN) return;
+  }
+  if (bytesRead <= 0) {
+    workerDied(worker.workerNum);
+    return;
+  }
+
+  for (unsigned i = 0; i < bytesRead/sizeof closedAddresses[0]; ++i) {
+    noteClosedHandedOffConnection(worker, closedAddresses[i]);
+  }
+}
+
+void RTSPServerWorkers::workerDied(unsigned workerNum) {
+#ifndef NO_WORKER_PROCESSES
+  WorkerProcess& worker = fWorkerProcesses[workerNum];
+  if (worker.socket < 0) return; // we already know
+
+  envir().taskScheduler().turnOffBackgroundReadHandling(worker.socket);
+  ::closeSocket(worker.socket); worker.socket = -1;
+
+  // The worker's connections have gone with it:
+  while (worker.connectionsByClientAddress->RemoveNext() != NULL) {}
+  worker.numConnections = 0;
+
+  // Reap the worker.  (Its end of our socket pair has gone away, so it can't take any more connections - even if it's
+  // somehow still running.  So make sure that it's gone.):
+  kill(worker.pid, SIGKILL);
+  int status = 0;
+  if (waitpid(worker.pid, &status, 0) == worker.pid) {
+    envir() << "RTSPServerWorkers: worker " << workerNum << " (process " << worker.pid << ") ";
+    if (WIFSIGNALED(status) && WTERMSIG(status) != SIGKILL) {
+      envir() << "was killed by signal " << WTERMSIG(status);
+    } else if (WIFEXITED(status)) {
+      envir() << "exited with status " << WEXITSTATUS(status);
+    } else {
+      envir() << "went away";
+    }
+    envir() << "; replacing it\n";
+  }
+  worker.pid = -1;
+
+  // Replace the worker after a delay.  (Until then, connections for its streams get a "503 Service Unavailable" response.):
+  worker.respawnTask = envir().taskScheduler().scheduleDelayedTask(WORKER_RESPAWN_DELAY_SECONDS*1000000,
+								   (TaskFunc*)respawnWorker, &worker);
+#endif
+}
+
+void RTSPServerWorkers::respawnWorker(void* clientData) {
+  WorkerProcess* worker = (WorkerProcess*)clientData;
+  RTSPServerWorkers* workers = worker->workers;
+  unsigned const workerNum = worker->workerNum;
+  worker->respawnTask = NULL;
+
+  if (!workers->forkWorker(workerNum)) {
+    workers->envir() << "RTSPServerWorkers: Failed to replace worker " << workerNum << ": " << workers->envir().getResultMsg() << "\n";
+    worker->respawnTask = workers->envir().taskScheduler().scheduleDelayedTask(WORKER_RESPAWN_DELAY_SECONDS*1000000,
+									      (TaskFunc*)respawnWorker, worker);
+    return;
+  }
+
+  // Note: In the new worker, "worker" no longer exists:
+  if (workers->isWorker()) workers->setUpRespawnedWorker();
+}
+
+void RTSPServerWorkers::setUpRespawnedWorker() {
+}
+
+void RTSPServerWorkers::signalWorkers(int sig) {
+#ifndef NO_WORKER_PROCESSES
+  if (fWorkerProcesses == NULL) return;
+
+  for (unsigned i = 0; i < fNumWorkers; ++i) {
+    if (fWorkerProcesses[i].pid > 0) kill(fWorkerProcesses[i].pid, sig);
+  }
+#endif
+}
+
+Boolean RTSPServerWorkers
+::requestIsForAnotherProcess(char const* cmdName, char const* urlPreSuffix, char const* urlSuffix) {
+  char urlPath[2*RTSP_PARAM_STRING_MAX];
+  if (urlPreSuffix[0] == '\0') {
+    snprintf(urlPath, sizeof urlPath, "%s", urlSuffix);
+  } else {
+    snprintf(urlPath, sizeof urlPath, "%s/%s", urlPreSuffix, urlSuffix);
+  }
+
+  int workerNum = workerForRequest(cmdName, urlPath);
+  if (workerNum < 0 || workerNum >= (int)fNumWorkers) return False; // any process can handle the request
+
+  return workerNum != fWorkerNum;
+}
+
+int RTSPServerWorkers::workerForRequest(char const* cmdName, char const* urlPath) {
+  if (strcmp(cmdName, "REGISTER") == 0 || strcmp(cmdName, "DEREGISTER") == 0) return 0;
+
+  return workerForStream(urlPath);
+}
+
+int RTSPServerWorkers::workerForStream(char const* streamName) {
+  if (streamName[0] == '\0' || strcmp(streamName, "*") == 0) return -1;
+
+  // Hash (using "FNV-1a") the first component of "streamName":
+  u_int32_t hash = 2166136261U;
+  for (char const* p = streamName; *p != '\0' && *p != '/'; ++p) {
+    hash = (hash^(u_int8_t)(*p))*16777619U;
+  }
+
+  return (int)(hash%fNumWorkers);
+}
+
+void RTSPServerWorkers::notePendingConnection(struct sockaddr_in const& clientAddr, Boolean isNew) {
+  // A pending connection counts toward our server's per-client-address connection limit (if any):
+  if (isNew) {
+    ++fNumPendingConnections;
+    fServer.noteNewClientConnection(clientAddr);
+  } else {
+    --fNumPendingConnections;
+    fServer.noteClosedClientConnection(clientAddr);
+  }
+}
+
+Boolean RTSPServerWorkers::admitConnection(struct sockaddr_in const& clientAddr) {
+  // The connections that we've passed to workers (and that are still open) count toward our server's connection limits,
+  // so that the limits apply to all processes together:
+  unsigned numConnections = 0, numConnectionsFromClientAddress = 0;
+  for (unsigned i = 0; i < fNumWorkers; ++i) {
+    WorkerProcess& worker = fWorkerProcesses[i];
+    numConnections += worker.numConnections;
+    numConnectionsFromClientAddress
+      += (unsigned)(unsigned long)(worker.connectionsByClientAddress->Lookup((char const*)(long)clientAddr.sin_addr.s_addr));
+  }
+
+  return fServer.admitConnection(clientAddr, numConnections, numConnectionsFromClientAddress);
+}
+
+void RTSPServerWorkers::noteHandedOffConnection(WorkerProcess& worker, netAddressBits clientAddress) {
+  char const* key = (char const*)(long)clientAddress;
+  unsigned long numConnections = (unsigned long)(worker.connectionsByClientAddress->Lookup(key));
+  worker.connectionsByClientAddress->Add(key, (void*)(numConnections + 1));
+  ++worker.numConnections;
+}
+
+void RTSPServerWorkers::noteClosedHandedOffConnection(WorkerProcess& worker, netAddressBits clientAddress) {
+  char const* key = (char const*)(long)clientAddress;
+  unsigned long numConnections = (unsigned long)(worker.connectionsByClientAddress->Lookup(key));
+  if (numConnections == 0) return; // (shouldn't happen)
+
+  if (numConnections > 1) {
+    worker.connectionsByClientAddress->Add(key, (void*)(numConnections - 1));
+  } else {
+    worker.connectionsByClientAddress->Remove(key);
+  }
+  --worker.numConnections;
+}
+
+void RTSPServerWorkers::reportClosedConnection(struct sockaddr_in const& clientAddr) {
+#ifndef NO_WORKER_PROCESSES
+  if (fHandOffSocket < 0) return; // we're not a worker (or are not yet set up as one)
+
+  // Tell the original process, so that it stops counting this connection toward our server's connection limits.
+  // (This can fail - losing the report - only if the original process is far behind in reading these.)
+  netAddressBits clientAddress = clientAddr.sin_addr.s_addr;
+  (void)send(fHandOffSocket, (char const*)&clientAddress, sizeof clientAddress, 0);
+#endif
+}
+
+char const* RTSPServerWorkers::allowedCommandNames() {
+  return fServer.allowedCommandNames();
+}
+
+void RTSPServerWorkers::incomingConnectionHandlerRTSP(void* instance, int /*mask*/) {
+  RTSPServerWorkers* workers = (RTSPServerWorkers*)instance;
+  workers->incomingConnectionHandler(workers->fServer.fRTSPServerSocket);
+}
+
+void RTSPServerWorkers::incomingConnectionHandlerHTTP(void* instance, int /*mask*/) {
+  RTSPServerWorkers* workers = (RTSPServerWorkers*)instance;
+  workers->incomingConnectionHandler(workers->fServer.fHTTPServerSocket);
+}
+
+void RTSPServerWorkers::incomingConnectionHandler(int serverSocket) {
+  for (unsigned i = 0; i < MAX_ACCEPTS_PER_EVENT; ++i) {
+    struct sockaddr_in clientAddr;
+    int clientSocket = acceptStreamSocket(serverSocket, clientAddr);
+    if (clientSocket < 0) {
+      int err = envir().getErrno();
+      if (err != EWOULDBLOCK && err != EAGAIN) {
+	envir().setResultErrMsg("accept() failed: ");
+      }
+      return;
+    }
+
+    if (fNumPendingConnections >= MAX_PENDING_CONNECTIONS || !admitConnection(clientAddr)) {
+      // We're over one of our connection limits, so close this connection right away:
+      ::closeSocket(clientSocket);
+      continue;
+    }
+    increaseSendBufferTo(envir(), clientSocket, 50*1024);
+
+    // Wait for the connection to name a stream, to see which worker should get it:
+    (void)new PendingConnection(*this, clientSocket, clientAddr);
+  }
+}
+
+Boolean RTSPServerWorkers::dispatchConnection(int clientSocket, struct sockaddr_in const& clientAddr, int workerNum) {
+  if (workerNum < 0) {
+    // We handle this connection ourself.  (We already checked our server's connection limits, when we accepted it.):
+    (void)fServer.createNewClientConnection(clientSocket, clientAddr);
+    return True;
+  }
+
+#ifdef NO_WORKER_PROCESSES
+  return False;
+#else
+  WorkerProcess& worker = fWorkerProcesses[workerNum];
+  if (worker.socket < 0) return False; // the worker has died, and hasn't yet been replaced
+
+  // Pass the socket (and the client's address) to the worker:
+  struct iovec iov;
+  iov.iov_base = (void*)&clientAddr;
+  iov.iov_len = sizeof clientAddr;
+
+  union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof (int))]; } control;
+  memset(&control, 0, sizeof control);
+  struct msghdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof control.buf;
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof (int));
+  memcpy(CMSG_DATA(cmsg), &clientSocket, sizeof (int));
+
+  if (sendmsg(worker.socket, &msg, MSG_DONTWAIT) < 0) {
+    int err = envir().getErrno();
+    if (err != EWOULDBLOCK && err != EAGAIN) {
+      workerDied(workerNum); // the worker has gone away
+    }
+    // (Otherwise, the worker is too far behind in taking connections.)
+    return False;
+  }
+
+  ::closeSocket(clientSocket); // it's the worker's now
+  noteHandedOffConnection(worker, clientAddr.sin_addr.s_addr);
+  return True;
+#endif
+}
+
+void RTSPServerWorkers::incomingHandOffHandler(void* instance, int /*mask*/) {
+  RTSPServerWorkers* workers = (RTSPServerWorkers*)instance;
+  workers->incomingHandOffHandler1();
+}
+
+void RTSPServerWorkers::incomingHandOffHandler1() {
+#ifndef NO_WORKER_PROCESSES
+  for (unsigned i = 0; i < MAX_ACCEPTS_PER_EVENT; ++i) {
+    struct sockaddr_in clientAddr;
+    struct iovec iov;
+    iov.iov_base = (void*)&clientAddr;
+    iov.iov_len = sizeof clientAddr;
+
+    union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof (int))]; } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof control.buf;
+
+    int bytesRead = recvmsg(fHandOffSocket, &msg, 0);
+    if (bytesRead < 0) {
+      int err = envir().getErrno();
+      if (err == EWOULDBLOCK || err == EAGAIN) return;
+    }
+    if (bytesRead <= 0) {
+      // The original process has gone away, so no more connections will reach us:
+      envir() << "RTSPServerWorkers: worker " << fWorkerNum << ": Lost our connection to the original process; exiting\n";
+      exit(0);
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue; // (shouldn't happen)
+    int clientSocket;
+    memcpy(&clientSocket, CMSG_DATA(cmsg), sizeof (int));
+    if (bytesRead != (int)(sizeof clientAddr)) { // (shouldn't happen)
+      ::closeSocket(clientSocket);
+      continue;
+    }
+
+    // (The original process has already checked our server's connection limits - for all processes - so we don't check
+    // them again here.)
+    (void)fServer.createNewClientConnection(clientSocket, clientAddr);
+  }
+#endif
+}
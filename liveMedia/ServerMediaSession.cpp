@@ -229,6 +229,10 @@ Boolean ServerMediaSession::isServerMediaSession() const {
 	return True;
 }
 
+void ServerMediaSession::addMetrics(MediaMetricsWriter& /*writer*/) {
+	// default implementation: do nothing
+}
+
 char* ServerMediaSession::generateSDPDescription() {
 	AddressString ipAddressStr(ourIPAddress(envir()));
 	unsigned ipAddressStrSize = strlen(ipAddressStr.val());
@@ -422,6 +426,10 @@ FramedSource* ServerMediaSubsession::getStreamSource(void* /*streamToken*/) {
 	// default implementation: return NULL
 	return NULL;
 }
+RTPSink* ServerMediaSubsession::getStreamRTPSink(void* /*streamToken*/) {
+	// default implementation: return NULL
+	return NULL;
+}
 void ServerMediaSubsession::deleteStream(unsigned /*clientSessionId*/,
 	void*& /*streamToken*/) {
 	// default implementation: do nothing
@@ -36,8 +36,30 @@ unsigned char* base64Decode(char const* in, unsigned inSize,
     // As above, but includes the size of the input string (i.e., the number of bytes to decode) as a parameter.
     // This saves an extra call to "strlen()" if we already know the length of the input string.
 
+unsigned base64DecodeToBuffer(char const* in, unsigned inSize, unsigned char* to,
+			      Boolean trimTrailingZeros = True);
+    // As above, but decodes into a caller-supplied buffer "to" - which must be at least
+    // "base64DecodedMaxSize(inSize)" bytes long - rather than allocating a new one.
+    // Returns the number of bytes decoded.  "to" may be the same as "in" (i.e., to decode in place).
+
+unsigned base64DecodedMaxSize(unsigned inSize);
+    // The maximum number of bytes that Base64-decoding "inSize" bytes can produce.
+
 char* base64Encode(char const* orig, unsigned origLength);
     // returns a 0-terminated string that
     // the caller is responsible for delete[]ing.
 
+unsigned base64EncodeToBuffer(char const* orig, unsigned origLength, char* to);
+    // As above, but encodes into a caller-supplied buffer "to" - which must be at least
+    // "base64EncodedSize(origLength)+1" bytes long - rather than allocating a new one.
+    // Returns the length of the resulting 0-terminated string.
+
+unsigned base64EncodedSize(unsigned origLength);
+    // The length (not counting the trailing '\0') of the Base64 encoding of "origLength" bytes.
+
+unsigned base64SetMaxSIMDLevel(unsigned maxLevel);
+    // For testing and benchmarking: limits the vector code that the functions above may use
+    // (0: none - i.e., the portable code only; 1: up to SSSE3; 2 (the default): up to AVX2).
+    // Returns the level that will actually be used (which is lower, if the CPU doesn't support "maxLevel").
+
 #endif
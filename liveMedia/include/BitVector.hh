@@ -41,6 +41,8 @@ public:
   unsigned getBits(unsigned numBits); // "numBits" <= 32
   unsigned get1Bit();
   Boolean get1BitBoolean() { return get1Bit() != 0; }
+  unsigned peekBits(unsigned numBits); // "numBits" <= 32
+      // Like "getBits()", except that the bits are not consumed
 
   void skipBits(unsigned numBits);
 
@@ -51,11 +53,23 @@ public:
   unsigned get_expGolomb();
       // Returns the value of the next bits, assuming that they were encoded using an exponential-Golomb code of order 0
 
+private:
+  unsigned cachedBits(unsigned numBits); // 0 < "numBits" <= 32
+  void fillCache();
+  void invalidateCache();
+
 private:
   unsigned char* fBaseBytePtr;
   unsigned fBaseBitOffset;
   unsigned fTotNumBits;
   unsigned fCurBitIndex;
+
+  // Reads are done from a cache of (up to) 64 bits, beginning at bit index "fCacheBitIndex", and left-aligned in "fCache".
+  // (Bits beyond the end of the vector are 0.)  Note that if the underlying bytes are changed other than by "putBits()" or
+  // "put1Bit()", then "setup()" must be called again before reading them.
+  unsigned long long fCache;
+  unsigned fCacheBitIndex;
+  unsigned fCacheNumBits;
 };
 
 // A general bit copy operation:
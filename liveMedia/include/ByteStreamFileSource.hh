@@ -49,6 +49,13 @@ public:
   void seekToByteRelative(int64_t offset, u_int64_t numBytesToStream = 0);
   void seekToEnd(); // to force EOF handling on the next read
 
+  void followGrowingFile(unsigned idleTimeoutSeconds = 0, unsigned pollIntervalMS = 500);
+      // Treats the file as one that is still being written (e.g., by a recorder): At the end of the file, we wait for more
+      // data to be appended (checking every "pollIntervalMS" milliseconds), rather than treating it as EOF.  EOF is
+      // signalled only after the file has not grown for "idleTimeoutSeconds" (0 means never).  If "preferredFrameSize" is
+      // set, then we deliver only complete frames of that size (e.g., whole Transport Stream packets).
+      // (This has no effect on non-seekable files (e.g., pipes).)
+
 protected:
   ByteStreamFileSource(UsageEnvironment& env,
 		       FILE* fid,
@@ -61,6 +68,9 @@ protected:
   static void fileReadableHandler(ByteStreamFileSource* source, int mask);
   void doReadFromFile();
 
+  static void retryReadingFromFile(ByteStreamFileSource* source);
+  void awaitMoreFileData(); // used if we're following a growing file
+
 private:
   // redefined virtual functions:
   virtual void doGetNextFrame();
@@ -77,6 +87,8 @@ private:
   Boolean fHaveStartedReading;
   Boolean fLimitNumBytesToStream;
   u_int64_t fNumBytesToStream; // used iff "fLimitNumBytesToStream" is True
+  Boolean fFollowGrowingFile;
+  unsigned fFollowIdleTimeoutMS, fFollowPollIntervalMS, fFollowIdleMS;
 };
 
 #endif
@@ -0,0 +1,153 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A filter that records the most recent frames of a live stream (up to a given number of seconds, and bytes) in a ring
+// buffer, indexed by presentation time, so that clients can play the stream from a point in the recent past (i.e.,
+// 'time-shift' it), and then catch up with the live stream.
+// C++ header
+
+#ifndef _DVR_BUFFER_HH
+#define _DVR_BUFFER_HH
+
+#ifndef _FRAMED_FILTER_HH
+#include "FramedFilter.hh"
+#endif
+
+class DVRBuffer: public FramedFilter {
+public:
+  static DVRBuffer* createNew(UsageEnvironment& env, FramedSource* inputSource, char const* codecName,
+			      unsigned maxSeconds, unsigned maxBytes);
+      // For a "H264" or "H265" "codecName", "inputSource" must deliver discrete NAL units (e.g., from a
+      // "H264or5VideoStreamDiscreteFramer"), and playback can begin only at a key frame (with the parameter sets that
+      // precede it).  For any other codec, each frame is assumed to be decodable on its own (as for audio, or JPEG).
+      // We keep (at least) the most recent "maxSeconds" of the stream, unless this would need more than "maxBytes" bytes.
+
+  void noteDiscontinuity();
+      // called when the input stream has been paused, or has switched to a new source.  We keep what we have recorded
+      // (so that it can still be played), but record nothing more until the next key frame.
+
+  unsigned bufferSize() const { return fDataSize; } // bytes currently recorded
+  unsigned numRecordedFrames() const { return fNumRecords; }
+  double recordedSeconds() const; // the span of the presentation times of our recorded frames
+
+protected:
+  DVRBuffer(UsageEnvironment& env, FramedSource* inputSource, char const* codecName,
+	    unsigned maxSeconds, unsigned maxBytes);
+      // called only by "createNew()"
+  virtual ~DVRBuffer();
+
+private: // redefined virtual functions:
+  virtual void doGetNextFrame();
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes,
+			 struct timeval presentationTime, unsigned durationInMicroseconds);
+
+  void recordFrame();
+  Boolean makeRoomFor(unsigned frameSize, Boolean isGOPStart, unsigned& offset);
+      // discards old GOPs (if necessary) to make room for a new frame; sets "offset" to where it can be written
+  void growBuffer(unsigned minNewSize);
+  void discardOldestGOP();
+  u_int64_t nextGOPStartRecordNum(); // the start of our second-oldest GOP (or "endRecordNum()", if there's none)
+
+  // Our recorded frames ('records') are numbered consecutively; records [fFirstRecordNum, fFirstRecordNum + fNumRecords)
+  // are currently in our buffer:
+  struct Record {
+    unsigned offset, size;
+    struct timeval presentationTime;
+    u_int64_t frameNum; // the number (in the order in which frames pass through us) of the frame that this is a copy of
+    u_int64_t gopStartRecordNum; // the record that begins this record's GOP (i.e., where playback can start)
+  };
+  Record& record(u_int64_t recordNum) { return fRecords[(fFirstRecordIndex + (unsigned)(recordNum - fFirstRecordNum))%fMaxNumRecords]; }
+  u_int64_t endRecordNum() const { return fFirstRecordNum + fNumRecords; }
+  u_int64_t recordNumAtTime(struct timeval const& time);
+      // returns the start of the GOP containing the most recent record whose presentation time is <= "time"
+      // (or our first record, if there's none).  Our records must not be empty.
+  u_int64_t recordNumAfterFrame(u_int64_t frameNum);
+      // returns the first record of a frame numbered > "frameNum" (or "endRecordNum()", if there's none)
+
+private:
+  friend class DVRBufferReader;
+  Boolean fIsH264or5, fIsH265;
+  unsigned fMaxSeconds, fMaxBytes;
+  Boolean fIsRecording; // False while we're waiting for a key frame, before we can record
+  Boolean fLastRecordWasKey;
+  Boolean fHaveLiveGOP; // True iff our most recent GOP has been recorded since the last discontinuity
+  u_int64_t fLiveGOPStartRecordNum; // if "fHaveLiveGOP"
+
+  u_int64_t fNextFrameNum;
+  Record* fRecords; // a ring of "fMaxNumRecords" entries, beginning at "fFirstRecordIndex"
+  unsigned fFirstRecordIndex, fNumRecords, fMaxNumRecords;
+  u_int64_t fFirstRecordNum;
+  unsigned char* fData; // a ring of "fDataBufferSize" bytes; records are never split around its end
+  unsigned fDataSize, fDataBufferSize, fNextOffset;
+};
+
+
+// A per-client source that plays a stream from a "DVRBuffer" - beginning with the most recent GOP (sped up by
+// "replaySpeedup", as for a "GOPCacheReader"), or from a point chosen by "seekToTime()" (at the speed set by "setScale()") -
+// and then, once it has caught up, the 'live' frames that are read from "liveSource" - which must be a "StreamReplicator"
+// replica of the "DVRBuffer".
+
+class DVRBufferReader: public FramedFilter {
+public:
+  static DVRBufferReader* createNew(UsageEnvironment& env, DVRBuffer& buffer, FramedSource* liveSource,
+				    unsigned replaySpeedup = 4);
+
+  Boolean seekToTime(struct timeval& time);
+      // Continues playing from the start of the GOP containing "time" (or from our oldest GOP, if "time" is older than that).
+      // "time" is updated to the presentation time that we'll actually play from.  Returns False (and leaves us where we
+      // were) if nothing has been recorded yet.
+  void setScale(float scale) { fScale = scale > 0.0f ? scale : 1.0f; } // for playing recorded frames, after a seek
+  Boolean isReplaying() const { return fIsReplaying; }
+
+protected:
+  DVRBufferReader(UsageEnvironment& env, DVRBuffer& buffer, FramedSource* liveSource, unsigned replaySpeedup);
+      // called only by "createNew()", or by subclass constructors
+  virtual ~DVRBufferReader();
+
+  virtual void aboutToDeliverFrame();
+      // called before each frame is delivered (with "fPresentationTime" etc. already set); does nothing by default
+
+private: // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
+
+private:
+  void deliverRecordedFrame();
+  static void afterGettingLiveFrame(void* clientData, unsigned frameSize,
+				    unsigned numTruncatedBytes,
+				    struct timeval presentationTime,
+				    unsigned durationInMicroseconds);
+  void afterGettingLiveFrame(unsigned frameSize, unsigned numTruncatedBytes,
+			     struct timeval presentationTime, unsigned durationInMicroseconds);
+  static void deliverFrame(void* clientData);
+
+private:
+  DVRBuffer& fBuffer;
+  unsigned fReplaySpeedup;
+  float fScale;
+  Boolean fHaveStarted, fIsReplaying, fIsCatchingUp; // "fIsCatchingUp": replaying the most recent GOP, at "fReplaySpeedup"
+  u_int64_t fNextRecordNum; // while replaying
+  u_int64_t fNextFrameNum; // the number of the next live frame that we want
+};
+
+#endif
@@ -0,0 +1,133 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A filter that keeps a copy of the most recent 'group of pictures' (i.e., the NAL units since - and including - the most
+// recent key frame, and the parameter sets that precede it) of a H.264 or H.265 video stream, so that it can be replayed
+// to clients that join the stream later (so that they don't have to wait for the next key frame before they can decode).
+// C++ header
+
+#ifndef _GOP_CACHE_HH
+#define _GOP_CACHE_HH
+
+#ifndef _FRAMED_FILTER_HH
+#include "FramedFilter.hh"
+#endif
+
+class GOPCache: public FramedFilter {
+public:
+  static GOPCache* createNew(UsageEnvironment& env, FramedSource* inputSource,
+			     Boolean isH265, unsigned maxCacheSize);
+      // "inputSource" must deliver discrete NAL units (e.g., from a "H264or5VideoStreamDiscreteFramer").
+      // If caching a GOP would need more than "maxCacheSize" bytes (or would take us over the global limit - see below),
+      // then that GOP isn't cached (and we try again with the next one).
+
+  void flush(); // discards the currently cached GOP (e.g., because the input stream has been paused)
+
+  unsigned cacheSize() const { return fDataSize; } // bytes currently cached
+  unsigned numCachedFrames() const { return fNumFrames; }
+
+  // A limit on the total memory used by all "GOPCache"s (0, the default, means no limit):
+  static void setGlobalMemoryLimit(unsigned long maxBytes) { fGlobalMemoryLimit = maxBytes; }
+  static unsigned long globalMemoryInUse() { return fGlobalMemoryInUse; }
+
+  // How a H.264 or H.265 NAL unit (identified by its first byte) affects the start of a GOP:
+  enum NALKind { KEY_NAL /* a parameter set, or a slice of a key frame */, NEUTRAL_NAL /* e.g., AUD or SEI */, OTHER_NAL };
+  static NALKind nalKind(u_int8_t firstByte, Boolean isH265);
+
+protected:
+  GOPCache(UsageEnvironment& env, FramedSource* inputSource, Boolean isH265, unsigned maxCacheSize);
+      // called only by "createNew()"
+  virtual ~GOPCache();
+
+private: // redefined virtual functions:
+  virtual void doGetNextFrame();
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+                                unsigned numTruncatedBytes,
+                                struct timeval presentationTime,
+                                unsigned durationInMicroseconds);
+  void afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes,
+			 struct timeval presentationTime, unsigned durationInMicroseconds);
+
+  void cacheFrame();
+  Boolean ensureBufferSize(unsigned newDataSize);
+  void abandonGOP(); // stops caching until the next key frame, and frees our buffer
+
+private:
+  friend class GOPCacheReader;
+  struct CachedFrame {
+    unsigned offset, size;
+    struct timeval presentationTime;
+  };
+
+  Boolean fIsH265;
+  unsigned fMaxCacheSize;
+  Boolean fIsCaching, fLastCachedFrameWasKey;
+
+  // Frames are numbered (by "GOPCacheReader"s) in the order in which they pass through us; the cached frames
+  // are numbered [fFirstFrameNum, fFirstFrameNum + fNumFrames):
+  u_int64_t fNextFrameNum, fFirstFrameNum;
+  CachedFrame* fFrames;
+  unsigned fNumFrames, fMaxNumFrames;
+  unsigned char* fData;
+  unsigned fDataSize, fDataBufferSize;
+
+  static unsigned long fGlobalMemoryLimit, fGlobalMemoryInUse;
+};
+
+
+// A per-client source that first delivers the frames cached by a "GOPCache" (faster than real time, by "replaySpeedup"),
+// and then the 'live' frames that are read from "liveSource" - which must be a "StreamReplicator" replica of the "GOPCache".
+
+class GOPCacheReader: public FramedFilter {
+public:
+  static GOPCacheReader* createNew(UsageEnvironment& env, GOPCache& cache, FramedSource* liveSource,
+				   unsigned replaySpeedup = 4);
+
+  Boolean isReplaying() const { return fIsReplaying; }
+
+protected:
+  GOPCacheReader(UsageEnvironment& env, GOPCache& cache, FramedSource* liveSource, unsigned replaySpeedup);
+      // called only by "createNew()", or by subclass constructors
+  virtual ~GOPCacheReader();
+
+  virtual void aboutToDeliverFrame();
+      // called before each frame is delivered (with "fPresentationTime" etc. already set); does nothing by default
+
+private: // redefined virtual functions:
+  virtual void doGetNextFrame();
+  virtual void doStopGettingFrames();
+
+private:
+  void deliverCachedFrame();
+  static void afterGettingLiveFrame(void* clientData, unsigned frameSize,
+				    unsigned numTruncatedBytes,
+				    struct timeval presentationTime,
+				    unsigned durationInMicroseconds);
+  void afterGettingLiveFrame(unsigned frameSize, unsigned numTruncatedBytes,
+			     struct timeval presentationTime, unsigned durationInMicroseconds);
+  static void deliverFrame(void* clientData);
+
+private:
+  GOPCache& fCache;
+  unsigned fReplaySpeedup;
+  Boolean fIsReplaying;
+  u_int64_t fNextFrameNum; // the number of the next frame that we want
+};
+
+#endif
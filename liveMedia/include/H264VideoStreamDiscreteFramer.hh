@@ -31,10 +31,12 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 class H264VideoStreamDiscreteFramer: public H264or5VideoStreamDiscreteFramer {
 public:
   static H264VideoStreamDiscreteFramer*
-  createNew(UsageEnvironment& env, FramedSource* inputSource);
+  createNew(UsageEnvironment& env, FramedSource* inputSource, Boolean includeStartCodeInOutput = False);
+      // If "includeStartCodeInOutput" is True, each output NAL unit is preceded by a 0x00000001 'start code'
+      // (e.g., for feeding it to a "MPEG2TransportStreamFromESSource", or to a byte-stream file).
 
 protected:
-  H264VideoStreamDiscreteFramer(UsageEnvironment& env, FramedSource* inputSource);
+  H264VideoStreamDiscreteFramer(UsageEnvironment& env, FramedSource* inputSource, Boolean includeStartCodeInOutput);
       // called only by createNew()
   virtual ~H264VideoStreamDiscreteFramer();
 
@@ -30,7 +30,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 class H264or5VideoStreamDiscreteFramer: public H264or5VideoStreamFramer {
 protected:
-  H264or5VideoStreamDiscreteFramer(int hNumber, UsageEnvironment& env, FramedSource* inputSource);
+  H264or5VideoStreamDiscreteFramer(int hNumber, UsageEnvironment& env, FramedSource* inputSource,
+                                   Boolean includeStartCodeInOutput);
       // we're an abstract base class
   virtual ~H264or5VideoStreamDiscreteFramer();
 
@@ -47,6 +48,9 @@ protected:
                           unsigned numTruncatedBytes,
                           struct timeval presentationTime,
                           unsigned durationInMicroseconds);
+
+private:
+  Boolean fIncludeStartCodeInOutput;
 };
 
 #endif
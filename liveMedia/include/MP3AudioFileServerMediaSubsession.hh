@@ -68,6 +68,7 @@ protected:
   Boolean fGenerateADUs;
   Interleaving* fInterleaving;
   float fFileDuration;
+  class MP3FrameIndex* fFrameIndex; // shared (via the "MediaFileCache") by all subsessions for our file
 };
 
 #endif
@@ -36,6 +36,10 @@ public:
   void setPresentationTimeScale(unsigned scale);
   void seekWithinFile(double seekNPT, double streamDuration);
       // if "streamDuration" is >0.0, then we limit the stream to that duration, before treating it as EOF
+  void setFrameIndex(class MP3FrameIndex* frameIndex);
+      // If set, "filePlayTime()" and "seekWithinFile()" use this (exact) index of the file's frames - once it has been
+      // built - rather than estimating.  "frameIndex" should come from "MP3FrameIndex::attach()"; we "detach()" it
+      // when we're closed (so it stays valid for as long as we use it, even if the file is later replaced).
 
 protected:
   MP3FileSource(UsageEnvironment& env, FILE* fid);
@@ -64,6 +68,7 @@ private:
   struct timeval fFirstFramePresentationTime; // set on stream init
   Boolean fLimitNumBytesToStream;
   unsigned fNumBytesToStream; // used iff "fLimitNumBytesToStream" is True
+  class MP3FrameIndex* fFrameIndex;
 };
 
 #endif
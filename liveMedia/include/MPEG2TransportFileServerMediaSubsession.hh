@@ -73,6 +73,8 @@ private: // redefined virtual functions
   virtual void seekStream(unsigned clientSessionId, void* streamToken, double& seekNPT, double streamDuration, u_int64_t& numBytes);
   virtual void setStreamScale(unsigned clientSessionId, void* streamToken, float scale);
   virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
+  virtual void handleKeyFrameRequest(FramedSource* inputSource);
+  virtual void closeStreamSource(FramedSource* inputSource);
 
   // The virtual functions thare are usually implemented by "ServerMediaSubsession"s:
   virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
@@ -101,7 +103,10 @@ private:
 
 class ClientTrickPlayState {
 public:
-  ClientTrickPlayState(MPEG2TransportStreamIndexFile* indexFile);
+  ClientTrickPlayState(MPEG2TransportStreamIndexFile* indexFile, char const* tsFileName = NULL);
+      // If "tsFileName" is given, then - for each 'trick play' scale - we stream a pre-rendered (I-frame only) copy of
+      // the file, if one exists (see "MPEG2TransportStreamTrickModeFilter::preRenderedFileName()").
+  virtual ~ClientTrickPlayState();
 
   // Functions to bring "fNPT", "fTSRecordNum" and "fIxRecordNum" in sync:
   unsigned long updateStateFromNPT(double npt, double seekDuration);
@@ -109,7 +114,14 @@ public:
   void updateStateOnPlayChange(Boolean reverseToPreviousVSH);
 
   void handleStreamDeletion();
+      // Called just before our framer gets closed (along with whatever source it is currently reading from)
   void setSource(MPEG2TransportStreamFramer* framer);
+  MPEG2TransportStreamFramer* source() const { return fFramer; }
+
+  Boolean skipToNextCleanPoint();
+      // Moves the stream ahead to the start of the next Video Sequence or GOP header (or H.264 SPS, or H.265 VPS), so that
+      // a client that has lost data can restart decoding from there.  Returns False (doing nothing) in 'trick play' mode,
+      // if there is no later clean point (yet), or if we've already done this within the last second.
 
   void setNextScale(float nextScale) { fNextScale = nextScale; }
   Boolean areChangingScale() const { return fNextScale != fScale; }
@@ -117,6 +129,9 @@ public:
 protected:
   void updateTSRecordNum();
   void reseekOriginalTransportStreamSource();
+  Boolean openPreRenderedSource();
+  void closePreRenderedSource();
+  float preRenderedStartNPT(float scale);
 
 protected:
   MPEG2TransportStreamIndexFile* fIndexFile;
@@ -126,6 +141,14 @@ protected:
   MPEG2TransportStreamFramer* fFramer;
   float fScale, fNextScale, fNPT;
   unsigned long fTSRecordNum, fIxRecordNum;
+
+  // Used instead of "fTrickModeFilter" and "fTrickPlaySource", when we have a pre-rendered 'trick play' file:
+  char const* fTSFileName;
+  ByteStreamFileSource* fPreRenderedSource;
+  MPEG2TransportStreamIndexFile* fPreRenderedIndexFile;
+  unsigned long fPreRenderedTSRecordNum;
+  float fTrickPlayPCRLimit; // relative to the start of the 'trick play' stream; 0 means 'no limit'
+  struct timeval fLastCleanPointSkipTime;
 };
 
 #endif
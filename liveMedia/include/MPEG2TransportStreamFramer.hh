@@ -37,6 +37,7 @@ public:
   createNew(UsageEnvironment& env, FramedSource* inputSource);
 
   u_int64_t tsPacketCount() const { return fTSPacketCount; }
+  void resetTSPacketCount() { fTSPacketCount = 0; fTSPCRCount = 0; } // e.g., after our input source has been repositioned
 
   void changeInputSource(FramedSource* newInputSource) { fInputSource = newInputSource; }
 
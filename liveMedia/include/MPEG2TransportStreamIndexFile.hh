@@ -52,11 +52,18 @@ public:
 	// (Adjust "tsPacketNumber" only if "reverseToPreviousCleanPoint" is True.)
         // (We also return the index record number that we looked up.)
 
+  Boolean lookupNextCleanPoint(unsigned long& tsPacketNumber, float& pcr, unsigned long& indexRecordNumber);
+    // Finds the first 'clean point' (see "rewindToCleanPoint()") at or after the transport packet "tsPacketNumber", and
+    // returns its transport packet number, PCR timestamp, and index record number.
+    // Returns False (leaving the parameters unchanged) if there is no such clean point (yet).
+
   // Miscellaneous functions used to implement 'trick play':
   Boolean readIndexRecordValues(unsigned long indexRecordNum,
 				unsigned long& transportPacketNum, u_int8_t& offset,
 				u_int8_t& size, float& pcr, u_int8_t& recordType);
   float getPlayingDuration();
+      // (If the index file is still growing, this - and the lookup functions above - will take account of new records.
+      //  The duration is cached, and re-read from the file only when the file has grown.)
   void stopReading() { closeFid(); }
 
   int mpegVersion();
@@ -66,10 +73,12 @@ public:
 private:
   MPEG2TransportStreamIndexFile(UsageEnvironment& env, char const* indexFileName);
 
+  void updateNumIndexRecords();
+
   Boolean openFid();
   Boolean seekToIndexRecord(unsigned long indexRecordNumber);
   Boolean readIndexRecord(unsigned long indexRecordNum); // into "fBuf"
-  Boolean readOneIndexRecord(unsigned long indexRecordNum); // closes "fFid" at end
+  Boolean readOneIndexRecord(unsigned long indexRecordNum); // closes "fFid" at end (unless it was already open)
   void closeFid();
 
   u_int8_t recordTypeFromBuf() { return fBuf[0]; }
@@ -81,6 +90,7 @@ private:
 
   Boolean rewindToCleanPoint(unsigned long&ixFound);
       // used to implement "lookupTSPacketNumber()"
+  Boolean isCleanPoint(u_int8_t recordType); // used to implement "lookupNextCleanPoint()"
 
 private:
   char* fFileName;
@@ -90,6 +100,8 @@ private:
   float fCachedPCR;
   unsigned long fCachedTSPacketNumber, fCachedIndexRecordNumber;
   unsigned long fNumIndexRecords;
+  float fPlayingDuration; // cached; read from the last of "fNumIndexRecordsAtPlayingDuration" records
+  unsigned long fNumIndexRecordsAtPlayingDuration;
   unsigned char fBuf[INDEX_RECORD_SIZE]; // used for reading index records from file
 };
 
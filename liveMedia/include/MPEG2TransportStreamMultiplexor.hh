@@ -51,6 +51,7 @@ private:
 private:
   void deliverDataToClient(u_int8_t pid, unsigned char* buffer, unsigned bufferSize,
 			   unsigned& startPositionInBuffer);
+      // appends one Transport Stream packet to the data that we're delivering to the client
 
   void deliverPATPacket();
   void deliverPMTPacket(Boolean hasChanged);
@@ -62,6 +63,7 @@ protected:
 
 private:
   unsigned fOutgoingPacketCounter;
+  unsigned fNumDeliveries; // each delivery is as many packets as fit in the client's buffer
   unsigned fProgramMapVersion;
   u_int8_t fPreviousInputProgramMapVersion, fCurrentInputProgramMapVersion;
       // These two fields are used if we see "program_stream_map"s in the input.
@@ -81,5 +83,12 @@ private:
 // The CRC calculation function that Transport Streams use.  We make this function public
 // here in case it's useful elsewhere:
 u_int32_t calculateCRC(u_int8_t const* data, unsigned dataLength, u_int32_t initialValue = 0xFFFFFFFF);
+    // To compute a CRC over several pieces of data, pass the result for the earlier pieces as "initialValue".
+    // (For a MPEG PSI section - including its CRC_32 field - the result will be 0 if the section is intact.)
+
+unsigned calculateCRCSetMaxSIMDLevel(unsigned maxLevel);
+    // For testing and benchmarking: limits the vector code that "calculateCRC()" may use
+    // (0: none - i.e., the portable code only; 1 (the default): carry-less multiplication ("PCLMULQDQ"), on x86).
+    // Returns the level that will actually be used (which is lower, if the CPU doesn't support "maxLevel").
 
 #endif
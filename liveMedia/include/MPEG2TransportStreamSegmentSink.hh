@@ -0,0 +1,96 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A sink that records a MPEG Transport Stream into a sequence of segment files - each beginning at a key frame, with
+// the stream's most recent PAT and PMT - and lists them (as they are completed) in a HLS-style ".m3u8" playlist.
+// C++ header
+
+#ifndef _MPEG2_TRANSPORT_STREAM_SEGMENT_SINK_HH
+#define _MPEG2_TRANSPORT_STREAM_SEGMENT_SINK_HH
+
+#ifndef _MEDIA_SINK_HH
+#include "MediaSink.hh"
+#endif
+
+class MPEG2TransportStreamSegmentSink: public MediaSink {
+public:
+  static MPEG2TransportStreamSegmentSink*
+  createNew(UsageEnvironment& env, char const* fileNamePrefix,
+	    unsigned segmentSeconds, unsigned maxSegmentBytes = 0,
+	    unsigned bufferSize = 20000);
+      // Segments are written to the files "<fileNamePrefix>-<n>.ts" (n = 0, 1, 2, ...), and are listed in
+      // "<fileNamePrefix>.m3u8".  A new segment is begun at the first key frame after the current segment has become
+      // at least "segmentSeconds" long (or - if "maxSegmentBytes" is non-zero - at least "maxSegmentBytes" large).
+      // The input source must deliver Transport Stream packets (any number per frame) - e.g., a
+      // "MPEG2TransportStreamFromESSource", a "MP2T" "MediaSubsession"s "readSource()", or a "StreamReplicator"
+      // replica of either.  Our memory use is fixed, regardless of how long we record.
+
+  unsigned numSegments() const { return fSegmentNum; } // the number of segments that have been completed
+
+protected:
+  MPEG2TransportStreamSegmentSink(UsageEnvironment& env, FILE* playlistFid, char const* fileNamePrefix,
+				  unsigned segmentSeconds, unsigned maxSegmentBytes, unsigned bufferSize);
+      // called only by createNew()
+  virtual ~MPEG2TransportStreamSegmentSink();
+
+protected: // redefined virtual functions:
+  virtual Boolean continuePlaying();
+
+private:
+  static void afterGettingFrame(void* clientData, unsigned frameSize,
+				unsigned numTruncatedBytes,
+				struct timeval presentationTime,
+				unsigned durationInMicroseconds);
+  void afterGettingFrame(unsigned frameSize, unsigned numTruncatedBytes);
+
+  Boolean handlePacket(unsigned char* pkt);
+      // Returns False if the output could not be written
+  Boolean isSegmentBoundary(unsigned char const* pkt, u_int16_t pid);
+  void noteProgramAssociationTable(unsigned char const* pkt);
+  void noteProgramMapTable(unsigned char const* pkt);
+  Boolean writeOutput(unsigned char const* data, unsigned dataSize);
+  Boolean beginNewSegment();
+  void endSegment();
+  double segmentDuration() const;
+
+private:
+  char* fFileNamePrefix;
+  char const* fSegmentFileNameBase; // "fFileNamePrefix", minus any directory name (for use in the playlist)
+  unsigned fSegmentSeconds, fMaxSegmentBytes;
+  unsigned char* fBuffer;
+  unsigned fBufferSize, fNumLeftoverBytes; // bytes (of an incomplete packet) left from the previous frame
+
+  // The most recent PAT and PMT (each assumed to fit in one packet), and what we learned from them:
+  unsigned char fPAT[188], fPMT[188];
+  Boolean fHavePAT, fHavePMT;
+  u_int16_t fPMT_PID, fPCR_PID, fVideoPID; // 0 means 'unknown'
+  u_int8_t fVideoStreamType;
+  Boolean fLastVideoUnitWasKey;
+
+  // The current segment:
+  FILE* fSegmentFid; // NULL before the first key frame
+  unsigned fSegmentNum, fSegmentBytes;
+  struct timeval fSegmentStartTime, fLastPacketTime; // wall-clock times
+  double fSegmentStartPCR, fLastPCR; // in seconds; <0 if none has been seen in this segment
+
+  // The playlist:
+  FILE* fPlaylistFid;
+  long fTargetDurationPosition; // where the "#EXT-X-TARGETDURATION" value is written
+  unsigned fTargetDuration;
+};
+
+#endif
@@ -48,6 +48,14 @@ public:
   void forgetInputSource() { fInputSource = NULL; }
       // this lets us delete this without also deleting the input Transport Stream
 
+  static char* preRenderedFileName(char const* tsFileName, int scale);
+      // Returns (as a string allocated with new[]) the name of the file that can hold a pre-rendered copy of our output
+      // - for "tsFileName", at "scale" - as a Transport Stream: "<name>.ts" => "<name>.ff<scale>.ts" (for fast forward)
+      // or "<name>.fr<-scale>.ts" (for reverse play).  Such a file (and its ".tsx" index file) is generated - offline -
+      // by "MPEG2TransportStreamIndexer -t <scale>", so that a server can then stream it sequentially, rather than
+      // reading each I-frame from a different place in the original file.
+      // Returns NULL if "tsFileName" doesn't end with ".ts".
+
 protected:
   MPEG2TransportStreamTrickModeFilter(UsageEnvironment& env, FramedSource* inputSource,
 				      MPEG2TransportStreamIndexFile* indexFile, int scale);
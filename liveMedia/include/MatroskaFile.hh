@@ -75,6 +75,7 @@ private:
 
   static void handleEndOfTrackHeaderParsing(void* clientData);
   void handleEndOfTrackHeaderParsing();
+  static void continueScanningClusters(void* clientData);
 
   void addTrack(MatroskaTrack* newTrack, unsigned trackNumber);
   void addCuePoint(double cueTime, u_int64_t clusterOffsetInFile, unsigned blockNumWithinCluster);
@@ -97,9 +98,12 @@ private:
 
   class MatroskaTrackTable* fTrackTable;
   HashTable* fDemuxesTable;
-  class CuePoint* fCuePoints;
+  class CuePointTable* fCuePoints; // NULL until the first cue point is added
   unsigned fChosenVideoTrackNumber, fChosenAudioTrackNumber, fChosenSubtitleTrackNumber;
   class MatroskaFileParser* fParserForInitialization;
+      // If the file has no 'Cues', then this continues (after we've signalled our creation) to scan 'Cluster' headers
+  TaskToken fScanClustersTask;
+  Boolean fHaveSignalledCreation;
 };
 
 // We define our own track type codes as bits (powers of 2), so we can use the set of track types as a bitmap, representing a set:
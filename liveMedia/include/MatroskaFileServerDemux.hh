@@ -38,6 +38,8 @@ public:
     // Note: Unlike most "createNew()" functions, this one doesn't return a new object immediately.  Instead, because this class
     // requires file reading (to parse the Matroska 'Track' headers) before a new object can be initialized, the creation of a new
     // object is signalled by calling - from the event loop - an 'onCreationFunc' that is passed as a parameter to "createNew()". 
+    // (However, if another "MatroskaFileServerDemux" has already parsed the same - unchanged - file, then its "MatroskaFile" object is
+    //  shared (see "MediaFileCache.hh"), and 'onCreationFunc' is called without reading the file - but still from the event loop.)
 
   ServerMediaSubsession* newServerMediaSubsession();
   ServerMediaSubsession* newServerMediaSubsession(unsigned& resultTrackNumber);
@@ -67,8 +69,10 @@ private:
 
   static void onMatroskaFileCreation(MatroskaFile* newFile, void* clientData);
   void onMatroskaFileCreation(MatroskaFile* newFile);
+  static void onCachedMatroskaFile(void* clientData);
 private:
   char const* fFileName; 
+  char* fCacheKey; // identifies our "MatroskaFile" in the "MediaFileCache"
   onCreationFunc* fOnCreation;
   void* fOnCreationClientData;
   MatroskaFile* fOurMatroskaFile;
@@ -129,6 +129,7 @@ public:
 
   MediaLookupTable* mediaTable;
   void* socketTable;
+  class MediaFileCache* mediaFileCache;
 
 protected:
   _Tables(UsageEnvironment& env);
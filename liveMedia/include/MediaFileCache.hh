@@ -0,0 +1,67 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A cache of media file objects (e.g., "MatroskaFile"s or "OggFile"s) whose headers have already been parsed, so that
+// other users of the same (unchanged) file can share them, rather than reading and parsing the file again.
+// C++ header
+
+#ifndef _MEDIA_FILE_CACHE_HH
+#define _MEDIA_FILE_CACHE_HH
+
+#ifndef _MEDIA_HH
+#include "Media.hh"
+#endif
+
+// There is one cache for each "UsageEnvironment".  Each cached object is identified by a "key" string (which should
+// include the file name, plus anything else - e.g., a preferred language - that affected how the file was parsed), and is
+// valid only as long as the file's modification time and size are unchanged.
+
+class MediaFileCache {
+public:
+  static Medium* attach(UsageEnvironment& env, char const* key, char const* fileName);
+      // If an object for "key" is cached, and "fileName" hasn't changed since it was parsed, then returns it (noting that it
+      // has a new user).  Otherwise returns NULL, in which case the caller should create (and then "add()") a new object.
+  static void add(UsageEnvironment& env, char const* key, char const* fileName, Medium* file);
+      // Caches "file" - a newly-created object for "fileName" - replacing any existing object for "key".
+      // The caller becomes the object's first user.
+  static void detach(UsageEnvironment& env, Medium* file);
+      // Called - instead of "Medium::close()" - by each user of an object that was returned by "attach()" or given to "add()",
+      // once it is done with it.  The object is closed once it has no users and is no longer in the cache.
+
+  static unsigned maxUnusedFiles;
+      // The number of objects that we keep cached after they have no users (in case they're used again); if there are more
+      // than this, we close the least recently used.  (Objects that are still being used are always kept.)  Default: 10
+
+private:
+  MediaFileCache();
+  virtual ~MediaFileCache();
+
+  static MediaFileCache* ourCache(UsageEnvironment& env, Boolean createIfNotPresent);
+  static void reclaimIfEmpty(UsageEnvironment& env);
+
+  void retire(class MediaFileCacheEntry* entry);
+  void closeEntry(class MediaFileCacheEntry* entry);
+  void closeUnusedEntriesIfNeeded();
+
+private:
+  HashTable* fEntriesByKey; // the current (not retired) entries
+  HashTable* fEntriesByFile; // all entries, including those that have been retired, but are still being used
+  unsigned fNumUnusedEntries;
+  unsigned fUseCounter; // used to find the least recently used entry
+};
+
+#endif
@@ -0,0 +1,82 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// A class for collecting a snapshot of (e.g., per-stream) metrics, and rendering it in the
+// Prometheus text exposition format (for serving - e.g. - via a "/metrics" HTTP URL).
+// C++ header
+
+#ifndef _MEDIA_METRICS_HH
+#define _MEDIA_METRICS_HH
+
+#ifndef _BOOLEAN_HH
+#include "Boolean.hh"
+#endif
+
+#ifndef MEDIA_METRICS_MAX_LABELS
+#define MEDIA_METRICS_MAX_LABELS 8
+#endif
+
+// The metrics themselves are not kept here; they're the (cheap, per-object, lock-free) counters that the objects being
+// measured (e.g., "RTPSink"s and "RTPSource"s) keep anyway.  A "MediaMetricsWriter" is created only when someone asks for
+// a snapshot; the code that owns each object adds samples for it, and then "text()" renders the result.
+
+class MediaMetricsWriter {
+public:
+  enum MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+  MediaMetricsWriter();
+  virtual ~MediaMetricsWriter();
+
+  // Labels that get attached to each subsequently-added sample (until they're changed or cleared):
+  void setLabel(char const* labelName, char const* labelValue);
+  void setLabel(char const* labelName, unsigned labelValue);
+      // "labelName" must be a static string (it is not copied); "labelValue" is copied (and escaped, if necessary).
+      // Setting a label that's already set replaces its value.
+  void clearLabel(char const* labelName);
+  void clearLabels();
+
+  void addSample(char const* metricName, MetricType metricType, char const* helpText, double value);
+      // "metricName" and "helpText" must be static strings (they are not copied).
+      // Samples for the same metric may be added in any order; they're grouped together (after a single
+      // "# HELP"/"# TYPE" header) in the output.
+  void addHistogram(char const* metricName, char const* helpText, unsigned numBuckets,
+		    double const* bucketUpperBounds, double const* bucketCounts, double sum);
+      // Adds a "HISTOGRAM" sample: one "<metricName>_bucket" series for each bucket (labelled "le"), then "<metricName>_sum"
+      // and "<metricName>_count".  "bucketCounts[i]" is the number of observations in bucket i alone (i.e., those that were
+      // > "bucketUpperBounds[i-1]", and <= "bucketUpperBounds[i]"); the output counts are cumulative, as Prometheus requires.
+      // The last upper bound should be "HUGE_VAL" (i.e., "+Inf").
+
+  char* text(unsigned& resultLength) const;
+      // returns a newly allocated string - of length "resultLength" - that the caller is responsible for delete[]ing.
+
+  static char const* contentType() { return "text/plain; version=0.0.4"; }
+
+private:
+  class MetricFamily* lookupFamily(char const* metricName, MetricType metricType, char const* helpText);
+  void appendSample(class MetricFamily* family, char const* nameSuffix, char const* leValue, double value);
+
+private:
+  class MetricFamily* fFamilies; // in the order in which they were first seen
+  class MetricFamily* fLastFamily;
+  unsigned fNumLabels;
+  struct {
+    char const* name;
+    char* value; // escaped
+  } fLabels[MEDIA_METRICS_MAX_LABELS];
+};
+
+#endif
@@ -50,6 +50,7 @@ public:
 
   char const* fileName() const { return fFileName; }
   unsigned numTracks() const;
+  float fileDuration() const; // in seconds; 0 if unknown (in which case we can't seek within the file)
 
   FramedSource*
   createSourceForStreaming(FramedSource* baseSource, u_int32_t trackNumber,
@@ -74,6 +75,7 @@ private:
 
   void addTrack(OggTrack* newTrack);
   void removeDemux(OggDemux* demux);
+  Boolean lookupSeekPosition(double& seekNPT, u_int64_t& offsetInFile, Boolean& resumeWithLastPacketInPage);
 
 private:
   friend class OggFileParser;
@@ -85,6 +87,7 @@ private:
   class OggTrackTable* fTrackTable;
   HashTable* fDemuxesTable;
   class OggFileParser* fParserForInitialization;
+  class OggPageIndex* fPageIndex; // used to find our duration, and to seek
 };
 
 class OggTrack {
@@ -163,6 +166,7 @@ private:
   friend class OggDemuxedTrack;
   void removeTrack(u_int32_t trackNumber);
   void continueReading(); // called by a demuxed track to tell us that it has a pending read ("doGetNextFrame()")
+  void seekToTime(double& seekNPT);
 
   static void handleEndOfFile(void* clientData);
   void handleEndOfFile();
@@ -37,6 +37,8 @@ public:
     // Note: Unlike most "createNew()" functions, this one doesn't return a new object immediately.  Instead, because this class
     // requires file reading (to parse the Ogg 'Track' headers) before a new object can be initialized, the creation of a new
     // object is signalled by calling - from the event loop - an 'onCreationFunc' that is passed as a parameter to "createNew()". 
+    // (However, if another "OggFileServerDemux" has already parsed the same - unchanged - file, then its "OggFile" object is
+    //  shared (see "MediaFileCache.hh"), and 'onCreationFunc' is called without reading the file - but still from the event loop.)
 
   ServerMediaSubsession* newServerMediaSubsession();
   ServerMediaSubsession* newServerMediaSubsession(u_int32_t& resultTrackNumber);
@@ -52,6 +54,7 @@ public:
 
   OggFile* ourOggFile() { return fOurOggFile; }
   char const* fileName() const { return fFileName; }
+  float fileDuration() const { return fOurOggFile->fileDuration(); }
 
   FramedSource* newDemuxedTrack(unsigned clientSessionId, u_int32_t trackNumber);
     // Used by the "ServerMediaSubsession" objects to implement their "createNewStreamSource()" virtual function.
@@ -64,8 +67,10 @@ private:
 
   static void onOggFileCreation(OggFile* newFile, void* clientData);
   void onOggFileCreation(OggFile* newFile);
+  static void onCachedOggFile(void* clientData);
 private:
   char const* fFileName; 
+  char* fCacheKey; // identifies our "OggFile" in the "MediaFileCache"
   onCreationFunc* fOnCreation;
   void* fOnCreationClientData;
   OggFile* fOurOggFile;
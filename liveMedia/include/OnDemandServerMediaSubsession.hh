@@ -72,6 +72,7 @@ protected: // redefined virtual functions
   virtual void setStreamScale(unsigned clientSessionId, void* streamToken, float scale);
   virtual float getCurrentNPT(void* streamToken);
   virtual FramedSource* getStreamSource(void* streamToken);
+  virtual RTPSink* getStreamRTPSink(void* streamToken);
   virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
 
 protected: // new virtual functions, possibly redefined by subclasses
@@ -89,6 +90,9 @@ protected: // new virtual functions, possibly redefined by subclasses
   virtual void setStreamSourceScale(FramedSource* inputSource, float scale);
   virtual void setStreamSourceDuration(FramedSource* inputSource, double streamDuration, u_int64_t& numBytes);
   virtual void closeStreamSource(FramedSource* inputSource);
+  virtual void handleKeyFrameRequest(FramedSource* inputSource);
+    // Called when a client asks - using a RTCP "PLI" or "FIR" - for a key frame (e.g., because it has lost data).
+    // "inputSource" is the source that's being streamed to the client.  By default, this does nothing.
 
 protected: // new virtual functions, defined by all subclasses
   virtual FramedSource* createNewStreamSource(unsigned clientSessionId,
@@ -162,6 +166,7 @@ public:
   void pause();
   void endPlaying(Destinations* destinations);
   void reclaim();
+  void handleKeyFrameRequest();
 
   unsigned& referenceCount() { return fReferenceCount; }
 
@@ -68,6 +68,7 @@ protected: // redefined virtual functions
 			   ServerRequestAlternativeByteHandler* serverRequestAlternativeByteHandler,
                            void* serverRequestAlternativeByteHandlerClientData);
   virtual float getCurrentNPT(void* streamToken);
+  virtual RTPSink* getStreamRTPSink(void* streamToken);
   virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
 
 protected:
@@ -47,8 +47,26 @@ public:
   void continueAfterLivenessCommand(int resultCode, Boolean serverSupportsGetParameter);
   void continueAfterSETUP();
 
+  static void setMaxConcurrentHandshakes(unsigned maxHandshakes, unsigned handshakeTimeoutSeconds = 10);
+      // Limits the number of "ProxyRTSPClient"s (over all proxied streams) that can be connecting to their back-end server,
+      // and awaiting its "DESCRIBE" response, at the same time.  Others wait (in order) for their turn.  This stops a proxy
+      // of many streams from opening all of its back-end connections at once (at startup, or after a network outage).
+      // (A handshake that has taken longer than "handshakeTimeoutSeconds" no longer counts towards the limit.)
+      // (0, the default, means no limit.)
+  static unsigned numHandshakesInProgress() { return fNumHandshakes; }
+  static unsigned numHandshakesWaiting() { return fNumHandshakesWaiting; }
+
+protected: // redefined virtual functions
+  virtual void handleConnectionLoss();
+
 private:
   void reset();
+  void setOurURL(char const* url); // used when switching to another of our session's back-end URLs
+
+  void requestDESCRIBE(); // sends a "DESCRIBE" now, or - if too many handshakes are in progress - later
+  void startHandshake();
+  void endHandshake(); // lets the next waiting "ProxyRTSPClient" (if any) start its handshake
+  static void handshakeTimeout(void* clientData);
 
   Authenticator* auth() { return fOurAuthenticator; }
 
@@ -73,6 +91,13 @@ private:
   unsigned fNextDESCRIBEDelay; // in seconds
   Boolean fServerSupportsGetParameter, fLastCommandWasPLAY;
   TaskToken fLivenessCommandTask, fDESCRIBECommandTask, fSubsessionTimerTask;
+  Boolean fIsDoingHandshake, fIsWaitingForHandshake;
+  ProxyRTSPClient* fNextWaitingForHandshake;
+  TaskToken fHandshakeTimeoutTask;
+
+  static unsigned fMaxHandshakes, fHandshakeTimeoutSeconds, fNumHandshakes, fNumHandshakesWaiting;
+  static ProxyRTSPClient* fHandshakeQueueHead;
+  static ProxyRTSPClient* fHandshakeQueueTail;
 };
 
 
@@ -109,6 +134,58 @@ public:
 
   char const* url() const;
 
+  virtual void addMetrics(MediaMetricsWriter& writer);
+      // adds samples describing our input (i.e., back-end) stream
+
+  void setGOPCacheSize(unsigned maxBytes, unsigned replaySpeedup = 4);
+      // If "maxBytes" > 0, then each H.264 or H.265 track keeps a copy of its most recent 'group of pictures' (up to "maxBytes"
+      // bytes; see "GOPCache.hh"), which is replayed - "replaySpeedup" times faster than real time - to each client that joins
+      // the stream, before it receives the live stream.  This lets clients start decoding immediately, rather than waiting
+      // for the next key frame.  (The default is 0: no GOP cache.)
+      // Note: This affects only tracks that are set up (i.e., after a back-end "DESCRIBE") from now on.  Also, because each
+      // client of a cached track then gets its own copy of the stream (and its own "RTPSink"), it costs more CPU per client.
+
+  void setDVRWindow(unsigned seconds, unsigned maxBytesPerTrack = 64*1024*1024);
+      // If "seconds" > 0, then each audio, H.264, H.265, JPEG or DV track records its most recent "seconds" (using at most
+      // "maxBytesPerTrack" bytes; see "DVRBuffer.hh"), and clients can play the stream from any point in this 'time-shift'
+      // window, by giving a "PLAY" with an absolute ("Range: clock=<UTC-time>-") start time.  They can then catch up with
+      // the live stream by also giving a "Scale:" > 1.  Clients that don't seek begin with a replay of the most recent GOP
+      // (as for a GOP cache, which this replaces).  (The default is 0: no time-shifting.)
+      // Note: As for a GOP cache, this affects only tracks that are set up from now on, and costs more CPU per client.
+      // Also, the window is recorded only while the back-end stream is playing, so it's best used with "UPSTREAM_HOT".
+
+  // How the back-end stream is managed when we have no clients:
+  enum UpstreamPolicy {
+    UPSTREAM_LAZY, // (the default) start the back-end stream when our first client arrives; "PAUSE" it when our last client leaves
+    UPSTREAM_HOT, // start the back-end stream as soon as it has been described, and keep it playing even when we have no clients
+    UPSTREAM_LINGER // like UPSTREAM_LAZY, except that the back-end stream keeps playing for "lingerSeconds" after our last client leaves
+  };
+  void setUpstreamPolicy(UpstreamPolicy policy, unsigned lingerSeconds = 0);
+      // Note: A back-end stream that's kept playing without clients is still read (and its data discarded), so that it's
+      // current (including any GOP cache) when a client arrives.  This avoids the delay of the back-end "SETUP"/"PLAY",
+      // and of waiting for the next key frame, but costs bandwidth and CPU even while nobody is watching.
+  UpstreamPolicy upstreamPolicy() const { return fUpstreamPolicy; }
+
+  static void setMaxIdleUpstreams(unsigned maxIdleUpstreams);
+      // A limit on the number of back-end streams (over all "ProxyServerMediaSession"s) that can be kept playing, by
+      // UPSTREAM_HOT or UPSTREAM_LINGER, while they have no clients.  (0, the default, means no limit.)  A stream that's
+      // refused because of this limit is "PAUSE"d (i.e., treated as UPSTREAM_LAZY) until it next loses its last client.
+  static unsigned numIdleUpstreams() { return fNumIdleUpstreams; }
+
+  // Failover between alternative back-end streams:
+  void addBackupURL(char const* backupStreamURL);
+      // Adds another "rtsp://" URL for the same stream (e.g., from a backup camera or encoder).  If the current back-end
+      // stream fails, we switch to the next URL in the list (wrapping around after the last one), while keeping our clients'
+      // streams open: Their "RTPSink"s keep their RTP sequence numbers and timestamps continuous across the switch (as long as
+      // the new back-end stream has the same tracks - i.e., the same media types and codecs - as the old one; otherwise our
+      // clients are closed, as before).
+  void setFailureDetection(unsigned noDataTimeoutMS);
+      // If "noDataTimeoutMS" > 0, then the back-end stream is considered to have failed if no RTP packets arrive from it for
+      // about "noDataTimeoutMS" ms (between 1 and 2 times this, in fact) while it's playing.  (Receiving a RTCP "BYE", or losing
+      // our RTSP connection to the back-end server, is always considered to be a failure, once this - or "addBackupURL()" -
+      // has been called.)
+  unsigned numFailovers() const { return fNumFailovers; }
+
   char describeCompletedFlag;//ԳʼΪ0˻˵"Դ"ˡDESCRIBEӦ
     // initialized to 0; set to 1 when the back-end "DESCRIBE" completes.
     // (This can be used as a 'watch variable' in "doEventLoop()".)
@@ -145,8 +222,41 @@ private:
   void continueAfterDESCRIBE(char const* sdpDescription);
   void resetDESCRIBEState(); // undoes what was done by "contineAfterDESCRIBE()"
 
+  Boolean failoverIsEnabled() const { return fNumUpstreamURLs > 1 || fNoDataTimeoutMS > 0; }
+  void scheduleFailover(char const* reason);
+  static void failover(void* clientData);
+  void failover();
+  Boolean switchToNextUpstreamAfterDESCRIBEFailure(); // returns True iff the next back-end URL should be tried right away
+  Boolean resumeAfterFailover(MediaSession* newClientMediaSession);
+  static void checkUpstreamData(void* clientData);
+  void checkUpstreamData();
+
+  void startHotUpstream();
+  void noteNewClient(); // called when a subsession that had no clients gets one
+  Boolean keepUpstreamPlaying(); // called when a subsession loses its last client
+  void releaseIdleUpstream();
+  static void lingerTimeout(void* clientData);
+  void lingerTimeout();
+
 private:
   int fVerbosityLevel;
+  unsigned fGOPCacheSize, fGOPCacheReplaySpeedup;
+  unsigned fDVRSeconds, fDVRMaxBytes;
+  UpstreamPolicy fUpstreamPolicy;
+  unsigned fLingerSeconds;
+  unsigned fNumSubsessionsWithClients;
+  Boolean fIsIdleUpstream; // True iff we count towards "fNumIdleUpstreams"
+  TaskToken fLingerTask;
+  static unsigned fMaxIdleUpstreams, fNumIdleUpstreams;
+  char** fUpstreamURLs; // the first is the URL that we were created with; the others are backups
+  unsigned fNumUpstreamURLs, fCurrentUpstreamIndex, fNumUpstreamsFailedInARow;
+  unsigned fNoDataTimeoutMS;
+  unsigned fNumFailovers;
+  Boolean fIsFailingOver; // True between a back-end failure and the completion of the "DESCRIBE" of its replacement
+  char const* fFailoverReason;
+  TaskToken fFailoverTask, fNoDataCheckTask;
+  Boolean fUpstreamWasPlayingAtLastCheck;
+  unsigned fNumUpstreamPacketsAtLastCheck;
   class PresentationTimeSessionNormalizer* fPresentationTimeSessionNormalizer;
   createNewProxyRTSPClientFunc* fCreateNewProxyRTSPClientFunc;
 };
@@ -162,6 +272,8 @@ private:
 class PresentationTimeSubsessionNormalizer: public FramedFilter {
 public:
   void setRTPSink(RTPSink* rtpSink) { fRTPSink = rtpSink; }
+  void setUpstream(RTPSource* rtpSource, char const* codecName) { fRTPSource = rtpSource; fCodecName = codecName; }
+      // called after switching to a new back-end stream
 
 private:
   friend class PresentationTimeSessionNormalizer;
@@ -198,6 +310,9 @@ public:
   PresentationTimeSubsessionNormalizer*
   createNewPresentationTimeSubsessionNormalizer(FramedSource* inputSource, RTPSource* rtpSource, char const* codecName);
 
+  void resetSynchronization() { fMasterSSNormalizer = NULL; }
+      // called when we switch to a new back-end stream, whose RTCP-synchronized presentation times are unrelated to the old one's
+
 private: // called only from within "~PresentationTimeSubsessionNormalizer":
   friend class PresentationTimeSubsessionNormalizer;
   void normalizePresentationTime(PresentationTimeSubsessionNormalizer* ssNormalizer,
@@ -81,6 +81,16 @@ public:
       // a specific source address and port.  (Note that if both a specific
       // and a general "RR" handler function is set, then both will be called.)
   void unsetSpecificRRHandler(netAddressBits fromAddress, Port fromPort); // equivalent to setSpecificRRHandler(..., NULL, NULL);
+  void setKeyFrameRequestHandler(TaskFunc* handlerTask, void* clientData);
+      // Assigns a handler routine to be called each time that a receiver asks - using a "PLI" (RFC 4585) or a "FIR" (RFC 5104)
+      // feedback message - for a key frame of the media that's sent by our "RTPSink".  (A repeated "FIR" - i.e., one with the
+      // same sequence number as the previous one - is ignored.)  (To turn off handling, call the function again with
+      // "handlerTask" (and "clientData") as NULL.)
+
+  void sendPLI();
+  void sendFIR();
+      // Ask the sender of the media that's received by our "RTPSource" for a key frame, using a "PLI" or a "FIR" feedback
+      // message (sent immediately, within a compound RTCP packet).
 
   Groupsock* RTCPgs() const { return fRTCPInterface.gs(); }
 
@@ -122,6 +132,7 @@ private:
         void enqueueReportBlock(RTPReceptionStats* receptionStats);
   void addSDES();
   void addBYE();
+  void addPSFB(unsigned char fmt);
 
   void sendBuiltPacket();
 
@@ -169,6 +180,10 @@ private:
   TaskFunc* fRRHandlerTask;
   void* fRRHandlerClientData;
   AddressPortLookupTable* fSpecificRRHandlerTable;
+  TaskFunc* fKeyFrameRequestHandlerTask;
+  void* fKeyFrameRequestHandlerClientData;
+  u_int8_t fLastIncomingFIRSeqNum, fNextOutgoingFIRSeqNum;
+  Boolean fHaveReceivedFIR;
 
 public: // because this stuff is used by an external "C" function
   void schedule(double nextTime);
@@ -190,6 +205,12 @@ const unsigned char RTCP_PT_RR = 201;
 const unsigned char RTCP_PT_SDES = 202;
 const unsigned char RTCP_PT_BYE = 203;
 const unsigned char RTCP_PT_APP = 204;
+const unsigned char RTCP_PT_RTPFB = 205; // transport layer feedback (RFC 4585)
+const unsigned char RTCP_PT_PSFB = 206; // payload-specific feedback (RFC 4585)
+
+// Payload-specific feedback message types (the 'FMT' field of a "RTCP_PT_PSFB" packet):
+const unsigned char RTCP_PSFB_PLI = 1; // Picture Loss Indication (RFC 4585)
+const unsigned char RTCP_PSFB_FIR = 4; // Full Intra Request (RFC 5104)
 
 // SDES tags:
 const unsigned char RTCP_SDES_END = 0;
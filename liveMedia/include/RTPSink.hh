@@ -69,6 +69,13 @@ public:
       // returns the number of bytes sent since the last time that we
       // were called, and resets the counter.
 
+  // Running totals (since we were created), for monitoring.  (Unlike the RTCP "SR" counts, these never wrap around.)
+  u_int64_t totNumPacketsSent() const { return fTotNumPacketsSent; }
+  u_int64_t totNumOctetsSent() const { return fTotNumOctetsSent; } // incl RTP hdr
+  u_int64_t totNumFramesSent() const { return fTotNumFramesSent; }
+  u_int64_t totNumTruncatedBytes() const { return fTotNumTruncatedBytes; }
+      // the number of bytes of input frames that were dropped because they didn't fit in our buffer
+
   struct timeval const& creationTime() const { return fCreationTime; }
   struct timeval const& initialPresentationTime() const { return fInitialPresentationTime; }
   struct timeval const& mostRecentPresentationTime() const { return fMostRecentPresentationTime; }
@@ -109,6 +116,7 @@ protected:
   RTPInterface fRTPInterface;
   unsigned char fRTPPayloadType;
   unsigned fPacketCount, fOctetCount, fTotalOctetCount /*incl RTP hdr*/;
+  u_int64_t fTotNumPacketsSent, fTotNumOctetsSent, fTotNumFramesSent, fTotNumTruncatedBytes;
   struct timeval fTotalOctetCountStartTime, fInitialPresentationTime, fMostRecentPresentationTime;
   u_int32_t fCurrentTimestamp;
   u_int16_t fSeqNo;
@@ -63,6 +63,11 @@ public:
   u_int32_t lastReceivedSSRC() const { return fLastReceivedSSRC; }
   // Note: This is the SSRC in the most recently received RTP packet; not *our* SSRC
 
+  // Running totals (since we were created), for monitoring.  (Per-SSRC packet and byte counts are in "receptionStatsDB()".)
+  u_int64_t totNumFramesReceived() const { return fTotNumFramesReceived; } // i.e., delivered to our reader
+  u_int64_t totNumTruncatedBytes() const { return fTotNumTruncatedBytes; }
+      // the number of bytes of received frames that were dropped because they didn't fit in our reader's buffer
+
   Boolean& enableRTCPReports() { return fEnableRTCPReports; }
   Boolean const& enableRTCPReports() const { return fEnableRTCPReports; }
 
@@ -98,6 +103,7 @@ protected:
   Boolean fCurPacketHasBeenSynchronizedUsingRTCP;
   u_int32_t fLastReceivedSSRC;
   class RTCPInstance* fRTCPInstanceForMultiplexedRTCPPackets;
+  u_int64_t fTotNumFramesReceived, fTotNumTruncatedBytes;
 
 private:
   // redefined virtual functions:
@@ -169,6 +169,11 @@ public:
 			      char*& username, char*& password, NetAddress& address, portNumBits& portNum, char const** urlSuffix = NULL);
       // Parses "url" as "rtsp://[<username>[:<password>]@]<server-address-or-name>[:<port>][/<stream-name>]"
       // (Note that the returned "username" and "password" are either NULL, or heap-allocated strings that the caller must later delete[].)
+  static Boolean parseRTSPURLHostName(UsageEnvironment& env, char const* url,
+				      char*& username, char*& password, char* hostName, portNumBits& portNum,
+				      char const** urlSuffix = NULL);
+      // Like "parseRTSPURL()", except that <server-address-or-name> is copied (unresolved) into "hostName" (which must be
+      // at least 100 bytes long), rather than being looked up.
 
   void setUserAgentString(char const* userAgentName);
       // sets an alternative string to be used in RTSP "User-Agent:" headers
@@ -235,6 +240,9 @@ protected:
 				   char const*& protocolStr,
 				   char*& extraHeaders, Boolean& extraHeadersWereAllocated);
       // used to implement "sendRequest()"; subclasses may reimplement this (e.g., when implementing a new command name)
+  virtual void handleConnectionLoss();
+      // called when our TCP connection to the server fails, or is closed by the server (before the response handlers of any
+      // still-pending requests are called with the error).  The default implementation does nothing.
 
 private: // redefined virtual functions
   virtual Boolean isRTSPClient() const;
@@ -261,6 +269,7 @@ private:
   void resetResponseBuffer();
   int openConnection(); // -1: failure; 0: pending; 1: success
   int connectToServer(int socketNum, portNumBits remotePortNum); // used to implement "openConnection()"; result values are the same
+  int connectToServerAddress(netAddressBits serverAddress); // used to implement "openConnection()"; result values are the same
   char* createAuthenticatorString(char const* cmd, char const* url);
   void handleRequestError(RequestRecord* request);
   Boolean parseResponseCode(char const* line, unsigned& responseCode, char const*& responseString);
@@ -296,6 +305,8 @@ private:
   // Support for asynchronous connections to the server:
   static void connectionHandler(void*, int /*mask*/);
   void connectionHandler1();
+  static void dnsLookupHandler(void* clientData, netAddressBits serverAddress);
+  void dnsLookupHandler1(netAddressBits serverAddress);
 
   // Support for handling data sent back by a server:
   static void incomingDataHandler(void*, int /*mask*/);
@@ -310,6 +321,7 @@ protected:
 
 private:
   portNumBits fTunnelOverHTTPPortNum;
+  portNumBits fServerPortNum; // the port that we connect to (set by "openConnection()")
   char* fUserAgentHeaderStr;
   unsigned fUserAgentHeaderStrLen;
   int fInputSocketNum, fOutputSocketNum;
@@ -38,6 +38,54 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 
 #define RTSP_PARAM_STRING_MAX 200
 
+#define RTSP_INITIAL_NUM_INDEXED_HEADERS 50 // the index grows, if a request has more headers than this
+
+// An index of the header lines of a RTSP (or HTTP) request.  It's built incrementally - one line at a time, as each
+// <CR><LF> is seen - so that the request gets scanned just once, no matter how many headers are later looked up.
+// Entries point into the caller's request buffer (nothing is copied), so they're valid only while that buffer is.
+class RTSPRequestHeaderIndex {
+public:
+  RTSPRequestHeaderIndex();
+  virtual ~RTSPRequestHeaderIndex();
+
+  void reset();
+  void addLine(char* line, unsigned lineSize);
+      // "line" is a complete line of the request, not including its terminating <CR><LF>.
+      // The first non-empty line (the request line) is remembered separately; subsequent lines are indexed as headers.
+      // If a header line has whitespace between its name and the ':' (e.g., "CSeq : 1"), then the name is moved (in place)
+      // to end at the ':' (giving " CSeq: 1"), so that routines that scan the line for "<name>:" will also find it.
+
+  char const* requestLine(unsigned& requestLineSize) const;
+      // returns NULL if no request line has been seen yet
+  char const* lookupLine(char const* headerName) const;
+      // Returns the start of the (first) line for the header named "headerName" (case insensitive), or NULL if none.
+  char const* lookupValue(char const* headerName, unsigned& valueSize) const;
+      // As above, but returns just the header's value (with any leading or trailing whitespace removed).
+  Boolean copyValue(char const* headerName, char* resultStr, unsigned resultMaxSize) const;
+      // As above, but copies the value (as a '\0'-terminated string) to "resultStr", returning False (and an empty string)
+      // if the header is not present, or its value will not fit.  (The value is never truncated; this is how the original,
+      // unindexed parsers treated a "CSeq:" - and the "x-sessioncookie:" and "Accept:" headers - that was too long.)
+
+  unsigned numHeaders() const { return fNumHeaders; }
+
+private:
+  // We own "fHeaders", so we can't be copied:
+  RTSPRequestHeaderIndex(RTSPRequestHeaderIndex const&); // not implemented
+  RTSPRequestHeaderIndex& operator=(RTSPRequestHeaderIndex const&); // not implemented
+
+  int lookup(char const* headerName) const;
+
+private:
+  char const* fRequestLine;
+  unsigned fRequestLineSize;
+  struct HeaderEntry {
+    char const* line;
+    unsigned nameSize;
+    unsigned valueOffset, valueSize;
+  }* fHeaders;
+  unsigned fNumHeaders, fMaxNumHeaders;
+};
+
 Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize,
 			       char *resultCmdName,
 			       unsigned resultCmdNameMaxSize,
@@ -51,6 +99,21 @@ Boolean parseRTSPRequestString(char const *reqStr, unsigned reqStrSize,
 			       unsigned resultSessionIdMaxSize,
 			       unsigned& contentLength);
 
+Boolean parseRTSPRequestString(RTSPRequestHeaderIndex const& headers,
+			       char *resultCmdName,
+			       unsigned resultCmdNameMaxSize,
+			       char* resultURLPreSuffix,
+			       unsigned resultURLPreSuffixMaxSize,
+			       char* resultURLSuffix,
+			       unsigned resultURLSuffixMaxSize,
+			       char* resultCSeq,
+			       unsigned resultCSeqMaxSize,
+			       char* resultSessionId,
+			       unsigned resultSessionIdMaxSize,
+			       unsigned& contentLength);
+    // As above, but using a request whose lines have already been indexed: Only the request line is parsed here;
+    // "CSeq:", "Session:" and "Content-Length:" are found using the index, rather than by rescanning the request.
+
 Boolean parseRangeParam(char const* paramStr, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 Boolean parseRangeHeader(char const* buf, double& rangeStart, double& rangeEnd, char*& absStartTime, char*& absEndTime, Boolean& startTimeIsNow);
 
@@ -30,6 +30,12 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #ifndef _DIGEST_AUTHENTICATION_HH
 #include "DigestAuthentication.hh"
 #endif
+#ifndef _RTSP_COMMON_HH
+#include "RTSPCommon.hh"
+#endif
+
+class TCPStreamSink; // forward
+class RTSPServerWorkers; // forward
 
 // A data structure used for optional user/password authentication:
 
@@ -141,6 +147,21 @@ public:
 	// Returns True iff the specified port can be used in this way (i.e., it's not already being used for a separate HTTP server).
 	// Note: RTSP-over-HTTP tunneling is described in http://developer.apple.com/quicktime/icefloe/dispatch028.html
 	portNumBits httpServerPortNum() const; // in host byte order.  (Returns 0 if not present.)
+
+	void setConnectionLimits(unsigned maxConnections, unsigned maxConnectionsPerClientAddress = 0);
+	// Limits the number of simultaneous client connections: in total, and from any one client IP address.
+	// A connection beyond either limit is closed as soon as it's accepted (without allocating any state for it).
+	// 0 (the default, for each) means 'no limit'.
+	unsigned numClientConnections() const;
+
+	void enableMetrics(char const* urlSuffix = "metrics");
+	// Arranges for a HTTP "GET" of ".../<urlSuffix>" - on our RTSP-over-HTTP tunneling port (if any), or on our RTSP port - to return
+	// a snapshot of our metrics (per-track packet, byte and frame counts, loss/jitter/RTT from receivers' RTCP "RR"s, etc.),
+	// in Prometheus text format.  (Note that this hides any stream of the same name from HTTP streaming.)
+	// This is off by default.  The request is subject to the same "specialClientAccessCheck()" and authentication (if we have
+	// an authentication database) as RTSP commands.  A NULL "urlSuffix" disables this again.
+	virtual void addMetrics(MediaMetricsWriter& writer);
+	// Adds samples for all of our metrics to "writer".  (A subclass that redefines this should also call this implementation.)
 	virtual ~RTSPServer();
 protected:
 	RTSPServer(UsageEnvironment& env,
@@ -197,6 +218,7 @@ public: // should be protected, but some old compilers complain otherwise
 			char* fProxyURLSuffix;
 		};
 	protected:
+		friend class RTSPServer;
 		friend class RTSPClientSession;
 		// Make the handler functions for each command virtual, to allow subclasses to reimplement them, if necessary:
 		virtual void handleCmd_OPTIONS();
@@ -211,6 +233,8 @@ public: // should be protected, but some old compilers complain otherwise
 		virtual void handleCmd_bad();
 		virtual void handleCmd_notSupported();
 		virtual void handleCmd_notFound();
+		virtual void handleCmd_redirectToNewConnection();
+		// used (when our streams are shared among worker processes) for a request for a stream that another process serves
 		virtual void handleCmd_sessionNotFound();
 		virtual void handleCmd_unsupportedTransport();
 		// Support for optional RTSP-over-HTTP tunneling:
@@ -224,18 +248,25 @@ public: // should be protected, but some old compilers complain otherwise
 		virtual void handleHTTPCmd_TunnelingGET(char const* sessionCookie);
 		virtual Boolean handleHTTPCmd_TunnelingPOST(char const* sessionCookie, unsigned char const* extraData, unsigned extraDataSize);
 		virtual void handleHTTPCmd_StreamingGET(char const* urlSuffix, char const* fullRequestStr);
+		virtual void handleHTTPCmd_metricsGET();
 	protected:
 		UsageEnvironment& envir() { return fOurServer.envir(); }
 		void resetRequestBuffer();
+		void allocateRequestBuffer();
 		void closeSockets();
 		static void incomingRequestHandler(void*, int /*mask*/);
 		void incomingRequestHandler1();
 		static void handleAlternativeRequestByte(void*, u_int8_t requestByte);
 		void handleAlternativeRequestByte1(u_int8_t requestByte);
 		void handleRequestBytes(int newBytesRead);
-		Boolean authenticationOK(char const* cmdName, char const* urlSuffix, char const* fullRequestStr);
+		char const* requestHeaderLine(char const* headerName, char const* fullRequestStr) const;
+		Boolean authenticationOK(char const* cmdName, char const* urlSuffix, char const* fullRequestStr,
+			Boolean isHTTPRequest = False);
+		// If "isHTTPRequest" is True, then any "401 Unauthorized" response is set up as a HTTP (rather than a RTSP) response.
+		void setUnauthorizedResponse(Boolean isHTTPRequest, Boolean includeChallenge = False);
 		void changeClientInputSocket(int newSocketNum, unsigned char const* extraData, unsigned extraDataSize);
 		// used to implement RTSP-over-HTTP tunneling
+		static void afterSendingMetrics(void* clientData);
 		static void continueHandlingREGISTER(ParamsForREGISTER* params);
 		virtual void continueHandlingREGISTER1(ParamsForREGISTER* params);
 
@@ -249,15 +280,18 @@ public: // should be protected, but some old compilers complain otherwise
 		Boolean fIsActive;
 		int fClientInputSocket, fClientOutputSocket;
 		struct sockaddr_in fClientAddr;
-		unsigned char fRequestBuffer[RTSP_BUFFER_SIZE];
+		unsigned char* fRequestBuffer; // RTSP_BUFFER_SIZE bytes, allocated only once the client has sent us something
 		unsigned fRequestBytesAlreadySeen, fRequestBufferBytesLeft;
 		unsigned char* fLastCRLF;
+		RTSPRequestHeaderIndex fRequestHeaders; // the lines of the current request, indexed as they arrive
 		unsigned char fResponseBuffer[RTSP_BUFFER_SIZE];
 		unsigned fRecursionCount;
 		char const* fCurrentCSeq;
 		Authenticator fCurrentAuthenticator; // used if access control is needed
 		char* fOurSessionCookie; // used for optional RTSP-over-HTTP tunneling
 		unsigned fBase64RemainderCount; // used for optional RTSP-over-HTTP tunneling (possible values: 0,1,2,3)
+		FramedSource* fMetricsSource; // used to send a response to a HTTP "GET" of our metrics
+		TCPStreamSink* fMetricsSink; // ditto
 	};
 
 	// The state of an individual client session (using one or more sequential TCP connections) handled by a RTSP server:
@@ -351,6 +385,11 @@ private:
 	void incomingConnectionHandlerHTTP1();
 
 	void incomingConnectionHandler(int serverSocket);
+	Boolean admitConnection(struct sockaddr_in const& clientAddr,
+				unsigned numOtherConnections = 0, unsigned numOtherConnectionsFromClientAddress = 0);
+	// "numOther..." are connections that count toward our limits, but that we're not handling ourself (see "RTSPServerWorkers")
+	void noteNewClientConnection(struct sockaddr_in const& clientAddr);
+	void noteClosedClientConnection(struct sockaddr_in const& clientAddr);
 
 protected:
 	Port fRTSPServerPort;
@@ -360,6 +399,7 @@ private:
 	friend class RTSPClientSession;
 	friend class ServerMediaSessionIterator;
 	friend class RegisterRequestRecord;
+	friend class RTSPServerWorkers;
 	int fRTSPServerSocket;
 	int fHTTPServerSocket; // for optional RTSP-over-HTTP tunneling
 	Port fHTTPServerPort; // ditto
@@ -372,6 +412,10 @@ private:
 	unsigned fRegisterRequestCounter;
 	UserAuthenticationDatabase* fAuthDB;
 	unsigned fReclamationTestSeconds;
+	unsigned fMaxConnections, fMaxConnectionsPerClientAddress; // 0 => no limit
+	HashTable* fNumConnectionsPerClientAddress; // maps client IP addresses to their number of connections (if limited)
+	char* fMetricsURLSuffix; // non-NULL iff "enableMetrics()" was called
+	RTSPServerWorkers* fWorkers; // non-NULL iff our streams are shared among worker processes (set by "RTSPServerWorkers")
 };
 
 
@@ -0,0 +1,122 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// "liveMedia"
+// Copyright (c) 1996-2014 Live Networks, Inc.  All rights reserved.
+// Shares out a RTSP server's streams among several worker processes - each with its own event loop - so that the server
+// can use more than one CPU core.  The original process accepts each incoming connection, and passes it to the worker
+// that owns the first stream that the connection's requests name.  (Requests that name no stream - e.g., "OPTIONS *" -
+// are answered by the original process itself, until one does.)  The server's connection limits (see
+// "RTSPServer::setConnectionLimits()") apply to all processes together: the original process checks them, counting each
+// connection that it has passed to a worker until the worker reports that it has closed.
+// C++ header
+
+#ifndef _RTSP_SERVER_WORKERS_HH
+#define _RTSP_SERVER_WORKERS_HH
+
+#ifndef _RTSP_SERVER_HH
+#include "RTSPServer.hh"
+#endif
+
+class RTSPServerWorkers: public Medium {
+public:
+  static RTSPServerWorkers* createNew(RTSPServer& server, unsigned numWorkers);
+      // Forks "numWorkers" worker processes, each of which returns from here with its own copy of "server" (and of
+      // everything else).  From then on, only the original process accepts connections on "server"s port(s).
+      // Call this after creating "server" (and setting up its RTSP-over-HTTP tunneling, if any), but before adding any
+      // streams to it, or starting any other network activity.  Then, in each worker, add (only) the streams for which
+      // "ownsStream()" is True.
+      // Returns NULL (in the original process) if the workers could not be created (e.g., on Windows, which has no "fork()").
+
+  int workerNum() const { return fWorkerNum; } // 0 .. numWorkers-1 in a worker; -1 in the original process
+  Boolean isWorker() const { return fWorkerNum >= 0; }
+  unsigned numWorkers() const { return fNumWorkers; }
+
+  Boolean ownsStream(char const* streamName) { return workerForStream(streamName) == fWorkerNum; }
+
+  void signalWorkers(int sig); // in the original process: sends "sig" to each worker (e.g., to pass on a "SIGHUP")
+
+  Boolean requestIsForAnotherProcess(char const* cmdName, char const* urlPreSuffix, char const* urlSuffix);
+      // Used by our "RTSPServer" (in each process) to check whether a request - on a connection that was routed to us
+      // because of an earlier request - names a stream that belongs to another worker.  (If so, the client is redirected
+      // to the request's URL, so that it reconnects, and gets routed to the right worker.)
+
+protected:
+  RTSPServerWorkers(RTSPServer& server, unsigned numWorkers); // called only by "createNew()", or by subclass constructors
+  virtual ~RTSPServerWorkers();
+
+  Boolean forkWorkers(); // called only by "createNew()" (or by subclass "createNew()"s)
+
+protected: // new virtual functions, possibly redefined by subclasses
+  virtual int workerForRequest(char const* cmdName, char const* urlPath);
+      // Returns the worker that should handle a request "cmdName" (e.g., "DESCRIBE", or a HTTP "GET"), for "urlPath" (the
+      // request's URL, minus any "rtsp://<host>[:<port>]" prefix and leading "/").  A connection is routed by the first of
+      // its requests for which this is not -1.  (Until then, the original process answers "OPTIONS" - and "GET_PARAMETER"
+      // or "SET_PARAMETER" on "*" - itself, and hands any other request - with its connection - to its own server.)
+      // The default implementation sends "REGISTER"s to worker 0, and everything else by "workerForStream()".
+  virtual int workerForStream(char const* streamName);
+      // The default implementation hashes the first component (i.e., up to any "/") of "streamName".  (Using just the
+      // first component means that the URLs of a stream's tracks - e.g., "<stream-name>/track1" - go to the same worker.)
+      // A stream name of "" or "*" (e.g., for "OPTIONS *") gets -1.
+  virtual void setUpRespawnedWorker();
+      // If a worker dies, then (after a short delay) the original process forks a new one to replace it.  This is then
+      // called in the new worker, which must be set up (e.g., add its streams to the server) just as the code that called
+      // "createNew()" set up the original workers.  The default implementation does nothing.
+
+private:
+  static void incomingConnectionHandlerRTSP(void*, int /*mask*/);
+  static void incomingConnectionHandlerHTTP(void*, int /*mask*/);
+  void incomingConnectionHandler(int serverSocket);
+  Boolean dispatchConnection(int clientSocket, struct sockaddr_in const& clientAddr, int workerNum);
+      // returns False if the connection could not be passed to the worker (in which case the caller still owns "clientSocket")
+  friend class PendingConnection;
+  void notePendingConnection(struct sockaddr_in const& clientAddr, Boolean isNew);
+  Boolean admitConnection(struct sockaddr_in const& clientAddr); // in the original process
+  friend class RTSPServer;
+  void reportClosedConnection(struct sockaddr_in const& clientAddr); // in a worker
+  char const* allowedCommandNames();
+
+  static void incomingHandOffHandler(void*, int /*mask*/);
+  void incomingHandOffHandler1();
+
+  struct WorkerProcess;
+  Boolean forkWorker(unsigned workerNum); // returns True in both processes (with "isWorker()" True in the new one)
+  void becomeWorker(unsigned workerNum, int handOffSocket);
+  static void workerSocketHandler(void*, int /*mask*/);
+  void workerSocketHandler1(WorkerProcess& worker);
+  void noteHandedOffConnection(WorkerProcess& worker, netAddressBits clientAddress);
+  void noteClosedHandedOffConnection(WorkerProcess& worker, netAddressBits clientAddress);
+  void workerDied(unsigned workerNum);
+  static void respawnWorker(void* clientData);
+
+private:
+  RTSPServer& fServer;
+  unsigned fNumWorkers;
+  int fWorkerNum;
+  struct WorkerProcess {
+    RTSPServerWorkers* workers;
+    unsigned workerNum;
+    int socket; // our end of the socket pair that we pass the worker's connections over (-1 if the worker has died)
+    int pid;
+    TaskToken respawnTask;
+    HashTable* connectionsByClientAddress; // the number of connections we've passed to the worker that are still open,
+    unsigned numConnections;               // from each client address, and in total
+  }* fWorkerProcesses; // in the original process only
+  int fHandOffSocket; // in a worker: our end of the socket pair that we receive connections over
+  class PendingConnection* fPendingConnections; // (in the original process) connections that haven't yet named a stream
+  unsigned fNumPendingConnections;
+};
+
+#endif
@@ -38,6 +38,8 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #endif
 
 class ServerMediaSubsession; // forward
+class RTPSink; // forward
+class MediaMetricsWriter; // forward
 
 class ServerMediaSession : public Medium {
 public:
@@ -71,6 +73,10 @@ public:
 	void decrementReferenceCount() { if (fReferenceCount > 0) --fReferenceCount; }
 	Boolean& deleteWhenUnreferenced() { return fDeleteWhenUnreferenced; }
 
+	virtual void addMetrics(MediaMetricsWriter& writer);
+	// Adds samples for any metrics that are specific to this session - e.g., for the input stream of a proxy.
+	// (The default implementation does nothing; the metrics of our clients' streams are added by "RTSPServer".)
+
 	void deleteAllSubsessions();
 	// Removes and deletes all subsessions added by "addSubsession()", returning us to an 'empty' state
 	// Note: If you have already added this "ServerMediaSession" to a "RTSPServer" then, before calling this function,
@@ -172,6 +178,8 @@ public:
 	virtual void setStreamScale(unsigned clientSessionId, void* streamToken, float scale);
 	virtual float getCurrentNPT(void* streamToken);
 	virtual FramedSource* getStreamSource(void* streamToken);
+	virtual RTPSink* getStreamRTPSink(void* streamToken);
+	// returns the "RTPSink" that's used to deliver this stream (or NULL, if none), so that its statistics can be monitored
 	virtual void deleteStream(unsigned clientSessionId, void*& streamToken);
 
 	virtual void testScaleFactor(float& scale); // sets "scale" to the actual supported scale
@@ -32,6 +32,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "H264VideoFileSink.hh"
 #include "H265VideoFileSink.hh"
 #include "OggFileSink.hh"
+#include "MPEG2TransportStreamSegmentSink.hh"
 #include "BasicUDPSink.hh"
 #include "GSMAudioRTPSink.hh"
 #include "H263plusVideoRTPSink.hh"
@@ -95,8 +96,11 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "AudioInputDevice.hh"
 #include "WAVAudioFileSource.hh"
 #include "StreamReplicator.hh"
+#include "GOPCache.hh"
+#include "DVRBuffer.hh"
 #include "RTSPRegisterSender.hh"
 #include "RTSPServerSupportingHTTPStreaming.hh"
+#include "RTSPServerWorkers.hh"
 #include "RTSPClient.hh"
 #include "SIPClient.hh"
 #include "QuickTimeFileSink.hh"
@@ -125,5 +129,7 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "OggFileServerDemux.hh"
 #include "ProxyServerMediaSession.hh"
 #include "DarwinInjector.hh"
+#include "MediaMetrics.hh"
+#include "MediaFileCache.hh"
 
 #endif
@@ -29,14 +29,31 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #pragma comment(lib,"libUsageEnvironmentD")
 #endif
 
-
-
+static void usage(UsageEnvironment& env, char const* progName) {
+  env << "Usage: " << progName << " [-m [-e]]\n";
+  env << "\t-m: also serve our metrics (in Prometheus text format), using HTTP, at \"/metrics\"\n";
+  env << "\t-e: also record (and include in our metrics) the timing of our event loop, and of each handler that it calls\n";
+  exit(1);
+}
 
 int main(int argc, char** argv) {
   // Begin by setting up our usage environment:
   TaskScheduler* scheduler = BasicTaskScheduler::createNew();
   UsageEnvironment* env = BasicUsageEnvironment::createNew(*scheduler);
 
+  // Parse the command line:
+  Boolean serveMetrics = False, recordEventLoopStats = False;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-m") == 0) {
+      serveMetrics = True;
+    } else if (strcmp(argv[i], "-e") == 0) {
+      recordEventLoopStats = True;
+    } else {
+      usage(*env, argv[0]);
+    }
+  }
+  if (recordEventLoopStats && !serveMetrics) usage(*env, argv[0]);
+
   UserAuthenticationDatabase* authDB = NULL;
 #ifdef ACCESS_CONTROL
   // To implement client access control to the RTSP server, do the following:
@@ -97,6 +114,14 @@ int main(int argc, char** argv) {
     *env << "(RTSP-over-HTTP tunneling is not available.)\n";
   }
 
+  // If requested, also serve our metrics (in Prometheus text format) via HTTP.  (These are subject to the same access control
+  // - if any - as our streams.):
+  if (serveMetrics) {
+    rtspServer->enableMetrics("metrics");
+    *env << "(Our metrics are at \"/metrics\" - using HTTP - on each of the ports above.)\n";
+    if (recordEventLoopStats) env->taskScheduler().eventLoopStats()->enable();
+  }
+
   env->taskScheduler().doEventLoop(); // does not return
   return 0; // only to prevent compiler warning
 }
@@ -21,6 +21,13 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 #include "BasicUsageEnvironment.hh"
  
 #include <memory>
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+#if !defined(__WIN32__) && !defined(_WIN32)
+#include <signal.h>
+#define USE_SIGNALS 1
+#endif
 
 #pragma comment(lib,"ws2_32")
 #if defined(_DEBUG)
@@ -45,6 +52,17 @@ char* password = NULL;
 Boolean proxyREGISTERRequests = True;
 char* usernameForREGISTER = NULL;
 char* passwordForREGISTER = NULL;
+unsigned gopCacheSizeKB = 0; // per stream; 0 means no GOP cache
+unsigned dvrSeconds = 0; // the 'time-shift' window recorded for each stream; 0 means no time-shifting
+unsigned dvrSizeKB = 64*1024; // the most memory that each track's time-shift window may use
+ProxyServerMediaSession::UpstreamPolicy upstreamPolicy = ProxyServerMediaSession::UPSTREAM_LAZY;
+unsigned upstreamLingerSeconds = 0;
+unsigned maxConcurrentHandshakes = 32; // back-end connections being opened (and "DESCRIBE"d) at once; 0 means no limit
+unsigned confCheckIntervalSeconds = 0; // how often to check whether the conf file has changed; 0 means never
+unsigned noDataTimeoutMS = 0; // fail over (to a stream's next URL) if no data arrives for this long; 0 means never
+unsigned numWorkers = 0; // worker processes to share our streams among; 0 means serve all streams from this process
+Boolean serveMetrics = False; // whether to serve our metrics via HTTP (at "/metrics")
+Boolean recordEventLoopStats = False; // whether to record (and include in our metrics) the timing of our event loop
 
 static RTSPServer* createRTSPServer(Port port) {
 	if (proxyREGISTERRequests) {
@@ -55,28 +73,299 @@ static RTSPServer* createRTSPServer(Port port) {
 	}
 }
 
-void parse_conf_file()
+static void setUpStreams(); // forward
+
+// When we use worker processes, each worker's metrics are at "metrics-<worker-num>" (with the original process's own
+// metrics - just its event loop and connections - at "metrics").  Also, worker 0 handles incoming "REGISTER" requests,
+// so the streams that it creates for them must be routed to it:
+class ProxyServerWorkers: public RTSPServerWorkers {
+public:
+	static ProxyServerWorkers* createNew(RTSPServer& server, unsigned numWorkers) {
+		ProxyServerWorkers* workers = new ProxyServerWorkers(server, numWorkers);
+		if (!workers->forkWorkers()) {
+			Medium::close(workers);
+			return NULL;
+		}
+		return workers;
+	}
+
+protected:
+	ProxyServerWorkers(RTSPServer& server, unsigned numWorkers)
+		: RTSPServerWorkers(server, numWorkers) {
+	}
+
+	virtual int workerForStream(char const* streamName) {
+		unsigned workerNum;
+		char extra;
+		if (strcmp(streamName, "metrics") == 0) return -1;
+		if (sscanf(streamName, "metrics-%u%c", &workerNum, &extra) == 1) return (int)workerNum;
+		if (strncmp(streamName, "registeredProxyStream-", 22) == 0) return 0;
+		return RTSPServerWorkers::workerForStream(streamName);
+	}
+
+	virtual void setUpRespawnedWorker() {
+		setUpStreams();
+	}
+};
+
+ProxyServerWorkers* workers = NULL;
+
+// Parses an 'upstream policy': "lazy", "hot" or "linger=<seconds>":
+static Boolean parseUpstreamPolicy(char const* str, ProxyServerMediaSession::UpstreamPolicy& policy, unsigned& lingerSeconds) {
+	if (strcmp(str, "lazy") == 0) {
+		policy = ProxyServerMediaSession::UPSTREAM_LAZY;
+	}
+	else if (strcmp(str, "hot") == 0) {
+		policy = ProxyServerMediaSession::UPSTREAM_HOT;
+	}
+	else if (sscanf(str, "linger=%u", &lingerSeconds) == 1) {
+		policy = ProxyServerMediaSession::UPSTREAM_LINGER;
+	}
+	else {
+		return False;
+	}
+	return True;
+}
+
+// Each stream that we created from the conf file, with the settings that we created it with.
+// (We remember these so that - when the conf file is reloaded - we can tell which streams have changed.)
+class ConfStream {
+public:
+	ConfStream(char const* url, char const* backupURLs, unsigned gopCacheSizeKB, unsigned dvrSeconds,
+		ProxyServerMediaSession::UpstreamPolicy upstreamPolicy, unsigned lingerSeconds)
+		: fURL(strDup(url)), fBackupURLs(strDup(backupURLs)), fGOPCacheSizeKB(gopCacheSizeKB), fDVRSeconds(dvrSeconds),
+		fUpstreamPolicy(upstreamPolicy), fLingerSeconds(lingerSeconds) {
+	}
+	virtual ~ConfStream() { delete[] fURL; delete[] fBackupURLs; }
+
+	Boolean sameAs(ConfStream const& other) const {
+		return strcmp(fURL, other.fURL) == 0 && strcmp(fBackupURLs, other.fBackupURLs) == 0
+			&& fGOPCacheSizeKB == other.fGOPCacheSizeKB && fDVRSeconds == other.fDVRSeconds
+			&& fUpstreamPolicy == other.fUpstreamPolicy && fLingerSeconds == other.fLingerSeconds;
+	}
+
+	char* fURL;
+	char* fBackupURLs; // separated by spaces ("" if none)
+	unsigned fGOPCacheSizeKB;
+	unsigned fDVRSeconds;
+	ProxyServerMediaSession::UpstreamPolicy fUpstreamPolicy;
+	unsigned fLingerSeconds;
+};
+
+HashTable* confStreams = NULL; // maps stream names to "ConfStream"s
+time_t confFileModificationTime = 0;
+
+static void createConfStream(char const* rtspStreamName, ConfStream const& stream) {
+	ProxyServerMediaSession* sms
+		= ProxyServerMediaSession::createNew(*env, rtspServer,
+		stream.fURL, rtspStreamName,
+		username, password, tunnelOverHTTPPortNum, verbosityLevel);
+	sms->setGOPCacheSize(stream.fGOPCacheSizeKB*1024);
+	sms->setDVRWindow(stream.fDVRSeconds, dvrSizeKB*1024);
+	sms->setUpstreamPolicy(stream.fUpstreamPolicy, stream.fLingerSeconds);
+	char backupURL[512];
+	int urlLength;
+	for (char const* p = stream.fBackupURLs; sscanf(p, "%511s%n", backupURL, &urlLength) == 1; p += urlLength) {
+		sms->addBackupURL(backupURL);
+	}
+	sms->setFailureDetection(noDataTimeoutMS);
+	rtspServer->addServerMediaSession(sms);
+
+	char* proxyStreamURL = rtspServer->rtspURL(sms);
+	*env << "RTSP stream, proxying the stream \"" << stream.fURL << "\"\n";
+	*env << "\tPlay this stream using the URL: " << proxyStreamURL << "\n";
+	delete[] proxyStreamURL;
+}
+
+static void deleteConfStreams(HashTable* streams) {
+	ConfStream* stream;
+	while ((stream = (ConfStream*)streams->RemoveNext()) != NULL) {
+		delete stream;
+	}
+	delete streams;
+}
+
+// Reads the conf file.  When it's reloaded ("isReload"), only the streams that have been added, removed or changed
+// are (re)created or deleted; the other streams - and their clients - are left alone:
+void parse_conf_file(Boolean isReload = False)
 {
 	char line[1024];
 	char rtspStreamName[512];
 	char proxiedStreamURL[512];
+	unsigned streamGOPCacheSizeKB;
+	char options[6][512];
+	char backupURLs[1024];
+	// (We note the conf file's modification time even if we then can't read it, so that "checkConfFile()" doesn't keep
+	// trying to reload it until it changes again.)
+	struct stat confStat;
+	if (stat("conf", &confStat) == 0) confFileModificationTime = confStat.st_mtime;
 	FILE * conf = fopen("conf", "r");
 	if (conf == NULL)
 	{
+		if (isReload) {
+			// Keep our current streams.  (We'll try again when the conf file next changes, or on the next SIGHUP.):
+			*env << "Can not open conf file (" << strerror(errno) << "); keeping our current streams\n";
+			return;
+		}
 		fprintf(stderr, "Can not open conf file!\n");
 		exit(1);
 	}
+
+	HashTable* newConfStreams = HashTable::create(STRING_HASH_KEYS);
 	while (fgets(line, 1024, conf) != NULL)
 	{
 		memset(rtspStreamName, 0, 512);
 		memset(proxiedStreamURL, 0, 512);
 
-		sscanf(line, "%[^ ] %[^# ]", proxiedStreamURL, rtspStreamName);
+		// Each line is: <rtsp-url> <stream-name> [<gop-cache-size-in-KB>]
+		// Each line may also specify (in any order) a GOP cache size (in KB), an 'upstream policy' (see above), a
+		// "dvr=<seconds>" time-shift window, and one or more "backup=<rtsp-url>"s (to fail over to, in order, if the stream fails):
+		streamGOPCacheSizeKB = gopCacheSizeKB;
+		unsigned streamDVRSeconds = dvrSeconds;
+		ProxyServerMediaSession::UpstreamPolicy streamUpstreamPolicy = upstreamPolicy;
+		unsigned streamLingerSeconds = upstreamLingerSeconds;
+		backupURLs[0] = '\0';
+		int numFields = sscanf(line,
+			"%[^ ] %[^# \t\r\n] %511[^# \t\r\n] %511[^# \t\r\n] %511[^# \t\r\n] %511[^# \t\r\n] %511[^# \t\r\n] %511[^# \t\r\n]",
+			proxiedStreamURL, rtspStreamName, options[0], options[1], options[2], options[3], options[4], options[5]);
+		if (numFields < 2) continue; // e.g., a blank line
+		if (workers != NULL && !workers->ownsStream(rtspStreamName)) continue; // another worker proxies this stream
+		for (int i = 0; i < numFields - 2; ++i) {
+			if (strncmp(options[i], "backup=rtsp://", 14) == 0) {
+				if (strlen(backupURLs) + strlen(options[i]) < sizeof backupURLs) {
+					if (backupURLs[0] != '\0') strcat(backupURLs, " ");
+					strcat(backupURLs, &options[i][7]);
+				}
+			}
+			else if (sscanf(options[i], "dvr=%u", &streamDVRSeconds) != 1
+				&& sscanf(options[i], "%u", &streamGOPCacheSizeKB) != 1
+				&& !parseUpstreamPolicy(options[i], streamUpstreamPolicy, streamLingerSeconds)) {
+				*env << "conf: ignoring unknown option \"" << options[i] << "\" for stream \"" << rtspStreamName << "\"\n";
+			}
+		}
 		//	*env << "original url:[" << rtspStreamURL << "]\t proxiedStreamURL:[" << proxiedStreamURLSuffix<< "]\n";
-		ServerMediaSession* sms
+		delete (ConfStream*)newConfStreams->Add(rtspStreamName,
+			new ConfStream(proxiedStreamURL, backupURLs, streamGOPCacheSizeKB, streamDVRSeconds,
+				streamUpstreamPolicy, streamLingerSeconds));
+	}
+	fclose(conf);
+
+	// Compare the new set of streams with the old set.  (Each stream costs just a hash table lookup; only the streams
+	// that have changed cost more.)
+	if (confStreams == NULL) confStreams = HashTable::create(STRING_HASH_KEYS);
+	unsigned numAdded = 0, numChanged = 0, numRemoved = 0;
+	HashTable::Iterator* iter = HashTable::Iterator::create(*newConfStreams);
+	char const* streamName;
+	ConfStream* stream;
+	while ((stream = (ConfStream*)iter->next(streamName)) != NULL) {
+		ConfStream* oldStream = (ConfStream*)confStreams->Lookup(streamName);
+		if (oldStream != NULL) {
+			if (oldStream->sameAs(*stream)) continue; // leave this stream alone
+
+			rtspServer->deleteServerMediaSession(streamName);
+			++numChanged;
+		}
+		else {
+			++numAdded;
+		}
+		createConfStream(streamName, *stream);
+	}
+	delete iter;
+
+	iter = HashTable::Iterator::create(*confStreams);
+	while ((stream = (ConfStream*)iter->next(streamName)) != NULL) {
+		if (newConfStreams->Lookup(streamName) == NULL) {
+			*env << "Removing the stream \"" << streamName << "\" (proxying \"" << stream->fURL << "\")\n";
+			rtspServer->deleteServerMediaSession(streamName);
+			++numRemoved;
+		}
+	}
+	delete iter;
+
+	deleteConfStreams(confStreams);
+	confStreams = newConfStreams;
+
+	if (isReload) {
+		*env << "Reloaded the conf file: " << numAdded << " stream(s) added, " << numChanged << " changed, "
+			<< numRemoved << " removed, " << confStreams->numEntries() - numAdded - numChanged << " unchanged\n";
+	}
+}
+
+static void reloadConfFile(void* /*clientData*/) {
+#ifdef USE_SIGNALS
+	if (workers != NULL && !workers->isWorker()) {
+		// Our workers own the streams, so get each of them to reload the conf file:
+		workers->signalWorkers(SIGHUP);
+		return;
+	}
+#endif
+	parse_conf_file(True);
+}
+
+#ifdef USE_SIGNALS
+volatile sig_atomic_t reloadRequested = 0;
+
+static void signalHandlerReload(int /*sig*/) {
+	// We can't reload from within a signal handler - nor do anything else there that's not 'async-signal-safe' (which
+	// includes telling the event loop) - so just note the request, for "checkForReloadRequest()" to see:
+	reloadRequested = 1;
+}
+
+// How often the event loop checks whether we've been sent a SIGHUP:
+#define RELOAD_REQUEST_CHECK_INTERVAL_USECS 200000
+
+static void checkForReloadRequest(void* /*clientData*/) {
+	if (reloadRequested) {
+		reloadRequested = 0;
+		reloadConfFile(NULL);
+	}
+	env->taskScheduler().scheduleDelayedTask(RELOAD_REQUEST_CHECK_INTERVAL_USECS, (TaskFunc*)checkForReloadRequest, NULL);
+}
+#endif
+
+// Reloads the conf file whenever its modification time changes.  (If we use worker processes, then only the original
+// process does this, and it has the workers reload the file.):
+static void checkConfFile(void* /*clientData*/) {
+	if (workers != NULL && workers->isWorker()) return; // a replacement worker inherited this task from the original process
+
+	struct stat confStat;
+	if (stat("conf", &confStat) == 0 && confStat.st_mtime != confFileModificationTime) {
+		confFileModificationTime = confStat.st_mtime;
+		reloadConfFile(NULL);
+	}
+	env->taskScheduler().scheduleDelayedTask(confCheckIntervalSeconds*1000000, (TaskFunc*)checkConfFile, NULL);
+}
+char** commandLineURLs = NULL; // the "rtsp://" URLs (of streams to be proxied) given on the command line
+int numCommandLineURLs = 0;
+
+// Sets up the streams that we proxy: those given on the command line, and those in the conf file.  (When we use worker
+// processes, each worker - including one that replaces a worker that died - does this, for just the streams that it owns.)
+static void setUpStreams() {
+	if (workers != NULL && serveMetrics) {
+		char metricsURLSuffix[30];
+		sprintf(metricsURLSuffix, "metrics-%d", workers->workerNum());
+		rtspServer->enableMetrics(metricsURLSuffix);
+	}
+
+	// Create a proxy for each "rtsp://" URL specified on the command line:
+	for (int i = 0; i < numCommandLineURLs; ++i) {
+		char const* proxiedStreamURL = commandLineURLs[i];
+		char streamName[30];
+		if (numCommandLineURLs == 1) {
+			sprintf(streamName, "%s", "proxyStream"); // there's just one stream; give it this name
+		}
+		else {
+			sprintf(streamName, "proxyStream-%d", i + 1); // there's more than one stream; distinguish them by name
+		}
+		if (workers != NULL && !workers->ownsStream(streamName)) continue; // another worker proxies this stream
+		ProxyServerMediaSession* sms
 			= ProxyServerMediaSession::createNew(*env, rtspServer,
-			proxiedStreamURL, rtspStreamName,
+			proxiedStreamURL, streamName,
 			username, password, tunnelOverHTTPPortNum, verbosityLevel);
+		sms->setGOPCacheSize(gopCacheSizeKB*1024);
+		sms->setDVRWindow(dvrSeconds, dvrSizeKB*1024);
+		sms->setUpstreamPolicy(upstreamPolicy, upstreamLingerSeconds);
+		sms->setFailureDetection(noDataTimeoutMS);
 		rtspServer->addServerMediaSession(sms);
 
 		char* proxyStreamURL = rtspServer->rtspURL(sms);
@@ -85,13 +374,23 @@ void parse_conf_file()
 		delete[] proxyStreamURL;
 	}
 
+	parse_conf_file();
 }
+
 void usage() {
 	*env << "Usage: " << progName
 		<< " [-v|-V]"
 		<< " [-t|-T <http-port>]"
 		<< " [-u <username> <password>]"
 		<< " [-R] [-U <username-for-REGISTER> <password-for-REGISTER>]"
+		<< " [-g <gop-cache-KB-per-stream> [-G <gop-cache-KB-total>]]"
+		<< " [-d <time-shift-seconds> [-D <time-shift-KB-per-track>]]"
+		<< " [-p lazy|hot|linger=<seconds>] [-P <max-idle-upstreams>]"
+		<< " [-H <max-concurrent-handshakes>]"
+		<< " [-r <conf-file-check-interval-seconds>]"
+		<< " [-F <no-data-failover-ms>]"
+		<< " [-w <num-worker-processes>]"
+		<< " [-m [-e]]"
 		<< " <rtsp-url-1> ... <rtsp-url-n>\n";
 	exit(1);
 }
@@ -181,9 +480,76 @@ int main(int argc, char** argv) {
 					  proxyREGISTERRequests = True;
 					  break;
 		}
-		case 'r':{	 //reload config file
+		case 'g': // keep a cache of each (H.264 or H.265) stream's most recent GOP, for clients that join the stream
+		case 'G': { // limit the total memory used by these caches
+					  unsigned sizeKB;
+					  if (argc < 3 || sscanf(argv[2], "%u", &sizeKB) != 1) usage();
+					  if (opt[1] == 'g') gopCacheSizeKB = sizeKB;
+					  else GOPCache::setGlobalMemoryLimit(sizeKB*1024UL);
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'd': { // record each stream's most recent seconds, so that clients can play it from a point in the recent past
+					  if (argc < 3 || sscanf(argv[2], "%u", &dvrSeconds) != 1) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'D': { // limit the memory used to record each track
+					  if (argc < 3 || sscanf(argv[2], "%u", &dvrSizeKB) != 1) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'p': { // how to manage each back-end stream while it has no clients
+					  if (argc < 3 || !parseUpstreamPolicy(argv[2], upstreamPolicy, upstreamLingerSeconds)) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'P': { // limit the number of back-end streams that are kept playing without clients
+					  unsigned maxIdleUpstreams;
+					  if (argc < 3 || sscanf(argv[2], "%u", &maxIdleUpstreams) != 1) usage();
+					  ProxyServerMediaSession::setMaxIdleUpstreams(maxIdleUpstreams);
+					  ++argv; --argc;
+					  break;
+		}
 
-					 exit(0);
+		case 'H': { // limit the number of back-end connections that are being set up at the same time
+					  if (argc < 3 || sscanf(argv[2], "%u", &maxConcurrentHandshakes) != 1) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'r': { // check the conf file periodically, and reload it if it has changed
+					  // (Where signals are available, sending us a SIGHUP also reloads the conf file.)
+					  if (argc < 3 || sscanf(argv[2], "%u", &confCheckIntervalSeconds) != 1) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'F': { // treat a back-end stream as having failed if no data arrives from it for this long (while it's playing)
+					  if (argc < 3 || sscanf(argv[2], "%u", &noDataTimeoutMS) != 1) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'w': { // share our streams among this many worker processes (each with its own event loop), to use more CPU cores
+					  // (Note that the limits set by -G, -P and -H then apply to each worker separately.)
+					  if (argc < 3 || sscanf(argv[2], "%u", &numWorkers) != 1) usage();
+					  ++argv; --argc;
+					  break;
+		}
+
+		case 'm': { // serve our metrics (in Prometheus text format) via HTTP
+					  serveMetrics = True;
+					  break;
+		}
+
+		case 'e': { // also record (and include in our metrics) the timing of our event loop, and of each handler that it calls
+					  recordEventLoopStats = True;
+					  break;
 		}
 
 		default: {
@@ -201,6 +567,10 @@ int main(int argc, char** argv) {
 		if (strncmp(argv[i], "rtsp://", 7) != 0) usage();
 	}
 	// Do some additional checking for invalid command-line argument combinations:
+	if (recordEventLoopStats && !serveMetrics) {
+		*env << "The -e option can be used only with -m\n";
+		usage();
+	}
 	if (authDBForREGISTER != NULL && !proxyREGISTERRequests) {
 		*env << "The '-U <username> <password>' option can be used only with -R\n";
 		usage();
@@ -225,6 +595,8 @@ int main(int argc, char** argv) {
 	// Create the RTSP server.  Try first with the default port number (554),
 	// and then with the alternative port number (8554):
 
+	ProxyRTSPClient::setMaxConcurrentHandshakes(maxConcurrentHandshakes);
+
 	portNumBits rtspServerPortNum = 554;
 	rtspServer = createRTSPServer(rtspServerPortNum);
 	if (rtspServer == NULL) {
@@ -236,34 +608,6 @@ int main(int argc, char** argv) {
 		exit(1);
 	}
 
-	// Create a proxy for each "rtsp://" URL specified on the command line:
-	for (i = 1; i < argc; ++i) {
-		char const* proxiedStreamURL = argv[i];
-		char streamName[30];
-		if (argc == 2) {
-			sprintf(streamName, "%s", "proxyStream"); // there's just one stream; give it this name
-		}
-		else {
-			sprintf(streamName, "proxyStream-%d", i); // there's more than one stream; distinguish them by name
-		}
-		ServerMediaSession* sms
-			= ProxyServerMediaSession::createNew(*env, rtspServer,
-			proxiedStreamURL, streamName,
-			username, password, tunnelOverHTTPPortNum, verbosityLevel);
-		rtspServer->addServerMediaSession(sms);
-
-		char* proxyStreamURL = rtspServer->rtspURL(sms);
-		*env << "RTSP stream, proxying the stream \"" << proxiedStreamURL << "\"\n";
-		*env << "\tPlay this stream using the URL: " << proxyStreamURL << "\n";
-		delete[] proxyStreamURL;
-	}
-
-	parse_conf_file();
-
-	if (proxyREGISTERRequests) {
-		*env << "(We handle incoming \"REGISTER\" requests on port " << rtspServerPortNum << ")\n";
-	}
-
 	// Also, attempt to create a HTTP server for RTSP-over-HTTP tunneling.
 	// Try first with the default HTTP port (80), and then with the alternative HTTP
 	// port numbers (8000 and 8080).
@@ -275,6 +619,47 @@ int main(int argc, char** argv) {
 		*env << "\n(RTSP-over-HTTP tunneling is not available.)\n";
 	}
 
+	// If requested, also serve our metrics (in Prometheus text format) via HTTP.  (These are subject to the same authentication
+	// - if any - as our streams.):
+	if (serveMetrics) {
+		rtspServer->enableMetrics("metrics");
+		*env << "(Our metrics are at \"/metrics\" - using HTTP - on each of the ports above.)\n";
+		if (recordEventLoopStats) env->taskScheduler().eventLoopStats()->enable();
+	}
+
+	if (numWorkers > 0) {
+		// Fork our worker processes.  (This must be done after our server's ports have been set up, but before any streams
+		// are created.)  From here on, each worker creates - and proxies - only those streams that are routed to it:
+		workers = ProxyServerWorkers::createNew(*rtspServer, numWorkers);
+		if (workers == NULL) {
+			*env << "Failed to create worker processes: " << env->getResultMsg() << "\n";
+			exit(1);
+		}
+		if (!workers->isWorker()) {
+			*env << "(We pass each incoming connection to one of our " << numWorkers << " worker processes.";
+			if (serveMetrics) *env << "  Worker <n>'s metrics are at \"/metrics-<n>\".";
+			*env << ")\n";
+		}
+	}
+
+	// Create our streams.  (If we use worker processes, then they do this, rather than us.):
+	commandLineURLs = &argv[1];
+	numCommandLineURLs = argc - 1;
+	if (workers == NULL || workers->isWorker()) setUpStreams();
+	if (confCheckIntervalSeconds > 0 && (workers == NULL || !workers->isWorker())) {
+		struct stat confStat;
+		if (stat("conf", &confStat) == 0) confFileModificationTime = confStat.st_mtime;
+		env->taskScheduler().scheduleDelayedTask(confCheckIntervalSeconds*1000000, (TaskFunc*)checkConfFile, NULL);
+	}
+#ifdef USE_SIGNALS
+	signal(SIGHUP, signalHandlerReload);
+	checkForReloadRequest(NULL);
+#endif
+
+	if (proxyREGISTERRequests && (workers == NULL || workers->workerNum() == 0)) {
+		*env << "(We handle incoming \"REGISTER\" requests on port " << rtspServerPortNum << ")\n";
+	}
+
 	// Now, enter the event loop:
 	env->taskScheduler().doEventLoop(); // does not return
 
@@ -18,47 +18,57 @@ along with this library; if not, write to the Free Software Foundation, Inc.,
 // and generates a separate index file that can be used - by our RTSP server
 // implementation - to support 'trick play' operations when streaming the
 // Transport Stream file.
+// Several files can be indexed in parallel (each by a separate process), and a file that's still being recorded can be
+// indexed as it grows ('follow' mode), so that 'trick play' can be used on it while it's being recorded.
+// Optionally, we also pre-render - for given 'trick play' scales - I-frame only copies of each file (each with its own
+// index file), so that the server can stream fast forward and reverse play sequentially from these.
 // main program
 
 #include <liveMedia.hh>
 #include <BasicUsageEnvironment.hh>
+#if defined(__WIN32__) || defined(_WIN32)
+#define NO_WORKER_PROCESSES 1
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 void afterPlaying(void* clientData); // forward
 
 UsageEnvironment* env;
 char const* programName;
+int followIdleTimeoutSeconds = -1; // -1 means: don't follow (i.e., index only the data that's already in the file)
+#define MAX_TRICK_PLAY_SCALES 20
+int trickPlayScales[MAX_TRICK_PLAY_SCALES];
+unsigned numTrickPlayScales = 0;
+char indexingIsDone;
 
 void usage() {
-  *env << "usage: " << programName << " <transport-stream-file-name>\n";
-  *env << "\twhere <transport-stream-file-name> ends with \".ts\"\n";
+  *env << "usage: " << programName << " [-j <max-parallel-jobs>] [-f <idle-timeout-seconds>] [-t <scale>]* <transport-stream-file-name> ...\n";
+  *env << "\twhere each <transport-stream-file-name> ends with \".ts\"\n";
+  *env << "\t-j: index up to <max-parallel-jobs> files at once, each in a separate process\n";
+  *env << "\t-f: 'follow' each file as it's being recorded, until it hasn't grown for <idle-timeout-seconds> (0 means forever)\n";
+  *env << "\t-t: also write a pre-rendered 'trick play' file (and its index file) for <scale> (a non-zero integer other than 1; negative for reverse play)\n";
   exit(1);
 }
 
-int main(int argc, char const** argv) {
-  // Begin by setting up our usage environment:
-  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
-  env = BasicUsageEnvironment::createNew(*scheduler);
-
-  // Parse the command line:
-  programName = argv[0];
-  if (argc != 2) usage();
-
-  char const* inputFileName = argv[1];
+Boolean indexFile(char const* inputFileName, Boolean follow) {
   // Check whether the input file name ends with ".ts":
   int len = strlen(inputFileName);
   if (len < 4 || strcmp(&inputFileName[len-3], ".ts") != 0) {
     *env << "ERROR: input file name \"" << inputFileName
 	 << "\" does not end with \".ts\"\n";
-    usage();
+    return False;
   }
 
   // Open the input file (as a 'byte stream file source'):
-  FramedSource* input
+  ByteStreamFileSource* input
     = ByteStreamFileSource::createNew(*env, inputFileName, TRANSPORT_PACKET_SIZE);
   if (input == NULL) {
     *env << "Failed to open input file \"" << inputFileName << "\" (does it exist?)\n";
-    exit(1);
+    return False;
   }
+  if (follow) input->followGrowingFile(followIdleTimeoutSeconds);
 
   // Create a filter that indexes the input Transport Stream data:
   FramedSource* indexer
@@ -72,19 +82,153 @@ int main(int argc, char const** argv) {
   MediaSink* output = FileSink::createNew(*env, outputFileName);
   if (output == NULL) {
     *env << "Failed to open output file \"" << outputFileName << "\"\n";
-    exit(1);
+    Medium::close(indexer);
+    delete[] outputFileName;
+    return False;
   }
 
   // Start playing, to generate the output index file:
-  *env << "Writing index file \"" << outputFileName << "\"...";
+  *env << "Writing index file \"" << outputFileName << "\"...\n";
+  indexingIsDone = 0;
   output->startPlaying(*indexer, afterPlaying, NULL);
+  env->taskScheduler().doEventLoop(&indexingIsDone);
+  *env << "...done writing \"" << outputFileName << "\"\n";
+
+  Medium::close(output);
+  Medium::close(indexer); // also closes "input"
+  delete[] outputFileName;
+  return True;
+}
+
+Boolean renderTrickPlayFile(char const* inputFileName, int scale) {
+  // Open the input file, and its index file (which we've just written):
+  ByteStreamFileSource* input
+    = ByteStreamFileSource::createNew(*env, inputFileName, TRANSPORT_PACKET_SIZE);
+  if (input == NULL) return False;
+
+  char* indexFileName = new char[strlen(inputFileName)+2]; // allow for trailing x\0
+  sprintf(indexFileName, "%sx", inputFileName);
+  MPEG2TransportStreamIndexFile* inputIndexFile
+    = MPEG2TransportStreamIndexFile::createNew(*env, indexFileName);
+  delete[] indexFileName;
+  if (inputIndexFile == NULL) {
+    *env << "Cannot pre-render 'trick play' files for \"" << inputFileName << "\", because it has no I-frames\n";
+    Medium::close(input);
+    return False;
+  }
+
+  // Generate a new Transport Stream from a trick mode filter.  For reverse play, we start from the end of the file:
+  MPEG2TransportStreamTrickModeFilter* trickModeFilter
+    = MPEG2TransportStreamTrickModeFilter::createNew(*env, input, inputIndexFile, scale);
+  if (scale < 0) {
+    float endTime = inputIndexFile->getPlayingDuration();
+    unsigned long tsRecordNumber, indexRecordNumber;
+    inputIndexFile->lookupTSPacketNumFromNPT(endTime, tsRecordNumber, indexRecordNumber);
+    trickModeFilter->seekTo(tsRecordNumber, indexRecordNumber);
+  }
+  MPEG2TransportStreamFromESSource* trickPlayStream = MPEG2TransportStreamFromESSource::createNew(*env);
+  trickPlayStream->addNewVideoSource(trickModeFilter, inputIndexFile->mpegVersion());
+
+  char* outputFileName = MPEG2TransportStreamTrickModeFilter::preRenderedFileName(inputFileName, scale);
+  MediaSink* output = FileSink::createNew(*env, outputFileName);
+  Boolean success = output != NULL;
+  if (success) {
+    *env << "Writing 'trick play' file \"" << outputFileName << "\" (scale " << scale << ")...\n";
+    indexingIsDone = 0;
+    output->startPlaying(*trickPlayStream, afterPlaying, NULL);
+    env->taskScheduler().doEventLoop(&indexingIsDone);
+    Medium::close(output);
+  } else {
+    *env << "Failed to open output file \"" << outputFileName << "\"\n";
+  }
+  Medium::close(trickPlayStream); // also closes "trickModeFilter" and "input"
+  Medium::close(inputIndexFile);
+
+  // Then index the new file (which the server needs, to find its position in it):
+  if (success) success = indexFile(outputFileName, False);
+  delete[] outputFileName;
+  return success;
+}
+
+Boolean processFile(char const* inputFileName) {
+  if (!indexFile(inputFileName, followIdleTimeoutSeconds >= 0)) return False;
 
-  env->taskScheduler().doEventLoop(); // does not return
+  Boolean success = True;
+  for (unsigned i = 0; i < numTrickPlayScales; ++i) {
+    if (!renderTrickPlayFile(inputFileName, trickPlayScales[i])) success = False;
+  }
+  return success;
+}
+
+int main(int argc, char const** argv) {
+  // Begin by setting up our usage environment:
+  TaskScheduler* scheduler = BasicTaskScheduler::createNew();
+  env = BasicUsageEnvironment::createNew(*scheduler);
+
+  // Parse the command line:
+  programName = argv[0];
+  unsigned maxParallelJobs = 1;
+  while (argc > 1 && argv[1][0] == '-') {
+    char const* opt = argv[1];
+    if (argc < 3) usage();
+    if (strcmp(opt, "-j") == 0) {
+      if (sscanf(argv[2], "%u", &maxParallelJobs) != 1 || maxParallelJobs == 0) usage();
+    } else if (strcmp(opt, "-f") == 0) {
+      if (sscanf(argv[2], "%d", &followIdleTimeoutSeconds) != 1 || followIdleTimeoutSeconds < 0) usage();
+    } else if (strcmp(opt, "-t") == 0) {
+      int scale;
+      if (sscanf(argv[2], "%d", &scale) != 1 || scale == 0 || scale == 1
+	  || numTrickPlayScales == MAX_TRICK_PLAY_SCALES) usage();
+      trickPlayScales[numTrickPlayScales++] = scale;
+    } else {
+      usage();
+    }
+    argc -= 2; argv += 2;
+  }
+  if (argc < 2) usage();
+  int numFiles = argc - 1;
+  char const** fileNames = &argv[1];
+
+  int numFailures = 0;
+#ifdef NO_WORKER_PROCESSES
+  maxParallelJobs = 1;
+#endif
+  if (maxParallelJobs == 1 || numFiles == 1) {
+    for (int i = 0; i < numFiles; ++i) {
+      if (!processFile(fileNames[i])) ++numFailures;
+    }
+  } else {
+#ifndef NO_WORKER_PROCESSES
+    // Index each file in a separate (child) process, running at most "maxParallelJobs" at once:
+    unsigned numRunning = 0;
+    int nextFile = 0;
+    while (nextFile < numFiles || numRunning > 0) {
+      if (nextFile < numFiles && numRunning < maxParallelJobs) {
+	pid_t pid = fork();
+	if (pid == 0) {
+	  // We're the child process:
+	  exit(processFile(fileNames[nextFile]) ? 0 : 1);
+	} else if (pid < 0) {
+	  *env << "fork() failed; indexing \"" << fileNames[nextFile] << "\" in this process instead\n";
+	  if (!processFile(fileNames[nextFile])) ++numFailures;
+	} else {
+	  ++numRunning;
+	}
+	++nextFile;
+      } else {
+	// Wait for a child process to finish:
+	int status;
+	if (wait(&status) < 0) break;
+	--numRunning;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++numFailures;
+      }
+    }
+#endif
+  }
 
-  return 0; // only to prevent compiler warning
+  return numFailures == 0 ? 0 : 1;
 }
 
 void afterPlaying(void* /*clientData*/) {
-  *env << "...done\n";
-  exit(0);
+  indexingIsDone = 1;
 }
@@ -73,6 +73,10 @@ Boolean generateMP4Format = False;
 QuickTimeFileSink* qtOut = NULL;
 Boolean outputAVIFile = False;
 AVIFileSink* aviOut = NULL;
+unsigned segmentDuration = 0; // seconds; 0 means: Don't output Transport Stream segments
+unsigned maxSegmentSizeKB = 0;
+MPEG2TransportStreamSegmentSink* segmentOut = NULL;
+MPEG2TransportStreamFromESSource* segmentMultiplexor = NULL;
 Boolean audioOnly = False;
 Boolean videoOnly = False;
 char const* singleMedium = NULL;
@@ -136,7 +140,7 @@ void usage() {
        << "]" << (supportCodecSelection ? " [-A <audio-codec-rtp-payload-format-code>|-M <mime-subtype-name>]" : "")
        << " [-s <initial-seek-time>]|[-U <absolute-seek-time>] [-z <scale>] [-g user-agent]"
        << " [-k <username-for-REGISTER> <password-for-REGISTER>]"
-       << " [-P <interval-in-seconds>]"
+       << " [-P <interval-in-seconds>] [-x <segment-duration> [-X <max-segment-KB>]]"
        << " [-w <width> -h <height>] [-f <frames-per-second>] [-y] [-H] [-Q [<measurement-interval>]] [-F <filename-prefix>] [-b <file-sink-buffer-size>] [-B <input-socket-buffer-size>] [-I <input-interface-ip-address>] [-m] [<url>|-R [<port-num>]] (or " << progName << " -o [-V] <url>)\n";
   shutdown();
 }
@@ -301,6 +305,26 @@ int main(int argc, char** argv) {
       break;
     }
 
+    case 'x': { // record into Transport Stream segments, of (at least) this many seconds
+      int segmentDurationInt;
+      if (sscanf(argv[2], "%d", &segmentDurationInt) != 1 || segmentDurationInt <= 0) {
+	usage();
+      }
+      segmentDuration = (unsigned)segmentDurationInt;
+      ++argv; --argc;
+      break;
+    }
+
+    case 'X': { // also begin a new segment once the current one has become this large
+      int maxSegmentSizeKBInt;
+      if (sscanf(argv[2], "%d", &maxSegmentSizeKBInt) != 1 || maxSegmentSizeKBInt <= 0) {
+	usage();
+      }
+      maxSegmentSizeKB = (unsigned)maxSegmentSizeKBInt;
+      ++argv; --argc;
+      break;
+    }
+
     case 't': {
       // stream RTP and RTCP over the TCP 'control' connection
       if (controlConnectionUsesTCP) {
@@ -537,6 +561,14 @@ int main(int argc, char** argv) {
     *env << "The -m and -P options cannot both be used!\n";
     usage();
   }
+  if (segmentDuration > 0 && (!createReceivers || outputCompositeFile || oneFilePerFrame || fileOutputInterval > 0)) {
+    *env << "The -x option cannot be used with -r, -q, -4, -i, -m, or -P!\n";
+    usage();
+  }
+  if (maxSegmentSizeKB > 0 && segmentDuration == 0) {
+    *env << "The -X option can be used only with -x!\n";
+    usage();
+  }
   if (outputCompositeFile && !movieWidthOptionSet) {
     *env << "Warning: The -q, -4 or -i option was used, but not -w.  Assuming a video width of "
 	 << movieWidth << " pixels\n";
@@ -833,6 +865,72 @@ void createOutputFiles(char const* periodicFilenameSuffix) {
       
       aviOut->startPlaying(sessionAfterPlaying, NULL);
     }
+  } else if (segmentDuration > 0) {
+    // Record into a sequence of Transport Stream segment files, listed in a ".m3u8" playlist.  A "MP2T" subsession is
+    // recorded as is; otherwise we multiplex those subsessions that can be carried in a Transport Stream:
+    FramedSource* transportStream = NULL;
+    MediaSubsessionIterator iter(*session);
+    while ((subsession = iter.next()) != NULL) {
+      if (subsession->readSource() == NULL) continue; // was not initiated
+      if (strcmp(subsession->codecName(), "MP2T") == 0) {
+	if (transportStream == NULL) transportStream = subsession->readSource();
+	continue;
+      }
+
+      // Each multiplexed input source is a framer, which - when the multiplexor is closed - we can detach from the
+      // subsession's source (so that the subsession can close it):
+      FramedFilter* framer = NULL;
+      int mpegVersion = 0;
+      if (strcmp(subsession->mediumName(), "video") == 0) {
+	if (strcmp(subsession->codecName(), "H264") == 0) {
+	  framer = H264VideoStreamDiscreteFramer::createNew(*env, subsession->readSource(), True/*include start codes*/);
+	  mpegVersion = 5;
+	} else if (strcmp(subsession->codecName(), "H265") == 0) {
+	  framer = H265VideoStreamDiscreteFramer::createNew(*env, subsession->readSource(), True/*include start codes*/);
+	  mpegVersion = 6;
+	} else if (strcmp(subsession->codecName(), "MPV") == 0) {
+	  framer = MPEG1or2VideoStreamDiscreteFramer::createNew(*env, subsession->readSource());
+	  mpegVersion = 2;
+	}
+      } else if (strcmp(subsession->mediumName(), "audio") == 0 &&
+		 strcmp(subsession->codecName(), "MPA") == 0) {
+	framer = MPEG1or2AudioStreamFramer::createNew(*env, subsession->readSource());
+	mpegVersion = 1;
+      }
+      if (framer == NULL) {
+	*env << "Cannot record the \"" << subsession->mediumName() << "/" << subsession->codecName()
+	     << "\" subsession in a Transport Stream; ignoring it\n";
+	continue;
+      }
+
+      if (segmentMultiplexor == NULL) segmentMultiplexor = MPEG2TransportStreamFromESSource::createNew(*env);
+      if (strcmp(subsession->mediumName(), "video") == 0) {
+	segmentMultiplexor->addNewVideoSource(framer, mpegVersion);
+      } else {
+	segmentMultiplexor->addNewAudioSource(framer, mpegVersion);
+      }
+      subsession->miscPtr = framer;
+    }
+    if (transportStream == NULL) transportStream = segmentMultiplexor;
+    if (transportStream == NULL) {
+      *env << "None of the subsessions can be recorded in a Transport Stream!\n";
+      shutdown();
+      return;
+    }
+
+    snprintf(outFileName, sizeof outFileName, "%s", fileNamePrefix[0] == '\0' ? "output" : fileNamePrefix);
+    segmentOut = MPEG2TransportStreamSegmentSink::createNew(*env, outFileName, segmentDuration,
+							    maxSegmentSizeKB*1024, fileSinkBufferSize);
+    if (segmentOut == NULL) {
+      *env << "Failed to create a \"MPEG2TransportStreamSegmentSink\" for outputting to \""
+	   << outFileName << ".m3u8\": " << env->getResultMsg() << "\n";
+      shutdown();
+      return;
+    } else {
+      *env << "Outputting Transport Stream segments listed in the file: \"" << outFileName << ".m3u8\"\n";
+    }
+
+    segmentOut->startPlaying(*transportStream, sessionAfterPlaying, NULL);
   } else {
     // Create and start "FileSink"s for each subsession:
     madeProgress = False;
@@ -1063,6 +1161,7 @@ void continueAfterPLAY(RTSPClient*, int resultCode, char* resultString) {
 void closeMediaSinks() {
   Medium::close(qtOut); qtOut = NULL;
   Medium::close(aviOut); aviOut = NULL;
+  Medium::close(segmentOut); segmentOut = NULL;
 
   if (session == NULL) return;
   MediaSubsessionIterator iter(*session);
@@ -1070,7 +1169,14 @@ void closeMediaSinks() {
   while ((subsession = iter.next()) != NULL) {
     Medium::close(subsession->sink);
     subsession->sink = NULL;
+
+    if (subsession->miscPtr != NULL) {
+      // This subsession's source was multiplexed (for "segmentOut").  Don't let the multiplexor close it:
+      ((FramedFilter*)(subsession->miscPtr))->detachInputSource();
+      subsession->miscPtr = NULL;
+    }
   }
+  Medium::close(segmentMultiplexor); segmentMultiplexor = NULL;
 }
 
 void subsessionAfterPlaying(void* clientData) {
@@ -0,0 +1,149 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+**********/
+// Copyright (c) 1996-2014, Live Networks, Inc.  All rights reserved
+// A program that checks our Base64 encoder and decoder - at each level of vector instructions that the CPU supports -
+// against the portable code (and a simple reference encoder), and then measures their throughput.
+// main program
+
+#include "testCommon.hh"
+#include "Base64.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned numFailures = 0;
+
+static char const referenceChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void referenceEncode(unsigned char const* in, unsigned inSize, char* out) {
+  // The simplest possible encoder (6 bits at a time), to check the others against:
+  unsigned numBits = 0, bits = 0;
+  for (unsigned i = 0; i < inSize; ++i) {
+    bits = (bits<<8) | in[i]; numBits += 8;
+    while (numBits >= 6) { numBits -= 6; *out++ = referenceChars[(bits>>numBits)&0x3F]; }
+  }
+  if (numBits > 0) *out++ = referenceChars[(bits<<(6-numBits))&0x3F];
+  while (inSize++%3 != 0) *out++ = '=';
+  *out = '\0';
+}
+
+static void fail(char const* what, unsigned level, unsigned size) {
+  fprintf(stderr, "FAILED: %s (vector level %u, %u bytes)\n", what, level, size);
+  ++numFailures;
+}
+
+static void checkOne(unsigned level, unsigned char const* data, unsigned size,
+		     char* encoded, char* expected, unsigned char* decoded) {
+  // Encoding must give the same result as the reference encoder:
+  referenceEncode(data, size, expected);
+  unsigned encodedSize = base64EncodeToBuffer((char const*)data, size, encoded);
+  if (encodedSize != base64EncodedSize(size) || strcmp(encoded, expected) != 0) fail("encode", level, size);
+
+  // Decoding must give back the original data - whether into a separate buffer, or in place:
+  unsigned decodedSize = base64DecodeToBuffer(encoded, encodedSize, decoded, False);
+  unsigned const paddedSize = base64DecodedMaxSize(encodedSize);
+  if (decodedSize != paddedSize || memcmp(decoded, data, size) != 0) fail("decode", level, size);
+
+  unsigned char* inPlace = (unsigned char*)encoded;
+  decodedSize = base64DecodeToBuffer(encoded, encodedSize, inPlace, False);
+  if (decodedSize != paddedSize || memcmp(inPlace, data, size) != 0) fail("in-place decode", level, size);
+
+  // "trimTrailingZeros" removes only (zero) bytes that were added because of padding:
+  unsigned trimmedSize = base64DecodeToBuffer(expected, encodedSize, decoded, True);
+  unsigned expectedTrimmedSize = paddedSize;
+  unsigned paddingCount = paddedSize - size;
+  while (paddingCount > 0 && expectedTrimmedSize > 0 && decoded[expectedTrimmedSize-1] == '\0') {
+    --expectedTrimmedSize; --paddingCount;
+  }
+  if (trimmedSize != expectedTrimmedSize) fail("trimmed decode", level, size);
+}
+
+static void checkCorruptedInput(unsigned level, unsigned char const* data, unsigned size,
+				char* encoded, unsigned char* decoded, unsigned char* portableDecoded) {
+  // Decoding input that contains invalid characters (or misplaced padding) must give the same result as the portable code:
+  unsigned encodedSize = base64EncodeToBuffer((char const*)data, size, encoded);
+  if (encodedSize == 0) return;
+  static char const badChars[] = { '=', '\0', '\n', ' ', '-', '_', '*', (char)0x80, (char)0xFF };
+  encoded[our_random()%encodedSize] = badChars[our_random()%sizeof badChars];
+
+  base64SetMaxSIMDLevel(0);
+  unsigned portableSize = base64DecodeToBuffer(encoded, encodedSize, portableDecoded);
+  base64SetMaxSIMDLevel(level);
+  unsigned decodedSize = base64DecodeToBuffer(encoded, encodedSize, decoded);
+  if (decodedSize != portableSize || memcmp(decoded, portableDecoded, decodedSize) != 0) {
+    fail("decode of corrupted input", level, size);
+  }
+}
+
+#define MAX_TEST_SIZE 4096
+#define BENCHMARK_SIZE (1024*1024)
+
+int main(int argc, char** argv) {
+  unsigned char* data = new unsigned char[BENCHMARK_SIZE];
+  char* encoded = new char[base64EncodedSize(BENCHMARK_SIZE)+1];
+  char* expected = new char[base64EncodedSize(BENCHMARK_SIZE)+1];
+  unsigned char* decoded = new unsigned char[BENCHMARK_SIZE+3];
+  unsigned char* portableDecoded = new unsigned char[BENCHMARK_SIZE+3];
+  initTestRandom();
+  for (unsigned i = 0; i < BENCHMARK_SIZE; ++i) data[i] = (unsigned char)our_random();
+
+  unsigned const maxLevel = base64SetMaxSIMDLevel(2);
+  for (unsigned level = 0; level <= maxLevel; ++level) {
+    base64SetMaxSIMDLevel(level);
+
+    // Every length up to a few vector blocks (to cover each way the vector code can leave a tail), then random lengths.
+    // Each test starts at a random offset within "data":
+    for (unsigned size = 0; size <= 200; ++size) {
+      checkOne(level, &data[our_random()%64], size, encoded, expected, decoded);
+    }
+    for (unsigned i = 0; i < 2000; ++i) {
+      unsigned size = our_random()%MAX_TEST_SIZE;
+      checkOne(level, &data[our_random()%64], size, encoded, expected, decoded);
+    }
+
+    // Inputs that are all 0x00 or all 0xFF bytes (i.e., the first and last alphabet characters):
+    memset(portableDecoded, 0x00, MAX_TEST_SIZE); checkOne(level, portableDecoded, MAX_TEST_SIZE-1, encoded, expected, decoded);
+    memset(portableDecoded, 0xFF, MAX_TEST_SIZE); checkOne(level, portableDecoded, MAX_TEST_SIZE-1, encoded, expected, decoded);
+
+    for (unsigned i = 0; i < 2000; ++i) {
+      checkCorruptedInput(level, &data[our_random()%64], our_random()%300, encoded, decoded, portableDecoded);
+    }
+  }
+  printf("Checked vector levels 0 to %u: %s\n", maxLevel, numFailures == 0 ? "OK" : "FAILED");
+
+  // Measure throughput, at each level:
+  unsigned const numIterations = argc > 1 ? atoi(argv[1]) : 200;
+  for (unsigned level = 0; level <= maxLevel; ++level) {
+    base64SetMaxSIMDLevel(level);
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    for (unsigned i = 0; i < numIterations; ++i) base64EncodeToBuffer((char const*)data, BENCHMARK_SIZE, encoded);
+    double encodeSeconds = secondsSince(start);
+
+    unsigned encodedSize = base64EncodedSize(BENCHMARK_SIZE);
+    gettimeofday(&start, NULL);
+    for (unsigned i = 0; i < numIterations; ++i) base64DecodeToBuffer(encoded, encodedSize, decoded);
+    double decodeSeconds = secondsSince(start);
+
+    double const numMegabytes = numIterations*(double)BENCHMARK_SIZE/1000000.0;
+    printf("vector level %u: encode %.0f MB/s; decode %.0f MB/s (of binary data)\n",
+	   level, numMegabytes/encodeSeconds, numMegabytes/decodeSeconds);
+  }
+
+  delete[] data; delete[] encoded; delete[] expected; delete[] decoded; delete[] portableDecoded;
+  return numFailures == 0 ? 0 : 1;
+}
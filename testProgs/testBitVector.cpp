@@ -0,0 +1,186 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+**********/
+// Copyright (c) 1996-2014, Live Networks, Inc.  All rights reserved
+// A program that checks reads from a "BitVector" (which uses a 64-bit cache, and a fast path for exponential-Golomb codes)
+// against a simple reader that copies bits one at a time (using "shiftBits()"), at every bit offset, and then measures
+// the throughput of each.
+// main program
+
+#include "testCommon.hh"
+#include "BitVector.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned numFailures = 0;
+
+// A reader that works the way that "BitVector" used to - copying bits one at a time - to check "BitVector" against:
+class BitwiseReader {
+public:
+  BitwiseReader(unsigned char const* baseBytePtr, unsigned baseBitOffset, unsigned totNumBits)
+    : fBaseBytePtr(baseBytePtr), fBaseBitOffset(baseBitOffset), fTotNumBits(totNumBits), fCurBitIndex(0) {
+  }
+
+  unsigned getBits(unsigned numBits) {
+    if (numBits == 0) return 0;
+    if (numBits > 32) numBits = 32;
+    unsigned overflowingBits = 0;
+    if (numBits > fTotNumBits - fCurBitIndex) overflowingBits = numBits - (fTotNumBits - fCurBitIndex);
+
+    unsigned char tmpBuf[4] = { 0, 0, 0, 0 };
+    shiftBits(tmpBuf, 0, fBaseBytePtr, fBaseBitOffset + fCurBitIndex, numBits - overflowingBits);
+    fCurBitIndex += numBits - overflowingBits;
+
+    unsigned result = (tmpBuf[0]<<24) | (tmpBuf[1]<<16) | (tmpBuf[2]<<8) | tmpBuf[3];
+    return result >> (32 - numBits); // any overflow bits are 0
+  }
+  unsigned peekBits(unsigned numBits) {
+    unsigned savedBitIndex = fCurBitIndex;
+    unsigned result = getBits(numBits);
+    fCurBitIndex = savedBitIndex;
+    return result;
+  }
+  unsigned get1Bit() { return getBits(1); }
+  void skipBits(unsigned numBits) {
+    fCurBitIndex = numBits > fTotNumBits - fCurBitIndex ? fTotNumBits : fCurBitIndex + numBits;
+  }
+  unsigned get_expGolomb() {
+    unsigned numLeadingZeroBits = 0;
+    unsigned codeStart = 1;
+    while (get1Bit() == 0 && fCurBitIndex < fTotNumBits) {
+      ++numLeadingZeroBits;
+      codeStart *= 2;
+    }
+    return codeStart - 1 + getBits(numLeadingZeroBits);
+  }
+  unsigned curBitIndex() const { return fCurBitIndex; }
+
+private:
+  unsigned char const* fBaseBytePtr;
+  unsigned fBaseBitOffset, fTotNumBits, fCurBitIndex;
+};
+
+static unsigned numMismatches = 0;
+
+static void checkReads(unsigned char* bytes, unsigned baseBitOffset, unsigned totNumBits) {
+  // Perform the same (random) sequence of reads using each method, and check that they give the same results:
+  BitVector bv(bytes, baseBitOffset, totNumBits);
+  BitwiseReader ref(bytes, baseBitOffset, totNumBits);
+
+  for (unsigned i = 0; i < 200 && ref.curBitIndex() < totNumBits + 8; ++i) {
+    unsigned numBits = our_random()%33;
+    unsigned result, expected;
+    switch (our_random()%5) {
+      case 0: { result = bv.getBits(numBits); expected = ref.getBits(numBits); break; }
+      case 1: { result = bv.peekBits(numBits); expected = ref.peekBits(numBits); break; }
+      case 2: { result = bv.get1Bit(); expected = ref.get1Bit(); break; }
+      case 3: { bv.skipBits(numBits); ref.skipBits(numBits); result = expected = 0; break; }
+      default: { result = bv.get_expGolomb(); expected = ref.get_expGolomb(); break; }
+    }
+    if (result != expected || bv.curBitIndex() != ref.curBitIndex()) {
+      ++numMismatches;
+      return;
+    }
+  }
+}
+
+#define BUFFER_SIZE (1024*1024)
+#define NUM_EXP_GOLOMB_VALUES 200000
+
+int main(int argc, char** argv) {
+  unsigned char* bytes = new unsigned char[BUFFER_SIZE];
+  initTestRandom();
+
+  // Check reads from random data, from 'sparse' data (mostly zero bytes, which gives long exponential-Golomb codes - some
+  // longer than 32 bits, which take the slow path), and from very short vectors - at every bit offset:
+  unsigned const numRounds = 3000;
+  for (unsigned round = 0; round < numRounds; ++round) {
+    unsigned const kind = round%3;
+    for (unsigned i = 0; i < 256; ++i) {
+      bytes[i] = kind == 1 && our_random()%16 != 0 ? 0 : (unsigned char)our_random();
+    }
+    unsigned const totNumBits = kind == 2 ? our_random()%48 : our_random()%(8*248);
+    for (unsigned baseBitOffset = 0; baseBitOffset < 8; ++baseBitOffset) {
+      checkReads(bytes, baseBitOffset, totNumBits);
+    }
+  }
+  if (numMismatches > 0) {
+    fprintf(stderr, "FAILED: %u of %u read sequences differed\n", numMismatches, numRounds*8);
+    ++numFailures;
+  }
+
+  // Encode some exponential-Golomb codes (with mostly small values, as in H.264/H.265 headers), at an odd bit offset,
+  // and check that they decode correctly:
+  unsigned* values = new unsigned[NUM_EXP_GOLOMB_VALUES];
+  memset(bytes, 0, BUFFER_SIZE);
+  BitVector writer(bytes, 3, 8*BUFFER_SIZE - 3);
+  for (unsigned i = 0; i < NUM_EXP_GOLOMB_VALUES; ++i) {
+    values[i] = our_random()%(1 << (our_random()%12));
+    unsigned numValueBits = 0;
+    while ((values[i] + 1) >> numValueBits > 1) ++numValueBits;
+    writer.putBits(0, numValueBits);
+    writer.putBits(values[i] + 1, numValueBits + 1);
+  }
+  unsigned const numCodedBits = writer.curBitIndex();
+  BitVector bv(bytes, 3, numCodedBits);
+  BitwiseReader ref(bytes, 3, numCodedBits);
+  for (unsigned i = 0; i < NUM_EXP_GOLOMB_VALUES; ++i) {
+    if (bv.get_expGolomb() != values[i] || ref.get_expGolomb() != values[i]) {
+      fprintf(stderr, "FAILED: exponential-Golomb code #%u decoded incorrectly\n", i);
+      ++numFailures;
+      break;
+    }
+  }
+  printf("Checked %u read sequences, and %u exponential-Golomb codes: %s\n",
+	 numRounds*8, NUM_EXP_GOLOMB_VALUES, numFailures == 0 ? "OK" : "FAILED");
+
+  // Measure throughput: reads of assorted sizes (at an odd bit offset), and exponential-Golomb decoding:
+  unsigned const numIterations = argc > 1 ? atoi(argv[1]) : 20;
+  static unsigned const readSizes[8] = { 1, 3, 5, 7, 8, 13, 16, 24 };
+  unsigned dummy = 0; // so that the reads can't be optimized away
+  for (unsigned method = 0; method < 2; ++method) {
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    unsigned numReads = 0;
+    for (unsigned n = 0; n < numIterations; ++n) {
+      BitVector bv(bytes, 3, 8*BUFFER_SIZE - 3);
+      BitwiseReader ref(bytes, 3, 8*BUFFER_SIZE - 3);
+      for (unsigned i = 0; i < 8*BUFFER_SIZE/12; ++i) {
+	dummy += method == 0 ? bv.getBits(readSizes[i%8]) : ref.getBits(readSizes[i%8]);
+      }
+      numReads += 8*BUFFER_SIZE/12;
+    }
+    double readSeconds = secondsSince(start);
+
+    gettimeofday(&start, NULL);
+    for (unsigned n = 0; n < numIterations; ++n) {
+      BitVector bv(bytes, 3, numCodedBits);
+      BitwiseReader ref(bytes, 3, numCodedBits);
+      for (unsigned i = 0; i < NUM_EXP_GOLOMB_VALUES; ++i) {
+	dummy += method == 0 ? bv.get_expGolomb() : ref.get_expGolomb();
+      }
+    }
+    double expGolombSeconds = secondsSince(start);
+
+    printf("%s: %.1f million reads/s; %.1f million exponential-Golomb codes/s\n",
+	   method == 0 ? "BitVector (cached)" : "bit at a time", numReads/readSeconds/1000000.0,
+	   numIterations*(double)NUM_EXP_GOLOMB_VALUES/expGolombSeconds/1000000.0);
+  }
+  if (dummy == 1) printf("\n"); // (unlikely)
+
+  delete[] values; delete[] bytes;
+  return numFailures == 0 ? 0 : 1;
+}
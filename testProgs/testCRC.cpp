@@ -0,0 +1,132 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+**********/
+// Copyright (c) 1996-2014, Live Networks, Inc.  All rights reserved
+// A program that checks "calculateCRC()" - the CRC-32/MPEG-2 used by Transport Stream PSI sections - both with and
+// without carry-less multiplication (if the CPU has it), against the CRC's bit-at-a-time definition.  It then measures
+// the throughput of each.
+// main program
+
+#include "testCommon.hh"
+#include "MPEG2TransportStreamMultiplexor.hh"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned numFailures = 0;
+
+static char const* implementationName(unsigned simdLevel) {
+  return simdLevel == 0 ? "slicing-by-8" : "carry-less multiplication";
+}
+
+static u_int32_t bitwiseCRC(u_int8_t const* data, unsigned dataLength, u_int32_t crc) {
+  // Polynomial division by 0x04C11DB7, one bit at a time (most significant bit first), with no final inversion:
+  while (dataLength-- > 0) {
+    crc ^= (u_int32_t)(*data++)<<24;
+    for (unsigned i = 0; i < 8; ++i) crc = (crc&0x80000000) != 0 ? (crc<<1)^0x04C11DB7 : crc<<1;
+  }
+  return crc;
+}
+
+static void checkCRC(unsigned simdLevel, u_int8_t const* data, unsigned dataLength) {
+  u_int32_t const initialValue = our_random32();
+  u_int32_t const expected = bitwiseCRC(data, dataLength, initialValue);
+  u_int32_t const crc = calculateCRC(data, dataLength, initialValue);
+
+  // Computing the CRC incrementally - by passing the CRC of the first part of the data as the "initialValue" for the
+  // rest - must give the same result, wherever the data is split:
+  unsigned const splitPoint = our_random()%(dataLength + 1);
+  u_int32_t const incrementalCRC
+    = calculateCRC(&data[splitPoint], dataLength - splitPoint, calculateCRC(data, splitPoint, initialValue));
+
+  if (crc != expected || incrementalCRC != expected) {
+    fprintf(stderr, "FAILED: %s: CRC of %u bytes was 0x%08x (incrementally, split after %u bytes: 0x%08x), not 0x%08x\n",
+	    implementationName(simdLevel), dataLength, crc, splitPoint, incrementalCRC, expected);
+    ++numFailures;
+  }
+}
+
+#define DATA_SIZE (1024*1024)
+#define TRANSPORT_PACKET_SIZE 188
+
+int main(int argc, char** argv) {
+  u_int8_t* data = new u_int8_t[DATA_SIZE];
+  initTestRandom();
+  for (unsigned i = 0; i < DATA_SIZE; ++i) data[i] = (u_int8_t)our_random();
+
+  unsigned const maxSIMDLevel = calculateCRCSetMaxSIMDLevel(1);
+  for (unsigned simdLevel = 0; simdLevel <= maxSIMDLevel; ++simdLevel) {
+    calculateCRCSetMaxSIMDLevel(simdLevel);
+
+    // The standard 'check' value for CRC-32/MPEG-2:
+    if (calculateCRC((u_int8_t const*)"123456789", 9) != 0x0376E6E7) {
+      fprintf(stderr, "FAILED: %s: wrong CRC for \"123456789\"\n", implementationName(simdLevel));
+      ++numFailures;
+    }
+
+    // Every length up to 256 bytes, at each alignment.  (Carry-less multiplication is used only for 64 or more bytes:
+    // it folds in 64-byte, and then 16-byte, blocks, leaving up to 15 bytes to the slicing-by-8 code - which, in turn,
+    // leaves up to 7 bytes to be done one at a time.)  Then some longer lengths:
+    for (unsigned dataLength = 0; dataLength <= 256; ++dataLength) {
+      for (unsigned alignment = 0; alignment < 16; ++alignment) checkCRC(simdLevel, &data[alignment], dataLength);
+    }
+    for (unsigned i = 0; i < 100; ++i) checkCRC(simdLevel, &data[our_random()%16], our_random()%(64*1024));
+
+    // A PSI section whose "CRC_32" field is intact has a CRC of 0 (which is how we check incoming PSI), and a corrupted
+    // bit is detected:
+    u_int8_t section[1024]; // the maximum size of a PSI section
+    unsigned const sectionLength = 12 + our_random()%(sizeof section - 12);
+    memmove(section, data, sectionLength - 4);
+    u_int32_t const sectionCRC = calculateCRC(section, sectionLength - 4);
+    section[sectionLength-4] = sectionCRC>>24; section[sectionLength-3] = sectionCRC>>16;
+    section[sectionLength-2] = sectionCRC>>8; section[sectionLength-1] = sectionCRC;
+    Boolean const intactSectionChecks = calculateCRC(section, sectionLength) == 0;
+    section[our_random()%sectionLength] ^= 1<<(our_random()%8);
+    if (!intactSectionChecks || calculateCRC(section, sectionLength) == 0) {
+      fprintf(stderr, "FAILED: %s: checking a %u-byte PSI section\n", implementationName(simdLevel), sectionLength);
+      ++numFailures;
+    }
+  }
+  printf("Checked calculateCRC() using %s%s: %s\n", implementationName(0),
+	 maxSIMDLevel > 0 ? " and carry-less multiplication" : " (this CPU can't do carry-less multiplication)",
+	 numFailures == 0 ? "OK" : "FAILED");
+
+  // Measure the throughput of each implementation: over 1 MB at once, and over each Transport Stream packet's worth:
+  unsigned const numIterations = argc > 1 ? atoi(argv[1]) : 200;
+  double const numMegabytes = numIterations*(double)DATA_SIZE/1000000.0;
+  for (unsigned simdLevel = 0; simdLevel <= maxSIMDLevel; ++simdLevel) {
+    calculateCRCSetMaxSIMDLevel(simdLevel);
+    u_int32_t dummy = 0; // so that the calls can't be optimized away
+
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    for (unsigned i = 0; i < numIterations; ++i) dummy += calculateCRC(data, DATA_SIZE);
+    double const wholeSeconds = secondsSince(start);
+
+    gettimeofday(&start, NULL);
+    for (unsigned i = 0; i < numIterations; ++i) {
+      for (unsigned offset = 0; offset + TRANSPORT_PACKET_SIZE <= DATA_SIZE; offset += TRANSPORT_PACKET_SIZE) {
+	dummy += calculateCRC(&data[offset], TRANSPORT_PACKET_SIZE);
+      }
+    }
+    double const packetSeconds = secondsSince(start);
+
+    printf("%s: %.0f MB/s (1 MB at once); %.0f MB/s (%u bytes at a time) [%08x]\n", implementationName(simdLevel),
+	   numMegabytes/wholeSeconds, numMegabytes/packetSeconds, TRANSPORT_PACKET_SIZE, dummy);
+  }
+
+  delete[] data;
+  return numFailures == 0 ? 0 : 1;
+}
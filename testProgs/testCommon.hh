@@ -0,0 +1,28 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+**********/
+// Copyright (c) 1996-2014, Live Networks, Inc.  All rights reserved
+// Common code, used by the test programs ("testBase64", "testCRC", etc.) that check - and then measure the
+// throughput of - some library code
+// Interfaces
+
+#include <GroupsockHelper.hh>
+
+extern void initTestRandom();
+  // Seeds "our_random()" with a fixed value, so that every run checks (and times) the same data - and any failure can be
+  // reproduced.
+
+extern double secondsSince(struct timeval const& start);
+  // Returns the time since "start" (which was set using "gettimeofday()")
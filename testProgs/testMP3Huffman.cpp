@@ -0,0 +1,118 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+**********/
+// Copyright (c) 1996-2014, Live Networks, Inc.  All rights reserved
+// A program that checks that MP3 Huffman decoding using lookup tables gives exactly the same results as walking each
+// decoder tree one bit at a time - for every Huffman table - and then measures the throughput of each.
+// main program
+
+#include "testCommon.hh"
+#include "../liveMedia/MP3InternalsHuffman.hh" // not a public header
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+unsigned numFailures = 0;
+
+#define NUM_BIG_VALUE_TABLES 32
+#define GRANULE_DATA_SIZE 600 /* bytes; enough for any granule */
+#define GRANULES_PER_TABLE 500
+
+struct Granule {
+  MP3SideInfo::gr_info_s_t gr;
+  unsigned char data[GRANULE_DATA_SIZE];
+  unsigned bitOffset, numBits;
+};
+
+static void makeGranule(Granule& granule, unsigned bigValueTable, unsigned count1Table) {
+  // Random Huffman-coded data, using "bigValueTable" in each of the three 'big values' regions:
+  for (unsigned i = 0; i < GRANULE_DATA_SIZE; ++i) granule.data[i] = (unsigned char)our_random();
+  MP3SideInfo::gr_info_s_t& gr = granule.gr;
+  memset(&gr, 0, sizeof gr);
+  gr.scfsi = -1;
+  gr.scalefac_compress = our_random()%16;
+  gr.big_values = our_random()%(SBLIMIT*SSLIMIT/2 + 1);
+  gr.region1start = our_random()%(gr.big_values + 1);
+  gr.region2start = gr.region1start + our_random()%(gr.big_values - gr.region1start + 1);
+  gr.table_select[0] = gr.table_select[1] = gr.table_select[2] = bigValueTable;
+  gr.count1table_select = count1Table;
+  granule.bitOffset = our_random()%8;
+  granule.numBits = 500 + our_random()%(8*GRANULE_DATA_SIZE - 508);
+}
+
+static void decode(Granule& granule, MP3HuffmanEncodingInfo& hei) {
+  unsigned scaleFactorsLength; // dummy
+  MP3SideInfo::gr_info_s_t gr = granule.gr; // because "MP3HuffmanDecode()" can change it
+  MP3HuffmanDecode(&gr, False, granule.data, granule.bitOffset, granule.numBits, scaleFactorsLength, hei);
+}
+
+static Boolean sameResults(MP3HuffmanEncodingInfo const& a, MP3HuffmanEncodingInfo const& b) {
+  if (a.numSamples != b.numSamples || a.reg1Start != b.reg1Start || a.reg2Start != b.reg2Start
+      || a.bigvalStart != b.bigvalStart) return False;
+  return memcmp(a.allBitOffsets, b.allBitOffsets, (a.numSamples+1)*sizeof a.allBitOffsets[0]) == 0
+    && memcmp(a.decodedValues, b.decodedValues, 4*a.numSamples*sizeof a.decodedValues[0]) == 0;
+}
+
+int main(int argc, char** argv) {
+  MP3HuffmanEncodingInfo withLookup(True), withTreeWalk(True);
+  Granule* granules = new Granule[NUM_BIG_VALUE_TABLES*2];
+  initTestRandom();
+
+  // Check every 'big values' table, with each 'count1' table:
+  unsigned numGranules = 0;
+  for (unsigned table = 0; table < NUM_BIG_VALUE_TABLES; ++table) {
+    for (unsigned count1Table = 0; count1Table < 2; ++count1Table) {
+      unsigned numMismatches = 0;
+      for (unsigned i = 0; i < GRANULES_PER_TABLE; ++i) {
+	Granule& granule = granules[2*table + count1Table]; // we keep the last one of each, for benchmarking
+	makeGranule(granule, table, count1Table);
+	MP3HuffmanSetUseLookupTables(True); decode(granule, withLookup);
+	MP3HuffmanSetUseLookupTables(False); decode(granule, withTreeWalk);
+	if (!sameResults(withLookup, withTreeWalk)) ++numMismatches;
+	++numGranules;
+      }
+      if (numMismatches > 0) {
+	fprintf(stderr, "FAILED: table %u, count1 table %u: %u of %u granules decoded differently\n",
+		table, count1Table, numMismatches, GRANULES_PER_TABLE);
+	++numFailures;
+      }
+    }
+  }
+  printf("Checked %u granules (all %u 'big values' tables, and both 'count1' tables): %s\n",
+	 numGranules, NUM_BIG_VALUE_TABLES, numFailures == 0 ? "OK" : "FAILED");
+
+  // Measure throughput, by each method.  (Keep each granule's 'count1' area short, as it is in real files.)
+  for (unsigned i = 0; i < NUM_BIG_VALUE_TABLES*2; ++i) {
+    decode(granules[i], withLookup);
+    unsigned numBits = withLookup.bigvalStart - granules[i].bitOffset + our_random()%100;
+    if (numBits < granules[i].numBits) granules[i].numBits = numBits;
+  }
+  unsigned const numIterations = argc > 1 ? atoi(argv[1]) : 2000;
+  for (int useLookupTables = 1; useLookupTables >= 0; --useLookupTables) {
+    MP3HuffmanSetUseLookupTables(useLookupTables);
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    for (unsigned n = 0; n < numIterations; ++n) {
+      for (unsigned i = 0; i < NUM_BIG_VALUE_TABLES*2; ++i) decode(granules[i], withLookup);
+    }
+    double seconds = secondsSince(start);
+    printf("%s: %.0f granules/s\n", useLookupTables ? "lookup tables" : "tree walk",
+	   numIterations*NUM_BIG_VALUE_TABLES*2/seconds);
+  }
+  MP3HuffmanSetUseLookupTables(True);
+
+  delete[] granules;
+  return numFailures == 0 ? 0 : 1;
+}
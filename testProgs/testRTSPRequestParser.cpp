@@ -0,0 +1,190 @@
+/**********
+This library is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by the
+Free Software Foundation; either version 2.1 of the License, or (at your
+option) any later version. (See <http://www.gnu.org/copyleft/lesser.html>.)
+
+This library is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this library; if not, write to the Free Software Foundation, Inc.,
+59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+**********/
+// Copyright (c) 1996-2014, Live Networks, Inc.  All rights reserved
+// A program that checks how RTSP requests are parsed using a "RTSPRequestHeaderIndex" (as "RTSPServer" does),
+// and then measures the throughput of this, compared with scanning each request once for each header.
+// main program
+
+#include <GroupsockHelper.hh>
+#include "RTSPCommon.hh"
+#include "strDup.hh"
+#include <stdio.h>
+#include <stdlib.h>
+
+unsigned numFailures = 0;
+
+struct ParsedRequest {
+  char cmdName[RTSP_PARAM_STRING_MAX];
+  char urlPreSuffix[RTSP_PARAM_STRING_MAX];
+  char urlSuffix[RTSP_PARAM_STRING_MAX];
+  char cseq[RTSP_PARAM_STRING_MAX];
+  char sessionId[RTSP_PARAM_STRING_MAX];
+  unsigned contentLength;
+  double rangeStart, rangeEnd;
+  float scale;
+};
+
+static void indexRequest(RTSPRequestHeaderIndex& headers, char* request) {
+  // Add each line to the index, as "RTSPServer" does as the request arrives:
+  headers.reset();
+  char* lineStart = request;
+  for (char* ptr = request; ptr[0] != '\0' && ptr[1] != '\0'; ++ptr) {
+    if (ptr[0] == '\r' && ptr[1] == '\n') {
+      if (ptr == lineStart) break; // the blank line at the end of the headers
+      headers.addLine(lineStart, ptr - lineStart);
+      lineStart = ptr + 2;
+    }
+  }
+}
+
+static Boolean parseUsingIndex(RTSPRequestHeaderIndex& headers, char* request, ParsedRequest& result) {
+  indexRequest(headers, request);
+  if (!parseRTSPRequestString(headers, result.cmdName, sizeof result.cmdName,
+			      result.urlPreSuffix, sizeof result.urlPreSuffix, result.urlSuffix, sizeof result.urlSuffix,
+			      result.cseq, sizeof result.cseq, result.sessionId, sizeof result.sessionId,
+			      result.contentLength)) return False;
+
+  char* absStart = NULL; char* absEnd = NULL; Boolean startTimeIsNow;
+  char const* rangeLine = headers.lookupLine("Range");
+  if (rangeLine == NULL || !parseRangeHeader(rangeLine, result.rangeStart, result.rangeEnd, absStart, absEnd, startTimeIsNow)) {
+    result.rangeStart = result.rangeEnd = -1.0;
+  }
+  delete[] absStart; delete[] absEnd;
+  char const* scaleLine = headers.lookupLine("Scale");
+  if (scaleLine == NULL) result.scale = 1.0; else parseScaleHeader(scaleLine, result.scale);
+  return True;
+}
+
+static Boolean parseByScanning(char const* request, ParsedRequest& result) {
+  // Parse the request the way that we used to: by scanning the whole request for each header:
+  if (!parseRTSPRequestString(request, strlen(request), result.cmdName, sizeof result.cmdName,
+			      result.urlPreSuffix, sizeof result.urlPreSuffix, result.urlSuffix, sizeof result.urlSuffix,
+			      result.cseq, sizeof result.cseq, result.sessionId, sizeof result.sessionId,
+			      result.contentLength)) return False;
+
+  char* absStart = NULL; char* absEnd = NULL; Boolean startTimeIsNow;
+  if (!parseRangeHeader(request, result.rangeStart, result.rangeEnd, absStart, absEnd, startTimeIsNow)) {
+    result.rangeStart = result.rangeEnd = -1.0;
+  }
+  delete[] absStart; delete[] absEnd;
+  parseScaleHeader(request, result.scale);
+  return True;
+}
+
+static void check(char const* name, char const* request, char const* cmdName, char const* urlSuffix,
+		  char const* cseq, char const* sessionId, unsigned contentLength, double rangeStart, float scale) {
+  RTSPRequestHeaderIndex headers;
+  char* buffer = strDup(request);
+  ParsedRequest result;
+  Boolean ok = parseUsingIndex(headers, buffer, result)
+    && strcmp(result.cmdName, cmdName) == 0 && strcmp(result.urlSuffix, urlSuffix) == 0
+    && strcmp(result.cseq, cseq) == 0 && strcmp(result.sessionId, sessionId) == 0
+    && result.contentLength == contentLength && result.rangeStart == rangeStart && result.scale == scale;
+
+  // Because "addLine()" normalizes any "name :" header lines in place, scanning the same (indexed) request must agree:
+  ParsedRequest scanned;
+  ok = ok && parseByScanning(buffer, scanned)
+    && strcmp(scanned.cseq, result.cseq) == 0 && strcmp(scanned.sessionId, result.sessionId) == 0
+    && scanned.contentLength == result.contentLength && scanned.rangeStart == result.rangeStart && scanned.scale == result.scale;
+
+  printf("%s: %s\n", name, ok ? "OK" : "FAILED");
+  if (!ok) ++numFailures;
+  delete[] buffer;
+}
+
+static char const* const setupRequest =
+  "SETUP rtsp://example.com/media.mp4/track1 RTSP/1.0\r\n"
+  "CSeq: 3\r\n"
+  "User-Agent: LibVLC/2.1.0 (LIVE555 Streaming Media v2014.01.21)\r\n"
+  "Transport: RTP/AVP;unicast;client_port=61234-61235\r\n"
+  "Session: 48B9C1A2\r\n"
+  "\r\n";
+
+static char const* const playRequest =
+  "PLAY rtsp://example.com/media.mp4/ RTSP/1.0\r\n"
+  "CSeq: 4\r\n"
+  "User-Agent: LibVLC/2.1.0 (LIVE555 Streaming Media v2014.01.21)\r\n"
+  "Session: 48B9C1A2\r\n"
+  "Range: npt=12.500-\r\n"
+  "Scale: 2.0\r\n"
+  "\r\n";
+
+static char* manyHeadersRequest(unsigned numPaddingHeaders) {
+  // A request whose "CSeq:", "Session:" and "Range:" headers come after many others:
+  char* request = new char[200 + 40*numPaddingHeaders];
+  char* ptr = request;
+  ptr += sprintf(ptr, "PLAY rtsp://example.com/padded RTSP/1.0\r\n");
+  for (unsigned i = 0; i < numPaddingHeaders; ++i) ptr += sprintf(ptr, "X-Padding-%u: %u\r\n", i, i);
+  sprintf(ptr, "CSeq: 99\r\nSession: 12345678\r\nRange: npt=1.000-\r\n\r\n");
+  return request;
+}
+
+int main(int argc, char** argv) {
+  // Check the parsing of some typical requests, and some unusual ones:
+  check("SETUP", setupRequest, "SETUP", "track1", "3", "48B9C1A2", 0, -1.0, 1.0);
+  check("PLAY", playRequest, "PLAY", "", "4", "48B9C1A2", 0, 12.5, 2.0);
+  check("whitespace before ':'",
+	"PLAY rtsp://example.com/x RTSP/1.0\r\nCSeq : 5\r\nSession\t: ABCD\r\nRange  :  npt=3-\r\nScale :1.5\r\n\r\n",
+	"PLAY", "x", "5", "ABCD", 0, 3.0, 1.5);
+  check("Content-Length",
+	"SET_PARAMETER rtsp://example.com/x RTSP/1.0\r\nCSeq: 6\r\nContent-Length: 12\r\n\r\n",
+	"SET_PARAMETER", "x", "6", "", 12, -1.0, 1.0);
+
+  // A "CSeq:" that's too long for its buffer makes the request fail to parse (rather than being truncated) - as it always did:
+  {
+    char* request = new char[2*RTSP_PARAM_STRING_MAX + 100];
+    char* ptr = request + sprintf(request, "OPTIONS rtsp://example.com/x RTSP/1.0\r\nCSeq: ");
+    for (unsigned i = 0; i < 2*RTSP_PARAM_STRING_MAX; ++i) *ptr++ = '1';
+    sprintf(ptr, "\r\n\r\n");
+    RTSPRequestHeaderIndex headers;
+    ParsedRequest result;
+    Boolean ok = !parseByScanning(request, result) && !parseUsingIndex(headers, request, result);
+    printf("over-long CSeq: %s\n", ok ? "OK" : "FAILED");
+    if (!ok) ++numFailures;
+    delete[] request;
+  }
+
+  char* padded = manyHeadersRequest(RTSP_INITIAL_NUM_INDEXED_HEADERS + 10);
+  check("headers beyond the initial index size", padded, "PLAY", "padded", "99", "12345678", 0, 1.0, 1.0);
+  delete[] padded;
+  padded = manyHeadersRequest(1000);
+  check("1000 headers", padded, "PLAY", "padded", "99", "12345678", 0, 1.0, 1.0);
+  delete[] padded;
+
+  // Measure the throughput of parsing a "PLAY" request (the command, "CSeq:", "Session:", "Content-Length:",
+  // "Range:" and "Scale:") by each method:
+  unsigned const numIterations = argc > 1 ? atoi(argv[1]) : 1000000;
+  char* request = strDup(playRequest);
+  RTSPRequestHeaderIndex headers;
+  ParsedRequest result;
+  struct timeval start, end;
+
+  gettimeofday(&start, NULL);
+  for (unsigned i = 0; i < numIterations; ++i) parseByScanning(request, result);
+  gettimeofday(&end, NULL);
+  double scanSeconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec)/1000000.0;
+
+  gettimeofday(&start, NULL);
+  for (unsigned i = 0; i < numIterations; ++i) parseUsingIndex(headers, request, result);
+  gettimeofday(&end, NULL);
+  double indexSeconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec)/1000000.0;
+
+  printf("Parsing a %u-byte PLAY request: scanning for each header: %.0f requests/s; using the index: %.0f requests/s\n",
+	 (unsigned)strlen(request), numIterations/scanSeconds, numIterations/indexSeconds);
+  delete[] request;
+
+  return numFailures == 0 ? 0 : 1;
+}